@@ -0,0 +1,22 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Bindless version of shader.frag - the texture is picked out of the global array by index
+layout(push_constant, std430) uniform pc {
+    vec3 position;
+    uint objectIndex;
+    uint textureIndex;
+    uint objectBufferIndex;
+};
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) in vec3 normal;
+
+layout(location = 0) out vec4 outColor;
+
+layout(set = 1, binding = 0) uniform sampler2D textures[]; // set 0 is the camera
+
+void main() {
+    outColor = texture(textures[nonuniformEXT(textureIndex)], fragTexCoord);
+}
@@ -0,0 +1,44 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+#extension GL_GOOGLE_include_directive : require
+
+// Bindless version of shader.vert - object data is read from the global storage buffer array instead of a per object uniform buffer
+layout(push_constant, std430) uniform pc {
+    vec3 position;
+    uint objectIndex;
+    uint textureIndex;
+    uint objectBufferIndex;
+    vec4 positionOffset; // compact vertices only
+    vec4 positionScale;
+};
+
+// Per object, matches ObjectData
+struct ObjectData {
+    mat4 model;
+};
+
+// Per frame, matches CameraData (FrameConstants)
+layout(set = 0, binding = 0) uniform CameraData {
+    mat4 view;
+    mat4 proj;
+    mat4 viewProj;
+    vec4 position;
+} camera;
+
+layout(set = 1, binding = 1) readonly buffer ObjectBuffer {
+    ObjectData objects[];
+} objectBuffers[];
+
+#include "vertex_input.glsl"
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) out vec3 normal;
+
+void main() {
+    ObjectData object = objectBuffers[objectBufferIndex].objects[objectIndex];
+    gl_Position = camera.viewProj * object.model * vec4(VertexPosition() + position, 1.0);
+    fragColor = VertexColor();
+    fragTexCoord = inTexCoord;
+    normal = VertexNormal();
+}
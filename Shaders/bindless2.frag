@@ -0,0 +1,25 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Bindless version of shader2.frag
+layout(push_constant, std430) uniform pc {
+    vec3 position;
+    uint objectIndex;
+    uint textureIndex;
+    uint objectBufferIndex;
+};
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) in vec3 normal;
+
+layout(location = 0) out vec4 outColor;
+
+layout(set = 1, binding = 0) uniform sampler2D textures[]; // set 0 is the camera
+
+void main() {
+    vec3 lightDir = vec3(0,1,0);
+    float intensity = (lightDir.x * normal.x / 2) + (lightDir.y * normal.y / 2) + (lightDir.z * normal.z / 2);
+    outColor = texture(textures[nonuniformEXT(textureIndex)], fragTexCoord);
+    outColor.xyz *= intensity;
+}
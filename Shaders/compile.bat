@@ -1,16 +1,44 @@
-C:/VulkanSDK/1.3.283.0/Bin/glslc.exe shader.vert -o compiledShaders/vert.spv
-C:/VulkanSDK/1.3.283.0/Bin/glslc.exe shader.frag -o compiledShaders/frag.spv
-C:/VulkanSDK/1.3.283.0/Bin/glslc.exe shader2.vert -o compiledShaders/vert2.spv
-C:/VulkanSDK/1.3.283.0/Bin/glslc.exe shader2.frag -o compiledShaders/frag2.spv
+@echo off
+rem Compiles every shader to SPIR-V. Vulkan-Runtime runs this before each build (prebuildcommands in Build-Runtime.lua), so the .spv files always match the GLSL and the layouts
+rem the code creates - running it by hand is only needed after editing a shader without rebuilding. glslc comes from the Vulkan SDK, whose installer sets VULKAN_SDK
+setlocal
+cd /d "%~dp0"
 
-C:/VulkanSDK/1.3.283.0/Bin/glslc.exe shader.vert -o ../Binaries/windows-x86_64/Release/Shaders/compiledShaders/vert.spv
-C:/VulkanSDK/1.3.283.0/Bin/glslc.exe shader.frag -o ../Binaries/windows-x86_64/Release/Shaders/compiledShaders/frag.spv
-C:/VulkanSDK/1.3.283.0/Bin/glslc.exe shader2.vert -o ../Binaries/windows-x86_64/Release/Shaders/compiledShaders/vert2.spv
-C:/VulkanSDK/1.3.283.0/Bin/glslc.exe shader2.frag -o ../Binaries/windows-x86_64/Release/Shaders/compiledShaders/frag2.spv
+if defined VULKAN_SDK (set GLSLC="%VULKAN_SDK%\Bin\glslc.exe") else (set GLSLC="C:\VulkanSDK\1.3.283.0\Bin\glslc.exe")
 
-C:/VulkanSDK/1.3.283.0/Bin/glslc.exe shader.vert -o ../Binaries/windows-x86_64/Debug/Shaders/compiledShaders/vert.spv
-C:/VulkanSDK/1.3.283.0/Bin/glslc.exe shader.frag -o ../Binaries/windows-x86_64/Debug/Shaders/compiledShaders/frag.spv
-C:/VulkanSDK/1.3.283.0/Bin/glslc.exe shader2.vert -o ../Binaries/windows-x86_64/Debug/Shaders/compiledShaders/vert2.spv
-C:/VulkanSDK/1.3.283.0/Bin/glslc.exe shader2.frag -o ../Binaries/windows-x86_64/Debug/Shaders/compiledShaders/frag2.spv
+for %%D in (compiledShaders ..\Binaries\windows-x86_64\Debug\Shaders\compiledShaders ..\Binaries\windows-x86_64\Release\Shaders\compiledShaders ..\Binaries\windows-x86_64\Dist\Shaders\compiledShaders) do (
+    if not exist %%D mkdir %%D
+    call :compile %%D || goto :failed
+)
 
-pause
\ No newline at end of file
+if /i not "%~1"=="nopause" pause
+exit /b 0
+
+:failed
+echo shader compilation failed
+if /i not "%~1"=="nopause" pause
+exit /b 1
+
+:compile
+set OUT=%~1
+%GLSLC% shader.vert -o %OUT%\vert.spv || exit /b 1
+%GLSLC% shader.frag -o %OUT%\frag.spv || exit /b 1
+%GLSLC% shader2.vert -o %OUT%\vert2.spv || exit /b 1
+%GLSLC% shader2.frag -o %OUT%\frag2.spv || exit /b 1
+%GLSLC% bindless.vert -o %OUT%\bindless_vert.spv || exit /b 1
+%GLSLC% bindless.frag -o %OUT%\bindless_frag.spv || exit /b 1
+%GLSLC% bindless2.frag -o %OUT%\bindless_frag2.spv || exit /b 1
+%GLSLC% instanced.vert -o %OUT%\instanced_vert.spv || exit /b 1
+%GLSLC% shader.vert -DCOMPACT_VERTEX -o %OUT%\vert_compact.spv || exit /b 1
+%GLSLC% shader.vert -DCOMPACT_VERTEX -DVERTEX_COLOR -o %OUT%\vert_compact_color.spv || exit /b 1
+%GLSLC% shader2.vert -DCOMPACT_VERTEX -o %OUT%\vert2_compact.spv || exit /b 1
+%GLSLC% shader2.vert -DCOMPACT_VERTEX -DVERTEX_COLOR -o %OUT%\vert2_compact_color.spv || exit /b 1
+%GLSLC% bindless.vert -DCOMPACT_VERTEX -o %OUT%\bindless_vert_compact.spv || exit /b 1
+%GLSLC% bindless.vert -DCOMPACT_VERTEX -DVERTEX_COLOR -o %OUT%\bindless_vert_compact_color.spv || exit /b 1
+%GLSLC% instanced.vert -DCOMPACT_VERTEX -o %OUT%\instanced_vert_compact.spv || exit /b 1
+%GLSLC% instanced.vert -DCOMPACT_VERTEX -DVERTEX_COLOR -o %OUT%\instanced_vert_compact_color.spv || exit /b 1
+%GLSLC% cull.comp -o %OUT%\cull_comp.spv || exit /b 1
+%GLSLC% cull.comp -DOCCLUSION -o %OUT%\cull_occlusion_comp.spv || exit /b 1
+%GLSLC% depth_pyramid.comp -o %OUT%\depth_pyramid_comp.spv || exit /b 1
+%GLSLC% depth_pyramid.comp -DMULTISAMPLED -o %OUT%\depth_pyramid_ms_comp.spv || exit /b 1
+exit /b 0
@@ -0,0 +1,49 @@
+#!/bin/sh
+# Compiles every shader to SPIR-V, the Linux and macOS version of compile.bat with the same outputs. Vulkan-Runtime runs this before each build (prebuildcommands in
+# Build-Runtime.lua), so running it by hand is only needed after editing a shader without rebuilding. glslc comes from the Vulkan SDK (its setup-env.sh sets VULKAN_SDK) or the PATH
+cd "$(dirname "$0")" || exit 1
+
+if [ -n "$VULKAN_SDK" ] && [ -x "$VULKAN_SDK/bin/glslc" ]; then
+    GLSLC="$VULKAN_SDK/bin/glslc"
+else
+    GLSLC=glslc
+fi
+
+# The Binaries folders are named after premake's %{cfg.system} (OutputDir in Build.lua)
+case "$(uname -s)" in
+    Darwin) SYSTEM=macosx ;;
+    *) SYSTEM=linux ;;
+esac
+
+compile()
+{
+    OUT=$1
+    "$GLSLC" shader.vert -o "$OUT/vert.spv" || return 1
+    "$GLSLC" shader.frag -o "$OUT/frag.spv" || return 1
+    "$GLSLC" shader2.vert -o "$OUT/vert2.spv" || return 1
+    "$GLSLC" shader2.frag -o "$OUT/frag2.spv" || return 1
+    "$GLSLC" bindless.vert -o "$OUT/bindless_vert.spv" || return 1
+    "$GLSLC" bindless.frag -o "$OUT/bindless_frag.spv" || return 1
+    "$GLSLC" bindless2.frag -o "$OUT/bindless_frag2.spv" || return 1
+    "$GLSLC" instanced.vert -o "$OUT/instanced_vert.spv" || return 1
+    "$GLSLC" shader.vert -DCOMPACT_VERTEX -o "$OUT/vert_compact.spv" || return 1
+    "$GLSLC" shader.vert -DCOMPACT_VERTEX -DVERTEX_COLOR -o "$OUT/vert_compact_color.spv" || return 1
+    "$GLSLC" shader2.vert -DCOMPACT_VERTEX -o "$OUT/vert2_compact.spv" || return 1
+    "$GLSLC" shader2.vert -DCOMPACT_VERTEX -DVERTEX_COLOR -o "$OUT/vert2_compact_color.spv" || return 1
+    "$GLSLC" bindless.vert -DCOMPACT_VERTEX -o "$OUT/bindless_vert_compact.spv" || return 1
+    "$GLSLC" bindless.vert -DCOMPACT_VERTEX -DVERTEX_COLOR -o "$OUT/bindless_vert_compact_color.spv" || return 1
+    "$GLSLC" instanced.vert -DCOMPACT_VERTEX -o "$OUT/instanced_vert_compact.spv" || return 1
+    "$GLSLC" instanced.vert -DCOMPACT_VERTEX -DVERTEX_COLOR -o "$OUT/instanced_vert_compact_color.spv" || return 1
+    "$GLSLC" cull.comp -o "$OUT/cull_comp.spv" || return 1
+    "$GLSLC" cull.comp -DOCCLUSION -o "$OUT/cull_occlusion_comp.spv" || return 1
+    "$GLSLC" depth_pyramid.comp -o "$OUT/depth_pyramid_comp.spv" || return 1
+    "$GLSLC" depth_pyramid.comp -DMULTISAMPLED -o "$OUT/depth_pyramid_ms_comp.spv" || return 1
+}
+
+for DIR in compiledShaders ../Binaries/$SYSTEM-x86_64/Debug/Shaders/compiledShaders ../Binaries/$SYSTEM-x86_64/Release/Shaders/compiledShaders ../Binaries/$SYSTEM-x86_64/Dist/Shaders/compiledShaders; do
+    if ! mkdir -p "$DIR" || ! compile "$DIR"; then
+        echo "shader compilation failed"
+        exit 1
+    fi
+done
+exit 0
@@ -0,0 +1,34 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+// Instanced version of shader.vert - the transform comes from the per instance vertex binding (InstanceData) instead of the push constants
+// Per draw, matches ObjectPushConstants (model is unused)
+layout(push_constant, std430) uniform pc {
+    mat4 model;
+    vec3 position;
+    vec4 positionOffset; // compact vertices only
+    vec4 positionScale;
+};
+
+// Per frame, matches CameraData (FrameConstants)
+layout(set = 0, binding = 0) uniform CameraData {
+    mat4 view;
+    mat4 proj;
+    mat4 viewProj;
+    vec4 position;
+} camera;
+
+#include "vertex_input.glsl"
+layout(location = 4) in mat4 instanceModel; // locations 4-7
+layout(location = 8) in vec4 instanceParams;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) out vec3 normal;
+
+void main() {
+    gl_Position = camera.viewProj * instanceModel * vec4(VertexPosition() + position, 1.0);
+    fragColor = VertexColor() * instanceParams.rgb;
+    fragTexCoord = inTexCoord;
+    normal = VertexNormal();
+}
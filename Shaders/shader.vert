@@ -1,27 +1,31 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 
+// Per draw, matches ObjectPushConstants
 layout(push_constant, std430) uniform pc {
+    mat4 model;
     vec3 position;
+    vec4 positionOffset; // compact vertices only
+    vec4 positionScale;
 };
 
-layout(set = 0, binding = 0) uniform UniformBufferObject {
-    mat4 model;
+// Per frame, matches CameraData (FrameConstants)
+layout(set = 0, binding = 0) uniform CameraData {
     mat4 view;
     mat4 proj;
-} ubo;
+    mat4 viewProj;
+    vec4 position;
+} camera;
 
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inColor;
-layout(location = 2) in vec2 inTexCoord;
-layout(location = 3) in vec3 inNormal;
+#include "vertex_input.glsl"
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
 layout(location = 2) out vec3 normal;
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition + position, 1.0);    
-    fragColor = inColor;
+    gl_Position = camera.viewProj * model * vec4(VertexPosition() + position, 1.0);    
+    fragColor = VertexColor();
     fragTexCoord = inTexCoord;
-    normal = inNormal;
+    normal = VertexNormal();
 }
\ No newline at end of file
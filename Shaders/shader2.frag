@@ -8,7 +8,7 @@ layout(location = 2) in vec3 normal;
 
 layout(location = 0) out vec4 outColor;
 
-layout(binding = 1) uniform sampler2D texSampler;
+layout(set = 1, binding = 1) uniform sampler2D texSampler; // set 0 is the camera
 
 void main() {
     // Textures are sampled using the built-in texture function.
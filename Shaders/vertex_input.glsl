@@ -0,0 +1,54 @@
+// Vertex inputs of every vertex shader, in the layout the GeometryArena stores them in (see VertexCodec).
+// Built as is for VertexFormat::FULL, with -DCOMPACT_VERTEX for COMPACT and -DCOMPACT_VERTEX -DVERTEX_COLOR for COMPACT_COLOR.
+// Include after the push constants, the compact path needs their positionOffset and positionScale (the mesh's GeometryRange)
+#ifdef COMPACT_VERTEX
+layout(location = 0) in vec3 inPosition; // 0 to 1 across the mesh's bounds
+#ifdef VERTEX_COLOR
+layout(location = 1) in vec3 inColor;
+#endif
+layout(location = 2) in vec2 inTexCoord;
+layout(location = 3) in vec2 inNormal; // octahedral
+
+// Refer to - https://www.jcgt.org/published/0003/02/01/
+// Undoes VertexCodec::EncodeNormal - the lower half of the octahedron was folded over the square's diagonals
+vec3 OctDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+vec3 VertexPosition() {
+    return positionOffset.xyz + inPosition * positionScale.xyz;
+}
+
+vec3 VertexNormal() {
+    return OctDecode(inNormal);
+}
+
+vec3 VertexColor() {
+#ifdef VERTEX_COLOR
+    return inColor;
+#else
+    return vec3(1.0); // what every imported mesh has anyway
+#endif
+}
+#else
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inTexCoord;
+layout(location = 3) in vec3 inNormal;
+
+vec3 VertexPosition() {
+    return inPosition;
+}
+
+vec3 VertexNormal() {
+    return inNormal;
+}
+
+vec3 VertexColor() {
+    return inColor;
+}
+#endif
@@ -0,0 +1,244 @@
+#include "BindlessTable.h"
+#include "Texture.h"
+#include "WinSys.h"
+#include "VulkanManager.h"
+#include "FrameConstants.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <cstring>
+
+
+namespace VCore
+{
+    BindlessTable::BindlessTable()
+    {
+        m_descriptorSetLayout = VK_NULL_HANDLE;
+        m_descriptorPool = VK_NULL_HANDLE;
+        m_descriptorSet = VK_NULL_HANDLE;
+        m_pipelineLayout = VK_NULL_HANDLE;
+        m_objectBuffers = std::vector<VkBuffer>();
+        m_objectBuffersMemory = std::vector<Allocation>();
+        m_objectBufferIndices = std::vector<uint32_t>();
+        m_textureCount = 0;
+        m_bufferCount = 0;
+        m_objectCount = 0;
+    }
+
+    BindlessTable::~BindlessTable()
+    {
+    }
+
+    void BindlessTable::Init(uint32_t framesInFlight, VkDescriptorSetLayout frameSetLayout, PipelineRegistry& pipelineRegistry, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice)
+    {
+        CreateDescriptorSetLayout(frameSetLayout, pipelineRegistry, logicalDevice);
+        CreateDescriptorSet(logicalDevice);
+        CreateObjectBuffers(framesInFlight, physicalDevice, logicalDevice);
+    }
+
+    void BindlessTable::Cleanup(PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice)
+    {
+        for (size_t i = 0; i < m_objectBuffers.size(); i++)
+        {
+            vkDestroyBuffer(logicalDevice.GetDevice(), m_objectBuffers[i], nullptr);
+            logicalDevice.GetAllocator().Free(m_objectBuffersMemory[i]);
+        }
+        m_objectBuffers.clear();
+        m_objectBuffersMemory.clear();
+
+        vkDestroyPipelineLayout(logicalDevice.GetDevice(), m_pipelineLayout, nullptr);
+        vkDestroyDescriptorPool(logicalDevice.GetDevice(), m_descriptorPool, nullptr); // frees m_descriptorSet too
+        pipelineRegistry.ReleaseDescriptorSetLayout(m_descriptorSetLayout, logicalDevice);
+        m_descriptorSetLayout = VK_NULL_HANDLE;
+    }
+
+    void BindlessTable::CreateDescriptorSetLayout(VkDescriptorSetLayout frameSetLayout, PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice)
+    {
+        std::vector<VkDescriptorSetLayoutBinding> bindings(2);
+
+        bindings[0].binding = 0;
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[0].descriptorCount = VM_BINDLESS_MAX_TEXTURES;
+        bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        bindings[0].pImmutableSamplers = nullptr;
+
+        bindings[1].binding = 1;
+        bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[1].descriptorCount = VM_BINDLESS_MAX_BUFFERS;
+        bindings[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        bindings[1].pImmutableSamplers = nullptr;
+
+        // Partially bound - unused slots can stay empty. Update after bind (+ unused while pending) - textures and buffers can be registered while frames using the set are in flight
+        std::vector<VkDescriptorBindingFlags> bindingFlags(2, VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT);
+
+        // The flags are part of the registry's key, so this never gets mixed up with a regular layout that has the same bindings
+        m_descriptorSetLayout = pipelineRegistry.AcquireDescriptorSetLayout(bindings, logicalDevice, VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT, bindingFlags);
+
+        VkPushConstantRange pushConstantRange = FrameConstants::GetPushConstantRange(true);
+
+        std::vector<VkDescriptorSetLayout> setLayouts = { frameSetLayout, m_descriptorSetLayout };
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+        pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+        if (vkCreatePipelineLayout(logicalDevice.GetDevice(), &pipelineLayoutInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create bindless pipeline layout!");
+        }
+    }
+
+    void BindlessTable::CreateDescriptorSet(LogicalDevice& logicalDevice)
+    {
+        std::vector<VkDescriptorPoolSize> poolSizes =
+        {
+            { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VM_BINDLESS_MAX_TEXTURES },
+            { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VM_BINDLESS_MAX_BUFFERS }
+        };
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+        poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        poolInfo.pPoolSizes = poolSizes.data();
+        poolInfo.maxSets = 1;
+
+        if (vkCreateDescriptorPool(logicalDevice.GetDevice(), &poolInfo, nullptr, &m_descriptorPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create bindless descriptor pool!");
+        }
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = m_descriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &m_descriptorSetLayout;
+
+        if (vkAllocateDescriptorSets(logicalDevice.GetDevice(), &allocInfo, &m_descriptorSet) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate bindless descriptor set!");
+        }
+    }
+
+    void BindlessTable::CreateObjectBuffers(uint32_t framesInFlight, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice)
+    {
+        // One buffer per frame in flight so the CPU can write next frame's object data while the GPU still reads the last one
+        VkDeviceSize bufferSize = sizeof(ObjectData) * VM_BINDLESS_MAX_OBJECTS;
+
+        m_objectBuffers.resize(framesInFlight);
+        m_objectBuffersMemory.resize(framesInFlight);
+        m_objectBufferIndices.resize(framesInFlight);
+
+        for (uint32_t i = 0; i < framesInFlight; i++)
+        {
+            WinSys::CreateBuffer(bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_objectBuffers[i], m_objectBuffersMemory[i], physicalDevice, logicalDevice);
+            m_objectBufferIndices[i] = RegisterBuffer(m_objectBuffers[i], bufferSize, logicalDevice);
+        }
+    }
+
+    uint32_t BindlessTable::RegisterTexture(Texture& texture, LogicalDevice& logicalDevice)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_textureCount >= VM_BINDLESS_MAX_TEXTURES)
+        {
+            throw std::runtime_error("failed to register texture, bindless texture array is full!");
+        }
+        uint32_t index = m_textureCount++;
+
+        VkDescriptorImageInfo imageInfo{};
+        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageInfo.imageView = texture.GetImageView();
+        imageInfo.sampler = texture.GetTextureSampler();
+
+        VkWriteDescriptorSet descriptorWrite{};
+        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite.dstSet = m_descriptorSet;
+        descriptorWrite.dstBinding = 0;
+        descriptorWrite.dstArrayElement = index;
+        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrite.descriptorCount = 1;
+        descriptorWrite.pImageInfo = &imageInfo;
+
+        vkUpdateDescriptorSets(logicalDevice.GetDevice(), 1, &descriptorWrite, 0, nullptr);
+
+        return index;
+    }
+
+    uint32_t BindlessTable::RegisterBuffer(VkBuffer buffer, VkDeviceSize size, LogicalDevice& logicalDevice)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_bufferCount >= VM_BINDLESS_MAX_BUFFERS)
+        {
+            throw std::runtime_error("failed to register buffer, bindless buffer array is full!");
+        }
+        uint32_t index = m_bufferCount++;
+
+        VkDescriptorBufferInfo bufferInfo{};
+        bufferInfo.buffer = buffer;
+        bufferInfo.offset = 0;
+        bufferInfo.range = size;
+
+        VkWriteDescriptorSet descriptorWrite{};
+        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite.dstSet = m_descriptorSet;
+        descriptorWrite.dstBinding = 1;
+        descriptorWrite.dstArrayElement = index;
+        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrite.descriptorCount = 1;
+        descriptorWrite.pBufferInfo = &bufferInfo;
+
+        vkUpdateDescriptorSets(logicalDevice.GetDevice(), 1, &descriptorWrite, 0, nullptr);
+
+        return index;
+    }
+
+    uint32_t BindlessTable::AllocateObject()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_objectCount >= VM_BINDLESS_MAX_OBJECTS)
+        {
+            throw std::runtime_error("failed to allocate bindless object, object buffer is full!");
+        }
+        return m_objectCount++;
+    }
+
+    void BindlessTable::WriteObject(uint32_t frame, uint32_t objectIndex, const ObjectData& objectData)
+    {
+        // Objects write disjoint slots, so recording threads don't need the lock
+        ObjectData* objects = static_cast<ObjectData*>(m_objectBuffersMemory[frame].mapped);
+        memcpy(&objects[objectIndex], &objectData, sizeof(ObjectData));
+    }
+
+    uint32_t BindlessTable::GetObjectBufferIndex(uint32_t frame)
+    {
+        return m_objectBufferIndices[frame];
+    }
+
+    void BindlessTable::Bind(VkCommandBuffer commandBuffer)
+    {
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 1, 1, &m_descriptorSet, 0, nullptr);
+    }
+
+    VkDescriptorSetLayout& BindlessTable::GetDescriptorSetLayout()
+    {
+        return m_descriptorSetLayout;
+    }
+
+    VkPipelineLayout& BindlessTable::GetPipelineLayout()
+    {
+        return m_pipelineLayout;
+    }
+
+    void BindlessTable::PrintStats()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::cout << "bindless: " << m_textureCount << "/" << VM_BINDLESS_MAX_TEXTURES << " textures, " << m_bufferCount << "/" << VM_BINDLESS_MAX_BUFFERS << " buffers, "
+            << m_objectCount << "/" << VM_BINDLESS_MAX_OBJECTS << " objects" << std::endl;
+    }
+}
\ No newline at end of file
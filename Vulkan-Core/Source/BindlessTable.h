@@ -0,0 +1,64 @@
+#pragma once
+#include "PhysicalDevice.h"
+#include "LogicalDevice.h"
+#include "PipelineRegistry.h"
+#include "Structs.h"
+
+#define GLFW_INCLUDE_VULKAN
+#include <glfw3.h>
+
+#include <vector>
+#include <mutex>
+
+
+namespace VCore
+{
+	class Texture;
+
+	// Refer to - https://docs.vulkan.org/samples/latest/samples/extensions/descriptor_indexing/README.html
+	// One global descriptor set (set 1, after FrameConstants' set 0) holding every texture (binding 0) and storage buffer (binding 1) in big partially bound arrays, bound once per command buffer.
+	// Draws pick their texture and object data by index through push constants (BindlessPushConstants) instead of binding a descriptor set per object.
+	// Needs Vulkan 1.2 descriptor indexing (PhysicalDevice::SupportsBindless). Per object data lives in one storage buffer per frame in flight, registered in the buffer array like any other buffer.
+	class BindlessTable
+	{
+	public:
+		BindlessTable();
+		~BindlessTable();
+
+		void Init(uint32_t framesInFlight, VkDescriptorSetLayout frameSetLayout, PipelineRegistry& pipelineRegistry, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
+		// Before pipelineRegistry's Cleanup, the set layout belongs to the registry
+		void Cleanup(PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice);
+
+		// Returns the texture's index into the texture array. Safe while frames are in flight (update after bind)
+		uint32_t RegisterTexture(Texture& texture, LogicalDevice& logicalDevice);
+		// Returns the buffer's index into the storage buffer array
+		uint32_t RegisterBuffer(VkBuffer buffer, VkDeviceSize size, LogicalDevice& logicalDevice);
+		// Reserves a slot in the per frame object data buffers
+		uint32_t AllocateObject();
+		void WriteObject(uint32_t frame, uint32_t objectIndex, const ObjectData& objectData);
+		uint32_t GetObjectBufferIndex(uint32_t frame);
+
+		void Bind(VkCommandBuffer commandBuffer);
+		VkDescriptorSetLayout& GetDescriptorSetLayout();
+		// Every bindless pipeline layout is compatible with this one (same set layouts and push constant range), so it's used to bind the set
+		VkPipelineLayout& GetPipelineLayout();
+		void PrintStats();
+
+	private:
+		void CreateDescriptorSetLayout(VkDescriptorSetLayout frameSetLayout, PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice);
+		void CreateDescriptorSet(LogicalDevice& logicalDevice);
+		void CreateObjectBuffers(uint32_t framesInFlight, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
+
+		VkDescriptorSetLayout m_descriptorSetLayout;
+		VkDescriptorPool m_descriptorPool;
+		VkDescriptorSet m_descriptorSet;
+		VkPipelineLayout m_pipelineLayout;
+		std::vector<VkBuffer> m_objectBuffers; // [frame in flight]
+		std::vector<Allocation> m_objectBuffersMemory;
+		std::vector<uint32_t> m_objectBufferIndices;
+		uint32_t m_textureCount;
+		uint32_t m_bufferCount;
+		uint32_t m_objectCount;
+		std::mutex m_mutex;
+	};
+}
@@ -0,0 +1,82 @@
+#include "Camera.h"
+
+#include <gtc/matrix_transform.hpp>
+
+
+namespace VCore
+{
+    Camera::Camera()
+    {
+        // The view the renderer has always had
+        m_position = glm::vec3(2.0f, 2.0f, 2.0f);
+        m_target = glm::vec3(0.0f, 0.0f, 0.0f);
+        m_up = glm::vec3(0.0f, 0.0f, 1.0f);
+        m_fovY = 45.0f;
+        m_nearPlane = 0.1f;
+        m_farPlane = 10.0f;
+        m_aspectRatio = 0.0f;
+    }
+
+    Camera::~Camera()
+    {
+    }
+
+    void Camera::LookAt(glm::vec3 position, glm::vec3 target, glm::vec3 up)
+    {
+        m_position = position;
+        m_target = target;
+        m_up = up;
+    }
+
+    void Camera::SetPosition(glm::vec3 position)
+    {
+        m_position = position;
+    }
+
+    void Camera::SetTarget(glm::vec3 target)
+    {
+        m_target = target;
+    }
+
+    void Camera::SetPerspective(float fovYDegrees, float nearPlane, float farPlane)
+    {
+        m_fovY = fovYDegrees;
+        m_nearPlane = nearPlane;
+        m_farPlane = farPlane;
+    }
+
+    void Camera::SetAspectRatio(float aspectRatio)
+    {
+        m_aspectRatio = aspectRatio;
+    }
+
+    glm::vec3 Camera::GetPosition()
+    {
+        return m_position;
+    }
+
+    glm::mat4 Camera::GetView()
+    {
+        return glm::lookAt(m_position, m_target, m_up);
+    }
+
+    glm::mat4 Camera::GetProjection(float aspectRatio)
+    {
+        // Refer to - https://vulkan-tutorial.com/en/Uniform_buffers/Descriptor_layout_and_buffer
+        glm::mat4 proj = glm::perspective(glm::radians(m_fovY), aspectRatio, m_nearPlane, m_farPlane);
+        proj[1][1] *= -1; // GLM was designed for OpenGL, where the Y coordinate of the clip coordinates is inverted
+        return proj;
+    }
+
+    CameraData Camera::GetCameraData(VkExtent2D extent)
+    {
+        float f_aspectRatio = m_aspectRatio > 0.0f ? m_aspectRatio : extent.width / (float)extent.height;
+
+        CameraData cameraData{};
+        cameraData.view = GetView();
+        cameraData.proj = GetProjection(f_aspectRatio);
+        cameraData.viewProj = cameraData.proj * cameraData.view;
+        cameraData.position = glm::vec4(m_position, 1.0f);
+        return cameraData;
+    }
+}
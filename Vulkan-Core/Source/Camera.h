@@ -0,0 +1,39 @@
+#pragma once
+#include "Structs.h"
+
+#define GLFW_INCLUDE_VULKAN
+#include <glfw3.h>
+#include <glm.hpp>
+
+
+namespace VCore
+{
+	// Refer to - https://learnopengl.com/Getting-started/Camera
+	// View and projection for the frame. Turned into a CameraData block once per frame (FrameConstants) instead of being recomputed for every object.
+	class Camera
+	{
+	public:
+		Camera();
+		~Camera();
+
+		void LookAt(glm::vec3 position, glm::vec3 target, glm::vec3 up = glm::vec3(0.0f, 0.0f, 1.0f));
+		void SetPosition(glm::vec3 position);
+		void SetTarget(glm::vec3 target);
+		void SetPerspective(float fovYDegrees, float nearPlane, float farPlane);
+		// 0 (the default) follows the aspect ratio of whatever is being rendered to
+		void SetAspectRatio(float aspectRatio);
+		glm::vec3 GetPosition();
+		glm::mat4 GetView();
+		glm::mat4 GetProjection(float aspectRatio);
+		CameraData GetCameraData(VkExtent2D extent);
+
+	private:
+		glm::vec3 m_position;
+		glm::vec3 m_target;
+		glm::vec3 m_up;
+		float m_fovY; // degrees
+		float m_nearPlane;
+		float m_farPlane;
+		float m_aspectRatio;
+	};
+}
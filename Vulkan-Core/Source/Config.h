@@ -0,0 +1,33 @@
+#pragma once
+#define GLFW_INCLUDE_VULKAN
+#include <glfw3.h>
+
+#include <cstdint>
+
+
+namespace VCore
+{
+	// Tuning constants shared across the engine. Kept apart from VulkanManager.h so the lower level modules (ie. device selection) can read them without pulling in the whole manager
+	const int VM_MAX_FRAMES_IN_FLIGHT = 2;
+	const float VM_HEADLESS_TIME_STEP = 1.0f / 60.0f; // seconds VM_elapsedTime moves on per headless frame
+	const VkDeviceSize VM_STAGING_RING_SIZE = 32ull * 1024 * 1024; // staging memory shared by all asset uploads, bigger uploads get their own temporary buffer
+	const char* const VM_PIPELINE_CACHE_PATH = "pipeline.cache"; // saved next to the working directory on shutdown, reused if the same driver and device load it
+	const uint32_t VM_GEOMETRY_PAGE_VERTICES = 1 << 20; // vertices and indices per GeometryArena page, meshes bigger than that get a page of their own
+	const uint32_t VM_GEOMETRY_PAGE_INDICES = 3 << 20;
+	const uint32_t VM_IMPORT_CORNERS_PER_JOB = 1 << 16; // face corners deduplicated per job when importing meshes
+	const uint32_t VM_PIPELINE_COMPILE_THREADS = 2; // background threads building material pipelines, kept apart from the draw recording threads
+	const uint32_t VM_DESCRIPTOR_POOL_INITIAL_SETS = 64; // sets in the first descriptor pool, each new pool doubles up to VM_DESCRIPTOR_POOL_MAX_SETS
+	const uint32_t VM_DESCRIPTOR_POOL_MAX_SETS = 4096;
+	const uint32_t VM_BINDLESS_MAX_TEXTURES = 4096; // sizes of the bindless descriptor arrays and per frame object buffers
+	const uint32_t VM_BINDLESS_MAX_BUFFERS = 1024;
+	const uint32_t VM_BINDLESS_MAX_OBJECTS = 65536;
+	const VkDeviceSize VM_UNIFORM_RING_SIZE = 1024 * 1024; // per frame in flight uniform data (the frame's CameraData). Per object transforms are pushed instead, so this no longer grows with the scene
+	const uint32_t VM_MAX_INSTANCES_PER_DRAW = 16384; // instanced batches bigger than this are split, so a big batch is still recorded across several threads
+	const uint32_t VM_NO_TRANSFORM = UINT32_MAX; // GameObjects not registered with the TransformSystem
+	const uint32_t VM_TRANSFORMS_PER_JOB = 16384; // world matrices built per job when a TransformSystem batch is split across threads
+	const uint32_t VM_CULL_OBJECTS_PER_JOB = 4096; // bounding spheres tested per job when frustum culling is split across threads
+	const uint32_t VM_OCCLUSION_WIDTH = 256; // default width of the software occlusion depth buffer, its height follows the window's aspect ratio
+	const float VM_LOD_ERROR_PIXELS = 1.0f; // default LodSelector error budget, how many pixels a coarser LOD may be off by on screen
+	const float VM_LOD_MAX_ERROR_RATIO = 0.1f; // LODs are built until their error would pass this share of the mesh's bounding radius
+	const uint32_t VM_DRAWS_PER_JOB = 64; // game objects recorded per job when splitting draw recording across threads - big enough that queueing a job costs much less than the recording itself
+}
@@ -0,0 +1,273 @@
+#include "DepthPyramid.h"
+#include "Helper.h"
+#include "Structs.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <array>
+
+
+namespace VCore
+{
+    DepthPyramid::DepthPyramid()
+    {
+        m_descriptorSetLayout = VK_NULL_HANDLE;
+        m_pipelineLayout = VK_NULL_HANDLE;
+        m_pipeline = VK_NULL_HANDLE;
+        m_sampler = VK_NULL_HANDLE;
+        m_image = VK_NULL_HANDLE;
+        m_imageMemory = Allocation();
+        m_imageView = VK_NULL_HANDLE;
+        m_levelViews = std::vector<VkImageView>();
+        m_descriptorSets = std::vector<VkDescriptorSet>();
+        m_width = 0;
+        m_height = 0;
+        m_levelCount = 0;
+        m_sampleCount = 1;
+        m_depthAspects = VK_IMAGE_ASPECT_DEPTH_BIT;
+    }
+
+    DepthPyramid::~DepthPyramid()
+    {
+    }
+
+    void DepthPyramid::Init(const std::string& shaderPath, const std::string& multisampledShaderPath, WinSys& winSystem, PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice)
+    {
+        // See Shaders/depth_pyramid.comp
+        std::vector<VkDescriptorSetLayoutBinding> bindings(3);
+        for (uint32_t i = 0; i < bindings.size(); i++)
+        {
+            bindings[i].binding = i;
+            bindings[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            bindings[i].descriptorCount = 1;
+            bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+            bindings[i].pImmutableSamplers = nullptr;
+        }
+        m_descriptorSetLayout = pipelineRegistry.AcquireDescriptorSetLayout(bindings, logicalDevice);
+
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(DepthPyramidPushConstants);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &m_descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+        if (vkCreatePipelineLayout(logicalDevice.GetDevice(), &pipelineLayoutInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create depth pyramid pipeline layout!");
+        }
+
+        // A multisampled attachment can only be read as a sampler2DMS, so it needs its own build of the shader
+        m_pipeline = pipelineRegistry.CreateComputePipeline(winSystem.GetMsaa() != VK_SAMPLE_COUNT_1_BIT ? multisampledShaderPath : shaderPath, m_pipelineLayout, logicalDevice);
+
+        // Only ever read with texelFetch, but combined image samplers still need one
+        VkSamplerCreateInfo samplerInfo{};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = VK_FILTER_NEAREST;
+        samplerInfo.minFilter = VK_FILTER_NEAREST;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.minLod = 0.0f;
+        samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+        if (vkCreateSampler(logicalDevice.GetDevice(), &samplerInfo, nullptr, &m_sampler) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create depth pyramid sampler!");
+        }
+    }
+
+    void DepthPyramid::Create(WinSys& winSystem, DescriptorAllocator& descriptorAllocator, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice)
+    {
+        DestroyImage(logicalDevice);
+
+        m_width = winSystem.GetExtent().width;
+        m_height = winSystem.GetExtent().height;
+        m_levelCount = 1;
+        while ((std::max(m_width, m_height) >> m_levelCount) > 0)
+        {
+            m_levelCount++;
+        }
+        m_sampleCount = static_cast<uint32_t>(winSystem.GetMsaa());
+        m_depthAspects = VK_IMAGE_ASPECT_DEPTH_BIT;
+        if (Helper::HasStencilComponent(Helper::FindDepthFormat(physicalDevice.GetDevice())))
+        {
+            m_depthAspects |= VK_IMAGE_ASPECT_STENCIL_BIT;
+        }
+
+        winSystem.CreateImage(m_width, m_height, m_levelCount, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_image, m_imageMemory, physicalDevice, logicalDevice);
+        m_imageView = winSystem.CreateImageView(m_image, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, m_levelCount, logicalDevice);
+
+        m_levelViews.resize(m_levelCount);
+        for (uint32_t level = 0; level < m_levelCount; level++)
+        {
+            VkImageViewCreateInfo viewInfo{};
+            viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            viewInfo.image = m_image;
+            viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            viewInfo.format = VK_FORMAT_R32_SFLOAT;
+            viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            viewInfo.subresourceRange.baseMipLevel = level;
+            viewInfo.subresourceRange.levelCount = 1;
+            viewInfo.subresourceRange.baseArrayLayer = 0;
+            viewInfo.subresourceRange.layerCount = 1;
+
+            if (vkCreateImageView(logicalDevice.GetDevice(), &viewInfo, nullptr, &m_levelViews[level]) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create depth pyramid level view!");
+            }
+        }
+
+        // Level 0 reads the attachment, every other level the one before it. The source binding of level 0 is never read, it just needs something valid.
+        // Sets are kept and rewritten across Creates, the new views can reuse the destroyed ones' handles
+        while (m_descriptorSets.size() < m_levelCount)
+        {
+            m_descriptorSets.push_back(descriptorAllocator.Allocate(m_descriptorSetLayout, logicalDevice));
+        }
+        for (uint32_t level = 0; level < m_levelCount; level++)
+        {
+            std::vector<DescriptorBinding> bindings(3);
+            bindings[0].binding = 0;
+            bindings[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            bindings[0].imageView = winSystem.GetDepthImageView();
+            bindings[0].sampler = m_sampler;
+            bindings[0].imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+            bindings[1].binding = 1;
+            bindings[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            bindings[1].imageView = m_levelViews[level > 0 ? level - 1 : 0];
+            bindings[1].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+            bindings[2].binding = 2;
+            bindings[2].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            bindings[2].imageView = m_levelViews[level];
+            bindings[2].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+            descriptorAllocator.Update(m_descriptorSets[level], bindings, logicalDevice);
+        }
+    }
+
+    void DepthPyramid::DestroyImage(LogicalDevice& logicalDevice)
+    {
+        for (VkImageView view : m_levelViews)
+        {
+            vkDestroyImageView(logicalDevice.GetDevice(), view, nullptr);
+        }
+        m_levelViews.clear();
+
+        if (m_image != VK_NULL_HANDLE)
+        {
+            vkDestroyImageView(logicalDevice.GetDevice(), m_imageView, nullptr);
+            vkDestroyImage(logicalDevice.GetDevice(), m_image, nullptr);
+            logicalDevice.GetAllocator().Free(m_imageMemory);
+            m_imageView = VK_NULL_HANDLE;
+            m_image = VK_NULL_HANDLE;
+        }
+    }
+
+    void DepthPyramid::Cleanup(PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice)
+    {
+        DestroyImage(logicalDevice);
+        vkDestroySampler(logicalDevice.GetDevice(), m_sampler, nullptr);
+        vkDestroyPipeline(logicalDevice.GetDevice(), m_pipeline, nullptr);
+        vkDestroyPipelineLayout(logicalDevice.GetDevice(), m_pipelineLayout, nullptr);
+        pipelineRegistry.ReleaseDescriptorSetLayout(m_descriptorSetLayout, logicalDevice);
+        m_sampler = VK_NULL_HANDLE;
+        m_pipeline = VK_NULL_HANDLE;
+        m_pipelineLayout = VK_NULL_HANDLE;
+        m_descriptorSetLayout = VK_NULL_HANDLE;
+    }
+
+    void DepthPyramid::Record(VkCommandBuffer commandBuffer, WinSys& winSystem)
+    {
+        // Refer to - https://docs.vulkan.org/guide/latest/synchronization_examples.html
+        // The depth attachment becomes readable once the render pass' depth writes are done. The pyramid's old contents don't matter,
+        // but the last frame's culling may still be reading them
+        std::array<VkImageMemoryBarrier, 2> barriers{};
+        barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barriers[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barriers[0].oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        barriers[0].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[0].image = winSystem.GetDepthImage();
+        barriers[0].subresourceRange = { m_depthAspects, 0, 1, 0, 1 };
+
+        barriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barriers[1].srcAccessMask = 0;
+        barriers[1].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barriers[1].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[1].image = m_image;
+        barriers[1].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, m_levelCount, 0, 1 };
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+
+        // Every level needs the one before it finished
+        VkMemoryBarrier levelBarrier{};
+        levelBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        levelBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        levelBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        for (uint32_t level = 0; level < m_levelCount; level++)
+        {
+            DepthPyramidPushConstants pushConstants{};
+            pushConstants.sourceWidth = level > 0 ? std::max(m_width >> (level - 1), 1u) : m_width;
+            pushConstants.sourceHeight = level > 0 ? std::max(m_height >> (level - 1), 1u) : m_height;
+            pushConstants.width = std::max(m_width >> level, 1u);
+            pushConstants.height = std::max(m_height >> level, 1u);
+            pushConstants.level = level;
+            pushConstants.sampleCount = m_sampleCount;
+
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &m_descriptorSets[level], 0, nullptr);
+            vkCmdPushConstants(commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(DepthPyramidPushConstants), &pushConstants);
+            vkCmdDispatch(commandBuffer, (pushConstants.width + 7) / 8, (pushConstants.height + 7) / 8, 1); // local_size 8x8
+
+            // The last one makes the whole pyramid visible to the culling shader
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &levelBarrier, 0, nullptr, 0, nullptr);
+        }
+
+        // Back to an attachment for the rest of the frame's draws
+        barriers[0].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barriers[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        barriers[0].oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        barriers[0].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &barriers[0]);
+    }
+
+    VkImageView& DepthPyramid::GetImageView()
+    {
+        return m_imageView;
+    }
+
+    VkSampler& DepthPyramid::GetSampler()
+    {
+        return m_sampler;
+    }
+
+    uint32_t DepthPyramid::GetWidth()
+    {
+        return m_width;
+    }
+
+    uint32_t DepthPyramid::GetHeight()
+    {
+        return m_height;
+    }
+
+    uint32_t DepthPyramid::GetLevelCount()
+    {
+        return m_levelCount;
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "PhysicalDevice.h"
+#include "LogicalDevice.h"
+#include "MemoryAllocator.h"
+#include "DescriptorAllocator.h"
+#include "PipelineRegistry.h"
+#include "WinSys.h"
+
+#define GLFW_INCLUDE_VULKAN
+#include <glfw3.h>
+
+#include <vector>
+#include <string>
+
+
+namespace VCore
+{
+	// Refer to - https://www.rastergrid.com/blog/2010/10/hierarchical-z-map-based-occlusion-culling/
+	// Mip chain of the depth attachment where every texel holds the farthest depth below it, built by a compute shader (Shaders/depth_pyramid.comp) one level per dispatch.
+	// Level 0 matches the attachment's size (the farthest of its samples when multisampled). Used by the GpuCuller to cull instances hidden behind what's already been drawn.
+	// One pyramid shared by every frame in flight, rebuilt from scratch each time it's recorded.
+	class DepthPyramid
+	{
+	public:
+		DepthPyramid();
+		~DepthPyramid();
+
+		// Creates the reduction pipeline - shaderPath reads a single sampled depth attachment, multisampledShaderPath a multisampled one
+		void Init(const std::string& shaderPath, const std::string& multisampledShaderPath, WinSys& winSystem, PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice);
+		// (Re)creates the pyramid to fit winSystem's depth attachment. Call again once the swap chain has been recreated, while the GPU is idle
+		void Create(WinSys& winSystem, DescriptorAllocator& descriptorAllocator, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
+		void Cleanup(PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice);
+
+		// Records building every level from the depth drawn so far. Outside a render pass, the depth attachment is expected in and left in DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+		void Record(VkCommandBuffer commandBuffer, WinSys& winSystem);
+
+		// Every level, in VK_IMAGE_LAYOUT_GENERAL. Read it with texelFetch
+		VkImageView& GetImageView();
+		VkSampler& GetSampler();
+		uint32_t GetWidth();
+		uint32_t GetHeight();
+		uint32_t GetLevelCount();
+
+	private:
+		void DestroyImage(LogicalDevice& logicalDevice);
+
+		VkDescriptorSetLayout m_descriptorSetLayout;
+		VkPipelineLayout m_pipelineLayout;
+		VkPipeline m_pipeline;
+		VkSampler m_sampler; // nearest, for the depth attachment and the pyramid
+		VkImage m_image;
+		Allocation m_imageMemory;
+		VkImageView m_imageView;
+		std::vector<VkImageView> m_levelViews; // [level], written as storage images
+		std::vector<VkDescriptorSet> m_descriptorSets; // [level] (at least), owned by the DescriptorAllocator
+		uint32_t m_width;
+		uint32_t m_height;
+		uint32_t m_levelCount;
+		uint32_t m_sampleCount; // of the depth attachment
+		VkImageAspectFlags m_depthAspects; // depth, and stencil if the depth format has it (layout transitions need both)
+	};
+}
@@ -0,0 +1,292 @@
+#include "DescriptorAllocator.h"
+#include "VulkanManager.h"
+#include "Helper.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <algorithm>
+
+
+namespace VCore
+{
+    DescriptorAllocator::DescriptorAllocator()
+    {
+        m_persistentPools = std::vector<VkDescriptorPool>();
+        m_framePools = std::vector<std::vector<VkDescriptorPool>>();
+        m_freePools = std::vector<VkDescriptorPool>();
+        m_setCache = std::unordered_map<uint64_t, std::vector<CachedSet>>();
+        m_setsPerPool = VM_DESCRIPTOR_POOL_INITIAL_SETS;
+        m_poolsCreated = 0;
+        m_poolsRecycled = 0;
+        m_setsAllocated = 0;
+        m_transientSetsAllocated = 0;
+        m_cacheHits = 0;
+        m_hashCollisions = 0;
+        m_setsInvalidated = 0;
+    }
+
+    DescriptorAllocator::~DescriptorAllocator()
+    {
+    }
+
+    void DescriptorAllocator::Init(uint32_t framesInFlight)
+    {
+        m_framePools.resize(framesInFlight);
+    }
+
+    void DescriptorAllocator::Cleanup(LogicalDevice& logicalDevice)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Destroying a pool frees every set allocated from it
+        for (VkDescriptorPool pool : m_persistentPools)
+        {
+            vkDestroyDescriptorPool(logicalDevice.GetDevice(), pool, nullptr);
+        }
+        for (std::vector<VkDescriptorPool>& pools : m_framePools)
+        {
+            for (VkDescriptorPool pool : pools)
+            {
+                vkDestroyDescriptorPool(logicalDevice.GetDevice(), pool, nullptr);
+            }
+            pools.clear();
+        }
+        for (VkDescriptorPool pool : m_freePools)
+        {
+            vkDestroyDescriptorPool(logicalDevice.GetDevice(), pool, nullptr);
+        }
+
+        m_persistentPools.clear();
+        m_freePools.clear();
+        m_setCache.clear();
+    }
+
+    VkDescriptorSet DescriptorAllocator::GetOrCreateSet(VkDescriptorSetLayout layout, const std::vector<DescriptorBinding>& bindings, LogicalDevice& logicalDevice)
+    {
+        // Key on the layout and every bound resource, handles are cast to integers so this works whether they're pointers or uint64_t. Invalidate depends on this layout
+        std::vector<uint64_t> keyData;
+        keyData.push_back((uint64_t)layout);
+        for (const DescriptorBinding& binding : bindings)
+        {
+            keyData.insert(keyData.end(), { binding.binding, static_cast<uint64_t>(binding.type), (uint64_t)binding.buffer, binding.offset, binding.range, (uint64_t)binding.imageView, (uint64_t)binding.sampler, static_cast<uint64_t>(binding.imageLayout) });
+        }
+        uint64_t key = Helper::Hash64(keyData.data(), keyData.size() * sizeof(uint64_t));
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::vector<CachedSet>& cachedSets = m_setCache[key];
+        for (const CachedSet& cachedSet : cachedSets)
+        {
+            if (cachedSet.keyData == keyData)
+            {
+                m_cacheHits++;
+                return cachedSet.descriptorSet;
+            }
+        }
+        if (!cachedSets.empty())
+        {
+            m_hashCollisions++;
+        }
+
+        VkDescriptorSet descriptorSet = AllocateFrom(m_persistentPools, layout, logicalDevice);
+        WriteSet(descriptorSet, bindings, logicalDevice);
+        cachedSets.push_back({ std::move(keyData), descriptorSet });
+        m_setsAllocated++;
+
+        return descriptorSet;
+    }
+
+    void DescriptorAllocator::Invalidate(uint64_t handle)
+    {
+        // Unused fields of every binding are null, a null handle would match them all
+        if (handle == 0)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Destroying resources is rare, so a walk over the whole cache is fine. Only the buffer, image view and sampler of each binding are compared (the layout comes first,
+        // then 8 values per binding as written by GetOrCreateSet), so a matching offset or range never counts
+        for (auto bucket = m_setCache.begin(); bucket != m_setCache.end();)
+        {
+            std::vector<CachedSet>& cachedSets = bucket->second;
+            auto end = std::remove_if(cachedSets.begin(), cachedSets.end(), [handle](const CachedSet& cachedSet)
+            {
+                for (size_t i = 1; i + 8 <= cachedSet.keyData.size(); i += 8)
+                {
+                    if (cachedSet.keyData[i + 2] == handle || cachedSet.keyData[i + 5] == handle || cachedSet.keyData[i + 6] == handle)
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            });
+            m_setsInvalidated += cachedSets.end() - end;
+            cachedSets.erase(end, cachedSets.end());
+
+            if (cachedSets.empty())
+            {
+                bucket = m_setCache.erase(bucket);
+            }
+            else
+            {
+                bucket++;
+            }
+        }
+    }
+
+    VkDescriptorSet DescriptorAllocator::Allocate(VkDescriptorSetLayout layout, LogicalDevice& logicalDevice)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_setsAllocated++;
+        return AllocateFrom(m_persistentPools, layout, logicalDevice);
+    }
+
+    void DescriptorAllocator::Update(VkDescriptorSet descriptorSet, const std::vector<DescriptorBinding>& bindings, LogicalDevice& logicalDevice)
+    {
+        WriteSet(descriptorSet, bindings, logicalDevice);
+    }
+
+    VkDescriptorSet DescriptorAllocator::AllocateTransient(uint32_t frame, VkDescriptorSetLayout layout, LogicalDevice& logicalDevice)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_transientSetsAllocated++;
+        return AllocateFrom(m_framePools[frame], layout, logicalDevice);
+    }
+
+    void DescriptorAllocator::ResetFrame(uint32_t frame, LogicalDevice& logicalDevice)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // One reset returns every set in the pool, much cheaper than freeing sets one by one
+        for (VkDescriptorPool pool : m_framePools[frame])
+        {
+            vkResetDescriptorPool(logicalDevice.GetDevice(), pool, 0);
+            m_freePools.push_back(pool);
+            m_poolsRecycled++;
+        }
+        m_framePools[frame].clear();
+    }
+
+    VkDescriptorSet DescriptorAllocator::AllocateFrom(std::vector<VkDescriptorPool>& pools, VkDescriptorSetLayout layout, LogicalDevice& logicalDevice)
+    {
+        if (pools.empty())
+        {
+            pools.push_back(GetFreePool(logicalDevice));
+        }
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = pools.back();
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &layout;
+
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        VkResult result = vkAllocateDescriptorSets(logicalDevice.GetDevice(), &allocInfo, &descriptorSet);
+
+        // A full pool reports VK_ERROR_OUT_OF_POOL_MEMORY or VK_ERROR_FRAGMENTED_POOL (Vulkan 1.0 drivers without maintenance1 may report an out of memory error instead),
+        // so any failure gets one more try from a fresh pool
+        if (result != VK_SUCCESS)
+        {
+            pools.push_back(GetFreePool(logicalDevice));
+            allocInfo.descriptorPool = pools.back();
+            if (vkAllocateDescriptorSets(logicalDevice.GetDevice(), &allocInfo, &descriptorSet) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to allocate descriptor sets!");
+            }
+        }
+
+        return descriptorSet;
+    }
+
+    VkDescriptorPool DescriptorAllocator::GetFreePool(LogicalDevice& logicalDevice)
+    {
+        if (!m_freePools.empty())
+        {
+            VkDescriptorPool pool = m_freePools.back();
+            m_freePools.pop_back();
+            return pool;
+        }
+
+        VkDescriptorPool pool = CreatePool(m_setsPerPool, logicalDevice);
+        // Each new pool is bigger than the last, so a scene with lots of objects ends up with a handful of big pools rather than many small ones
+        m_setsPerPool = std::min(m_setsPerPool * 2, VM_DESCRIPTOR_POOL_MAX_SETS);
+        return pool;
+    }
+
+    VkDescriptorPool DescriptorAllocator::CreatePool(uint32_t setCount, LogicalDevice& logicalDevice)
+    {
+        // Refer to - https://vulkan-tutorial.com/en/Uniform_buffers/Descriptor_pool_and_sets
+        // Sized for the descriptor types materials (and the GpuCuller's and DepthPyramid's storage buffers and images) use, per set. Sets with more samplers than this just fill the pool sooner
+        std::vector<VkDescriptorPoolSize> poolSizes =
+        {
+            { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, setCount },
+            { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, setCount },
+            { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, setCount },
+            { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, setCount },
+            { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, setCount * 2 }
+        };
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        poolInfo.pPoolSizes = poolSizes.data();
+        poolInfo.maxSets = setCount;
+
+        VkDescriptorPool pool = VK_NULL_HANDLE;
+        if (vkCreateDescriptorPool(logicalDevice.GetDevice(), &poolInfo, nullptr, &pool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create descriptor pool!");
+        }
+        m_poolsCreated++;
+
+        return pool;
+    }
+
+    void DescriptorAllocator::WriteSet(VkDescriptorSet descriptorSet, const std::vector<DescriptorBinding>& bindings, LogicalDevice& logicalDevice)
+    {
+        // Refer to - https://vulkan-tutorial.com/en/Uniform_buffers/Descriptor_pool_and_sets
+        // Infos are sized up front, the writes point into them
+        std::vector<VkDescriptorBufferInfo> bufferInfos(bindings.size());
+        std::vector<VkDescriptorImageInfo> imageInfos(bindings.size());
+        std::vector<VkWriteDescriptorSet> descriptorWrites(bindings.size());
+
+        for (size_t i = 0; i < bindings.size(); i++)
+        {
+            const DescriptorBinding& binding = bindings[i];
+
+            descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptorWrites[i].dstSet = descriptorSet;
+            descriptorWrites[i].dstBinding = binding.binding;
+            descriptorWrites[i].dstArrayElement = 0;
+            descriptorWrites[i].descriptorType = binding.type;
+            descriptorWrites[i].descriptorCount = 1;
+
+            if (binding.type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER || binding.type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)
+            {
+                imageInfos[i].imageLayout = binding.imageLayout;
+                imageInfos[i].imageView = binding.imageView;
+                imageInfos[i].sampler = binding.sampler;
+                descriptorWrites[i].pImageInfo = &imageInfos[i];
+            }
+            else
+            {
+                bufferInfos[i].buffer = binding.buffer;
+                bufferInfos[i].offset = binding.offset;
+                bufferInfos[i].range = binding.range;
+                descriptorWrites[i].pBufferInfo = &bufferInfos[i];
+            }
+        }
+
+        vkUpdateDescriptorSets(logicalDevice.GetDevice(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+    }
+
+    void DescriptorAllocator::PrintStats()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::cout << "descriptors: " << m_setsAllocated << " sets allocated, " << m_cacheHits << " reused from the cache (" << m_hashCollisions << " hash collisions), " << m_setsInvalidated << " invalidated, " << m_transientSetsAllocated << " transient, "
+            << m_poolsCreated << " pools created, " << m_poolsRecycled << " pool resets" << std::endl;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+#include "LogicalDevice.h"
+
+#define GLFW_INCLUDE_VULKAN
+#include <glfw3.h>
+
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+
+namespace VCore
+{
+	// One resource bound to a descriptor set, either a buffer range or an image view + sampler depending on type
+	struct DescriptorBinding
+	{
+		uint32_t binding = 0;
+		VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize range = 0;
+		VkImageView imageView = VK_NULL_HANDLE;
+		VkSampler sampler = VK_NULL_HANDLE;
+		VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL; // layout the image is in whenever the set is used
+	};
+
+	// Hands out descriptor sets from a shared, growing list of VkDescriptorPools instead of a pool per GameObject.
+	// Persistent sets live until Cleanup and are cached on their layout + bindings, so objects with the same material and resources get the same set back.
+	// Transient sets come from per frame in flight pools that are reset in one call once that frame's fence has been waited on.
+	// Thread safe.
+	class DescriptorAllocator
+	{
+	public:
+		DescriptorAllocator();
+		~DescriptorAllocator();
+
+		void Init(uint32_t framesInFlight);
+		void Cleanup(LogicalDevice& logicalDevice);
+
+		// Returns the set already written with these bindings, or allocates and writes a new one
+		VkDescriptorSet GetOrCreateSet(VkDescriptorSetLayout layout, const std::vector<DescriptorBinding>& bindings, LogicalDevice& logicalDevice);
+		VkDescriptorSet Allocate(VkDescriptorSetLayout layout, LogicalDevice& logicalDevice);
+		// Drops every cached set written with handle (a VkBuffer, VkImageView or VkSampler cast to uint64_t). Call before destroying anything GetOrCreateSet has seen, or a new
+		// resource that gets the same handle back would be handed the old set. The sets stay allocated until Cleanup, persistent pools can't free single sets
+		void Invalidate(uint64_t handle);
+		// (Re)writes a set from Allocate or AllocateTransient. No frame using it can be in flight
+		void Update(VkDescriptorSet descriptorSet, const std::vector<DescriptorBinding>& bindings, LogicalDevice& logicalDevice);
+		// Only valid until ResetFrame(frame) is called again
+		VkDescriptorSet AllocateTransient(uint32_t frame, VkDescriptorSetLayout layout, LogicalDevice& logicalDevice);
+		// Call after waiting on frame's fence, recycles every pool its transient sets came from
+		void ResetFrame(uint32_t frame, LogicalDevice& logicalDevice);
+		void PrintStats();
+
+	private:
+		VkDescriptorPool GetFreePool(LogicalDevice& logicalDevice);
+		VkDescriptorPool CreatePool(uint32_t setCount, LogicalDevice& logicalDevice);
+		// Allocates from the last pool in pools, moving on to a fresh pool when it runs out
+		VkDescriptorSet AllocateFrom(std::vector<VkDescriptorPool>& pools, VkDescriptorSetLayout layout, LogicalDevice& logicalDevice);
+		static void WriteSet(VkDescriptorSet descriptorSet, const std::vector<DescriptorBinding>& bindings, LogicalDevice& logicalDevice);
+
+		// The layout and bindings a cached set was written with, compared in full on lookup so two sets whose keys hash the same are never mixed up
+		struct CachedSet
+		{
+			std::vector<uint64_t> keyData;
+			VkDescriptorSet descriptorSet;
+		};
+
+		std::vector<VkDescriptorPool> m_persistentPools;
+		std::vector<std::vector<VkDescriptorPool>> m_framePools; // [frame in flight]
+		std::vector<VkDescriptorPool> m_freePools; // reset and ready for reuse
+		std::unordered_map<uint64_t, std::vector<CachedSet>> m_setCache; // every set whose key hashes to the same value
+		uint32_t m_setsPerPool; // grows with each new pool
+		std::mutex m_mutex;
+
+		// stats
+		uint32_t m_poolsCreated;
+		uint32_t m_poolsRecycled;
+		uint64_t m_setsAllocated;
+		uint64_t m_transientSetsAllocated;
+		uint64_t m_cacheHits;
+		uint64_t m_hashCollisions;
+		uint64_t m_setsInvalidated;
+	};
+}
@@ -0,0 +1,207 @@
+#include "DrawList.h"
+#include "GameObject.h"
+#include "VulkanManager.h"
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+
+namespace VCore
+{
+    // Key layout, most significant first
+    static const uint32_t PIPELINE_BITS = 12;
+    static const uint32_t DESCRIPTOR_SET_BITS = 16;
+    static const uint32_t MESH_BITS = 16;
+    static const uint32_t DEPTH_BITS = 20;
+
+    DrawList::DrawList()
+    {
+        m_unsorted = std::vector<DrawItem>();
+        m_draws = std::vector<DrawItem>();
+        m_keys = std::vector<uint64_t>();
+        m_sortKeys = std::vector<uint64_t>();
+        m_sortIndices = std::vector<uint32_t>();
+        m_tempKeys = std::vector<uint64_t>();
+        m_tempIndices = std::vector<uint32_t>();
+        m_pipelineIds = std::unordered_map<uint64_t, uint32_t>();
+        m_descriptorSetIds = std::unordered_map<uint64_t, uint32_t>();
+        m_meshIds = std::unordered_map<uint64_t, uint32_t>();
+        m_totalStats = BindStats();
+        m_totalDraws = 0;
+        m_sortPasses = 0;
+        m_buildTimeMs = 0.0f;
+        m_frames = 0;
+    }
+
+    DrawList::~DrawList()
+    {
+    }
+
+    void DrawList::Build(std::vector<GameObject>& gameObjects, const std::vector<uint32_t>& visibleObjects, std::vector<InstanceBatch>& batches, bool b_gpuBatches, const glm::mat4& viewProj, glm::vec3 objectOffset, LodSelector& lodSelector)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        m_unsorted.clear();
+        m_keys.clear();
+
+        for (uint32_t index : visibleObjects)
+        {
+            GameObject& object = gameObjects[index];
+
+            // Distance in front of the camera (clip w) of the culling sphere's center. A positive float's bits sort like the float, so its top bits make the depth field
+            glm::vec3 center = object.GetModel().GetMesh()->GetBounds().center + objectOffset;
+            const glm::mat4& model = object.GetModel().GetTransform();
+            float f_depth = (viewProj * (model * glm::vec4(center, 1.0f))).w;
+            uint32_t ui_depthBits = 0;
+            if (f_depth > 0.0f)
+            {
+                std::memcpy(&ui_depthBits, &f_depth, sizeof(float));
+            }
+
+            DrawItem draw;
+            draw.object = &object;
+            draw.lod = lodSelector.SelectLod(object.GetModel().GetMesh()->GetGeometry(), LodSelector::GetScale(model, f_depth));
+            m_unsorted.push_back(draw);
+            m_keys.push_back(MakeKey(object, ui_depthBits >> (32 - DEPTH_BITS - 1))); // the sign bit is always 0
+        }
+
+        for (uint32_t i = 0; i < static_cast<uint32_t>(batches.size()); i++)
+        {
+            // A batch spreads its instances around, so it has no one depth to sort on
+            DrawItem draw;
+            draw.object = batches[i].object;
+            draw.batch = &batches[i];
+            draw.gpuBatch = b_gpuBatches ? i : 0;
+            // The GpuCuller's indirect commands are fixed, only the CPU culled batches know their instances this frame
+            draw.lod = b_gpuBatches ? 0 : lodSelector.SelectLod(batches[i].object->GetModel().GetMesh()->GetGeometry(), batches[i].lodScale);
+            m_unsorted.push_back(draw);
+            m_keys.push_back(MakeKey(*batches[i].object, 0));
+        }
+
+        Sort();
+
+        m_draws.resize(m_unsorted.size());
+        for (size_t i = 0; i < m_sortIndices.size(); i++)
+        {
+            m_draws[i] = m_unsorted[m_sortIndices[i]];
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        m_buildTimeMs += std::chrono::duration<float, std::chrono::milliseconds::period>(end - start).count();
+        m_totalDraws += m_draws.size();
+        m_frames++;
+    }
+
+    uint64_t DrawList::MakeKey(GameObject& object, uint64_t depth)
+    {
+        // The pipeline that will actually be bound, the fallback's while the material's own is compiling. Draws that will be skipped all sort to the end
+        Material* material = object.GetMaterial()->GetDrawMaterial();
+        uint64_t pipeline = material != nullptr ? GetId(m_pipelineIds, (uint64_t)material->GetGraphicsPipeline(), (1u << PIPELINE_BITS) - 2) : (1u << PIPELINE_BITS) - 1;
+        // Bindless materials don't bind a set of their own
+        uint64_t descriptorSet = material != nullptr && material->GetBindlessTable() == nullptr ? GetId(m_descriptorSetIds, (uint64_t)object.GetDescriptorSets()[VM_currentFrame], (1u << DESCRIPTOR_SET_BITS) - 1) : 0;
+        // Draws only bind new vertex and index buffers when they move to another GeometryArena page, so that's what groups them
+        uint64_t mesh = GetId(m_meshIds, (uint64_t)object.GetModel().GetVertexBuffer(), (1u << MESH_BITS) - 1);
+
+        return (pipeline << (DESCRIPTOR_SET_BITS + MESH_BITS + DEPTH_BITS)) | (descriptorSet << (MESH_BITS + DEPTH_BITS)) | (mesh << DEPTH_BITS) | std::min(depth, static_cast<uint64_t>((1u << DEPTH_BITS) - 1));
+    }
+
+    uint32_t DrawList::GetId(std::unordered_map<uint64_t, uint32_t>& ids, uint64_t handle, uint32_t maxId)
+    {
+        auto existing = ids.find(handle);
+        if (existing != ids.end())
+        {
+            return existing->second;
+        }
+        uint32_t id = std::min(static_cast<uint32_t>(ids.size()), maxId);
+        ids.emplace(handle, id);
+        return id;
+    }
+
+    void DrawList::Sort()
+    {
+        // Least significant byte first, each pass stable, so the last pass leaves the keys fully sorted. Every byte's histogram is counted in one go up front
+        size_t count = m_keys.size();
+        m_sortKeys = m_keys;
+        m_sortIndices.resize(count);
+        for (uint32_t i = 0; i < static_cast<uint32_t>(count); i++)
+        {
+            m_sortIndices[i] = i;
+        }
+        m_tempKeys.resize(count);
+        m_tempIndices.resize(count);
+
+        uint32_t histograms[8][256] = {};
+        for (uint64_t key : m_sortKeys)
+        {
+            for (int byte = 0; byte < 8; byte++)
+            {
+                histograms[byte][(key >> (byte * 8)) & 0xFF]++;
+            }
+        }
+
+        m_sortPasses = 0;
+        for (int byte = 0; byte < 8; byte++)
+        {
+            uint32_t* histogram = histograms[byte];
+            // Every key has the same value in this byte (mostly the high pipeline bits and unused ids), the pass wouldn't move anything
+            if (count == 0 || histogram[(m_sortKeys[0] >> (byte * 8)) & 0xFF] == count)
+            {
+                continue;
+            }
+
+            uint32_t offset = 0;
+            for (int digit = 0; digit < 256; digit++)
+            {
+                uint32_t digitCount = histogram[digit];
+                histogram[digit] = offset;
+                offset += digitCount;
+            }
+
+            for (size_t i = 0; i < count; i++)
+            {
+                uint32_t destination = histogram[(m_sortKeys[i] >> (byte * 8)) & 0xFF]++;
+                m_tempKeys[destination] = m_sortKeys[i];
+                m_tempIndices[destination] = m_sortIndices[i];
+            }
+            m_sortKeys.swap(m_tempKeys);
+            m_sortIndices.swap(m_tempIndices);
+            m_sortPasses++;
+        }
+    }
+
+    const std::vector<DrawItem>& DrawList::GetDraws()
+    {
+        return m_draws;
+    }
+
+    void DrawList::AddBindStats(const BindStats& stats)
+    {
+        m_totalStats.pipelines += stats.pipelines;
+        m_totalStats.descriptorSets += stats.descriptorSets;
+        m_totalStats.vertexBuffers += stats.vertexBuffers;
+        m_totalStats.indexBuffers += stats.indexBuffers;
+        m_totalStats.pushConstants += stats.pushConstants;
+        m_totalStats.skippedPipelines += stats.skippedPipelines;
+        m_totalStats.skippedDescriptorSets += stats.skippedDescriptorSets;
+        m_totalStats.skippedVertexBuffers += stats.skippedVertexBuffers;
+        m_totalStats.skippedIndexBuffers += stats.skippedIndexBuffers;
+        m_totalStats.skippedPushConstants += stats.skippedPushConstants;
+    }
+
+    void DrawList::PrintStats()
+    {
+        uint32_t ui_frames = std::max(m_frames, 1u);
+        const BindStats& s = m_totalStats;
+        uint64_t bound = s.pipelines + s.descriptorSets + s.vertexBuffers + s.indexBuffers + s.pushConstants;
+        uint64_t skipped = s.skippedPipelines + s.skippedDescriptorSets + s.skippedVertexBuffers + s.skippedIndexBuffers + s.skippedPushConstants;
+        std::cout << "draw list: " << m_totalDraws / ui_frames << " draws per frame, built and sorted in " << m_buildTimeMs / ui_frames << " ms (" << m_sortPasses << " of 8 byte passes last frame)" << std::endl;
+        std::cout << "  binds per frame (issued/skipped): pipelines " << s.pipelines / ui_frames << "/" << s.skippedPipelines / ui_frames
+            << ", descriptor sets " << s.descriptorSets / ui_frames << "/" << s.skippedDescriptorSets / ui_frames
+            << ", vertex buffers " << s.vertexBuffers / ui_frames << "/" << s.skippedVertexBuffers / ui_frames
+            << ", index buffers " << s.indexBuffers / ui_frames << "/" << s.skippedIndexBuffers / ui_frames
+            << ", push constants " << s.pushConstants / ui_frames << "/" << s.skippedPushConstants / ui_frames
+            << " - " << skipped / ui_frames << " of " << (bound + skipped) / ui_frames << " saved" << std::endl;
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include "Structs.h"
+#include "InstanceBatcher.h"
+#include "LodSelector.h"
+
+#define GLFW_INCLUDE_VULKAN
+#include <glfw3.h>
+#include <glm.hpp>
+
+#include <vector>
+#include <unordered_map>
+
+
+namespace VCore
+{
+	class GameObject;
+
+	// Binds a command buffer issued and skipped because the state was already bound, per kind of bind. Vertex buffers count the per instance binding too
+	struct BindStats
+	{
+		uint64_t pipelines = 0;
+		uint64_t descriptorSets = 0;
+		uint64_t vertexBuffers = 0;
+		uint64_t indexBuffers = 0;
+		uint64_t pushConstants = 0;
+		uint64_t skippedPipelines = 0;
+		uint64_t skippedDescriptorSets = 0;
+		uint64_t skippedVertexBuffers = 0;
+		uint64_t skippedIndexBuffers = 0;
+		uint64_t skippedPushConstants = 0;
+	};
+
+	// What's currently bound in one command buffer, so draws only bind what changed since the draw before them. Starts out with nothing bound (set 0 aside)
+	struct BindState
+	{
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE; // set 1
+		VkBuffer vertexBuffer = VK_NULL_HANDLE;
+		VkBuffer instanceBuffer = VK_NULL_HANDLE;
+		VkBuffer indexBuffer = VK_NULL_HANDLE;
+		ObjectPushConstants objectConstants{};
+		BindlessPushConstants bindlessConstants{};
+		bool b_objectConstants = false; // which of the two was pushed last, if either
+		bool b_bindlessConstants = false;
+		BindStats stats;
+	};
+
+	// One draw of the list, a regular object or an instanced batch
+	struct DrawItem
+	{
+		GameObject* object = nullptr;
+		const InstanceBatch* batch = nullptr; // nullptr for regular objects
+		uint32_t gpuBatch = 0; // batch's index in the GpuCuller, for its indirect draw
+		uint32_t lod = 0; // which of the mesh's GeometryRange::lods to draw, GpuCuller batches always draw the full detail one
+	};
+
+	// Refer to - https://realtimecollisiondetection.net/blog/?p=86
+	// Every frame's draws, sorted so draws sharing state end up next to each other and RenderPass::RecordCommandBuffer can skip binds that wouldn't change anything.
+	// Each draw gets a 64 bit key: pipeline (12 bits), material descriptor set (16), mesh (16, in practice the GeometryArena page its buffers are in) and depth (20), most significant first. The keys are radix sorted a byte at a time,
+	// skipping bytes every key shares. Ids are handed out the first time a pipeline, set or mesh is seen and kept across frames, so the order doesn't shuffle from frame to frame.
+	// Ids past what fits in their bits all share the last one, which only costs sorting quality - binds are always skipped by comparing the actual handles.
+	// Within a pipeline, set and mesh regular objects go front to back so the depth test rejects more of what's behind them. Main thread only, apart from AddBindStats.
+	class DrawList
+	{
+	public:
+		DrawList();
+		~DrawList();
+
+		// Fills the list with visibleObjects (indices into gameObjects) and batches, then sorts it. With b_gpuBatches the batches are the GpuCuller's and draw indirectly.
+		// Depth is the distance in front of the camera of each object's bounding sphere, moved by objectOffset like the culling spheres are. lodSelector picks each draw's LOD from it
+		void Build(std::vector<GameObject>& gameObjects, const std::vector<uint32_t>& visibleObjects, std::vector<InstanceBatch>& batches, bool b_gpuBatches, const glm::mat4& viewProj, glm::vec3 objectOffset, LodSelector& lodSelector);
+		// In sorted order
+		const std::vector<DrawItem>& GetDraws();
+		// Adds a command buffer's bind counts to the totals. Call from the main thread once recording is done
+		void AddBindStats(const BindStats& stats);
+		void PrintStats();
+
+	private:
+		uint64_t MakeKey(GameObject& object, uint64_t depth);
+		static uint32_t GetId(std::unordered_map<uint64_t, uint32_t>& ids, uint64_t handle, uint32_t maxId);
+		void Sort();
+
+		std::vector<DrawItem> m_unsorted;
+		std::vector<DrawItem> m_draws;
+		std::vector<uint64_t> m_keys; // [unsorted draw]
+		// Radix sort scratch, key and the draw it belongs to
+		std::vector<uint64_t> m_sortKeys;
+		std::vector<uint32_t> m_sortIndices;
+		std::vector<uint64_t> m_tempKeys;
+		std::vector<uint32_t> m_tempIndices;
+		std::unordered_map<uint64_t, uint32_t> m_pipelineIds;
+		std::unordered_map<uint64_t, uint32_t> m_descriptorSetIds;
+		std::unordered_map<uint64_t, uint32_t> m_meshIds;
+
+		// stats
+		BindStats m_totalStats;
+		uint64_t m_totalDraws;
+		uint32_t m_sortPasses; // byte passes the last sort needed out of 8
+		float m_buildTimeMs;
+		uint32_t m_frames;
+	};
+}
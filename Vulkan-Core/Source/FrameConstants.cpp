@@ -0,0 +1,112 @@
+#include "FrameConstants.h"
+
+#include <stdexcept>
+
+
+namespace VCore
+{
+    FrameConstants::FrameConstants()
+    {
+        m_descriptorSetLayout = VK_NULL_HANDLE;
+        m_pipelineLayout = VK_NULL_HANDLE;
+        m_descriptorSets = std::vector<VkDescriptorSet>();
+        m_cameraOffsets = std::vector<uint32_t>();
+    }
+
+    FrameConstants::~FrameConstants()
+    {
+    }
+
+    void FrameConstants::Init(uint32_t framesInFlight, bool b_bindless, UniformRing& uniformRing, DescriptorAllocator& descriptorAllocator, PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice)
+    {
+        m_descriptorSetLayout = pipelineRegistry.AcquireDescriptorSetLayout(GetSetLayoutBindings(), logicalDevice);
+
+        VkPushConstantRange pushConstantRange = GetPushConstantRange(b_bindless);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &m_descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+        if (vkCreatePipelineLayout(logicalDevice.GetDevice(), &pipelineLayoutInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create frame pipeline layout!");
+        }
+
+        m_descriptorSets.resize(framesInFlight);
+        m_cameraOffsets.assign(framesInFlight, 0);
+
+        for (uint32_t i = 0; i < framesInFlight; i++)
+        {
+            std::vector<DescriptorBinding> bindings(1);
+            bindings[0].binding = 0;
+            bindings[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            bindings[0].buffer = uniformRing.GetBuffer(i);
+            bindings[0].offset = 0; // the real offset is given when binding
+            bindings[0].range = sizeof(CameraData);
+
+            m_descriptorSets[i] = descriptorAllocator.GetOrCreateSet(m_descriptorSetLayout, bindings, logicalDevice);
+        }
+    }
+
+    void FrameConstants::Cleanup(PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice)
+    {
+        // The sets go with the DescriptorAllocator's pools
+        vkDestroyPipelineLayout(logicalDevice.GetDevice(), m_pipelineLayout, nullptr);
+        pipelineRegistry.ReleaseDescriptorSetLayout(m_descriptorSetLayout, logicalDevice);
+        m_pipelineLayout = VK_NULL_HANDLE;
+        m_descriptorSetLayout = VK_NULL_HANDLE;
+        m_descriptorSets.clear();
+    }
+
+    std::vector<VkDescriptorSetLayoutBinding> FrameConstants::GetSetLayoutBindings()
+    {
+        // Refer to - https://vulkan-tutorial.com/en/Uniform_buffers/Descriptor_layout_and_buffer
+        VkDescriptorSetLayoutBinding cameraLayoutBinding{};
+        cameraLayoutBinding.binding = 0;
+        cameraLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC; // points at the UniformRing, the offset moves every frame
+        cameraLayoutBinding.descriptorCount = 1;
+        cameraLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        cameraLayoutBinding.pImmutableSamplers = nullptr;
+
+        return { cameraLayoutBinding };
+    }
+
+    VkPushConstantRange FrameConstants::GetPushConstantRange(bool b_bindless)
+    {
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(ObjectPushConstants);
+
+        if (b_bindless)
+        {
+            pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+            pushConstantRange.size = sizeof(BindlessPushConstants);
+        }
+
+        return pushConstantRange;
+    }
+
+    void FrameConstants::Update(uint32_t frame, const CameraData& cameraData, UniformRing& uniformRing)
+    {
+        m_cameraOffsets[frame] = uniformRing.Push(frame, &cameraData, sizeof(CameraData));
+    }
+
+    void FrameConstants::Bind(VkCommandBuffer commandBuffer, uint32_t frame)
+    {
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &m_descriptorSets[frame], 1, &m_cameraOffsets[frame]);
+    }
+
+    VkDescriptorSetLayout& FrameConstants::GetDescriptorSetLayout()
+    {
+        return m_descriptorSetLayout;
+    }
+
+    VkPipelineLayout& FrameConstants::GetPipelineLayout()
+    {
+        return m_pipelineLayout;
+    }
+}
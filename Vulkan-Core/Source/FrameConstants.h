@@ -0,0 +1,44 @@
+#pragma once
+#include "LogicalDevice.h"
+#include "UniformRing.h"
+#include "DescriptorAllocator.h"
+#include "PipelineRegistry.h"
+#include "Structs.h"
+
+#define GLFW_INCLUDE_VULKAN
+#include <glfw3.h>
+
+#include <vector>
+
+
+namespace VCore
+{
+	// Set 0 of every pipeline - the per frame CameraData block, written once per frame into the UniformRing and bound once per command buffer.
+	// Per object data no longer goes through descriptors at all: transforms are pushed (ObjectPushConstants) or, for bindless materials, read from the table's object buffers.
+	class FrameConstants
+	{
+	public:
+		FrameConstants();
+		~FrameConstants();
+
+		// Every pipeline layout shares set 0 and its push constant range (bindless or not, all materials are one or the other), which makes them compatible with the one used here to bind set 0
+		void Init(uint32_t framesInFlight, bool b_bindless, UniformRing& uniformRing, DescriptorAllocator& descriptorAllocator, PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice);
+		void Cleanup(PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice);
+
+		// Bindings of the set 0 layout, so materials can get the same layout from the PipelineRegistry
+		static std::vector<VkDescriptorSetLayoutBinding> GetSetLayoutBindings();
+		static VkPushConstantRange GetPushConstantRange(bool b_bindless);
+
+		// Pushes this frame's camera into the uniform ring. Call once per frame, after the ring has been reset
+		void Update(uint32_t frame, const CameraData& cameraData, UniformRing& uniformRing);
+		void Bind(VkCommandBuffer commandBuffer, uint32_t frame);
+		VkDescriptorSetLayout& GetDescriptorSetLayout();
+		VkPipelineLayout& GetPipelineLayout();
+
+	private:
+		VkDescriptorSetLayout m_descriptorSetLayout;
+		VkPipelineLayout m_pipelineLayout;
+		std::vector<VkDescriptorSet> m_descriptorSets; // [frame in flight], owned by the DescriptorAllocator
+		std::vector<uint32_t> m_cameraOffsets; // this frame's CameraData in the uniform ring
+	};
+}
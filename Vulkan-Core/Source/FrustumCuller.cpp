@@ -0,0 +1,365 @@
+#include "FrustumCuller.h"
+#include "GameObject.h"
+#include "OcclusionRasterizer.h"
+#include "VulkanManager.h"
+
+#include <gtc/matrix_transform.hpp>
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__)
+    #define CULLING_SSE // SSE2 is always there on x64
+    #include <immintrin.h>
+#endif
+
+
+namespace VCore
+{
+    static void TestSpheresScalar(const glm::vec4* planes, const float* centerX, const float* centerY, const float* centerZ, const float* radius, uint32_t begin, uint32_t end, uint8_t* visible)
+    {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            bool b_inside = true;
+            for (int plane = 0; plane < 6; plane++)
+            {
+                // Signed distance of the center, a sphere is only outside once it's entirely behind one plane. Summed in the same order as the SSE kernel so both agree exactly
+                float f_distance = (planes[plane].x * centerX[i] + planes[plane].y * centerY[i]) + (planes[plane].z * centerZ[i] + planes[plane].w);
+                b_inside = b_inside && f_distance >= -radius[i];
+            }
+            visible[i] = b_inside ? 1 : 0;
+        }
+    }
+
+#ifdef CULLING_SSE
+    // Four spheres against one plane per step, no branches until the four results are written out
+    static void TestSpheresSse(const glm::vec4* planes, const float* centerX, const float* centerY, const float* centerZ, const float* radius, uint32_t begin, uint32_t end, uint8_t* visible)
+    {
+        __m128 planeX[6];
+        __m128 planeY[6];
+        __m128 planeZ[6];
+        __m128 planeW[6];
+        for (int plane = 0; plane < 6; plane++)
+        {
+            planeX[plane] = _mm_set1_ps(planes[plane].x);
+            planeY[plane] = _mm_set1_ps(planes[plane].y);
+            planeZ[plane] = _mm_set1_ps(planes[plane].z);
+            planeW[plane] = _mm_set1_ps(planes[plane].w);
+        }
+
+        for (uint32_t i = begin; i < end; i += 4)
+        {
+            __m128 x = _mm_loadu_ps(centerX + i);
+            __m128 y = _mm_loadu_ps(centerY + i);
+            __m128 z = _mm_loadu_ps(centerZ + i);
+            __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int plane = 0; plane < 6; plane++)
+            {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[plane], x), _mm_mul_ps(planeY[plane], y)), _mm_add_ps(_mm_mul_ps(planeZ[plane], z), planeW[plane]));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+            }
+
+            int mask = _mm_movemask_ps(inside);
+            visible[i] = mask & 1;
+            visible[i + 1] = (mask >> 1) & 1;
+            visible[i + 2] = (mask >> 2) & 1;
+            visible[i + 3] = (mask >> 3) & 1;
+        }
+    }
+#endif
+
+    static void TestSpheresBest(const glm::vec4* planes, const float* centerX, const float* centerY, const float* centerZ, const float* radius, uint32_t count, uint8_t* visible)
+    {
+        // The SSE kernel stops at the last full group of four, the scalar one finishes the rest
+        uint32_t simdEnd = 0;
+    #ifdef CULLING_SSE
+        simdEnd = count / 4 * 4;
+        TestSpheresSse(planes, centerX, centerY, centerZ, radius, 0, simdEnd, visible);
+    #endif
+        TestSpheresScalar(planes, centerX, centerY, centerZ, radius, simdEnd, count, visible);
+    }
+
+    FrustumCuller::FrustumCuller()
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            m_planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f); // everything is inside until a frustum is set
+        }
+        m_viewProj = glm::mat4(1.0f);
+        m_objectOffset = glm::vec3(0.0f);
+        m_b_enabled = true;
+        m_occlusionRasterizer = nullptr;
+        m_visibleFlags = std::vector<uint8_t>();
+        m_visibleObjects = std::vector<uint32_t>();
+        m_frameStats = CullStats();
+        m_totalTested = 0;
+        m_totalCulled = 0;
+        m_frames = 0;
+    }
+
+    FrustumCuller::~FrustumCuller()
+    {
+    }
+
+    void FrustumCuller::SetFrustum(const glm::mat4& viewProj)
+    {
+        // Rows of viewProj (glm is column major, so row i is viewProj[column][i]). A point is inside when -w <= x, y <= w and 0 <= z <= w
+        glm::vec4 row0 = glm::vec4(viewProj[0][0], viewProj[1][0], viewProj[2][0], viewProj[3][0]);
+        glm::vec4 row1 = glm::vec4(viewProj[0][1], viewProj[1][1], viewProj[2][1], viewProj[3][1]);
+        glm::vec4 row2 = glm::vec4(viewProj[0][2], viewProj[1][2], viewProj[2][2], viewProj[3][2]);
+        glm::vec4 row3 = glm::vec4(viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3]);
+
+        m_planes[0] = row3 + row0; // left
+        m_planes[1] = row3 - row0; // right
+        m_planes[2] = row3 + row1; // bottom and top (swapped by the projection's Y flip, which doesn't matter here)
+        m_planes[3] = row3 - row1;
+        m_planes[4] = row2; // near, Vulkan's depth starts at 0 rather than OpenGL's -w
+        m_planes[5] = row3 - row2; // far
+
+        for (int i = 0; i < 6; i++)
+        {
+            float f_length = glm::length(glm::vec3(m_planes[i]));
+            if (f_length > 0.0f)
+            {
+                m_planes[i] /= f_length;
+            }
+        }
+
+        m_viewProj = viewProj;
+        m_frameStats = CullStats();
+        m_frames++;
+    }
+
+    void FrustumCuller::SetObjectOffset(glm::vec3 offset)
+    {
+        m_objectOffset = offset;
+    }
+
+    glm::vec3 FrustumCuller::GetObjectOffset()
+    {
+        return m_objectOffset;
+    }
+
+    void FrustumCuller::GetPlanes(glm::vec4 planes[6])
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            planes[i] = m_b_enabled ? m_planes[i] : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        }
+    }
+
+    glm::mat4 FrustumCuller::GetViewProj()
+    {
+        return m_viewProj;
+    }
+
+    MeshBounds FrustumCuller::GetCullBounds(const MeshBounds& bounds)
+    {
+        MeshBounds cullBounds = bounds;
+        cullBounds.min += m_objectOffset;
+        cullBounds.max += m_objectOffset;
+        cullBounds.center += m_objectOffset;
+        return cullBounds;
+    }
+
+    void FrustumCuller::SetEnabled(bool b_enabled)
+    {
+        m_b_enabled = b_enabled;
+    }
+
+    bool FrustumCuller::IsEnabled()
+    {
+        return m_b_enabled;
+    }
+
+    void FrustumCuller::SetOcclusionRasterizer(OcclusionRasterizer* occlusionRasterizer)
+    {
+        m_occlusionRasterizer = occlusionRasterizer;
+    }
+
+    void FrustumCuller::CullObjects(std::vector<GameObject>& gameObjects, JobSystem& jobSystem)
+    {
+        // 0 culled, 1 visible, 2 instanced (culled with its batch instead) or without a mesh (released, nothing to draw)
+        m_visibleFlags.resize(gameObjects.size());
+
+        // Pieces write disjoint ranges of the flags. Spheres are gathered a block at a time into arrays on the stack, then tested together
+        jobSystem.ParallelFor(static_cast<uint32_t>(gameObjects.size()), VM_CULL_OBJECTS_PER_JOB, [&](uint32_t begin, uint32_t end, uint32_t threadIndex)
+        {
+            const uint32_t ui_blockSize = 256;
+            float centerX[ui_blockSize];
+            float centerY[ui_blockSize];
+            float centerZ[ui_blockSize];
+            float radius[ui_blockSize];
+            uint8_t visible[ui_blockSize];
+            uint32_t objects[ui_blockSize];
+
+            for (uint32_t blockBegin = begin; blockBegin < end; blockBegin += ui_blockSize)
+            {
+                uint32_t blockEnd = std::min(end, blockBegin + ui_blockSize);
+                uint32_t ui_sphereCount = 0;
+
+                for (uint32_t i = blockBegin; i < blockEnd; i++)
+                {
+                    GameObject& object = gameObjects[i];
+                    if (object.GetMaterial()->IsInstanced() || object.GetModel().GetMesh() == nullptr)
+                    {
+                        m_visibleFlags[i] = 2;
+                        continue;
+                    }
+
+                    // The sphere goes through the object's matrix, its radius grows with the largest axis scale so it still covers the mesh
+                    MeshBounds bounds = GetCullBounds(object.GetModel().GetMesh()->GetBounds());
+                    const glm::mat4& transform = object.GetModel().GetTransform();
+                    glm::vec4 center = transform * glm::vec4(bounds.center, 1.0f);
+                    float f_scale = std::sqrt(std::max(std::max(glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])), glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1]))), glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2]))));
+
+                    centerX[ui_sphereCount] = center.x;
+                    centerY[ui_sphereCount] = center.y;
+                    centerZ[ui_sphereCount] = center.z;
+                    radius[ui_sphereCount] = bounds.radius * f_scale;
+                    objects[ui_sphereCount] = i;
+                    ui_sphereCount++;
+                }
+
+                TestSpheres(centerX, centerY, centerZ, radius, ui_sphereCount, visible);
+                for (uint32_t i = 0; i < ui_sphereCount; i++)
+                {
+                    m_visibleFlags[objects[i]] = visible[i];
+                }
+            }
+        });
+
+        // Compacting keeps the objects in order, so what's drawn (and headless captures) doesn't depend on the thread count
+        m_visibleObjects.clear();
+        uint32_t ui_tested = 0;
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_visibleFlags.size()); i++)
+        {
+            if (m_visibleFlags[i] != 2)
+            {
+                ui_tested++;
+            }
+            if (m_visibleFlags[i] == 1)
+            {
+                m_visibleObjects.push_back(i);
+            }
+        }
+        AddStats(ui_tested, ui_tested - static_cast<uint32_t>(m_visibleObjects.size()));
+    }
+
+    std::vector<uint32_t>& FrustumCuller::GetVisibleObjects()
+    {
+        return m_visibleObjects;
+    }
+
+    void FrustumCuller::TestSpheres(const float* centerX, const float* centerY, const float* centerZ, const float* radius, uint32_t count, uint8_t* visible)
+    {
+        if (!m_b_enabled)
+        {
+            std::fill(visible, visible + count, 1);
+        }
+        else
+        {
+            TestSpheresBest(m_planes, centerX, centerY, centerZ, radius, count, visible);
+        }
+
+        // Only what's inside the frustum is worth the more expensive occlusion test
+        if (m_occlusionRasterizer != nullptr)
+        {
+            m_occlusionRasterizer->TestSpheres(centerX, centerY, centerZ, radius, count, visible);
+        }
+    }
+
+    void FrustumCuller::AddStats(uint32_t tested, uint32_t culled)
+    {
+        m_frameStats.tested += tested;
+        m_frameStats.culled += culled;
+        m_frameStats.drawn += tested - culled;
+        m_totalTested += tested;
+        m_totalCulled += culled;
+    }
+
+    CullStats FrustumCuller::GetFrameStats()
+    {
+        return m_frameStats;
+    }
+
+    void FrustumCuller::PrintStats()
+    {
+        uint32_t ui_frames = std::max(m_frames, 1u);
+        std::cout << "culling: " << (m_b_enabled ? "" : "disabled, ") << m_totalTested / ui_frames << " objects tested, " << m_totalCulled / ui_frames << " culled per frame on average";
+        std::cout << " (last frame " << m_frameStats.tested << " tested, " << m_frameStats.culled << " culled, " << m_frameStats.drawn << " drawn)" << std::endl;
+    }
+
+    void FrustumCuller::RunBenchmark(uint32_t count, JobSystem& jobSystem)
+    {
+        const uint32_t ui_iterations = 20;
+
+        // Spheres scattered around a camera looking into the middle of them, so a good share is on each side of every plane
+        std::mt19937 random(1234); // same spheres every run
+        std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+        std::vector<float> centerX(count);
+        std::vector<float> centerY(count);
+        std::vector<float> centerZ(count);
+        std::vector<float> radius(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            centerX[i] = distribution(random) * 200.0f;
+            centerY[i] = distribution(random) * 200.0f;
+            centerZ[i] = distribution(random) * 200.0f;
+            radius[i] = distribution(random) + 2.0f;
+        }
+
+        FrustumCuller culler;
+        culler.SetFrustum(glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 250.0f) * glm::lookAt(glm::vec3(0.0f, -150.0f, 0.0f), glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f)));
+
+        auto timeRuns = [&](int kernel, bool b_threaded, std::vector<uint8_t>& visible)
+        {
+            visible.assign(count, 0);
+            auto start = std::chrono::high_resolution_clock::now();
+            for (uint32_t i = 0; i < ui_iterations; i++)
+            {
+                if (b_threaded)
+                {
+                    jobSystem.ParallelFor(count, VM_CULL_OBJECTS_PER_JOB, [&](uint32_t begin, uint32_t end, uint32_t threadIndex)
+                    {
+                        culler.TestSpheres(&centerX[begin], &centerY[begin], &centerZ[begin], &radius[begin], end - begin, &visible[begin]);
+                    });
+                }
+                else if (kernel == 0)
+                {
+                    TestSpheresScalar(culler.m_planes, centerX.data(), centerY.data(), centerZ.data(), radius.data(), 0, count, visible.data());
+                }
+                else
+                {
+                    culler.TestSpheres(centerX.data(), centerY.data(), centerZ.data(), radius.data(), count, visible.data());
+                }
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            return std::chrono::duration<float, std::chrono::milliseconds::period>(end - start).count() / ui_iterations;
+        };
+
+        std::vector<uint8_t> reference;
+        float f_scalarMs = timeRuns(0, false, reference);
+        uint32_t ui_visible = static_cast<uint32_t>(std::count(reference.begin(), reference.end(), 1));
+        std::cout << "culling: " << count << " spheres, " << ui_visible << " visible, " << ui_iterations << " runs each" << std::endl;
+        std::cout << "  scalar, 1 thread: " << f_scalarMs << " ms" << std::endl;
+
+    #ifdef CULLING_SSE
+        const char* kernelName = "sse";
+    #else
+        const char* kernelName = "scalar";
+    #endif
+        for (int i = 0; i < 2; i++)
+        {
+            bool b_threaded = i == 1;
+            std::vector<uint8_t> visible;
+            float f_ms = timeRuns(1, b_threaded, visible);
+            std::cout << "  " << kernelName << ", " << (b_threaded ? jobSystem.GetThreadCount() : 1) << (b_threaded && jobSystem.GetThreadCount() > 1 ? " threads: " : " thread: ") << f_ms << " ms (" << f_scalarMs / std::max(f_ms, 0.001f) << "x), " << (visible == reference ? "matches scalar" : "DIFFERS FROM SCALAR") << std::endl;
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "Structs.h"
+#include "JobSystem.h"
+
+#include <glm.hpp>
+
+#include <vector>
+
+
+namespace VCore
+{
+	class GameObject;
+	class OcclusionRasterizer;
+
+	// Objects looked at by the culler in one frame. drawn is what was passed on to be recorded, objects still waiting on a pipeline included
+	struct CullStats
+	{
+		uint32_t tested = 0;
+		uint32_t culled = 0;
+		uint32_t drawn = 0;
+	};
+
+	// Refer to - https://www.gamedevs.org/uploads/fast-extraction-viewing-frustum-planes-from-world-view-projection-matrix.pdf
+	// Tests world space bounding spheres against the camera's six frustum planes, four spheres at a time with SSE (scalar elsewhere), before anything is recorded.
+	// Regular objects are culled here into a list of visible indices, instanced objects are culled by the InstanceBatcher as it compacts each batch (or by the GpuCuller,
+	// whose counts are read back and added here a few frames late).
+	// SetFrustum and CullObjects are main thread only, TestSpheres can run from any number of threads at once.
+	class FrustumCuller
+	{
+	public:
+		FrustumCuller();
+		~FrustumCuller();
+
+		// Extracts the planes from viewProj (Vulkan's 0 to 1 depth range). Call once per frame before culling, it also starts the frame's counters
+		void SetFrustum(const glm::mat4& viewProj);
+		// Object space offset every shader adds to the vertices (ObjectPushConstants::position), spheres are moved by it before they're transformed
+		void SetObjectOffset(glm::vec3 offset);
+		glm::vec3 GetObjectOffset();
+		// The current planes, or planes every sphere passes when disabled - for culling outside this class (GpuCuller)
+		void GetPlanes(glm::vec4 planes[6]);
+		// The matrix passed to the last SetFrustum - for occlusion culling (GpuCuller)
+		glm::mat4 GetViewProj();
+		// Bounds moved by the object offset
+		MeshBounds GetCullBounds(const MeshBounds& bounds);
+		// Disabled, every sphere passes (counters still count them) - for comparing against culling
+		void SetEnabled(bool b_enabled);
+		bool IsEnabled();
+		// Spheres that pass the frustum are then tested against occlusionRasterizer's depth buffer, which has to be rendered for the frame before culling. nullptr turns it off
+		void SetOcclusionRasterizer(OcclusionRasterizer* occlusionRasterizer);
+
+		// Tests every non instanced object that still has a mesh, split across the job system, and fills GetVisibleObjects in their original order
+		void CullObjects(std::vector<GameObject>& gameObjects, JobSystem& jobSystem);
+		// Indices into the game objects passed to CullObjects
+		std::vector<uint32_t>& GetVisibleObjects();
+
+		// Writes 1 to visible[i] if sphere i (structure of arrays, world space) is at least partly inside the frustum and not hidden by the occluders, 0 otherwise
+		void TestSpheres(const float* centerX, const float* centerY, const float* centerZ, const float* radius, uint32_t count, uint8_t* visible);
+		// For culling done outside CullObjects (InstanceBatcher, GpuCuller), main thread only
+		void AddStats(uint32_t tested, uint32_t culled);
+
+		CullStats GetFrameStats();
+		void PrintStats();
+
+		// Times the sphere test on count random spheres, single threaded and across the job system, and checks SSE against scalar
+		static void RunBenchmark(uint32_t count, JobSystem& jobSystem);
+
+	private:
+		glm::vec4 m_planes[6]; // xyz normal pointing inwards, w distance, normalized so a sphere's radius can be compared against it directly
+		glm::mat4 m_viewProj;
+		glm::vec3 m_objectOffset;
+		bool m_b_enabled;
+		OcclusionRasterizer* m_occlusionRasterizer;
+		std::vector<uint8_t> m_visibleFlags; // [game object], scratch for CullObjects
+		std::vector<uint32_t> m_visibleObjects;
+		CullStats m_frameStats;
+
+		// stats
+		uint64_t m_totalTested;
+		uint64_t m_totalCulled;
+		uint32_t m_frames;
+	};
+}
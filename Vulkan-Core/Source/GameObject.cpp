@@ -1,4 +1,5 @@
 #include "GameObject.h"
+#include "VulkanManager.h"
 
 
 namespace VCore
@@ -7,19 +8,17 @@ namespace VCore
 	{
 		m_model = Model();
 		m_material = std::make_shared<Material>();
-		m_descriptorPool = VK_NULL_HANDLE;
 		m_descriptorSets = std::vector<VkDescriptorSet>();
+		m_objectIndex = 0;
+		m_instanceParams = glm::vec4(1.0f);
+		m_transformIndex = VM_NO_TRANSFORM;
+		m_b_occluder = false;
 	}
 
 	GameObject::~GameObject()
 	{
 	}
 
-	void GameObject::CleanupDescriptorPool(LogicalDevice& logicalDevice)
-	{
-		vkDestroyDescriptorPool(logicalDevice.GetDevice(), m_descriptorPool, nullptr);
-	}
-
 
 	void GameObject::SetModel(Model model)
 	{
@@ -31,12 +30,9 @@ namespace VCore
 		return m_model;
 	}
 
-	void GameObject::CreateModelResources(VkCommandPool commandPool, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice)
+	void GameObject::CreateModelResources(UploadQueue& uploadQueue, JobSystem& jobSystem, MeshRegistry& meshRegistry, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice)
 	{
-		m_model.LoadModel();
-		m_model.CreateVertexBuffer(commandPool, physicalDevice, logicalDevice);
-		m_model.CreateIndexBuffer(commandPool, physicalDevice, logicalDevice);
-		m_model.CreateUniformBuffers(physicalDevice, logicalDevice);
+		m_model.AcquireMesh(meshRegistry, jobSystem, uploadQueue, physicalDevice, logicalDevice);
 	}
 
 	void GameObject::SetMaterial(std::shared_ptr<Material> material)
@@ -49,15 +45,53 @@ namespace VCore
 		return m_material;
 	}
 
-	void GameObject::CreateResources(WinSys& winSystem, VkCommandPool commandPool, RenderPass& renderPass, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice)
+	void GameObject::CreateResources(WinSys& winSystem, UploadQueue& uploadQueue, JobSystem& jobSystem, MeshRegistry& meshRegistry, DescriptorAllocator& descriptorAllocator, RenderPass& renderPass, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice)
 	{
-		CreateModelResources(commandPool, physicalDevice, logicalDevice);
-		m_material->CreateDescriptorPool(m_descriptorPool, logicalDevice);
-		m_material->CreateDescriptorSets(m_descriptorSets, m_descriptorPool, m_model, logicalDevice);
+		CreateModelResources(uploadQueue, jobSystem, meshRegistry, physicalDevice, logicalDevice);
+		m_material->CreateDescriptorSets(m_descriptorSets, descriptorAllocator, logicalDevice);
+		if (m_material->GetBindlessTable() != nullptr)
+		{
+			m_objectIndex = m_material->GetBindlessTable()->AllocateObject();
+		}
 	}
 
 	std::vector<VkDescriptorSet>& GameObject::GetDescriptorSets()
 	{
 		return m_descriptorSets;
 	}
+
+	uint32_t GameObject::GetObjectIndex()
+	{
+		return m_objectIndex;
+	}
+
+	void GameObject::SetInstanceParams(glm::vec4 params)
+	{
+		m_instanceParams = params;
+	}
+
+	glm::vec4 GameObject::GetInstanceParams()
+	{
+		return m_instanceParams;
+	}
+
+	void GameObject::SetTransformIndex(uint32_t index)
+	{
+		m_transformIndex = index;
+	}
+
+	uint32_t GameObject::GetTransformIndex()
+	{
+		return m_transformIndex;
+	}
+
+	void GameObject::SetOccluder(bool b_occluder)
+	{
+		m_b_occluder = b_occluder;
+	}
+
+	bool GameObject::IsOccluder()
+	{
+		return m_b_occluder;
+	}
 }
\ No newline at end of file
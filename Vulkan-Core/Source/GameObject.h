@@ -18,20 +18,32 @@ namespace VCore
 	public:
 		GameObject();
 		~GameObject();
-		void CleanupDescriptorPool(LogicalDevice& logicalDevice);
 
 		void SetModel(Model model);
 		Model& GetModel();
-		void CreateModelResources(VkCommandPool commandPool, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
+		void CreateModelResources(UploadQueue& uploadQueue, JobSystem& jobSystem, MeshRegistry& meshRegistry, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
 		void SetMaterial(std::shared_ptr<Material> material);
 		std::shared_ptr<Material> GetMaterial();	
-		void CreateResources(WinSys& winSystem, VkCommandPool commandPool, RenderPass& renderPass, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
+		void CreateResources(WinSys& winSystem, UploadQueue& uploadQueue, JobSystem& jobSystem, MeshRegistry& meshRegistry, DescriptorAllocator& descriptorAllocator, RenderPass& renderPass, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
 		std::vector<VkDescriptorSet>& GetDescriptorSets();
+		uint32_t GetObjectIndex(); // slot in the bindless object buffers, only set for bindless materials
+		// Per instance shader parameters for instanced materials, read when the InstanceBatcher is built
+		void SetInstanceParams(glm::vec4 params);
+		glm::vec4 GetInstanceParams();
+		// Where the object's transform lives in the TransformSystem, VM_NO_TRANSFORM if it only has the Model's matrix
+		void SetTransformIndex(uint32_t index);
+		uint32_t GetTransformIndex();
+		// Drawn into the OcclusionRasterizer's depth buffer so it can hide other objects. Regular (non instanced) objects only, read when the rasterizer is built
+		void SetOccluder(bool b_occluder);
+		bool IsOccluder();
 
 	private:
 		Model m_model;
 		std::shared_ptr<Material> m_material;
-		VkDescriptorPool m_descriptorPool;
-		std::vector<VkDescriptorSet> m_descriptorSets;
+		std::vector<VkDescriptorSet> m_descriptorSets; // owned by the DescriptorAllocator
+		uint32_t m_objectIndex;
+		glm::vec4 m_instanceParams;
+		uint32_t m_transformIndex;
+		bool m_b_occluder;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,400 @@
+#include "GeometryArena.h"
+#include "WinSys.h"
+#include "VulkanManager.h"
+
+#include <iostream>
+#include <algorithm>
+
+
+namespace VCore
+{
+    GeometryArena::GeometryArena()
+    {
+        m_vertexFormat = VertexFormat::FULL;
+        m_vertexStride = VertexCodec::GetStride(VertexFormat::FULL);
+        m_pages = std::vector<std::unique_ptr<Page>>();
+        m_ranges = std::vector<std::unique_ptr<GeometryRange>>();
+        m_encodedVertices = std::vector<uint8_t>();
+        m_narrowIndices = std::vector<uint16_t>();
+        m_compactions = 0;
+        m_bytesMoved = 0;
+        m_pagesReleased = 0;
+    }
+
+    GeometryArena::~GeometryArena()
+    {
+    }
+
+    void GeometryArena::Cleanup(LogicalDevice& logicalDevice)
+    {
+        for (std::unique_ptr<Page>& page : m_pages)
+        {
+            DestroyPage(*page, logicalDevice);
+        }
+        m_pages.clear();
+        m_ranges.clear();
+    }
+
+    void GeometryArena::SetVertexFormat(VertexFormat format)
+    {
+        m_vertexFormat = format;
+        m_vertexStride = VertexCodec::GetStride(format);
+    }
+
+    VertexFormat GeometryArena::GetVertexFormat()
+    {
+        return m_vertexFormat;
+    }
+
+    uint32_t GeometryArena::GetVertexStride()
+    {
+        return m_vertexStride;
+    }
+
+    GeometryRange* GeometryArena::Allocate(const MeshView& meshView, UploadQueue& uploadQueue, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice)
+    {
+        uint32_t ui_pageIndex = UINT32_MAX;
+        uint32_t ui_firstVertex = 0;
+        uint32_t ui_firstIndex = 0;
+        uint32_t ui_indexCount = meshView.GetTotalIndexCount();
+        VkIndexType indexType = GetIndexType(meshView.vertexCount);
+
+        // First page of the right index type with room for both, a page short on indices gets its vertices back
+        for (uint32_t p = 0; p < static_cast<uint32_t>(m_pages.size()) && ui_pageIndex == UINT32_MAX; p++)
+        {
+            Page& page = *m_pages[p];
+            if (page.indexType != indexType || !TakeRange(page.freeVertices, meshView.vertexCount, ui_firstVertex))
+            {
+                continue;
+            }
+            if (!TakeRange(page.freeIndices, ui_indexCount, ui_firstIndex))
+            {
+                ReturnRange(page.freeVertices, ui_firstVertex, meshView.vertexCount);
+                continue;
+            }
+            ui_pageIndex = p;
+        }
+
+        if (ui_pageIndex == UINT32_MAX)
+        {
+            m_pages.push_back(CreatePage(std::max(VM_GEOMETRY_PAGE_VERTICES, meshView.vertexCount), std::max(VM_GEOMETRY_PAGE_INDICES, ui_indexCount), indexType, physicalDevice, logicalDevice));
+            ui_pageIndex = static_cast<uint32_t>(m_pages.size() - 1);
+            TakeRange(m_pages.back()->freeVertices, meshView.vertexCount, ui_firstVertex);
+            TakeRange(m_pages.back()->freeIndices, ui_indexCount, ui_firstIndex);
+        }
+
+        Page& page = *m_pages[ui_pageIndex];
+        page.usedVertices += meshView.vertexCount;
+        page.usedIndices += ui_indexCount;
+        page.rangeCount++;
+
+        // Full vertices go up as they are, compact ones are encoded first
+        std::unique_ptr<GeometryRange> range = std::make_unique<GeometryRange>();
+        const void* vertexData = meshView.vertices;
+        if (m_vertexFormat != VertexFormat::FULL)
+        {
+            VertexCodec::Encode(m_vertexFormat, meshView.vertices, meshView.vertexCount, meshView.bounds, m_encodedVertices, range->positionOffset, range->positionScale);
+            vertexData = m_encodedVertices.data();
+        }
+
+        // The staging buffer is the upload queue's shared ring, and the copies are batched with every other upload. They stay on the graphics queue:
+        // the page is exclusive to it and may be drawn from while this range fills, so it can't be handed to the transfer queue and back
+        if (meshView.vertexCount > 0)
+        {
+            uploadQueue.UploadBuffer(vertexData, static_cast<VkDeviceSize>(m_vertexStride) * meshView.vertexCount, page.vertexBuffer, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, static_cast<VkDeviceSize>(m_vertexStride) * ui_firstVertex, true);
+        }
+        if (ui_indexCount > 0)
+        {
+            const void* indexData = meshView.indices;
+            if (indexType == VK_INDEX_TYPE_UINT16)
+            {
+                m_narrowIndices.assign(meshView.indices, meshView.indices + ui_indexCount); // every index is below the vertex count, so nothing is cut off
+                indexData = m_narrowIndices.data();
+            }
+            VkDeviceSize indexSize = GetIndexSize(indexType);
+            uploadQueue.UploadBuffer(indexData, indexSize * ui_indexCount, page.indexBuffer, VK_ACCESS_INDEX_READ_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, indexSize * ui_firstIndex, true);
+        }
+
+        range->vertexBuffer = page.vertexBuffer;
+        range->indexBuffer = page.indexBuffer;
+        range->indexType = indexType;
+        range->page = ui_pageIndex;
+        range->firstVertex = ui_firstVertex;
+        range->vertexCount = meshView.vertexCount;
+        range->firstIndex = ui_firstIndex;
+        range->indexCount = meshView.indexCount;
+        range->totalIndexCount = ui_indexCount;
+
+        // A mesh without LODs is its own only one
+        range->lodCount = std::max(meshView.lodCount, 1u);
+        range->lods[0] = { 0, meshView.indexCount, 0.0f, 0 };
+        for (uint32_t l = 0; l < meshView.lodCount; l++)
+        {
+            range->lods[l] = meshView.lods[l];
+        }
+        for (uint32_t l = 0; l < range->lodCount; l++)
+        {
+            range->lods[l].firstIndex += ui_firstIndex;
+        }
+        m_ranges.push_back(std::move(range));
+
+        return m_ranges.back().get();
+    }
+
+    void GeometryArena::Free(GeometryRange* range)
+    {
+        auto existing = std::find_if(m_ranges.begin(), m_ranges.end(), [range](const std::unique_ptr<GeometryRange>& owned) { return owned.get() == range; });
+        if (existing == m_ranges.end())
+        {
+            return;
+        }
+
+        // An emptied page is kept for the next meshes, only Compact releases it
+        Page& page = *m_pages[range->page];
+        ReturnRange(page.freeVertices, range->firstVertex, range->vertexCount);
+        ReturnRange(page.freeIndices, range->firstIndex, range->totalIndexCount);
+        page.usedVertices -= range->vertexCount;
+        page.usedIndices -= range->totalIndexCount;
+        page.rangeCount--;
+
+        std::swap(*existing, m_ranges.back());
+        m_ranges.pop_back();
+    }
+
+    void GeometryArena::Compact(UploadQueue& uploadQueue, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice)
+    {
+        // Every upload into the old pages has to land before they're copied from
+        uploadQueue.WaitIdle();
+
+        // Keeping the old order (page, then offset) moves neighbours together
+        std::vector<GeometryRange*> live;
+        for (std::unique_ptr<GeometryRange>& range : m_ranges)
+        {
+            live.push_back(range.get());
+        }
+        std::sort(live.begin(), live.end(), [](const GeometryRange* a, const GeometryRange* b) { return a->page != b->page ? a->page < b->page : a->firstVertex < b->firstVertex; });
+
+        VkCommandBuffer commandBuffer = uploadQueue.GetGraphicsCommands();
+
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        // Ranges are laid end to end, a new page of their index type is started whenever the next one doesn't fit in the last
+        std::vector<std::unique_ptr<Page>> packed;
+        uint32_t targets[2] = { UINT32_MAX, UINT32_MAX }; // packed page being filled, per index type
+        for (GeometryRange* range : live)
+        {
+            uint32_t& ui_target = targets[range->indexType == VK_INDEX_TYPE_UINT16 ? 0 : 1];
+            Page* target = ui_target == UINT32_MAX ? nullptr : packed[ui_target].get();
+            if (target == nullptr || target->usedVertices + range->vertexCount > target->vertexCapacity || target->usedIndices + range->totalIndexCount > target->indexCapacity)
+            {
+                packed.push_back(CreatePage(std::max(VM_GEOMETRY_PAGE_VERTICES, range->vertexCount), std::max(VM_GEOMETRY_PAGE_INDICES, range->totalIndexCount), range->indexType, physicalDevice, logicalDevice));
+                ui_target = static_cast<uint32_t>(packed.size() - 1);
+                target = packed.back().get();
+            }
+
+            Page& source = *m_pages[range->page];
+            if (range->vertexCount > 0)
+            {
+                VkBufferCopy copyRegion{};
+                copyRegion.srcOffset = static_cast<VkDeviceSize>(m_vertexStride) * range->firstVertex;
+                copyRegion.dstOffset = static_cast<VkDeviceSize>(m_vertexStride) * target->usedVertices;
+                copyRegion.size = static_cast<VkDeviceSize>(m_vertexStride) * range->vertexCount;
+                vkCmdCopyBuffer(commandBuffer, source.vertexBuffer, target->vertexBuffer, 1, &copyRegion);
+                m_bytesMoved += copyRegion.size;
+            }
+            if (range->totalIndexCount > 0)
+            {
+                VkBufferCopy copyRegion{};
+                VkDeviceSize indexSize = GetIndexSize(range->indexType);
+                copyRegion.srcOffset = indexSize * range->firstIndex;
+                copyRegion.dstOffset = indexSize * target->usedIndices;
+                copyRegion.size = indexSize * range->totalIndexCount;
+                vkCmdCopyBuffer(commandBuffer, source.indexBuffer, target->indexBuffer, 1, &copyRegion);
+                m_bytesMoved += copyRegion.size;
+            }
+
+            range->vertexBuffer = target->vertexBuffer;
+            range->indexBuffer = target->indexBuffer;
+            range->page = ui_target;
+            range->firstVertex = target->usedVertices;
+            for (uint32_t l = 0; l < range->lodCount; l++)
+            {
+                range->lods[l].firstIndex = range->lods[l].firstIndex - range->firstIndex + target->usedIndices;
+            }
+            range->firstIndex = target->usedIndices;
+            target->usedVertices += range->vertexCount;
+            target->usedIndices += range->totalIndexCount;
+            target->rangeCount++;
+        }
+
+        // What's left of each page is one free range at its end
+        for (std::unique_ptr<Page>& page : packed)
+        {
+            page->freeVertices.clear();
+            page->freeIndices.clear();
+            ReturnRange(page->freeVertices, page->usedVertices, page->vertexCapacity - page->usedVertices);
+            ReturnRange(page->freeIndices, page->usedIndices, page->indexCapacity - page->usedIndices);
+        }
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        // The old pages can only go once the copies out of them are done
+        uploadQueue.WaitIdle();
+        for (std::unique_ptr<Page>& page : m_pages)
+        {
+            DestroyPage(*page, logicalDevice);
+        }
+        if (m_pages.size() > packed.size())
+        {
+            m_pagesReleased += static_cast<uint32_t>(m_pages.size() - packed.size());
+        }
+        m_pages = std::move(packed);
+        m_compactions++;
+    }
+
+    std::unique_ptr<GeometryArena::Page> GeometryArena::CreatePage(uint32_t vertexCapacity, uint32_t indexCapacity, VkIndexType indexType, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice)
+    {
+        std::unique_ptr<Page> page = std::make_unique<Page>();
+        page->indexType = indexType;
+        page->vertexCapacity = vertexCapacity;
+        page->indexCapacity = indexCapacity;
+        page->freeVertices.push_back({ 0, vertexCapacity });
+        page->freeIndices.push_back({ 0, indexCapacity });
+
+        // Transfer source too, so Compact can copy out of it
+        WinSys::CreateBuffer(static_cast<VkDeviceSize>(m_vertexStride) * vertexCapacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, page->vertexBuffer, page->vertexMemory, physicalDevice, logicalDevice);
+        WinSys::CreateBuffer(static_cast<VkDeviceSize>(GetIndexSize(indexType)) * indexCapacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, page->indexBuffer, page->indexMemory, physicalDevice, logicalDevice);
+
+        return page;
+    }
+
+    void GeometryArena::DestroyPage(Page& page, LogicalDevice& logicalDevice)
+    {
+        vkDestroyBuffer(logicalDevice.GetDevice(), page.indexBuffer, nullptr);
+        logicalDevice.GetAllocator().Free(page.indexMemory);
+        vkDestroyBuffer(logicalDevice.GetDevice(), page.vertexBuffer, nullptr);
+        logicalDevice.GetAllocator().Free(page.vertexMemory);
+        page.indexBuffer = VK_NULL_HANDLE;
+        page.vertexBuffer = VK_NULL_HANDLE;
+    }
+
+    VkIndexType GeometryArena::GetIndexType(uint32_t vertexCount)
+    {
+        // Indices are relative to the mesh's first vertex, the largest is vertexCount - 1
+        return vertexCount <= 65536 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    }
+
+    uint32_t GeometryArena::GetIndexSize(VkIndexType indexType)
+    {
+        return indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    }
+
+    bool GeometryArena::TakeRange(std::vector<FreeRange>& freeRanges, uint32_t count, uint32_t& first)
+    {
+        first = 0;
+        if (count == 0)
+        {
+            return true;
+        }
+
+        for (size_t i = 0; i < freeRanges.size(); i++)
+        {
+            if (freeRanges[i].count < count)
+            {
+                continue;
+            }
+
+            first = freeRanges[i].first;
+            if (freeRanges[i].count == count)
+            {
+                freeRanges.erase(freeRanges.begin() + i);
+            }
+            else
+            {
+                freeRanges[i].first += count;
+                freeRanges[i].count -= count;
+            }
+            return true;
+        }
+
+        return false;
+    }
+
+    void GeometryArena::ReturnRange(std::vector<FreeRange>& freeRanges, uint32_t first, uint32_t count)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        // Keep the ranges sorted and merge with the free neighbours on either side, so bigger meshes fit again
+        auto next = std::lower_bound(freeRanges.begin(), freeRanges.end(), first, [](const FreeRange& range, uint32_t value) { return range.first < value; });
+        auto inserted = freeRanges.insert(next, { first, count });
+
+        if (inserted + 1 != freeRanges.end() && inserted->first + inserted->count == (inserted + 1)->first)
+        {
+            inserted->count += (inserted + 1)->count;
+            freeRanges.erase(inserted + 1);
+        }
+
+        if (inserted != freeRanges.begin() && (inserted - 1)->first + (inserted - 1)->count == inserted->first)
+        {
+            (inserted - 1)->count += inserted->count;
+            freeRanges.erase(inserted);
+        }
+    }
+
+    GeometryArena::StreamStats GeometryArena::GetStreamStats(bool b_indices)
+    {
+        StreamStats stats;
+        for (std::unique_ptr<Page>& page : m_pages)
+        {
+            const std::vector<FreeRange>& freeRanges = b_indices ? page->freeIndices : page->freeVertices;
+            uint64_t elementSize = b_indices ? GetIndexSize(page->indexType) : m_vertexStride;
+            stats.capacity += elementSize * (b_indices ? page->indexCapacity : page->vertexCapacity);
+            stats.used += elementSize * (b_indices ? page->usedIndices : page->usedVertices);
+            stats.freeRanges += static_cast<uint32_t>(freeRanges.size());
+            for (const FreeRange& range : freeRanges)
+            {
+                stats.largestFree = std::max(stats.largestFree, elementSize * range.count);
+            }
+        }
+        return stats;
+    }
+
+    void GeometryArena::PrintStreamStats(const char* name, const StreamStats& stats)
+    {
+        // Fragmentation is how much of the free space is outside the largest free range, 0% when it's all in one piece
+        uint64_t free = stats.capacity - stats.used;
+        float f_fill = stats.capacity > 0 ? 100.0f * stats.used / stats.capacity : 0.0f;
+        float f_fragmentation = free > 0 ? 100.0f * (1.0f - static_cast<float>(stats.largestFree) / free) : 0.0f;
+        std::cout << "  " << name << ": " << stats.used / 1024 << " KiB used of " << stats.capacity / 1024 << " KiB (" << f_fill << "% full), "
+            << stats.freeRanges << " free ranges, largest " << stats.largestFree / 1024 << " KiB, " << f_fragmentation << "% fragmented" << std::endl;
+    }
+
+    void GeometryArena::PrintStats()
+    {
+        std::cout << "geometry arena: " << m_ranges.size() << " meshes in " << m_pages.size() << " pages, " << m_compactions << " compactions (" << m_bytesMoved / 1024 << " KiB moved, "
+            << m_pagesReleased << " pages released)" << std::endl;
+        PrintStreamStats("vertices", GetStreamStats(false));
+        PrintStreamStats("indices", GetStreamStats(true));
+
+        uint32_t ui_narrowRanges = 0;
+        uint64_t indicesSaved = 0;
+        for (std::unique_ptr<GeometryRange>& range : m_ranges)
+        {
+            if (range->indexType == VK_INDEX_TYPE_UINT16)
+            {
+                ui_narrowRanges++;
+                indicesSaved += range->totalIndexCount;
+            }
+        }
+        std::cout << "  " << ui_narrowRanges << " of " << m_ranges.size() << " meshes use 16 bit indices, " << indicesSaved * (sizeof(uint32_t) - sizeof(uint16_t)) / 1024 << " KiB saved" << std::endl;
+    }
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include "Structs.h"
+#include "PhysicalDevice.h"
+#include "LogicalDevice.h"
+#include "MemoryAllocator.h"
+#include "UploadQueue.h"
+#include "MeshCache.h"
+#include "VertexCodec.h"
+
+#define GLFW_INCLUDE_VULKAN
+#include <glfw3.h>
+
+#include <vector>
+#include <memory>
+
+
+namespace VCore
+{
+	// Where one mesh lives inside the GeometryArena. Draw with vertexOffset = firstVertex and firstIndex out of the page's buffers, bound as indexType.
+	// firstIndex and indexCount are the full detail triangles, lods[l] the same for each level of detail (lods[0] included), all over the same vertices
+	struct GeometryRange
+	{
+		glm::vec3 positionOffset = glm::vec3(0.0f); // object space position = positionOffset + stored position * positionScale, see VertexCodec
+		glm::vec3 positionScale = glm::vec3(1.0f);
+		VkBuffer vertexBuffer = VK_NULL_HANDLE;
+		VkBuffer indexBuffer = VK_NULL_HANDLE;
+		VkIndexType indexType = VK_INDEX_TYPE_UINT32; // the page's, UINT16 whenever the mesh has few enough vertices
+		uint32_t page = 0;
+		uint32_t firstVertex = 0;
+		uint32_t vertexCount = 0;
+		uint32_t firstIndex = 0;
+		uint32_t indexCount = 0;
+		uint32_t totalIndexCount = 0; // every LOD's, what the range takes up in the page
+		uint32_t lodCount = 1;
+		MeshLod lods[MESH_MAX_LODS] = {};
+	};
+
+	// Refer to - https://vulkan-tutorial.com/en/Vertex_buffers/Index_buffer (Conclusion) and https://developer.nvidia.com/vulkan-memory-management
+	// Sub-allocates every mesh's vertices and indices out of a few large device local "pages", one vertex buffer and one index buffer each, instead of two buffers per mesh.
+	// Consecutive draws of different meshes then share their vertex and index buffer binds, and only differ in firstIndex and vertexOffset.
+	// Each page keeps its free vertex and index ranges sorted and merged with their neighbours, like the MemoryAllocator's FREE_LIST blocks. Pages are added as they fill up
+	// (VM_GEOMETRY_PAGE_VERTICES / VM_GEOMETRY_PAGE_INDICES, or just big enough for a mesh that wouldn't fit in one).
+	// Meshes with at most 65536 vertices (almost all of them) have their indices narrowed to 16 bits on upload and go into pages whose index buffers are UINT16,
+	// the indices count from the mesh's own first vertex so only the vertex count matters, not where in the page the mesh lands.
+	// Unloading meshes leaves holes behind, Compact packs what's left into as few pages as it fits in. GeometryRanges stay where they are in memory and are updated in place,
+	// so holding on to one across a Compact is fine. Not thread safe, the MeshRegistry calls it under its lock.
+	class GeometryArena
+	{
+	public:
+		GeometryArena();
+		~GeometryArena();
+
+		// Destroys every page. Every range handed out is gone too
+		void Cleanup(LogicalDevice& logicalDevice);
+		// What vertices are stored as, call before the first Allocate. Defaults to VertexFormat::FULL
+		void SetVertexFormat(VertexFormat format);
+		VertexFormat GetVertexFormat();
+		uint32_t GetVertexStride(); // bytes per stored vertex
+
+		// Finds room for meshView's vertices and every LOD's indices (adding a page if none has any), encodes the vertices and indices and uploads them there. The range stays valid until the matching Free
+		GeometryRange* Allocate(const MeshView& meshView, UploadQueue& uploadQueue, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
+		// Returns range's space to its page. Like destroying a buffer, nothing in flight may still draw from it
+		void Free(GeometryRange* range);
+		// Copies every live range into freshly packed pages and destroys the old ones. Nothing may use the arena's buffers while it runs (wait for the device first),
+		// and anything that captured a range's buffers or offsets has to read them again afterwards. Waits for the copies to finish before returning
+		void Compact(UploadQueue& uploadQueue, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
+		void PrintStats();
+
+	private:
+		struct FreeRange
+		{
+			uint32_t first;
+			uint32_t count;
+		};
+
+		struct Page
+		{
+			VkBuffer vertexBuffer = VK_NULL_HANDLE;
+			VkBuffer indexBuffer = VK_NULL_HANDLE;
+			Allocation vertexMemory;
+			Allocation indexMemory;
+			VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+			uint32_t vertexCapacity = 0;
+			uint32_t indexCapacity = 0;
+			std::vector<FreeRange> freeVertices; // sorted by first
+			std::vector<FreeRange> freeIndices;
+			uint32_t usedVertices = 0;
+			uint32_t usedIndices = 0;
+			uint32_t rangeCount = 0;
+		};
+
+		// Free space of one stream (vertices or indices) across every page, in bytes since index pages come in two sizes
+		struct StreamStats
+		{
+			uint64_t capacity = 0;
+			uint64_t used = 0;
+			uint32_t freeRanges = 0;
+			uint64_t largestFree = 0;
+		};
+
+		std::unique_ptr<Page> CreatePage(uint32_t vertexCapacity, uint32_t indexCapacity, VkIndexType indexType, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
+		static VkIndexType GetIndexType(uint32_t vertexCount);
+		static uint32_t GetIndexSize(VkIndexType indexType);
+		void DestroyPage(Page& page, LogicalDevice& logicalDevice);
+		// First fit. A count of 0 always succeeds without taking anything
+		static bool TakeRange(std::vector<FreeRange>& freeRanges, uint32_t count, uint32_t& first);
+		static void ReturnRange(std::vector<FreeRange>& freeRanges, uint32_t first, uint32_t count);
+		StreamStats GetStreamStats(bool b_indices);
+		static void PrintStreamStats(const char* name, const StreamStats& stats);
+
+		VertexFormat m_vertexFormat;
+		uint32_t m_vertexStride;
+		std::vector<std::unique_ptr<Page>> m_pages;
+		std::vector<std::unique_ptr<GeometryRange>> m_ranges;
+		std::vector<uint8_t> m_encodedVertices; // scratch for Allocate, the upload queue copies out of it right away
+		std::vector<uint16_t> m_narrowIndices; // same for 16 bit indices
+
+		// stats
+		uint32_t m_compactions;
+		uint64_t m_bytesMoved; // by every Compact
+		uint32_t m_pagesReleased; // by every Compact
+	};
+}
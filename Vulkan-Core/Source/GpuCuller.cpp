@@ -0,0 +1,427 @@
+#include "GpuCuller.h"
+#include "GameObject.h"
+#include "VulkanManager.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+
+namespace VCore
+{
+    GpuCuller::GpuCuller()
+    {
+        m_b_drawIndirectCount = false;
+        m_depthPyramid = nullptr;
+        m_phaseCount = 1;
+        m_phase = 0;
+        m_descriptorSetLayout = VK_NULL_HANDLE;
+        m_pipelineLayout = VK_NULL_HANDLE;
+        m_pipeline = VK_NULL_HANDLE;
+        m_batches = std::vector<InstanceBatch>();
+        m_transformIndices = std::vector<uint32_t>();
+        m_initialDrawCommands = std::vector<VkDrawIndexedIndirectCommand>();
+        m_instanceCount = 0;
+        m_instanceBatchBuffer = VK_NULL_HANDLE;
+        m_instanceBatchMemory = Allocation();
+        m_batchBuffer = VK_NULL_HANDLE;
+        m_batchMemory = Allocation();
+        m_visibilityBuffer = VK_NULL_HANDLE;
+        m_visibilityMemory = Allocation();
+        m_b_visibilityCleared = false;
+        m_frameBindings = std::vector<std::vector<DescriptorBinding>>();
+        m_descriptorSets = std::vector<VkDescriptorSet>();
+        m_b_frameSubmitted = std::vector<char>();
+        m_visibleTotal = 0;
+        m_lateTotal = 0;
+        m_frustumCulledTotal = 0;
+        m_occlusionCulledTotal = 0;
+        m_lastVisible = 0;
+        m_framesReadBack = 0;
+    }
+
+    GpuCuller::~GpuCuller()
+    {
+    }
+
+    void GpuCuller::Init(const std::string& shaderPath, bool b_drawIndirectCount, DepthPyramid* depthPyramid, PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice)
+    {
+        m_b_drawIndirectCount = b_drawIndirectCount;
+        m_depthPyramid = depthPyramid;
+        m_phaseCount = depthPyramid != nullptr ? 2 : 1;
+
+        // See Shaders/cull.comp - storage buffers, then the visibility buffer, occlusion constants and pyramid of the occlusion build
+        std::vector<VkDescriptorSetLayoutBinding> bindings(depthPyramid != nullptr ? 10 : 7);
+        for (uint32_t i = 0; i < bindings.size(); i++)
+        {
+            bindings[i].binding = i;
+            bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[i].descriptorCount = 1;
+            bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+            bindings[i].pImmutableSamplers = nullptr;
+        }
+        if (depthPyramid != nullptr)
+        {
+            bindings[8].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            bindings[9].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        }
+        m_descriptorSetLayout = pipelineRegistry.AcquireDescriptorSetLayout(bindings, logicalDevice);
+
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(CullPushConstants);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &m_descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+        if (vkCreatePipelineLayout(logicalDevice.GetDevice(), &pipelineLayoutInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create culling pipeline layout!");
+        }
+
+        m_pipeline = pipelineRegistry.CreateComputePipeline(shaderPath, m_pipelineLayout, logicalDevice);
+
+        m_b_frameSubmitted.assign(VM_MAX_FRAMES_IN_FLIGHT, 0);
+    }
+
+    void GpuCuller::Cleanup(PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice)
+    {
+        DestroyBuffers(logicalDevice);
+        vkDestroyPipeline(logicalDevice.GetDevice(), m_pipeline, nullptr);
+        vkDestroyPipelineLayout(logicalDevice.GetDevice(), m_pipelineLayout, nullptr);
+        pipelineRegistry.ReleaseDescriptorSetLayout(m_descriptorSetLayout, logicalDevice);
+        m_pipeline = VK_NULL_HANDLE;
+        m_pipelineLayout = VK_NULL_HANDLE;
+        m_descriptorSetLayout = VK_NULL_HANDLE;
+    }
+
+    void GpuCuller::DestroyBuffers(LogicalDevice& logicalDevice)
+    {
+        // Only called from Build and Cleanup, before any frame that could still be reading the old buffers is recorded
+        std::vector<std::pair<VkBuffer*, Allocation*>> buffers = { { &m_instanceBatchBuffer, &m_instanceBatchMemory }, { &m_batchBuffer, &m_batchMemory }, { &m_visibilityBuffer, &m_visibilityMemory } };
+        for (size_t i = 0; i < m_inputBuffers.size(); i++)
+        {
+            buffers.push_back({ &m_inputBuffers[i], &m_inputMemory[i] });
+            buffers.push_back({ &m_instanceBuffers[i], &m_instanceMemory[i] });
+            buffers.push_back({ &m_drawCommandBuffers[i], &m_drawCommandMemory[i] });
+            buffers.push_back({ &m_drawCountBuffers[i], &m_drawCountMemory[i] });
+            buffers.push_back({ &m_counterBuffers[i], &m_counterMemory[i] });
+            buffers.push_back({ &m_occlusionBuffers[i], &m_occlusionMemory[i] });
+        }
+
+        for (std::pair<VkBuffer*, Allocation*>& buffer : buffers)
+        {
+            if (*buffer.first != VK_NULL_HANDLE)
+            {
+                vkDestroyBuffer(logicalDevice.GetDevice(), *buffer.first, nullptr);
+                logicalDevice.GetAllocator().Free(*buffer.second);
+                *buffer.first = VK_NULL_HANDLE;
+            }
+        }
+
+        m_inputBuffers.clear();
+        m_inputMemory.clear();
+        m_instanceBuffers.clear();
+        m_instanceMemory.clear();
+        m_drawCommandBuffers.clear();
+        m_drawCommandMemory.clear();
+        m_drawCountBuffers.clear();
+        m_drawCountMemory.clear();
+        m_counterBuffers.clear();
+        m_counterMemory.clear();
+        m_occlusionBuffers.clear();
+        m_occlusionMemory.clear();
+    }
+
+    void GpuCuller::Build(InstanceBatcher& instanceBatcher, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice)
+    {
+        DestroyBuffers(logicalDevice);
+
+        m_batches = instanceBatcher.GetBatches();
+        m_transformIndices = instanceBatcher.GetTransformIndices();
+        m_instanceCount = static_cast<uint32_t>(m_transformIndices.size());
+        m_b_visibilityCleared = false;
+        std::fill(m_b_frameSubmitted.begin(), m_b_frameSubmitted.end(), 0);
+        if (m_instanceCount == 0)
+        {
+            return;
+        }
+
+        uint32_t ui_batchCount = static_cast<uint32_t>(m_batches.size());
+        uint32_t ui_commandCount = ui_batchCount * m_phaseCount;
+        const VkMemoryPropertyFlags hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+        // Which batch every instance belongs to and each batch's bounds never change between Builds
+        WinSys::CreateBuffer(sizeof(uint32_t) * m_instanceCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible, m_instanceBatchBuffer, m_instanceBatchMemory, physicalDevice, logicalDevice);
+        WinSys::CreateBuffer(sizeof(CullBatch) * ui_batchCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible, m_batchBuffer, m_batchMemory, physicalDevice, logicalDevice);
+        if (m_depthPyramid != nullptr)
+        {
+            // Carried from one frame to the next, so there's only one. Cleared by the first RecordCull
+            WinSys::CreateBuffer(sizeof(uint32_t) * m_instanceCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_visibilityBuffer, m_visibilityMemory, physicalDevice, logicalDevice);
+        }
+
+        uint32_t* instanceBatches = static_cast<uint32_t*>(m_instanceBatchMemory.mapped);
+        CullBatch* cullBatches = static_cast<CullBatch*>(m_batchMemory.mapped);
+        m_initialDrawCommands.resize(ui_commandCount);
+        for (uint32_t b = 0; b < ui_batchCount; b++)
+        {
+            const InstanceBatch& batch = m_batches[b];
+            std::fill(instanceBatches + batch.firstInstance, instanceBatches + batch.firstInstance + batch.instanceCount, b);
+
+            const MeshBounds& bounds = batch.object->GetModel().GetMesh()->GetBounds();
+            CullBatch cullBatch{};
+            cullBatch.sphere = glm::vec4(bounds.center, bounds.radius);
+            cullBatch.firstInstance = batch.firstInstance;
+            cullBatches[b] = cullBatch;
+
+            // instanceCount is what the shader counts up from. Each phase packs its survivors into its own copy of the instance range, phase 1's starting m_instanceCount in
+            // (drawIndirectFirstInstance, VulkanManager::UseGpuCulling turns occlusion culling off along with GPU culling without it)
+            for (uint32_t phase = 0; phase < m_phaseCount; phase++)
+            {
+                VkDrawIndexedIndirectCommand& command = m_initialDrawCommands[phase * ui_batchCount + b];
+                command.instanceCount = 0;
+                command.firstInstance = phase * m_instanceCount + batch.firstInstance;
+            }
+        }
+        RefreshGeometry();
+
+        // One of everything the frame writes per frame in flight, so the CPU can fill next frame's while the GPU still culls and draws the last one
+        m_inputBuffers.resize(VM_MAX_FRAMES_IN_FLIGHT);
+        m_inputMemory.resize(VM_MAX_FRAMES_IN_FLIGHT);
+        m_instanceBuffers.resize(VM_MAX_FRAMES_IN_FLIGHT);
+        m_instanceMemory.resize(VM_MAX_FRAMES_IN_FLIGHT);
+        m_drawCommandBuffers.resize(VM_MAX_FRAMES_IN_FLIGHT);
+        m_drawCommandMemory.resize(VM_MAX_FRAMES_IN_FLIGHT);
+        m_drawCountBuffers.resize(VM_MAX_FRAMES_IN_FLIGHT);
+        m_drawCountMemory.resize(VM_MAX_FRAMES_IN_FLIGHT);
+        m_counterBuffers.resize(VM_MAX_FRAMES_IN_FLIGHT);
+        m_counterMemory.resize(VM_MAX_FRAMES_IN_FLIGHT);
+        m_occlusionBuffers.resize(VM_MAX_FRAMES_IN_FLIGHT);
+        m_occlusionMemory.resize(VM_MAX_FRAMES_IN_FLIGHT);
+        // The sets themselves are transient, so a set can never outlive the buffers it was written with
+        m_frameBindings.resize(VM_MAX_FRAMES_IN_FLIGHT);
+        m_descriptorSets.assign(VM_MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE);
+
+        std::vector<glm::vec4>& instanceParams = instanceBatcher.GetInstanceParams();
+        for (uint32_t frame = 0; frame < VM_MAX_FRAMES_IN_FLIGHT; frame++)
+        {
+            VkDeviceSize instanceBytes = sizeof(InstanceData) * m_instanceCount;
+            WinSys::CreateBuffer(instanceBytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible, m_inputBuffers[frame], m_inputMemory[frame], physicalDevice, logicalDevice);
+            // Only ever written and read by the GPU
+            WinSys::CreateBuffer(instanceBytes * m_phaseCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_instanceBuffers[frame], m_instanceMemory[frame], physicalDevice, logicalDevice);
+            WinSys::CreateBuffer(sizeof(VkDrawIndexedIndirectCommand) * ui_commandCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, hostVisible, m_drawCommandBuffers[frame], m_drawCommandMemory[frame], physicalDevice, logicalDevice);
+            WinSys::CreateBuffer(sizeof(uint32_t) * ui_commandCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, hostVisible, m_drawCountBuffers[frame], m_drawCountMemory[frame], physicalDevice, logicalDevice);
+            WinSys::CreateBuffer(sizeof(GpuCullCounters), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible, m_counterBuffers[frame], m_counterMemory[frame], physicalDevice, logicalDevice);
+
+            // Parameters don't change from frame to frame, so every frame's input gets them once here. The shader copies them along with the matrix
+            InstanceData* inputs = static_cast<InstanceData*>(m_inputMemory[frame].mapped);
+            for (uint32_t i = 0; i < m_instanceCount; i++)
+            {
+                inputs[i].params = instanceParams[i];
+            }
+
+            std::vector<DescriptorBinding> descriptorBindings(7);
+            VkBuffer buffers[7] = { m_inputBuffers[frame], m_instanceBatchBuffer, m_batchBuffer, m_instanceBuffers[frame], m_drawCommandBuffers[frame], m_drawCountBuffers[frame], m_counterBuffers[frame] };
+            for (uint32_t i = 0; i < 7; i++)
+            {
+                descriptorBindings[i].binding = i;
+                descriptorBindings[i].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                descriptorBindings[i].buffer = buffers[i];
+                descriptorBindings[i].offset = 0;
+                descriptorBindings[i].range = VK_WHOLE_SIZE;
+            }
+
+            if (m_depthPyramid != nullptr)
+            {
+                WinSys::CreateBuffer(sizeof(OcclusionConstants), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, hostVisible, m_occlusionBuffers[frame], m_occlusionMemory[frame], physicalDevice, logicalDevice);
+
+                descriptorBindings.resize(10);
+                descriptorBindings[7].binding = 7;
+                descriptorBindings[7].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                descriptorBindings[7].buffer = m_visibilityBuffer;
+                descriptorBindings[7].range = VK_WHOLE_SIZE;
+                descriptorBindings[8].binding = 8;
+                descriptorBindings[8].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+                descriptorBindings[8].buffer = m_occlusionBuffers[frame];
+                descriptorBindings[8].range = sizeof(OcclusionConstants);
+                descriptorBindings[9].binding = 9;
+                descriptorBindings[9].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                descriptorBindings[9].imageView = m_depthPyramid->GetImageView();
+                descriptorBindings[9].sampler = m_depthPyramid->GetSampler();
+                descriptorBindings[9].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+            }
+            m_frameBindings[frame] = descriptorBindings;
+        }
+    }
+
+    void GpuCuller::RefreshGeometry()
+    {
+        if (m_instanceCount == 0)
+        {
+            return;
+        }
+
+        // Where each batch's mesh sits in its GeometryArena page
+        uint32_t ui_batchCount = static_cast<uint32_t>(m_batches.size());
+        for (size_t c = 0; c < m_initialDrawCommands.size(); c++)
+        {
+            const GeometryRange& geometry = m_batches[c % ui_batchCount].object->GetModel().GetMesh()->GetGeometry();
+            m_initialDrawCommands[c].indexCount = geometry.indexCount;
+            m_initialDrawCommands[c].firstIndex = geometry.firstIndex;
+            m_initialDrawCommands[c].vertexOffset = static_cast<int32_t>(geometry.firstVertex);
+        }
+    }
+
+    void GpuCuller::WriteInstances(uint32_t frame, TransformSystem& transformSystem, FrustumCuller& frustumCuller, JobSystem& jobSystem)
+    {
+        if (m_instanceCount == 0)
+        {
+            return;
+        }
+
+        // The fence for this frame has been waited on, so the counts the shader left here are final
+        VkDrawIndexedIndirectCommand* drawCommands = static_cast<VkDrawIndexedIndirectCommand*>(m_drawCommandMemory[frame].mapped);
+        GpuCullCounters* counters = static_cast<GpuCullCounters*>(m_counterMemory[frame].mapped);
+        if (m_b_frameSubmitted[frame])
+        {
+            m_lastVisible = 0;
+            for (size_t c = 0; c < m_initialDrawCommands.size(); c++)
+            {
+                m_lastVisible += drawCommands[c].instanceCount;
+                if (c >= m_batches.size())
+                {
+                    m_lateTotal += drawCommands[c].instanceCount;
+                }
+            }
+            m_visibleTotal += m_lastVisible;
+            m_frustumCulledTotal += counters->frustumCulled;
+            m_occlusionCulledTotal += counters->occlusionCulled;
+            m_framesReadBack++;
+            // Culled is whatever wasn't drawn by either phase - phase 1 may count an instance phase 0 already drew as occluded
+            frustumCuller.AddStats(m_instanceCount, m_instanceCount - std::min(m_lastVisible, m_instanceCount));
+        }
+
+        memcpy(drawCommands, m_initialDrawCommands.data(), sizeof(VkDrawIndexedIndirectCommand) * m_initialDrawCommands.size());
+        memset(m_drawCountMemory[frame].mapped, 0, sizeof(uint32_t) * m_initialDrawCommands.size());
+        memset(counters, 0, sizeof(GpuCullCounters));
+
+        // Only the model matrix of each InstanceData is written, the parameters next to it are left alone
+        InstanceData* inputs = static_cast<InstanceData*>(m_inputMemory[frame].mapped);
+        transformSystem.ComputeWorld(m_transformIndices.data(), m_instanceCount, &inputs[0].model, sizeof(InstanceData), jobSystem);
+    }
+
+    void GpuCuller::RecordCull(VkCommandBuffer commandBuffer, uint32_t frame, FrustumCuller& frustumCuller, DescriptorAllocator& descriptorAllocator, LogicalDevice& logicalDevice, uint32_t phase)
+    {
+        m_phase = phase;
+        if (m_instanceCount == 0)
+        {
+            return;
+        }
+
+        if (m_depthPyramid != nullptr && phase == 0)
+        {
+            if (!m_b_visibilityCleared)
+            {
+                // Nothing was visible before the first frame, so it all goes through phase 1
+                vkCmdFillBuffer(commandBuffer, m_visibilityBuffer, 0, VK_WHOLE_SIZE, 0);
+                m_b_visibilityCleared = true;
+            }
+
+            // Last frame's phase 1 (or the clear) wrote the visibility this phase reads
+            VkMemoryBarrier visibilityBarrier{};
+            visibilityBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            visibilityBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+            visibilityBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &visibilityBarrier, 0, nullptr, 0, nullptr);
+
+            // Written before the command buffer is submitted, the same matrix the CPU culls with
+            OcclusionConstants occlusionConstants{};
+            occlusionConstants.viewProj = frustumCuller.GetViewProj();
+            occlusionConstants.pyramidSize = glm::vec2(static_cast<float>(m_depthPyramid->GetWidth()), static_cast<float>(m_depthPyramid->GetHeight()));
+            occlusionConstants.pyramidLevels = m_depthPyramid->GetLevelCount();
+            memcpy(m_occlusionMemory[frame].mapped, &occlusionConstants, sizeof(OcclusionConstants));
+        }
+
+        CullPushConstants pushConstants{};
+        frustumCuller.GetPlanes(pushConstants.planes);
+        pushConstants.objectOffset = glm::vec4(frustumCuller.GetObjectOffset(), 0.0f);
+        pushConstants.instanceCount = m_instanceCount;
+        pushConstants.batchCount = static_cast<uint32_t>(m_batches.size());
+        pushConstants.phase = phase;
+
+        // A new set from the frame's transient pools every frame, phase 1 binds the same one. The pools are reset in one go once the frame's fence has been waited on
+        if (phase == 0)
+        {
+            m_descriptorSets[frame] = descriptorAllocator.AllocateTransient(frame, m_descriptorSetLayout, logicalDevice);
+            descriptorAllocator.Update(m_descriptorSets[frame], m_frameBindings[frame], logicalDevice);
+        }
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &m_descriptorSets[frame], 0, nullptr);
+        vkCmdPushConstants(commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstants), &pushConstants);
+        vkCmdDispatch(commandBuffer, (m_instanceCount + 63) / 64, 1, 1); // local_size_x = 64
+
+        // The draws read the commands, counts and packed instances, and the CPU reads the commands back once the frame's fence is signaled
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+            0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        m_b_frameSubmitted[frame] = 1;
+    }
+
+    void GpuCuller::RecordDraw(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t batch)
+    {
+        uint32_t ui_command = m_phase * static_cast<uint32_t>(m_batches.size()) + batch;
+        VkDeviceSize commandOffset = sizeof(VkDrawIndexedIndirectCommand) * ui_command;
+        if (m_b_drawIndirectCount)
+        {
+            // The count is 0 when nothing in the batch survived, so the GPU skips the draw entirely
+            vkCmdDrawIndexedIndirectCount(commandBuffer, m_drawCommandBuffers[frame], commandOffset, m_drawCountBuffers[frame], sizeof(uint32_t) * ui_command, 1, sizeof(VkDrawIndexedIndirectCommand));
+        }
+        else
+        {
+            vkCmdDrawIndexedIndirect(commandBuffer, m_drawCommandBuffers[frame], commandOffset, 1, sizeof(VkDrawIndexedIndirectCommand));
+        }
+    }
+
+    std::vector<InstanceBatch>& GpuCuller::GetBatches()
+    {
+        return m_batches;
+    }
+
+    VkBuffer& GpuCuller::GetInstanceBuffer(uint32_t frame)
+    {
+        return m_instanceBuffers[frame];
+    }
+
+    void GpuCuller::PrintStats()
+    {
+        std::cout << "gpu culling: " << m_instanceCount << " instances in " << m_batches.size() << " indirect draws" << (m_b_drawIndirectCount ? "" : " (no draw count support)")
+            << (m_depthPyramid != nullptr ? ", occlusion culled against a " + std::to_string(m_depthPyramid->GetLevelCount()) + " level depth pyramid" : "");
+        if (m_framesReadBack > 0)
+        {
+            // Every instance is tested every frame
+            std::cout << ", per frame on average: " << m_instanceCount << " tested, " << m_frustumCulledTotal / m_framesReadBack << " frustum culled";
+            if (m_depthPyramid != nullptr)
+            {
+                std::cout << ", " << m_occlusionCulledTotal / m_framesReadBack << " occlusion culled";
+            }
+            std::cout << ", " << m_visibleTotal / m_framesReadBack << " drawn";
+            if (m_depthPyramid != nullptr)
+            {
+                std::cout << " (" << m_lateTotal / m_framesReadBack << " of them newly visible)";
+            }
+            std::cout << " (last read back " << m_lastVisible << " drawn)";
+        }
+        std::cout << std::endl;
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include "PhysicalDevice.h"
+#include "LogicalDevice.h"
+#include "MemoryAllocator.h"
+#include "DescriptorAllocator.h"
+#include "PipelineRegistry.h"
+#include "InstanceBatcher.h"
+#include "FrustumCuller.h"
+#include "DepthPyramid.h"
+#include "TransformSystem.h"
+#include "JobSystem.h"
+#include "Structs.h"
+
+#define GLFW_INCLUDE_VULKAN
+#include <glfw3.h>
+
+#include <vector>
+#include <string>
+
+
+namespace VCore
+{
+	// Refer to - https://docs.vulkan.org/samples/latest/samples/performance/multi_draw_indirect/README.html
+	// GPU driven path for instanced batches. The CPU only writes every instance's world matrix. A compute shader (Shaders/cull.comp) then tests each instance's
+	// bounding sphere against the frustum and packs the visible ones into a device local instance buffer. It also fills one VkDrawIndexedIndirectCommand and a draw count per batch.
+	// Batches are then drawn with vkCmdDrawIndexedIndirectCount, so the CPU never walks the instances or learns how many survived.
+	// Without the drawIndirectCount feature it falls back to vkCmdDrawIndexedIndirect, where a batch with nothing visible is just an empty draw.
+	// With a DepthPyramid it culls occluded instances too, in two phases: phase 0 lets through what was visible last frame, which is drawn and the pyramid built from.
+	// Phase 1 then tests every instance against the frustum and the pyramid, remembers what's visible for the next frame and draws the newly visible ones.
+	// Regular objects are still culled and drawn by the CPU. The draws start at their batch's slice of the instance buffer, so the device needs drawIndirectFirstInstance.
+	class GpuCuller
+	{
+	public:
+		GpuCuller();
+		~GpuCuller();
+
+		// Creates the compute pipeline from shaderPath (SPIR-V). With a depthPyramid, shaderPath has to be the occlusion build of the shader
+		void Init(const std::string& shaderPath, bool b_drawIndirectCount, DepthPyramid* depthPyramid, PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice);
+		void Cleanup(PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice);
+
+		// (Re)creates the buffers for instanceBatcher's batches. Call after every InstanceBatcher::Build, and after the DepthPyramid is recreated
+		void Build(InstanceBatcher& instanceBatcher, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
+		// Reads every batch's index range again, for after the GeometryArena moved the meshes around. Applies from the next WriteInstances
+		void RefreshGeometry();
+		// CPU half of a frame, after frame's fence has been waited on: reads back how many instances the last use of frame's buffers drew (and adds them to frustumCuller's
+		// counters, VM_MAX_FRAMES_IN_FLIGHT frames late), resets its draw commands and builds every instance's world matrix into its input buffer, split across the job system
+		void WriteInstances(uint32_t frame, TransformSystem& transformSystem, FrustumCuller& frustumCuller, JobSystem& jobSystem);
+		// Records the culling dispatch and the barrier that makes its output visible to the draws. Must be outside a render pass, after descriptorAllocator's ResetFrame(frame).
+		// Phase 1 only exists with a DepthPyramid, and goes after the pyramid has been recorded
+		void RecordCull(VkCommandBuffer commandBuffer, uint32_t frame, FrustumCuller& frustumCuller, DescriptorAllocator& descriptorAllocator, LogicalDevice& logicalDevice, uint32_t phase = 0);
+		// Draws batch's instances that survived the last RecordCull. Everything else (pipeline, vertex and index buffers, descriptor sets) has to be bound already
+		void RecordDraw(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t batch);
+
+		std::vector<InstanceBatch>& GetBatches();
+		VkBuffer& GetInstanceBuffer(uint32_t frame);
+		void PrintStats();
+
+	private:
+		void DestroyBuffers(LogicalDevice& logicalDevice);
+
+		bool m_b_drawIndirectCount;
+		DepthPyramid* m_depthPyramid;
+		uint32_t m_phaseCount; // 2 with occlusion culling, 1 without
+		uint32_t m_phase; // of the last RecordCull
+		VkDescriptorSetLayout m_descriptorSetLayout;
+		VkPipelineLayout m_pipelineLayout;
+		VkPipeline m_pipeline;
+
+		std::vector<InstanceBatch> m_batches;
+		std::vector<uint32_t> m_transformIndices; // every instance's transform, in instance buffer order
+		std::vector<VkDrawIndexedIndirectCommand> m_initialDrawCommands; // [phase][batch], copied over each frame's commands before culling
+		uint32_t m_instanceCount;
+
+		// Written once by Build
+		VkBuffer m_instanceBatchBuffer; // batch index of every instance
+		Allocation m_instanceBatchMemory;
+		VkBuffer m_batchBuffer; // CullBatch per batch
+		Allocation m_batchMemory;
+		VkBuffer m_visibilityBuffer; // occlusion culling only, whether each instance was visible last frame. Device local, shared by every frame
+		Allocation m_visibilityMemory;
+		bool m_b_visibilityCleared;
+		// [frame in flight]
+		std::vector<VkBuffer> m_inputBuffers; // InstanceData of every instance, host visible
+		std::vector<Allocation> m_inputMemory;
+		std::vector<VkBuffer> m_instanceBuffers; // the survivors of each phase, device local, read as the per instance vertex binding
+		std::vector<Allocation> m_instanceMemory;
+		std::vector<VkBuffer> m_drawCommandBuffers; // VkDrawIndexedIndirectCommand per phase per batch, host visible so it can be reset and read back
+		std::vector<Allocation> m_drawCommandMemory;
+		std::vector<VkBuffer> m_drawCountBuffers; // uint per phase per batch, 0 or 1
+		std::vector<Allocation> m_drawCountMemory;
+		std::vector<VkBuffer> m_counterBuffers; // GpuCullCounters, host visible
+		std::vector<Allocation> m_counterMemory;
+		std::vector<VkBuffer> m_occlusionBuffers; // OcclusionConstants, host visible
+		std::vector<Allocation> m_occlusionMemory;
+		std::vector<std::vector<DescriptorBinding>> m_frameBindings; // [frame in flight], what phase 0's RecordCull writes the frame's set with
+		std::vector<VkDescriptorSet> m_descriptorSets; // [frame in flight], transient, only valid for the frame that allocated it
+		std::vector<char> m_b_frameSubmitted; // whether frame's draw commands hold results to read back
+
+		// stats
+		uint64_t m_visibleTotal;
+		uint64_t m_lateTotal; // drawn by phase 1
+		uint64_t m_frustumCulledTotal;
+		uint64_t m_occlusionCulledTotal;
+		uint32_t m_lastVisible;
+		uint32_t m_framesReadBack;
+	};
+}
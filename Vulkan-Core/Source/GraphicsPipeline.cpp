@@ -1,8 +1,10 @@
 #include "GraphicsPipeline.h"
 #include "Helper.h"
 #include "VulkanManager.h"
+#include "FrameConstants.h"
 
 #include <stdexcept>
+#include <cstring>
 
 
 namespace VCore
@@ -11,22 +13,35 @@ namespace VCore
 	{
         m_graphicsPipeline = VK_NULL_HANDLE;
         m_pipelineLayout = VK_NULL_HANDLE;
+        m_pipelineKey = std::vector<char>();
+        m_b_bindless = false;
+        m_b_instanced = false;
+        m_vertexFormat = VertexFormat::FULL;
         SetVertexPath(vertexPath);
         SetFragmentPath(fragmentPath);
 	}
 
     GraphicsPipeline::GraphicsPipeline()
     {
+        m_graphicsPipeline = VK_NULL_HANDLE;
+        m_pipelineLayout = VK_NULL_HANDLE;
+        m_pipelineKey = std::vector<char>();
+        m_b_bindless = false;
+        m_b_instanced = false;
+        m_vertexFormat = VertexFormat::FULL;
     }
 
 	GraphicsPipeline::~GraphicsPipeline()
 	{
 	}
 
-    void GraphicsPipeline::Cleanup(LogicalDevice& logicalDevice)
+    void GraphicsPipeline::Cleanup(PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice)
     {
-        vkDestroyPipeline(logicalDevice.GetDevice(), m_graphicsPipeline, nullptr);
-        vkDestroyPipelineLayout(logicalDevice.GetDevice(), m_pipelineLayout, nullptr);
+        // Shared with every other material using the same pipeline, the registry destroys it once the last one lets go
+        pipelineRegistry.ReleasePipeline(m_pipelineKey, logicalDevice);
+        m_graphicsPipeline = VK_NULL_HANDLE;
+        m_pipelineLayout = VK_NULL_HANDLE;
+        m_pipelineKey.clear();
     }
 
 
@@ -40,6 +55,21 @@ namespace VCore
         m_fragmentPath = path;
     }
 
+    void GraphicsPipeline::SetBindless(bool b_bindless)
+    {
+        m_b_bindless = b_bindless;
+    }
+
+    void GraphicsPipeline::SetInstanced(bool b_instanced)
+    {
+        m_b_instanced = b_instanced;
+    }
+
+    void GraphicsPipeline::SetVertexFormat(VertexFormat format)
+    {
+        m_vertexFormat = format;
+    }
+
     VkShaderModule GraphicsPipeline::CreateShaderModule(const std::vector<char>& code, LogicalDevice& logicalDevice)
     {
         // Before we can pass the code to the pipeline, we have to wrap it in a VkShaderModule object.
@@ -58,13 +88,50 @@ namespace VCore
         return shaderModule;
     }
 
-    void GraphicsPipeline::CreateGraphicsPipeline(LogicalDevice& logicalDevice, WinSys& winSystem, RenderPass& renderPass, VkDescriptorSetLayout& descriptorSetLayout)
+    void GraphicsPipeline::CreateGraphicsPipeline(LogicalDevice& logicalDevice, VkSampleCountFlagBits samples, RenderPass& renderPass, VkDescriptorSetLayout& frameSetLayout, VkDescriptorSetLayout& descriptorSetLayout, PipelineRegistry& pipelineRegistry)
     {
         // More info here - https://vulkan-tutorial.com/en/Drawing_a_triangle/Graphics_pipeline_basics/Fixed_functions
         // Load the bytecode of the shaders
-        auto vertShaderCode = Helper::ReadFile(m_vertexPath);
+        auto vertShaderCode = Helper::ReadFile(VertexCodec::GetShaderPath(m_vertexPath, m_vertexFormat)); // the build that decodes m_vertexFormat
         auto fragShaderCode = Helper::ReadFile(m_fragmentPath);
 
+        // Everything below is fixed except for the shaders, the descriptor set layouts (shared between materials with the same bindings), the render pass and the sample count - so that's the key.
+        // Viewport and scissor are dynamic state, so the extent isn't part of it and the pipelines survive a resize
+        struct PipelineKey
+        {
+            uint64_t vertexSize;
+            uint64_t fragmentSize;
+            VkDescriptorSetLayout frameSetLayout;
+            VkDescriptorSetLayout descriptorSetLayout;
+            VkRenderPass renderPass;
+            uint32_t samples;
+            uint32_t subpass;
+            uint32_t bindless;
+            uint32_t instanced;
+            uint32_t vertexFormat;
+        };
+        PipelineKey key;
+        memset(&key, 0, sizeof(key)); // padding is compared too
+        key.vertexSize = vertShaderCode.size();
+        key.fragmentSize = fragShaderCode.size();
+        key.frameSetLayout = frameSetLayout;
+        key.descriptorSetLayout = descriptorSetLayout;
+        key.renderPass = renderPass.GetRenderPass();
+        key.samples = static_cast<uint32_t>(samples);
+        key.subpass = 0;
+        key.bindless = m_b_bindless ? 1 : 0;
+        key.instanced = m_b_instanced ? 1 : 0;
+        key.vertexFormat = static_cast<uint32_t>(m_vertexFormat);
+        // The shader bytes follow the struct, so two pipelines only match if their shaders really are the same (the registry compares the whole key, the hash just picks the bucket)
+        m_pipelineKey.assign(reinterpret_cast<const char*>(&key), reinterpret_cast<const char*>(&key) + sizeof(key));
+        m_pipelineKey.insert(m_pipelineKey.end(), vertShaderCode.begin(), vertShaderCode.end());
+        m_pipelineKey.insert(m_pipelineKey.end(), fragShaderCode.begin(), fragShaderCode.end());
+
+        if (pipelineRegistry.AcquirePipeline(m_pipelineKey, m_graphicsPipeline, m_pipelineLayout))
+        {
+            return;
+        }
+
         // The compilation and linking of the SPIR-V bytecode to machine code for execution by the GPU doesn't happen until the graphics pipeline is created, so we make them local and destroy them immediately after pipeline creation is finished
         VkShaderModule vertShaderModule = CreateShaderModule(vertShaderCode, logicalDevice);
         VkShaderModule fragShaderModule = CreateShaderModule(fragShaderCode, logicalDevice);
@@ -91,15 +158,23 @@ namespace VCore
         // 1. Bindings: spacing between data and whether the data is per - vertex or per - instance(see instancing)
         // 2. Attribute descriptions : type of the attributes passed to the vertex shader, which binding to load them from and at which offset
 
-        auto bindingDescription = Vertex::getBindingDescription();
-        auto attributeDescription = Vertex::getAttributeDescriptions();
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions = { VertexCodec::GetBindingDescription(m_vertexFormat) };
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions = VertexCodec::GetAttributeDescriptions(m_vertexFormat);
+
+        // Refer to - https://docs.vulkan.org/samples/latest/samples/performance/instancing/README.html
+        if (m_b_instanced)
+        {
+            constexpr auto instanceAttributes = InstanceDataLayout::GetAttributeDescriptions();
+            bindingDescriptions.push_back(InstanceDataLayout::GetBindingDescription());
+            attributeDescriptions.insert(attributeDescriptions.end(), instanceAttributes.begin(), instanceAttributes.end());
+        }
 
         VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
         vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vertexInputInfo.vertexBindingDescriptionCount = 1;
-        vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-        vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescription.size());
-        vertexInputInfo.pVertexAttributeDescriptions = attributeDescription.data();
+        vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
+        vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
+        vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+        vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 
 
         // Describes what kind of geometry will be drawn from the vertices and if primitive restart should be enabled
@@ -115,22 +190,6 @@ namespace VCore
         inputAssembly.primitiveRestartEnable = VK_FALSE;
 
 
-        // Describe viewport dimensions
-        VkViewport viewport{};
-        viewport.x = 0.0f;
-        viewport.y = 0.0f;
-        viewport.width = (float)winSystem.GetExtent().width;
-        viewport.height = (float)winSystem.GetExtent().height;
-        viewport.minDepth = 0.0f;
-        viewport.maxDepth = 1.0f;
-
-        // Any pixels outside the scissor rectangles will be discarded by the rasterizer. 
-        // If we want to draw to the entire framebuffer, we specify a scissor rectangle that covers it entirely:
-        VkRect2D scissor{};
-        scissor.offset = { 0, 0 };
-        scissor.extent = winSystem.GetExtent();
-
-
         // For creating dynamic pipeline that doesn't need to be fully recreated for certain values (ie. viewport size, line width, and blend constants)
         // Configuration of these values will be ignored and you will be able (and required) to specify the data at drawing time.
         std::vector<VkDynamicState> dynamicStates =
@@ -147,7 +206,7 @@ namespace VCore
         VkPipelineViewportStateCreateInfo viewportState{};
         viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
         viewportState.viewportCount = 1;
-        viewportState.scissorCount = 1;
+        viewportState.scissorCount = 1; // the viewport and scissor themselves are set at record time, see RenderPass::SetViewport
 
 
         // Rasterizer - more info found here: https://vulkan-tutorial.com/en/Drawing_a_triangle/Graphics_pipeline_basics/Fixed_functions
@@ -170,7 +229,7 @@ namespace VCore
         VkPipelineMultisampleStateCreateInfo multisampling{};
         multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
         multisampling.sampleShadingEnable = VK_TRUE; // VK_FALSE;
-        multisampling.rasterizationSamples = winSystem.GetMsaa();
+        multisampling.rasterizationSamples = samples;
         multisampling.minSampleShading = 0.2f; // 1.0f; // Optional
         multisampling.pSampleMask = nullptr; // Optional
         multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
@@ -204,15 +263,13 @@ namespace VCore
 
 
         // Pipeline Layout config
-        VkPushConstantRange translateRange = {};
-        translateRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-        translateRange.offset = 0;
-        translateRange.size = 12; // %v4float (vec4) is defined as 16 bytes
+        // Same set 0 and push constant range as FrameConstants' (and for bindless, BindlessTable's) pipeline layout, which is what binds those sets
+        VkPushConstantRange translateRange = FrameConstants::GetPushConstantRange(m_b_bindless);
 
-        std::vector<VkDescriptorSetLayout> layouts(VM_MAX_FRAMES_IN_FLIGHT, descriptorSetLayout);
+        std::vector<VkDescriptorSetLayout> layouts = { frameSetLayout, descriptorSetLayout };
         VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipelineLayoutInfo.setLayoutCount = 2;
+        pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(layouts.size());
         pipelineLayoutInfo.pSetLayouts = layouts.data();
         pipelineLayoutInfo.pushConstantRangeCount = 1; // Optional
         pipelineLayoutInfo.pPushConstantRanges = &translateRange; // Optional
@@ -265,11 +322,14 @@ namespace VCore
         // For Depth testing
         pipelineInfo.pDepthStencilState = &depthStencil;
 
-        if (vkCreateGraphicsPipelines(logicalDevice.GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_graphicsPipeline) != VK_SUCCESS)
+        // The pipeline cache lets the driver skip compiling shaders it has seen before (this run or, since it's saved to disk, a previous one)
+        if (vkCreateGraphicsPipelines(logicalDevice.GetDevice(), pipelineRegistry.GetPipelineCache(), 1, &pipelineInfo, nullptr, &m_graphicsPipeline) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to create graphics pipeline.");
         }
 
+        pipelineRegistry.AddPipeline(m_pipelineKey, m_graphicsPipeline, m_pipelineLayout, logicalDevice);
+
 
         // Cleanup when pipeline is finished being created
         vkDestroyShaderModule(logicalDevice.GetDevice(), vertShaderModule, nullptr);
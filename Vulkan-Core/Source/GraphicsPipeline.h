@@ -2,6 +2,8 @@
 #include "LogicalDevice.h"
 #include "WinSys.h"
 #include "RenderPass.h"
+#include "PipelineRegistry.h"
+#include "VertexCodec.h"
 
 #define GLFW_INCLUDE_VULKAN
 #include <glfw3.h>
@@ -18,12 +20,21 @@ namespace VCore
 		GraphicsPipeline(std::string vertexPath, std::string fragmentPath);
 		GraphicsPipeline();
 		~GraphicsPipeline();
-		void Cleanup(LogicalDevice& logicalDevice);
+		void Cleanup(PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice);
 
 		void SetVertexPath(std::string path);
 		void SetFragmentPath(std::string path);
+		// Bindless pipelines use the global table as set 1 and push BindlessPushConstants to both stages
+		void SetBindless(bool b_bindless);
+		// Instanced pipelines read InstanceData from vertex binding 1
+		void SetInstanced(bool b_instanced);
+		// Vertex layout the pipeline reads, and which build of the vertex shader it loads (see VertexCodec::GetShaderPath). Defaults to VertexFormat::FULL
+		void SetVertexFormat(VertexFormat format);
 		VkShaderModule CreateShaderModule(const std::vector<char>& code, LogicalDevice& logicalDevice);
-		void CreateGraphicsPipeline(LogicalDevice& logicalDevice, WinSys& winSystem, RenderPass& renderPass, VkDescriptorSetLayout& descriptorSetLayout);
+		// Reuses the registry's pipeline if one was already built from the same shaders and state, otherwise builds it through the registry's pipeline cache.
+		// Set 0 is frameSetLayout (FrameConstants), set 1 is descriptorSetLayout (the material's textures or the bindless table). samples is the target's, passed by value
+		// so a compile on another thread never reads the window system while the swap chain is being recreated. Viewport and scissor are dynamic, nothing depends on the extent
+		void CreateGraphicsPipeline(LogicalDevice& logicalDevice, VkSampleCountFlagBits samples, RenderPass& renderPass, VkDescriptorSetLayout& frameSetLayout, VkDescriptorSetLayout& descriptorSetLayout, PipelineRegistry& pipelineRegistry);
 		VkPipeline& GetGraphicsPipeline();
 		VkPipelineLayout& GetPipelineLayout();
 
@@ -32,5 +43,9 @@ namespace VCore
 		VkPipelineLayout m_pipelineLayout;
 		std::string m_vertexPath;
 		std::string m_fragmentPath;
+		std::vector<char> m_pipelineKey; // identifies the pipeline in the PipelineRegistry
+		bool m_b_bindless;
+		bool m_b_instanced;
+		VertexFormat m_vertexFormat;
 	};
 }
\ No newline at end of file
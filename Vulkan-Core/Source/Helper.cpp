@@ -3,6 +3,7 @@
 
 #include <set>
 #include <fstream>
+#include <cstring>
 #include <filesystem>
 
 
@@ -20,34 +21,62 @@ namespace VCore
         std::vector<VkQueueFamilyProperties> queueFamilies(ui_queueFamilyCount); // Use that number to initialize a container for familyProperties
         vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &ui_queueFamilyCount, queueFamilies.data()); // Put queue families into new container
 
-        int i = 0;
-        for (const auto& queueFamily : queueFamilies)
+        // Graphics - the culling and depth pyramid dispatches are recorded on the graphics queue, so the family has to do compute too.
+        // The first one that can also present is kept, so drawing and presenting share a queue whenever the device allows it
+        for (uint32_t i = 0; i < ui_queueFamilyCount; i++)
         {
-            // Graphics
-            if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) // Check this queue family flag for graphics and grabs it if it is
+            const VkQueueFlags required = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT;
+            if ((queueFamilies[i].queueFlags & required) != required)
+            {
+                continue;
+            }
+            if (!indices.graphicsFamily.has_value())
             {
                 indices.graphicsFamily = i;
             }
-            // Surface Presenting
-            VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &presentSupport); // checks if support for our specific surface is available in the queuefamily
-            if (presentSupport) // Check this queue family flag for present support and grabs it if it is
+            if (SupportsPresent(physicalDevice, surface, i))
             {
+                indices.graphicsFamily = i;
                 indices.presentFamily = i;
+                break;
             }
+        }
 
-            // If we find a suitable card, exit early
-            if (indices.isComplete())
+        // Surface Presenting - no graphics family presents, take the first family that does
+        for (uint32_t i = 0; i < ui_queueFamilyCount && !indices.presentFamily.has_value() && indices.graphicsFamily.has_value(); i++)
+        {
+            if (SupportsPresent(physicalDevice, surface, i))
             {
-                break;
+                indices.presentFamily = i;
             }
+        }
 
-            i++;
+        // Dedicated transfer (no graphics or compute support means it's the copy engine rather than another view of the main queue)
+        for (uint32_t i = 0; i < ui_queueFamilyCount; i++)
+        {
+            if ((queueFamilies[i].queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFamilies[i].queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+            {
+                indices.transferFamily = i;
+                break;
+            }
         }
 
         return indices;
     }
 
+    bool Helper::SupportsPresent(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, uint32_t queueFamily)
+    {
+        // Headless - nothing is ever presented, so any family stands in for the present family to keep isComplete() meaningful
+        if (surface == VK_NULL_HANDLE)
+        {
+            return true;
+        }
+
+        VkBool32 presentSupport = false;
+        vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, queueFamily, surface, &presentSupport); // checks if support for our specific surface is available in the queuefamily
+        return presentSupport;
+    }
+
     VkSampleCountFlagBits Helper::GetMaxUsableSampleCount(VkPhysicalDevice physicalDevice)
     {
         // Refer to - https://vulkan-tutorial.com/Multisampling
@@ -227,4 +256,124 @@ namespace VCore
 
         return buffer;
     }
+
+    void Helper::WritePPM(const std::string& filename, uint32_t width, uint32_t height, const std::vector<uint8_t>& rgbaPixels)
+    {
+        // PPM is about the simplest image format there is (a short text header followed by raw RGB bytes), so captures can be diffed without pulling in an image writer
+        if (rgbaPixels.size() < static_cast<size_t>(width) * height * 4)
+        {
+            throw std::runtime_error("failed to write image, not enough pixel data.");
+        }
+
+        std::ofstream file(filename, std::ios::binary);
+
+        if (!file.is_open())
+        {
+            throw std::runtime_error("failed to open file for writing.");
+        }
+
+        file << "P6\n" << width << " " << height << "\n255\n";
+
+        std::vector<char> row(static_cast<size_t>(width) * 3);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                size_t src = (static_cast<size_t>(y) * width + x) * 4;
+                row[x * 3 + 0] = static_cast<char>(rgbaPixels[src + 0]);
+                row[x * 3 + 1] = static_cast<char>(rgbaPixels[src + 1]);
+                row[x * 3 + 2] = static_cast<char>(rgbaPixels[src + 2]);
+            }
+            file.write(row.data(), row.size());
+        }
+
+        file.close();
+    }
+
+    void Helper::ReadPPM(const std::string& filename, uint32_t& width, uint32_t& height, std::vector<uint8_t>& rgbaPixels)
+    {
+        std::ifstream file(filename, std::ios::binary);
+
+        if (!file.is_open())
+        {
+            throw std::runtime_error("failed to open file.");
+        }
+
+        std::string magic;
+        uint32_t ui_maxValue = 0;
+        file >> magic >> width >> height >> ui_maxValue;
+        file.get(); // single whitespace between the header and the pixel data
+
+        if (!file || magic != "P6" || ui_maxValue != 255)
+        {
+            throw std::runtime_error("failed to read image, only 8 bit binary PPM (P6) files are supported.");
+        }
+
+        std::vector<char> rgb(static_cast<size_t>(width) * height * 3);
+        file.read(rgb.data(), rgb.size());
+
+        if (file.gcount() != static_cast<std::streamsize>(rgb.size()))
+        {
+            throw std::runtime_error("failed to read image, file is truncated.");
+        }
+
+        rgbaPixels.resize(static_cast<size_t>(width) * height * 4);
+        for (size_t i = 0; i < static_cast<size_t>(width) * height; i++)
+        {
+            rgbaPixels[i * 4 + 0] = static_cast<uint8_t>(rgb[i * 3 + 0]);
+            rgbaPixels[i * 4 + 1] = static_cast<uint8_t>(rgb[i * 3 + 1]);
+            rgbaPixels[i * 4 + 2] = static_cast<uint8_t>(rgb[i * 3 + 2]);
+            rgbaPixels[i * 4 + 3] = 255;
+        }
+    }
+
+    static inline uint64_t RotateLeft(uint64_t value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    uint64_t Helper::Hash64(const void* data, size_t size)
+    {
+        // Refer to - https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md (XXH64, single accumulator)
+        // Each word goes through a multiply and a rotate, so differences in the high bits (ie. float sign bits) get folded back down instead of cancelling out between words
+        const uint64_t PRIME_1 = 0x9E3779B185EBCA87ull;
+        const uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+        const uint64_t PRIME_3 = 0x165667B19E3779F9ull;
+        const uint64_t PRIME_4 = 0x85EBCA77C2B2AE63ull;
+        const uint64_t PRIME_5 = 0x27D4EB2F165667C5ull;
+
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        uint64_t hash = PRIME_5 + size;
+        size_t i = 0;
+
+        for (; i + 8 <= size; i += 8)
+        {
+            uint64_t word;
+            memcpy(&word, bytes + i, sizeof(word)); // no alignment requirements on data
+            hash ^= RotateLeft(word * PRIME_2, 31) * PRIME_1;
+            hash = RotateLeft(hash, 27) * PRIME_1 + PRIME_4;
+        }
+        if (i + 4 <= size)
+        {
+            uint32_t word;
+            memcpy(&word, bytes + i, sizeof(word));
+            hash ^= word * PRIME_1;
+            hash = RotateLeft(hash, 23) * PRIME_2 + PRIME_3;
+            i += 4;
+        }
+        for (; i < size; i++)
+        {
+            hash ^= bytes[i] * PRIME_5;
+            hash = RotateLeft(hash, 11) * PRIME_1;
+        }
+
+        // Final avalanche so every input bit reaches every output bit
+        hash ^= hash >> 33;
+        hash *= PRIME_2;
+        hash ^= hash >> 29;
+        hash *= PRIME_3;
+        hash ^= hash >> 32;
+
+        return hash;
+    }
 }
\ No newline at end of file
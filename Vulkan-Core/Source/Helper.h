@@ -15,7 +15,10 @@ namespace VCore
     class Helper
     {
     public:
+        // Graphics is the first family that also does compute (and presents, if any such family does), transfer the first transfer only family
         static QueueFamilyIndices FindQueueFamilies(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface);
+        // Always true headless (surface is VK_NULL_HANDLE)
+        static bool SupportsPresent(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, uint32_t queueFamily);
         static VkSampleCountFlagBits GetMaxUsableSampleCount(VkPhysicalDevice physicalDevice);
         static SwapChainSupportDetails QuerySwapChainSupport(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface);
         static bool CheckDeviceExtensionSupport(VkPhysicalDevice physicalDevice);
@@ -26,5 +29,10 @@ namespace VCore
         static VkFormat FindDepthFormat(VkPhysicalDevice physicalDevice);
         static bool HasStencilComponent(VkFormat format);
         static std::vector<char> ReadFile(const std::string& filename);
+        // Binary PPM (P6) image files for headless captures - RGBA8 pixels in, alpha is dropped on write and set to 255 on read
+        static void WritePPM(const std::string& filename, uint32_t width, uint32_t height, const std::vector<uint8_t>& rgbaPixels);
+        static void ReadPPM(const std::string& filename, uint32_t& width, uint32_t& height, std::vector<uint8_t>& rgbaPixels);
+        // 64 bit hash of arbitrary bytes (XXH64 style) - file checksums, vertex deduplication and pipeline keys
+        static uint64_t Hash64(const void* data, size_t size);
     };
 }
\ No newline at end of file
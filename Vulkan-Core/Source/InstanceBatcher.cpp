@@ -0,0 +1,241 @@
+#include "InstanceBatcher.h"
+#include "GameObject.h"
+#include "VulkanManager.h"
+
+#include <map>
+#include <iostream>
+#include <algorithm>
+#include <cfloat>
+
+
+namespace VCore
+{
+    InstanceBatcher::InstanceBatcher()
+    {
+        m_instances = std::vector<GameObject*>();
+        m_transformIndices = std::vector<uint32_t>();
+        m_instanceParams = std::vector<glm::vec4>();
+        m_batches = std::vector<InstanceBatch>();
+        m_visibleTransformIndices = std::vector<uint32_t>();
+        m_visibleCounts = std::vector<uint32_t>();
+        m_lodScales = std::vector<float>();
+        m_drawBatches = std::vector<InstanceBatch>();
+        m_instanceBuffers = std::vector<VkBuffer>();
+        m_instanceBuffersMemory = std::vector<Allocation>();
+        m_instanceCapacity = 0;
+    }
+
+    InstanceBatcher::~InstanceBatcher()
+    {
+    }
+
+    void InstanceBatcher::Cleanup(LogicalDevice& logicalDevice)
+    {
+        for (size_t i = 0; i < m_instanceBuffers.size(); i++)
+        {
+            vkDestroyBuffer(logicalDevice.GetDevice(), m_instanceBuffers[i], nullptr);
+            logicalDevice.GetAllocator().Free(m_instanceBuffersMemory[i]);
+        }
+        m_instanceBuffers.clear();
+        m_instanceBuffersMemory.clear();
+        m_instanceCapacity = 0;
+        m_instances.clear();
+        m_transformIndices.clear();
+        m_instanceParams.clear();
+        m_batches.clear();
+        m_visibleTransformIndices.clear();
+        m_visibleCounts.clear();
+        m_lodScales.clear();
+        m_drawBatches.clear();
+    }
+
+    void InstanceBatcher::Build(std::vector<GameObject>& gameObjects, TransformSystem& transformSystem, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice)
+    {
+        // Group by mesh + material, keeping groups in the order they first show up so the draw order (and headless captures) stay the same from run to run
+        std::map<std::pair<Mesh*, Material*>, size_t> groupLookup;
+        std::vector<std::vector<GameObject*>> groups;
+
+        for (GameObject& object : gameObjects)
+        {
+            if (!object.GetMaterial()->IsInstanced())
+            {
+                continue;
+            }
+            if (object.GetTransformIndex() == VM_NO_TRANSFORM)
+            {
+                object.SetTransformIndex(transformSystem.Add(object.GetModel().GetTransform()));
+            }
+
+            std::pair<Mesh*, Material*> key = { object.GetModel().GetMesh(), object.GetMaterial().get() };
+            auto existing = groupLookup.find(key);
+            if (existing == groupLookup.end())
+            {
+                existing = groupLookup.emplace(key, groups.size()).first;
+                groups.push_back(std::vector<GameObject*>());
+            }
+            groups[existing->second].push_back(&object);
+        }
+
+        m_instances.clear();
+        m_batches.clear();
+        for (std::vector<GameObject*>& group : groups)
+        {
+            // Big groups are split so the draws can be recorded on more than one thread
+            for (size_t begin = 0; begin < group.size(); begin += VM_MAX_INSTANCES_PER_DRAW)
+            {
+                size_t end = std::min(group.size(), begin + VM_MAX_INSTANCES_PER_DRAW);
+
+                InstanceBatch batch;
+                batch.object = group[begin];
+                batch.firstInstance = static_cast<uint32_t>(m_instances.size());
+                batch.instanceCount = static_cast<uint32_t>(end - begin);
+                m_batches.push_back(batch);
+
+                m_instances.insert(m_instances.end(), group.begin() + begin, group.begin() + end);
+            }
+        }
+
+        m_transformIndices.resize(m_instances.size());
+        m_instanceParams.resize(m_instances.size());
+        for (size_t i = 0; i < m_instances.size(); i++)
+        {
+            m_transformIndices[i] = m_instances[i]->GetTransformIndex();
+            m_instanceParams[i] = m_instances[i]->GetInstanceParams();
+        }
+        m_visibleTransformIndices.resize(m_instances.size());
+        m_visibleCounts.resize(m_batches.size());
+        m_lodScales.resize(m_batches.size());
+        m_drawBatches.clear();
+
+        if (m_instances.size() > m_instanceCapacity)
+        {
+            CreateInstanceBuffers(static_cast<uint32_t>(m_instances.size()), physicalDevice, logicalDevice);
+        }
+    }
+
+    void InstanceBatcher::CreateInstanceBuffers(uint32_t instanceCount, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice)
+    {
+        // Only called from Build, before any frame that could still be reading the old buffers is recorded
+        for (size_t i = 0; i < m_instanceBuffers.size(); i++)
+        {
+            vkDestroyBuffer(logicalDevice.GetDevice(), m_instanceBuffers[i], nullptr);
+            logicalDevice.GetAllocator().Free(m_instanceBuffersMemory[i]);
+        }
+
+        // One buffer per frame in flight so the CPU can write next frame's instances while the GPU still reads the last ones
+        VkDeviceSize bufferSize = sizeof(InstanceData) * instanceCount;
+
+        m_instanceBuffers.resize(VM_MAX_FRAMES_IN_FLIGHT);
+        m_instanceBuffersMemory.resize(VM_MAX_FRAMES_IN_FLIGHT);
+
+        for (size_t i = 0; i < VM_MAX_FRAMES_IN_FLIGHT; i++)
+        {
+            WinSys::CreateBuffer(bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_instanceBuffers[i], m_instanceBuffersMemory[i], physicalDevice, logicalDevice);
+        }
+        m_instanceCapacity = instanceCount;
+    }
+
+    std::vector<InstanceBatch>& InstanceBatcher::GetBatches()
+    {
+        return m_batches;
+    }
+
+    void InstanceBatcher::WriteTransforms(uint32_t frame, TransformSystem& transformSystem, FrustumCuller& frustumCuller, JobSystem& jobSystem)
+    {
+        m_drawBatches.clear();
+        if (m_instances.empty())
+        {
+            return;
+        }
+
+        // Batches own disjoint ranges of the instance buffer, so each job packs its survivors into its own range without touching anyone else's
+        InstanceData* instances = static_cast<InstanceData*>(m_instanceBuffersMemory[frame].mapped);
+        glm::mat4 viewProj = frustumCuller.GetViewProj();
+        jobSystem.ParallelFor(static_cast<uint32_t>(m_batches.size()), 1, [&](uint32_t begin, uint32_t end, uint32_t threadIndex)
+        {
+            const uint32_t ui_blockSize = 256;
+            float centerX[ui_blockSize];
+            float centerY[ui_blockSize];
+            float centerZ[ui_blockSize];
+            float radius[ui_blockSize];
+            uint8_t visible[ui_blockSize];
+
+            for (uint32_t b = begin; b < end; b++)
+            {
+                const InstanceBatch& batch = m_batches[b];
+                MeshBounds bounds = frustumCuller.GetCullBounds(batch.object->GetModel().GetMesh()->GetBounds());
+                uint32_t ui_visibleCount = 0;
+                float f_lodScale = 0.0f;
+
+                for (uint32_t blockBegin = 0; blockBegin < batch.instanceCount; blockBegin += ui_blockSize)
+                {
+                    uint32_t first = batch.firstInstance + blockBegin;
+                    uint32_t ui_count = std::min(ui_blockSize, batch.instanceCount - blockBegin);
+
+                    transformSystem.ComputeBoundingSpheres(&m_transformIndices[first], ui_count, bounds, centerX, centerY, centerZ, radius);
+                    frustumCuller.TestSpheres(centerX, centerY, centerZ, radius, ui_count, visible);
+
+                    for (uint32_t i = 0; i < ui_count; i++)
+                    {
+                        if (visible[i])
+                        {
+                            uint32_t destination = batch.firstInstance + ui_visibleCount;
+                            m_visibleTransformIndices[destination] = m_transformIndices[first + i];
+                            instances[destination].params = m_instanceParams[first + i];
+                            ui_visibleCount++;
+
+                            // The sphere's radius over the mesh's is the instance's scale, the center's clip w its distance (see LodSelector::GetScale)
+                            float f_depth = viewProj[0][3] * centerX[i] + viewProj[1][3] * centerY[i] + viewProj[2][3] * centerZ[i] + viewProj[3][3];
+                            float f_scale = bounds.radius > 0.0f ? radius[i] / bounds.radius : 1.0f;
+                            f_lodScale = std::max(f_lodScale, f_depth > 0.0f ? f_scale / f_depth : FLT_MAX);
+                        }
+                    }
+                }
+
+                // Matrices only for what survived. Batches are at most VM_MAX_INSTANCES_PER_DRAW, about what the TransformSystem would give a job anyway
+                transformSystem.ComputeWorld(&m_visibleTransformIndices[batch.firstInstance], ui_visibleCount, &instances[batch.firstInstance].model, sizeof(InstanceData));
+                m_visibleCounts[b] = ui_visibleCount;
+                m_lodScales[b] = f_lodScale;
+            }
+        });
+
+        uint32_t ui_visibleTotal = 0;
+        for (size_t b = 0; b < m_batches.size(); b++)
+        {
+            if (m_visibleCounts[b] > 0)
+            {
+                InstanceBatch drawBatch = m_batches[b];
+                drawBatch.instanceCount = m_visibleCounts[b];
+                drawBatch.lodScale = m_lodScales[b];
+                m_drawBatches.push_back(drawBatch);
+                ui_visibleTotal += m_visibleCounts[b];
+            }
+        }
+        frustumCuller.AddStats(static_cast<uint32_t>(m_instances.size()), static_cast<uint32_t>(m_instances.size()) - ui_visibleTotal);
+    }
+
+    std::vector<uint32_t>& InstanceBatcher::GetTransformIndices()
+    {
+        return m_transformIndices;
+    }
+
+    std::vector<glm::vec4>& InstanceBatcher::GetInstanceParams()
+    {
+        return m_instanceParams;
+    }
+
+    std::vector<InstanceBatch>& InstanceBatcher::GetDrawBatches()
+    {
+        return m_drawBatches;
+    }
+
+    VkBuffer& InstanceBatcher::GetInstanceBuffer(uint32_t frame)
+    {
+        return m_instanceBuffers[frame];
+    }
+
+    void InstanceBatcher::PrintStats()
+    {
+        std::cout << "instancing: " << m_instances.size() << " instanced objects in " << m_batches.size() << " draws" << std::endl;
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "PhysicalDevice.h"
+#include "LogicalDevice.h"
+#include "MemoryAllocator.h"
+#include "Structs.h"
+#include "TransformSystem.h"
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+
+#define GLFW_INCLUDE_VULKAN
+#include <glfw3.h>
+
+#include <vector>
+
+
+namespace VCore
+{
+	class GameObject;
+
+	// A run of objects drawn with one vkCmdDrawIndexed. The first object's mesh, material and descriptor sets are used for the whole batch,
+	// the rest only contribute their InstanceData
+	struct InstanceBatch
+	{
+		GameObject* object = nullptr;
+		uint32_t firstInstance = 0; // into m_instances and the instance buffers
+		uint32_t instanceCount = 0;
+		float lodScale = 0.0f; // LodSelector scale of the visible instance nearest for its size, the whole batch is drawn at the LOD that one needs
+	};
+
+	// Refer to - https://docs.vulkan.org/samples/latest/samples/performance/instancing/README.html
+	// Groups objects whose material is instanced (Material::SetInstanced) by mesh + material, so any number of copies of a prop cost one draw per VM_MAX_INSTANCES_PER_DRAW.
+	// Per instance data lives in a host visible vertex buffer per frame in flight, read through a VK_VERTEX_INPUT_RATE_INSTANCE binding (InstanceData).
+	// Every frame each batch's instances are frustum culled and the survivors packed to the front of the batch's range, then the TransformSystem builds their world matrices
+	// straight into that buffer. The batches actually drawn that frame (GetDrawBatches) only cover the survivors, empty ones are dropped.
+	// Call Build again whenever objects are added, change mesh or material or change their parameters.
+	class InstanceBatcher
+	{
+	public:
+		InstanceBatcher();
+		~InstanceBatcher();
+
+		// Groups the instanced objects and (re)creates the instance buffers to fit them. Objects without a transform in transformSystem get one from their Model's matrix
+		void Build(std::vector<GameObject>& gameObjects, TransformSystem& transformSystem, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
+		void Cleanup(LogicalDevice& logicalDevice);
+
+		std::vector<InstanceBatch>& GetBatches();
+		// Every instance's transform and parameters, in instance buffer order (for the GpuCuller)
+		std::vector<uint32_t>& GetTransformIndices();
+		std::vector<glm::vec4>& GetInstanceParams();
+		// Culls every batch and writes the visible instances' world matrices and parameters into frame's instance buffer, one batch per job
+		void WriteTransforms(uint32_t frame, TransformSystem& transformSystem, FrustumCuller& frustumCuller, JobSystem& jobSystem);
+		// What WriteTransforms left to draw this frame
+		std::vector<InstanceBatch>& GetDrawBatches();
+		VkBuffer& GetInstanceBuffer(uint32_t frame);
+		void PrintStats();
+
+	private:
+		void CreateInstanceBuffers(uint32_t instanceCount, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
+
+		std::vector<GameObject*> m_instances; // ordered so every batch is a contiguous range
+		std::vector<uint32_t> m_transformIndices; // m_instances' transforms, in the same order
+		std::vector<glm::vec4> m_instanceParams; // and their parameters
+		std::vector<InstanceBatch> m_batches;
+		std::vector<uint32_t> m_visibleTransformIndices; // this frame's survivors, at the front of each batch's range
+		std::vector<uint32_t> m_visibleCounts; // [batch]
+		std::vector<float> m_lodScales; // [batch]
+		std::vector<InstanceBatch> m_drawBatches;
+		std::vector<VkBuffer> m_instanceBuffers; // [frame in flight]
+		std::vector<Allocation> m_instanceBuffersMemory;
+		uint32_t m_instanceCapacity;
+	};
+}
@@ -0,0 +1,191 @@
+#include "JobSystem.h"
+
+#include <atomic>
+#include <algorithm>
+
+
+namespace VCore
+{
+    static thread_local uint32_t t_threadIndex = 0;
+
+    JobSystem::JobSystem()
+    {
+        m_workers = std::vector<std::thread>();
+        m_jobs = std::deque<std::function<void()>>();
+        m_b_running = false;
+    }
+
+    JobSystem::~JobSystem()
+    {
+        Shutdown();
+    }
+
+    void JobSystem::Init(uint32_t workerCount)
+    {
+        Shutdown();
+
+        m_b_running = true;
+        for (uint32_t i = 0; i < workerCount; i++)
+        {
+            m_workers.emplace_back(&JobSystem::WorkerLoop, this, i + 1);
+        }
+    }
+
+    void JobSystem::Shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_b_running = false;
+        }
+        m_condition.notify_all();
+
+        for (std::thread& worker : m_workers)
+        {
+            worker.join();
+        }
+        m_workers.clear();
+    }
+
+    uint32_t JobSystem::GetWorkerCount()
+    {
+        return static_cast<uint32_t>(m_workers.size());
+    }
+
+    uint32_t JobSystem::GetThreadCount()
+    {
+        return static_cast<uint32_t>(m_workers.size()) + 1;
+    }
+
+    uint32_t JobSystem::GetThreadIndex()
+    {
+        return t_threadIndex;
+    }
+
+    uint32_t JobSystem::GetDefaultWorkerCount()
+    {
+        uint32_t ui_hardwareThreads = std::thread::hardware_concurrency(); // may be 0 if it can't be determined
+        return ui_hardwareThreads > 1 ? ui_hardwareThreads - 1 : 0;
+    }
+
+    void JobSystem::WorkerLoop(uint32_t threadIndex)
+    {
+        t_threadIndex = threadIndex;
+
+        while (true)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_condition.wait(lock, [this]() { return !m_b_running || !m_jobs.empty(); });
+
+                if (!m_b_running && m_jobs.empty())
+                {
+                    return;
+                }
+
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+            }
+
+            job();
+        }
+    }
+
+    bool JobSystem::RunOneJob()
+    {
+        std::function<void()> job;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_jobs.empty())
+            {
+                return false;
+            }
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        job();
+        return true;
+    }
+
+    void JobSystem::Submit(std::function<void()> job)
+    {
+        if (m_workers.empty())
+        {
+            job();
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.push_back(std::move(job));
+        }
+        m_condition.notify_one();
+    }
+
+    void JobSystem::ParallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t, uint32_t, uint32_t)>& func)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        batchSize = std::max(batchSize, 1u);
+        uint32_t ui_batchCount = (count + batchSize - 1) / batchSize;
+
+        // Nothing to gain from the queue with a single batch or no workers
+        if (ui_batchCount == 1 || m_workers.empty())
+        {
+            for (uint32_t begin = 0; begin < count; begin += batchSize)
+            {
+                func(begin, std::min(begin + batchSize, count), t_threadIndex);
+            }
+            return;
+        }
+
+        // Shared between the batches - lives until the last one finishes since we don't return before that
+        std::atomic<uint32_t> remaining(ui_batchCount);
+        std::mutex errorMutex;
+        std::exception_ptr firstError = nullptr;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (uint32_t begin = 0; begin < count; begin += batchSize)
+            {
+                uint32_t end = std::min(begin + batchSize, count);
+                m_jobs.push_back([&func, &remaining, &errorMutex, &firstError, begin, end]()
+                {
+                    try
+                    {
+                        func(begin, end, t_threadIndex);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> errorLock(errorMutex);
+                        if (!firstError)
+                        {
+                            firstError = std::current_exception();
+                        }
+                    }
+                    remaining.fetch_sub(1, std::memory_order_acq_rel);
+                });
+            }
+        }
+        m_condition.notify_all();
+
+        // Help out instead of sleeping, then spin politely on whatever the workers are still finishing
+        while (remaining.load(std::memory_order_acquire) > 0)
+        {
+            if (!RunOneJob())
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        if (firstError)
+        {
+            std::rethrow_exception(firstError);
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+
+namespace VCore
+{
+	// Small fixed size thread pool. The thread that calls ParallelFor helps run the work, so a JobSystem with 0 workers just runs everything inline.
+	// Every thread gets a stable index (0 for the calling thread, 1..workerCount for the workers) so callers can keep per-thread data (ie. command pools) without locking.
+	class JobSystem
+	{
+	public:
+		JobSystem();
+		~JobSystem();
+
+		void Init(uint32_t workerCount);
+		void Shutdown();
+		uint32_t GetWorkerCount();
+		uint32_t GetThreadCount(); // workers + the calling thread, ie. how many per-thread slots callers need
+		static uint32_t GetThreadIndex();
+		static uint32_t GetDefaultWorkerCount(); // one less than the hardware threads, leaving one for the main thread
+
+		// Splits [0, count) into batches of batchSize and calls func(begin, end, threadIndex) for each, returning once all of them are done.
+		// Exceptions thrown by func are rethrown here (the first one wins).
+		void ParallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t, uint32_t, uint32_t)>& func);
+		// Queues a job without waiting for it (runs it right away with no workers). Long jobs shouldn't share a JobSystem with ParallelFor callers, they'd end up helping with them.
+		// Exceptions are the job's responsibility.
+		void Submit(std::function<void()> job);
+
+	private:
+		void WorkerLoop(uint32_t threadIndex);
+		bool RunOneJob();
+
+		std::vector<std::thread> m_workers;
+		std::deque<std::function<void()>> m_jobs;
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		bool m_b_running;
+	};
+}
@@ -0,0 +1,102 @@
+#include "LodSelector.h"
+#include "VulkanManager.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+
+namespace VCore
+{
+    LodSelector::LodSelector()
+    {
+        m_errorBudget = VM_LOD_ERROR_PIXELS;
+        m_pixelsPerUnit = 0.0f;
+        for (uint32_t l = 0; l < MESH_MAX_LODS; l++)
+        {
+            m_selections[l] = 0;
+        }
+        m_totalTriangles = 0;
+        m_totalFullDetailTriangles = 0;
+        m_frameTriangles = 0;
+        m_frameFullDetailTriangles = 0;
+        m_frames = 0;
+    }
+
+    LodSelector::~LodSelector()
+    {
+    }
+
+    void LodSelector::SetErrorBudget(float pixels)
+    {
+        m_errorBudget = std::max(pixels, 0.0f);
+    }
+
+    float LodSelector::GetErrorBudget()
+    {
+        return m_errorBudget;
+    }
+
+    void LodSelector::SetView(const glm::mat4& proj, uint32_t height)
+    {
+        // proj[1][1] is 1 / tan(fov / 2), flipped for Vulkan's y. Half the viewport spans that many units at distance 1
+        m_pixelsPerUnit = std::abs(proj[1][1]) * height * 0.5f;
+    }
+
+    uint32_t LodSelector::SelectLod(const GeometryRange& geometry, float scale)
+    {
+        // Errors only grow from one LOD to the next, so the first one over budget ends the search
+        uint32_t ui_lod = 0;
+        if (m_errorBudget > 0.0f)
+        {
+            while (ui_lod + 1 < geometry.lodCount && geometry.lods[ui_lod + 1].error * scale * m_pixelsPerUnit <= m_errorBudget)
+            {
+                ui_lod++;
+            }
+        }
+        m_selections[ui_lod]++;
+        return ui_lod;
+    }
+
+    float LodSelector::GetScale(const glm::mat4& model, float depth)
+    {
+        if (depth <= 0.0f)
+        {
+            return FLT_MAX;
+        }
+
+        // The longest axis of the model matrix, so a non uniformly scaled object picks its LOD by the side that grows the error most
+        float f_scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+        return f_scale / depth;
+    }
+
+    void LodSelector::RecordFrame(uint64_t triangles, uint64_t fullDetailTriangles)
+    {
+        m_frameTriangles = triangles;
+        m_frameFullDetailTriangles = fullDetailTriangles;
+        m_totalTriangles += triangles;
+        m_totalFullDetailTriangles += fullDetailTriangles;
+        m_frames++;
+    }
+
+    void LodSelector::PrintStats()
+    {
+        uint32_t ui_frames = std::max(m_frames, 1u);
+        uint64_t draws = 0;
+        for (uint32_t l = 0; l < MESH_MAX_LODS; l++)
+        {
+            draws += m_selections[l];
+        }
+
+        float f_saved = m_totalFullDetailTriangles > 0 ? 100.0f * (1.0f - static_cast<float>(m_totalTriangles) / m_totalFullDetailTriangles) : 0.0f;
+        std::cout << "lod: " << (m_errorBudget > 0.0f ? "" : "disabled, ") << m_errorBudget << " pixel error budget, " << m_totalTriangles / ui_frames << " triangles per frame on average of "
+            << m_totalFullDetailTriangles / ui_frames << " at full detail (" << f_saved << "% saved, last frame " << m_frameTriangles << " of " << m_frameFullDetailTriangles << ")" << std::endl;
+        std::cout << "  draws per LOD:";
+        for (uint32_t l = 0; l < MESH_MAX_LODS; l++)
+        {
+            std::cout << " " << l << ": " << (draws > 0 ? 100.0f * m_selections[l] / draws : 0.0f) << "%";
+        }
+        std::cout << std::endl;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "Structs.h"
+#include "GeometryArena.h"
+
+#include <glm.hpp>
+
+
+namespace VCore
+{
+	// Refer to - https://github.com/zeux/meshoptimizer#simplification (the error it returns is what gets projected here)
+	// Picks which of a mesh's levels of detail (MeshSimplifier) each draw uses. A LOD's error is how far its surface may be from the full detail one in object space,
+	// projected onto the screen it's error * scale * pixels per unit at distance 1, where scale folds in the object's size and distance (GetScale). The coarsest LOD whose projected error fits the error budget is drawn.
+	// SetView once per frame before selecting, everything here is main thread only.
+	class LodSelector
+	{
+	public:
+		LodSelector();
+		~LodSelector();
+
+		// Pixels a LOD's error may cover on screen. 0 always draws the full detail mesh. Defaults to VM_LOD_ERROR_PIXELS
+		void SetErrorBudget(float pixels);
+		float GetErrorBudget();
+		// The frame's projection and viewport height, what turns distances into pixels
+		void SetView(const glm::mat4& proj, uint32_t height);
+		// scale is world units per object space unit over the distance in front of the camera (clip w). Anything at or behind the camera gets full detail
+		uint32_t SelectLod(const GeometryRange& geometry, float scale);
+		// scale for an object drawn with model whose bounding sphere's center is depth in front of the camera
+		static float GetScale(const glm::mat4& model, float depth);
+		// Counts a frame's triangles, drawn and what the full detail meshes would have been
+		void RecordFrame(uint64_t triangles, uint64_t fullDetailTriangles);
+		void PrintStats();
+
+	private:
+		float m_errorBudget;
+		float m_pixelsPerUnit; // at distance 1
+
+		// stats
+		uint64_t m_selections[MESH_MAX_LODS]; // draws per LOD
+		uint64_t m_totalTriangles;
+		uint64_t m_totalFullDetailTriangles;
+		uint64_t m_frameTriangles; // last frame's
+		uint64_t m_frameFullDetailTriangles;
+		uint32_t m_frames;
+	};
+}
@@ -14,6 +14,8 @@ namespace VCore
         m_device = VK_NULL_HANDLE;
         m_graphicsQueue = VK_NULL_HANDLE;
         m_presentQueue = VK_NULL_HANDLE;
+        m_transferQueue = VK_NULL_HANDLE;
+        m_allocator = std::make_shared<MemoryAllocator>();
     }
 
     LogicalDevice::~LogicalDevice()
@@ -35,7 +37,17 @@ namespace VCore
         return m_presentQueue;
     }
 
-    void LogicalDevice::Init(PhysicalDevice &physicalDevice, VkSurfaceKHR surface)
+    VkQueue& LogicalDevice::GetTransferQueue()
+    {
+        return m_transferQueue;
+    }
+
+    MemoryAllocator& LogicalDevice::GetAllocator()
+    {
+        return *m_allocator;
+    }
+
+    void LogicalDevice::Init(PhysicalDevice &physicalDevice, VkSurfaceKHR surface, bool b_bindless, bool b_drawIndirectCount, bool b_drawIndirectFirstInstance)
     {
         // Create logical device to interface with the m_phyiscalDevice and queues for the device
 
@@ -46,6 +58,10 @@ namespace VCore
         // We create unique createInfos for each of these queueFamilies
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
         std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value() };
+        if (indices.transferFamily.has_value())
+        {
+            uniqueQueueFamilies.insert(indices.transferFamily.value()); // for the UploadQueue
+        }
 
 
         float f_queuePriority = 1.0f; // Vulkan lets you assign priorities to queues to influence the scheduling of command buffer execution using floating point numbers between 0.0 and 1.0
@@ -65,6 +81,14 @@ namespace VCore
         deviceFeatures.samplerAnisotropy = VK_TRUE; // Anisotropic texture filtering
         deviceFeatures.sampleRateShading = VK_TRUE; // enable sample shading feature for the device (at a potential performance cost)
         // ^^ Need to also change multisampling.sampleShadingEnable and multisampling.minSampleShading to correctly switch this on and off in createGraphicsPipeline() function
+        if (b_bindless)
+        {
+            deviceFeatures.shaderStorageBufferArrayDynamicIndexing = VK_TRUE; // bindless.vert indexes the object buffer array with a push constant
+        }
+        if (b_drawIndirectFirstInstance)
+        {
+            deviceFeatures.drawIndirectFirstInstance = VK_TRUE; // GpuCuller's draw commands start at each batch's (and phase's) slice of the instance buffer
+        }
 
 
         // Now we can start filling out the VkDeviceCreateInfo structure for our logical device with the structs created above
@@ -74,10 +98,39 @@ namespace VCore
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pEnabledFeatures = &deviceFeatures;
 
+        // Descriptor indexing for the BindlessTable, draw count buffers for the GpuCuller
+        VkPhysicalDeviceVulkan12Features vulkan12Features{};
+        vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        if (b_bindless)
+        {
+            vulkan12Features.descriptorIndexing = VK_TRUE;
+            vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+            vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+            vulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+            vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+            vulkan12Features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+            vulkan12Features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        }
+        if (b_drawIndirectCount)
+        {
+            vulkan12Features.drawIndirectCount = VK_TRUE;
+        }
+        if (b_bindless || b_drawIndirectCount)
+        {
+            createInfo.pNext = &vulkan12Features;
+        }
+
 
         // NOTE FROM WIKI: The remainder of the information bears a resemblance to the VkInstanceCreateInfo struct and requires you to specify extensions and validation layers. The difference is that these are device specific this time.
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(DEVICE_EXTENSIONS.size()); // give number of enabled extensions
-        createInfo.ppEnabledExtensionNames = DEVICE_EXTENSIONS.data(); // give names of extensions enabled (ie. VK_KHR_swapchain)
+        if (surface != VK_NULL_HANDLE)
+        {
+            createInfo.enabledExtensionCount = static_cast<uint32_t>(DEVICE_EXTENSIONS.size()); // give number of enabled extensions
+            createInfo.ppEnabledExtensionNames = DEVICE_EXTENSIONS.data(); // give names of extensions enabled (ie. VK_KHR_swapchain)
+        }
+        else
+        {
+            createInfo.enabledExtensionCount = 0; // headless - no swap chain, so VK_KHR_swapchain isn't needed (and may not exist on software drivers)
+        }
 
         if (b_ENABLE_VALIDATION_LAYERS)
         {
@@ -101,11 +154,18 @@ namespace VCore
             // ^^ NOTE FROM WIKI: The parameters are the logical device, queue family, queue index and a pointer to the variable to store the queue handle in. Because we're only creating a single queue from this family, we'll simply use index 0.
             vkGetDeviceQueue(m_device, indices.presentFamily.value(), 0, &m_presentQueue); // Present queue handle
             // ^^ NOTE FROM WIKI: In case the queue families are the same, the two handles will most likely have the same value now. 
+            if (indices.transferFamily.has_value())
+            {
+                vkGetDeviceQueue(m_device, indices.transferFamily.value(), 0, &m_transferQueue); // Transfer queue handle
+            }
+
+            m_allocator->Init(physicalDevice.GetDevice(), m_device);
         }
     }
 
     void LogicalDevice::Cleanup()
     {
+        m_allocator->Cleanup(); // every resource should already be destroyed, this releases the blocks themselves
         vkDestroyDevice(m_device, nullptr);
     }
 }
\ No newline at end of file
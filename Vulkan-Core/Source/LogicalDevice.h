@@ -1,9 +1,12 @@
 #pragma once
 #include "PhysicalDevice.h"
+#include "MemoryAllocator.h"
 
 #define GLFW_INCLUDE_VULKAN
 #include <glfw3.h>
 
+#include <memory>
+
 
 namespace VCore
 {
@@ -16,13 +19,19 @@ namespace VCore
 		VkDevice& GetDevice();
 		VkQueue& GetGraphicsQueue();
 		VkQueue& GetPresentQueue();
-		void Init(PhysicalDevice& physicalDevice, VkSurfaceKHR surface);
+		VkQueue& GetTransferQueue(); // VK_NULL_HANDLE if the device has no dedicated transfer family
+		MemoryAllocator& GetAllocator();
+		// b_bindless turns on the descriptor indexing features BindlessTable needs (check PhysicalDevice::SupportsBindless first)
+		// b_drawIndirectCount turns on drawIndirectCount for GpuCuller (check PhysicalDevice::SupportsDrawIndirectCount first)
+		void Init(PhysicalDevice& physicalDevice, VkSurfaceKHR surface, bool b_bindless = false, bool b_drawIndirectCount = false, bool b_drawIndirectFirstInstance = false);
 		void Cleanup();
 
 	private:
 		VkDevice m_device;
 		VkQueue m_graphicsQueue;
 		VkQueue m_presentQueue;
+		VkQueue m_transferQueue;
+		std::shared_ptr<MemoryAllocator> m_allocator; // all buffer and image memory is sub-allocated from here
 	};
 }
 
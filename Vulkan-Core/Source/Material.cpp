@@ -9,35 +9,65 @@ namespace VCore
 	Material::Material(std::string vertexPath, std::string fragmentPath)
 	{
 		m_graphicsPipeline = GraphicsPipeline(vertexPath, fragmentPath);
+		m_frameSetLayout = VK_NULL_HANDLE;
 		m_descriptorSetLayout = VK_NULL_HANDLE;
 		m_textures = std::vector<Texture>();
+		m_b_pipelineReady = false;
+		m_b_pipelineFailed = false;
+		m_fallback = nullptr;
+		m_bindlessTable = nullptr;
+		m_bindlessVertexPath = "";
+		m_bindlessFragmentPath = "";
+		m_textureIndex = 0;
+		m_b_instanced = false;
 	}
 
 	Material::Material()
 	{
+		m_frameSetLayout = VK_NULL_HANDLE;
+		m_descriptorSetLayout = VK_NULL_HANDLE;
+		m_b_pipelineReady = false;
+		m_b_pipelineFailed = false;
+		m_fallback = nullptr;
+		m_bindlessTable = nullptr;
+		m_textureIndex = 0;
+		m_b_instanced = false;
 	}
 
 	Material::~Material()
 	{
 	}
 
-	void Material::CleanupTextures(LogicalDevice& logicalDevice)
+	void Material::CleanupTextures(DescriptorAllocator& descriptorAllocator, LogicalDevice& logicalDevice)
 	{
-		for (Texture texture : m_textures)
+		for (Texture& texture : m_textures)
 		{
+			// Cached sets written with these can't be handed to whatever gets the handles next
+			descriptorAllocator.Invalidate((uint64_t)texture.GetImageView());
+			descriptorAllocator.Invalidate((uint64_t)texture.GetTextureSampler());
 			texture.Cleanup(logicalDevice);
 		}
 	}
 
 
-	void Material::CreateMaterialResources(WinSys& winSystem, VkCommandPool commandPool, RenderPass& renderPass, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice)
+	void Material::CreateMaterialResources(WinSys& winSystem, UploadQueue& uploadQueue, PipelineRegistry& pipelineRegistry, RenderPass& renderPass, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice)
 	{
-		CreateTextureResources(winSystem, commandPool, physicalDevice, logicalDevice);
-		CreateDescriptorSetLayout(logicalDevice);
-		CreateGraphicsPipeline(logicalDevice, winSystem, renderPass);
-		// Will need to create descriptor sets (and pools?) when the material is applied to a new model. These are stored on the GameObject
-		// CreateDescriptorPool(logicalDevice);
-		// CreateDescriptorSets(model, logicalDevice);
+		CreateTextureResources(winSystem, uploadQueue, physicalDevice, logicalDevice);
+		if (m_bindlessTable != nullptr)
+		{
+			// Textures are registered one after another, so the first index is enough to find the rest
+			for (size_t i = 0; i < m_textures.size(); i++)
+			{
+				uint32_t index = m_bindlessTable->RegisterTexture(m_textures[i], logicalDevice);
+				if (i == 0)
+				{
+					m_textureIndex = index;
+				}
+			}
+		}
+		CreateDescriptorSetLayout(pipelineRegistry, logicalDevice);
+		// The pipeline is left to the PipelineCompiler so a slow shader compile never holds up the frame loop
+		// Descriptor sets are created when the material is applied to a model (CreateDescriptorSets), and are stored on the GameObject
 	}
 
 	void Material::SetVertexPath(std::string path)
@@ -50,9 +80,96 @@ namespace VCore
 		m_graphicsPipeline.SetFragmentPath(path);
 	}
 
-	void Material::CreateGraphicsPipeline(LogicalDevice& logicalDevice, WinSys& winSystem, RenderPass& renderPass)
+	void Material::SetBindlessShaders(std::string vertexPath, std::string fragmentPath)
+	{
+		m_bindlessVertexPath = vertexPath;
+		m_bindlessFragmentPath = fragmentPath;
+	}
+
+	void Material::EnableBindless(BindlessTable& bindlessTable)
+	{
+		m_bindlessTable = &bindlessTable;
+		if (!m_bindlessVertexPath.empty() && !m_bindlessFragmentPath.empty())
+		{
+			m_graphicsPipeline.SetVertexPath(m_bindlessVertexPath);
+			m_graphicsPipeline.SetFragmentPath(m_bindlessFragmentPath);
+		}
+		m_graphicsPipeline.SetBindless(true);
+		// Bindless objects already skip per object descriptor binding, they keep drawing one by one
+		m_b_instanced = false;
+		m_graphicsPipeline.SetInstanced(false);
+	}
+
+	void Material::SetInstanced(std::string vertexPath)
+	{
+		m_b_instanced = true;
+		m_graphicsPipeline.SetVertexPath(vertexPath);
+		m_graphicsPipeline.SetInstanced(true);
+	}
+
+	bool Material::IsInstanced()
+	{
+		return m_b_instanced;
+	}
+
+	void Material::SetVertexFormat(VertexFormat format)
+	{
+		m_graphicsPipeline.SetVertexFormat(format);
+	}
+
+	BindlessTable* Material::GetBindlessTable()
+	{
+		return m_bindlessTable;
+	}
+
+	uint32_t Material::GetTextureIndex()
+	{
+		return m_textureIndex;
+	}
+
+	void Material::CreateGraphicsPipeline(LogicalDevice& logicalDevice, VkSampleCountFlagBits samples, RenderPass& renderPass, PipelineRegistry& pipelineRegistry)
+	{
+		m_graphicsPipeline.CreateGraphicsPipeline(logicalDevice, samples, renderPass, m_frameSetLayout, m_descriptorSetLayout, pipelineRegistry);
+		// Release pairs with the acquire in IsPipelineReady, so a recording thread that sees true also sees the pipeline handles
+		m_b_pipelineReady.store(true, std::memory_order_release);
+	}
+
+	bool Material::IsPipelineReady()
+	{
+		return m_b_pipelineReady.load(std::memory_order_acquire);
+	}
+
+	void Material::MarkPipelineFailed()
+	{
+		m_b_pipelineFailed.store(true, std::memory_order_release);
+	}
+
+	bool Material::IsPipelineFailed()
+	{
+		return m_b_pipelineFailed.load(std::memory_order_acquire);
+	}
+
+	void Material::SetFallback(std::shared_ptr<Material> fallback)
+	{
+		m_fallback = fallback;
+	}
+
+	std::shared_ptr<Material> Material::GetFallback()
 	{
-		m_graphicsPipeline.CreateGraphicsPipeline(logicalDevice, winSystem, renderPass, m_descriptorSetLayout);
+		return m_fallback;
+	}
+
+	Material* Material::GetDrawMaterial()
+	{
+		if (IsPipelineReady())
+		{
+			return this;
+		}
+		if (m_fallback != nullptr && m_fallback->IsPipelineReady() && m_fallback->GetDescriptorSetLayout() == m_descriptorSetLayout && m_fallback->IsInstanced() == m_b_instanced)
+		{
+			return m_fallback.get();
+		}
+		return nullptr;
 	}
 
 	VkPipeline& Material::GetGraphicsPipeline()
@@ -65,19 +182,20 @@ namespace VCore
 		return m_graphicsPipeline.GetPipelineLayout();
 	}
 
-	void Material::CreateDescriptorSetLayout(LogicalDevice& logicalDevice)
+	void Material::CreateDescriptorSetLayout(PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice)
 	{
-		// Refer to - https://vulkan-tutorial.com/en/Uniform_buffers/Descriptor_layout_and_buffer
-		std::vector<VkDescriptorSetLayoutBinding> bindings{};
+		m_frameSetLayout = pipelineRegistry.AcquireDescriptorSetLayout(FrameConstants::GetSetLayoutBindings(), logicalDevice);
 
-		VkDescriptorSetLayoutBinding uboLayoutBinding{};
-		uboLayoutBinding.binding = 0;
-		uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		uboLayoutBinding.descriptorCount = 1;
-		uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-		uboLayoutBinding.pImmutableSamplers = nullptr; // Optional
+		// Every bindless material shares the table's layout, so they're all fallback compatible with each other too
+		if (m_bindlessTable != nullptr)
+		{
+			m_descriptorSetLayout = m_bindlessTable->GetDescriptorSetLayout();
+			return;
+		}
 
-		bindings.push_back(uboLayoutBinding);
+		// Refer to - https://vulkan-tutorial.com/en/Texture_mapping/Combined_image_sampler
+		// Binding 0 used to be the per object uniform buffer, textures keep starting at 1 so the shaders' bindings didn't have to move
+		std::vector<VkDescriptorSetLayoutBinding> bindings{};
 
 		for (int i = 0; i < m_textures.size(); i++)
 		{
@@ -91,15 +209,8 @@ namespace VCore
 			bindings.push_back(samplerLayoutBinding);
 		}
 
-		VkDescriptorSetLayoutCreateInfo layoutInfo{};
-		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-		layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
-		layoutInfo.pBindings = bindings.data();
-
-		if (vkCreateDescriptorSetLayout(logicalDevice.GetDevice(), &layoutInfo, nullptr, &m_descriptorSetLayout) != VK_SUCCESS)
-		{
-			throw std::runtime_error("failed to create descriptor set layout!");
-		}
+		// Materials with the same bindings share one layout, which in turn lets them share a pipeline
+		m_descriptorSetLayout = pipelineRegistry.AcquireDescriptorSetLayout(bindings, logicalDevice);
 	}
 
 	VkDescriptorSetLayout& Material::GetDescriptorSetLayout()
@@ -107,103 +218,55 @@ namespace VCore
 		return m_descriptorSetLayout;
 	}
 
-	void Material::CreateDescriptorPool(VkDescriptorPool& descriptorPool, LogicalDevice& logicalDevice)
+	void Material::CreateDescriptorSets(std::vector<VkDescriptorSet>& descriptorSets, DescriptorAllocator& descriptorAllocator, LogicalDevice& logicalDevice)
 	{
-		VkDescriptorPool newPool = VK_NULL_HANDLE;
-
 		// Refer to - https://vulkan-tutorial.com/en/Uniform_buffers/Descriptor_pool_and_sets
 		// And for combined sampler - https://vulkan-tutorial.com/en/Texture_mapping/Combined_image_sampler
-
-		std::vector<VkDescriptorPoolSize> poolSizes{};
-		poolSizes.resize(m_textures.size() + 1);
-
-		poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		poolSizes[0].descriptorCount = static_cast<uint32_t>(VM_MAX_FRAMES_IN_FLIGHT);
-
-		for (int j = 1; j < m_textures.size() + 1; j++)
-		{
-			poolSizes[j].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-			poolSizes[j].descriptorCount = static_cast<uint32_t>(VM_MAX_FRAMES_IN_FLIGHT);
-		}
-
-		VkDescriptorPoolCreateInfo poolInfo{};
-		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-		poolInfo.pPoolSizes = poolSizes.data();
-		poolInfo.maxSets = static_cast<uint32_t>(VM_MAX_FRAMES_IN_FLIGHT);
-
-		if (vkCreateDescriptorPool(logicalDevice.GetDevice(), &poolInfo, nullptr, &newPool) != VK_SUCCESS)
+		// Bindless objects find their data through the global set instead
+		if (m_bindlessTable != nullptr)
 		{
-			throw std::runtime_error("failed to create descriptor pool!");
+			descriptorSets.clear();
+			return;
 		}
 
-		descriptorPool = newPool;
-	}
-
-	void Material::CreateDescriptorSets(std::vector<VkDescriptorSet>& descriptorSets, VkDescriptorPool& descriptorPool, Model& model, LogicalDevice& logicalDevice)
-	{
 		descriptorSets.resize(VM_MAX_FRAMES_IN_FLIGHT);
 
-		std::vector<VkDescriptorSetLayout> layouts(VM_MAX_FRAMES_IN_FLIGHT, m_descriptorSetLayout);
-		VkDescriptorSetAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-		allocInfo.descriptorPool = descriptorPool;
-		allocInfo.descriptorSetCount = static_cast<uint32_t>(VM_MAX_FRAMES_IN_FLIGHT);
-		allocInfo.pSetLayouts = layouts.data();
-
-		// Allocate descriptor sets
-		if (vkAllocateDescriptorSets(logicalDevice.GetDevice(), &allocInfo, descriptorSets.data()) != VK_SUCCESS)
-		{
-			throw std::runtime_error("failed to allocate descriptor sets!");
-		}
-
 		for (int i = 0; i < VM_MAX_FRAMES_IN_FLIGHT; i++)
 		{
-			// Populate them
-			std::vector<VkWriteDescriptorSet> descriptorWrites{};
-			descriptorWrites.resize(m_textures.size() + 1);
-
-			VkDescriptorBufferInfo bufferInfo{};
-			bufferInfo.buffer = model.GetUniformBuffers()[i];
-			bufferInfo.offset = 0;
-			bufferInfo.range = sizeof(UniformBufferObject);
-
-			descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[0].dstSet = descriptorSets[i];
-			descriptorWrites[0].dstBinding = 0;
-			descriptorWrites[0].dstArrayElement = 0;
-			descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			descriptorWrites[0].descriptorCount = 1;
-			descriptorWrites[0].pBufferInfo = &bufferInfo;
+			std::vector<DescriptorBinding> bindings(m_textures.size());
 
 			for (size_t j = 0; j < m_textures.size(); j++)
 			{
-				VkDescriptorImageInfo imageInfo{};
-				imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-				imageInfo.imageView = m_textures[j].GetImageView();
-				imageInfo.sampler = m_textures[j].GetTextureSampler();
-
-				descriptorWrites[j + 1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				descriptorWrites[j + 1].dstSet = descriptorSets[i];
-				descriptorWrites[j + 1].dstBinding = j + 1;
-				descriptorWrites[j + 1].dstArrayElement = 0;
-				descriptorWrites[j + 1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-				descriptorWrites[j + 1].descriptorCount = 1;
-				descriptorWrites[j + 1].pImageInfo = &imageInfo;
+				bindings[j].binding = static_cast<uint32_t>(j + 1);
+				bindings[j].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+				bindings[j].imageView = m_textures[j].GetImageView();
+				bindings[j].sampler = m_textures[j].GetTextureSampler();
 			}
 
-			vkUpdateDescriptorSets(logicalDevice.GetDevice(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+			// Nothing object specific is in the set, so every object using this material shares one set per frame
+			descriptorSets[i] = descriptorAllocator.GetOrCreateSet(m_descriptorSetLayout, bindings, logicalDevice);
 		}
 	}
 
-	void Material::CleanupGraphicsPipeline(LogicalDevice& logicalDevice)
+	void Material::CleanupGraphicsPipeline(PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice)
 	{
-		m_graphicsPipeline.Cleanup(logicalDevice);
+		// A material whose compile never finished (or failed) has nothing to release
+		if (m_b_pipelineReady.exchange(false))
+		{
+			m_graphicsPipeline.Cleanup(pipelineRegistry, logicalDevice);
+		}
 	}
 
-	void Material::CleanupDescriptorSetLayout(LogicalDevice& logicalDevice)
+	void Material::CleanupDescriptorSetLayout(PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice)
 	{
-		vkDestroyDescriptorSetLayout(logicalDevice.GetDevice(), m_descriptorSetLayout, nullptr);
+		// The bindless layout belongs to the BindlessTable
+		if (m_bindlessTable == nullptr)
+		{
+			pipelineRegistry.ReleaseDescriptorSetLayout(m_descriptorSetLayout, logicalDevice);
+		}
+		pipelineRegistry.ReleaseDescriptorSetLayout(m_frameSetLayout, logicalDevice);
+		m_descriptorSetLayout = VK_NULL_HANDLE;
+		m_frameSetLayout = VK_NULL_HANDLE;
 	}
 
 	void Material::AddTexture(std::string path)
@@ -218,11 +281,11 @@ namespace VCore
 		return m_textures;
 	}
 
-	void Material::CreateTextureResources(WinSys& winSystem, VkCommandPool commandPool, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice)
+	void Material::CreateTextureResources(WinSys& winSystem, UploadQueue& uploadQueue, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice)
 	{
 		for (Texture& texture : m_textures)
 		{
-			texture.CreateTextureImage(winSystem, commandPool, physicalDevice, logicalDevice);
+			texture.CreateTextureImage(winSystem, uploadQueue, physicalDevice, logicalDevice);
 			texture.CreateTextureSampler(physicalDevice, logicalDevice);
 		}
 	}
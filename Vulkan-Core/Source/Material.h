@@ -6,12 +6,17 @@
 #include "RenderPass.h"
 #include "Texture.h"
 #include "Model.h"
+#include "DescriptorAllocator.h"
+#include "BindlessTable.h"
+#include "FrameConstants.h"
 
 #define GLFW_INCLUDE_VULKAN
 #include <glfw3.h>
 
 #include <string>
 #include <vector>
+#include <memory>
+#include <atomic>
 
 
 namespace VCore
@@ -22,27 +27,58 @@ namespace VCore
 		Material(std::string vertexPath, std::string fragmentPath);
 		Material();
 		~Material();
-		void CleanupGraphicsPipeline(LogicalDevice& logicalDevice);
-		void CleanupDescriptorSetLayout(LogicalDevice& logicalDevice);		
-		void CleanupTextures(LogicalDevice& logicalDevice);
+		void CleanupGraphicsPipeline(PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice);
+		void CleanupDescriptorSetLayout(PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice);
+		void CleanupTextures(DescriptorAllocator& descriptorAllocator, LogicalDevice& logicalDevice);
 
-		void CreateMaterialResources(WinSys& winSystem, VkCommandPool commandPool, RenderPass& renderPass, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
+		// Textures and descriptor set layout only - the pipeline is built separately (CreateGraphicsPipeline, usually from a PipelineCompiler worker)
+		void CreateMaterialResources(WinSys& winSystem, UploadQueue& uploadQueue, PipelineRegistry& pipelineRegistry, RenderPass& renderPass, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
 		void SetVertexPath(std::string path);
 		void SetFragmentPath(std::string path);
-		void CreateGraphicsPipeline(LogicalDevice& logicalDevice, WinSys& winSystem, RenderPass& renderPass);
+		// Shaders used instead of the regular ones when the material is bindless
+		void SetBindlessShaders(std::string vertexPath, std::string fragmentPath);
+		// Call before CreateMaterialResources. Textures go into the table's texture array and objects get their data from its object buffers instead of per object descriptor sets
+		void EnableBindless(BindlessTable& bindlessTable);
+		BindlessTable* GetBindlessTable(); // nullptr unless bindless
+		uint32_t GetTextureIndex(); // first texture's index in the bindless texture array
+		// Objects using this material are drawn in instanced batches (InstanceBatcher). vertexPath replaces the vertex shader and has to read InstanceData at locations 4-8
+		void SetInstanced(std::string vertexPath);
+		bool IsInstanced();
+		// Call before CreateGraphicsPipeline, has to match the MeshRegistry's. The vertex shaders' compact builds are picked by name (see VertexCodec::GetShaderPath)
+		void SetVertexFormat(VertexFormat format);
+		// Safe to call from another thread, the pipeline is only published to IsPipelineReady() once it's fully built
+		void CreateGraphicsPipeline(LogicalDevice& logicalDevice, VkSampleCountFlagBits samples, RenderPass& renderPass, PipelineRegistry& pipelineRegistry);
+		bool IsPipelineReady();
+		// Set by the PipelineCompiler when the compile threw. The material never becomes ready, its objects are drawn with the fallback for good
+		void MarkPipelineFailed();
+		bool IsPipelineFailed();
+		// Drawn in this material's place while its pipeline compiles. Only used if it ends up with the same descriptor set layout and instancing, otherwise the objects' descriptor sets or vertex bindings wouldn't fit it
+		void SetFallback(std::shared_ptr<Material> fallback);
+		std::shared_ptr<Material> GetFallback();
+		// The material to draw with this frame, or nullptr if neither this nor its fallback is ready
+		Material* GetDrawMaterial();
 		VkPipeline& GetGraphicsPipeline();
 		VkPipelineLayout& GetPipelineLayout();
-		void CreateDescriptorSetLayout(LogicalDevice& logicalDevice);
+		void CreateDescriptorSetLayout(PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice);
 		VkDescriptorSetLayout& GetDescriptorSetLayout();
-		void CreateDescriptorPool(VkDescriptorPool& descriptorPool, LogicalDevice& logicalDevice);
-		void CreateDescriptorSets(std::vector<VkDescriptorSet>& descriptorSets, VkDescriptorPool& descriptorPool, Model& model, LogicalDevice& logicalDevice);
+		// Set 1, this material's textures. The camera lives in FrameConstants' set 0 and transforms are pushed per draw
+		void CreateDescriptorSets(std::vector<VkDescriptorSet>& descriptorSets, DescriptorAllocator& descriptorAllocator, LogicalDevice& logicalDevice);
 		void AddTexture(std::string path);
 		std::vector<Texture>& GetTextures();
-		void CreateTextureResources(WinSys& winSystem, VkCommandPool commandPool, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
+		void CreateTextureResources(WinSys& winSystem, UploadQueue& uploadQueue, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
 
 	private:
 		GraphicsPipeline m_graphicsPipeline;
+		VkDescriptorSetLayout m_frameSetLayout; // set 0, the same layout FrameConstants gets from the registry
 		VkDescriptorSetLayout m_descriptorSetLayout;
 		std::vector<Texture> m_textures;
+		std::atomic<bool> m_b_pipelineReady;
+		std::atomic<bool> m_b_pipelineFailed;
+		std::shared_ptr<Material> m_fallback;
+		BindlessTable* m_bindlessTable;
+		std::string m_bindlessVertexPath;
+		std::string m_bindlessFragmentPath;
+		uint32_t m_textureIndex;
+		bool m_b_instanced;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,270 @@
+#include "MemoryAllocator.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <iostream>
+
+
+namespace VCore
+{
+    const VkDeviceSize DEFAULT_DEVICE_BLOCK_SIZE = 64ull * 1024 * 1024;
+    const VkDeviceSize DEFAULT_HOST_BLOCK_SIZE = 16ull * 1024 * 1024;
+
+    MemoryAllocator::MemoryAllocator()
+    {
+        m_device = VK_NULL_HANDLE;
+        m_memoryProperties = VkPhysicalDeviceMemoryProperties{};
+        m_blocks = std::vector<std::unique_ptr<MemoryBlock>>();
+        m_deviceAllocationCalls = 0;
+    }
+
+    MemoryAllocator::~MemoryAllocator()
+    {
+    }
+
+    void MemoryAllocator::Init(VkPhysicalDevice physicalDevice, VkDevice device)
+    {
+        m_device = device;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_memoryProperties);
+    }
+
+    VkDeviceSize MemoryAllocator::GetBlockSize(uint32_t memoryTypeIndex)
+    {
+        // Host visible heaps (staging, uniforms) are usually much smaller than device local ones, and on small heaps we never want a single block to eat a big chunk of it
+        bool b_hostVisible = (m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+        VkDeviceSize blockSize = b_hostVisible ? DEFAULT_HOST_BLOCK_SIZE : DEFAULT_DEVICE_BLOCK_SIZE;
+        VkDeviceSize heapSize = m_memoryProperties.memoryHeaps[m_memoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+
+        return std::min(blockSize, heapSize / 8);
+    }
+
+    Allocation MemoryAllocator::Allocate(const VkMemoryRequirements& memRequirements, uint32_t memoryTypeIndex, bool b_optimalImage, AllocationStrategy strategy)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        Allocation allocation{};
+        VkDeviceSize offset = 0;
+        VkDeviceSize rangeOffset = 0;
+        MemoryBlock* chosenBlock = nullptr;
+        VkDeviceSize blockSize = GetBlockSize(memoryTypeIndex);
+
+        if (memRequirements.size > blockSize / 2)
+        {
+            // Big resources (large textures, render targets at high resolutions) get a block of their own rather than fragmenting the shared ones
+            chosenBlock = CreateBlock(memRequirements.size, memoryTypeIndex, b_optimalImage, strategy, true);
+            AllocateFromBlock(*chosenBlock, memRequirements.size, memRequirements.alignment, offset, rangeOffset);
+        }
+        else
+        {
+            for (std::unique_ptr<MemoryBlock>& block : m_blocks)
+            {
+                if (!block->b_dedicated && block->memoryTypeIndex == memoryTypeIndex && block->b_optimalImages == b_optimalImage && block->strategy == strategy &&
+                    AllocateFromBlock(*block, memRequirements.size, memRequirements.alignment, offset, rangeOffset))
+                {
+                    chosenBlock = block.get();
+                    break;
+                }
+            }
+
+            if (chosenBlock == nullptr)
+            {
+                chosenBlock = CreateBlock(blockSize, memoryTypeIndex, b_optimalImage, strategy, false);
+                if (!AllocateFromBlock(*chosenBlock, memRequirements.size, memRequirements.alignment, offset, rangeOffset))
+                {
+                    throw std::runtime_error("failed to sub-allocate memory from a new block!");
+                }
+            }
+        }
+
+        allocation.memory = chosenBlock->memory;
+        allocation.offset = offset;
+        allocation.size = memRequirements.size;
+        allocation.block = chosenBlock;
+        allocation.rangeOffset = rangeOffset;
+        if (chosenBlock->mapped != nullptr)
+        {
+            allocation.mapped = static_cast<char*>(chosenBlock->mapped) + offset;
+        }
+
+        return allocation;
+    }
+
+    void MemoryAllocator::Free(Allocation& allocation)
+    {
+        if (allocation.block == nullptr)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        MemoryBlock* block = allocation.block;
+        FreeInBlock(*block, allocation.rangeOffset, allocation.offset + allocation.size - allocation.rangeOffset);
+
+        if (block->b_dedicated && block->allocationCount == 0)
+        {
+            vkFreeMemory(m_device, block->memory, nullptr); // unmapped implicitly
+            m_blocks.erase(std::find_if(m_blocks.begin(), m_blocks.end(), [block](const std::unique_ptr<MemoryBlock>& other) { return other.get() == block; }));
+        }
+
+        allocation = Allocation{};
+    }
+
+    MemoryBlock* MemoryAllocator::CreateBlock(VkDeviceSize size, uint32_t memoryTypeIndex, bool b_optimalImage, AllocationStrategy strategy, bool b_dedicated)
+    {
+        std::unique_ptr<MemoryBlock> block = std::make_unique<MemoryBlock>();
+        block->size = size;
+        block->memoryTypeIndex = memoryTypeIndex;
+        block->b_optimalImages = b_optimalImage;
+        block->b_dedicated = b_dedicated;
+        block->strategy = strategy;
+        block->freeRanges.push_back({ 0, size });
+
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = size;
+        allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+        if (vkAllocateMemory(m_device, &allocInfo, nullptr, &block->memory) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate device memory block!");
+        }
+        m_deviceAllocationCalls++;
+
+        // Host visible blocks stay mapped for their whole lifetime - mapping is expensive and it's perfectly legal to keep memory mapped while the GPU uses it
+        if (m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        {
+            if (vkMapMemory(m_device, block->memory, 0, VK_WHOLE_SIZE, 0, &block->mapped) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to map device memory block!");
+            }
+        }
+
+        m_blocks.push_back(std::move(block));
+        return m_blocks.back().get();
+    }
+
+    bool MemoryAllocator::AllocateFromBlock(MemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset, VkDeviceSize& rangeOffset)
+    {
+        // alignment is always a power of two (memRequirements.alignment)
+        if (block.strategy == AllocationStrategy::LINEAR)
+        {
+            VkDeviceSize alignedOffset = (block.linearHead + alignment - 1) & ~(alignment - 1);
+            if (alignedOffset + size > block.size)
+            {
+                return false;
+            }
+
+            offset = alignedOffset;
+            rangeOffset = block.linearHead;
+            block.usedBytes += (alignedOffset + size) - block.linearHead;
+            block.linearHead = alignedOffset + size;
+            block.allocationCount++;
+            return true;
+        }
+
+        // First fit through the free ranges
+        for (size_t i = 0; i < block.freeRanges.size(); i++)
+        {
+            MemoryBlock::FreeRange range = block.freeRanges[i];
+            VkDeviceSize alignedOffset = (range.offset + alignment - 1) & ~(alignment - 1);
+            VkDeviceSize padding = alignedOffset - range.offset;
+
+            if (padding + size > range.size)
+            {
+                continue;
+            }
+
+            // The alignment padding stays with the allocation so Free can hand back the whole range
+            offset = alignedOffset;
+            rangeOffset = range.offset;
+            VkDeviceSize consumed = padding + size;
+            if (consumed == range.size)
+            {
+                block.freeRanges.erase(block.freeRanges.begin() + i);
+            }
+            else
+            {
+                block.freeRanges[i].offset += consumed;
+                block.freeRanges[i].size -= consumed;
+            }
+
+            block.usedBytes += consumed;
+            block.allocationCount++;
+            return true;
+        }
+
+        return false;
+    }
+
+    void MemoryAllocator::FreeInBlock(MemoryBlock& block, VkDeviceSize rangeOffset, VkDeviceSize rangeSize)
+    {
+        block.allocationCount--;
+
+        if (block.strategy == AllocationStrategy::LINEAR)
+        {
+            // Individual frees don't return space, the block is rewound once it's empty
+            if (block.allocationCount == 0)
+            {
+                block.linearHead = 0;
+                block.usedBytes = 0;
+            }
+            return;
+        }
+
+        // Find where the range goes (free ranges are kept sorted by offset), then merge with the free neighbours on either side so big allocations can fit again
+        auto next = std::lower_bound(block.freeRanges.begin(), block.freeRanges.end(), rangeOffset, [](const MemoryBlock::FreeRange& range, VkDeviceSize value) { return range.offset < value; });
+        auto inserted = block.freeRanges.insert(next, { rangeOffset, rangeSize });
+        block.usedBytes -= rangeSize;
+
+        if (inserted + 1 != block.freeRanges.end() && inserted->offset + inserted->size == (inserted + 1)->offset)
+        {
+            inserted->size += (inserted + 1)->size;
+            block.freeRanges.erase(inserted + 1);
+        }
+
+        if (inserted != block.freeRanges.begin() && (inserted - 1)->offset + (inserted - 1)->size == inserted->offset)
+        {
+            (inserted - 1)->size += inserted->size;
+            block.freeRanges.erase(inserted);
+        }
+
+    }
+
+    MemoryStats MemoryAllocator::GetStats()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        MemoryStats stats{};
+        stats.blockCount = static_cast<uint32_t>(m_blocks.size());
+        stats.deviceAllocationCalls = m_deviceAllocationCalls;
+
+        for (std::unique_ptr<MemoryBlock>& block : m_blocks)
+        {
+            stats.allocationCount += block->allocationCount;
+            stats.reservedBytes += block->size;
+            stats.usedBytes += block->usedBytes;
+        }
+
+        return stats;
+    }
+
+    void MemoryAllocator::PrintStats()
+    {
+        MemoryStats stats = GetStats();
+
+        std::cout << "memory: " << stats.allocationCount << " allocations in " << stats.blockCount << " blocks, "
+            << stats.usedBytes / 1024 << " KiB used of " << stats.reservedBytes / 1024 << " KiB reserved, "
+            << stats.deviceAllocationCalls << " vkAllocateMemory calls" << std::endl;
+    }
+
+    void MemoryAllocator::Cleanup()
+    {
+        for (std::unique_ptr<MemoryBlock>& block : m_blocks)
+        {
+            vkFreeMemory(m_device, block->memory, nullptr);
+        }
+
+        m_blocks.clear();
+    }
+}
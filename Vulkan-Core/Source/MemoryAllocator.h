@@ -0,0 +1,90 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <glfw3.h>
+
+#include <vector>
+#include <memory>
+#include <mutex>
+
+
+namespace VCore
+{
+	// How space is handed out inside a block
+	enum class AllocationStrategy
+	{
+		FREE_LIST, // long lived resources (vertex/index/uniform buffers, textures) - freed space is reused and merged with its neighbours
+		LINEAR     // short lived resources (staging buffers) - bump allocated, the whole block is reset once everything in it has been freed
+	};
+
+	struct MemoryBlock;
+
+	// A range of device memory sub-allocated out of a larger MemoryBlock. Bind with memory + offset.
+	struct Allocation
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		void* mapped = nullptr; // persistently mapped pointer to the start of this range if the memory is host visible, nullptr otherwise
+		MemoryBlock* block = nullptr;
+		VkDeviceSize rangeOffset = 0; // start of the range taken from the block, including alignment padding in front of offset
+	};
+
+	struct MemoryBlock
+	{
+		struct FreeRange
+		{
+			VkDeviceSize offset;
+			VkDeviceSize size;
+		};
+
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize size = 0;
+		void* mapped = nullptr;
+		uint32_t memoryTypeIndex = 0;
+		bool b_optimalImages = false; // blocks hold either linear resources (buffers) or optimal tiling images, never both (see bufferImageGranularity)
+		bool b_dedicated = false; // single resource too big to share a block, released as soon as it is freed
+		AllocationStrategy strategy = AllocationStrategy::FREE_LIST;
+		std::vector<FreeRange> freeRanges; // sorted by offset (FREE_LIST blocks)
+		VkDeviceSize linearHead = 0; // next free offset (LINEAR blocks)
+		VkDeviceSize usedBytes = 0;
+		uint32_t allocationCount = 0;
+	};
+
+	struct MemoryStats
+	{
+		uint32_t blockCount = 0;
+		uint32_t allocationCount = 0;
+		VkDeviceSize reservedBytes = 0; // memory held in vkAllocateMemory blocks
+		VkDeviceSize usedBytes = 0; // memory handed out to resources (including alignment padding)
+		uint32_t deviceAllocationCalls = 0; // total vkAllocateMemory calls since Init
+	};
+
+	// Refer to - https://vulkan-tutorial.com/en/Vertex_buffers/Staging_buffer (Conclusion) and https://developer.nvidia.com/vulkan-memory-management
+	// Grabs large blocks of device memory per memory type and sub-allocates buffers and images out of them, so we stay far away from maxMemoryAllocationCount and skip a driver round trip per resource
+	class MemoryAllocator
+	{
+	public:
+		MemoryAllocator();
+		~MemoryAllocator();
+
+		void Init(VkPhysicalDevice physicalDevice, VkDevice device);
+		Allocation Allocate(const VkMemoryRequirements& memRequirements, uint32_t memoryTypeIndex, bool b_optimalImage, AllocationStrategy strategy = AllocationStrategy::FREE_LIST);
+		void Free(Allocation& allocation);
+		MemoryStats GetStats();
+		void PrintStats();
+		void Cleanup();
+
+	private:
+		MemoryBlock* CreateBlock(VkDeviceSize size, uint32_t memoryTypeIndex, bool b_optimalImage, AllocationStrategy strategy, bool b_dedicated);
+		bool AllocateFromBlock(MemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset, VkDeviceSize& rangeOffset);
+		void FreeInBlock(MemoryBlock& block, VkDeviceSize rangeOffset, VkDeviceSize rangeSize);
+		VkDeviceSize GetBlockSize(uint32_t memoryTypeIndex);
+
+		VkDevice m_device;
+		VkPhysicalDeviceMemoryProperties m_memoryProperties;
+		std::vector<std::unique_ptr<MemoryBlock>> m_blocks;
+		uint32_t m_deviceAllocationCalls;
+		std::mutex m_mutex;
+	};
+}
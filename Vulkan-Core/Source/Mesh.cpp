@@ -0,0 +1,231 @@
+#include "Mesh.h"
+#include "MeshImporter.h"
+#include "Helper.h"
+#include "VulkanManager.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+
+
+namespace VCore
+{
+    Mesh::Mesh(std::string path)
+    {
+        m_path = path;
+        m_vertices = std::vector<Vertex>();
+        m_indices = std::vector<uint32_t>();
+        m_lods = std::vector<MeshLod>();
+        m_meshFile = nullptr;
+        m_meshView = MeshView();
+        m_indexCount = 0;
+        m_bounds = MeshBounds();
+        m_vertexCache = VertexCacheStats();
+        m_geometryArena = nullptr;
+        m_geometry = nullptr;
+    }
+
+    Mesh::Mesh()
+    {
+        m_path = "";
+        m_meshFile = nullptr;
+        m_meshView = MeshView();
+        m_indexCount = 0;
+        m_bounds = MeshBounds();
+        m_vertexCache = VertexCacheStats();
+        m_geometryArena = nullptr;
+        m_geometry = nullptr;
+    }
+
+    Mesh::~Mesh()
+    {
+    }
+
+    void Mesh::Cleanup()
+    {
+        if (m_geometry != nullptr)
+        {
+            m_geometryArena->Free(m_geometry);
+        }
+        m_geometry = nullptr;
+        m_geometryArena = nullptr;
+    }
+
+    void Mesh::Load(JobSystem& jobSystem)
+    {
+        // Refer to - https://vulkan-tutorial.com/en/Loading_models
+        // Parsing and deduplicating happens once per OBJ edit - after that the .vmesh cache is mapped and its arrays are copied straight into staging memory
+
+        std::string cachePath = MeshCache::GetCachePath(m_path);
+        m_meshFile = std::make_shared<MappedFile>();
+
+        if (MeshCache::Load(cachePath, m_path, *m_meshFile, m_meshView))
+        {
+            m_indexCount = m_meshView.indexCount;
+            m_bounds = m_meshView.bounds;
+            m_vertexCache = MeshOptimizer::AnalyzeVertexCache(m_meshView.indices, m_meshView.indexCount, m_meshView.vertexCount);
+            return;
+        }
+
+        // Missing or stale cache - fall back to the OBJ and rebuild the cache for next time
+        m_meshFile.reset();
+        m_vertices.clear();
+        m_indices.clear();
+        ImportObj(m_path, m_vertices, m_indices, m_lods, m_bounds, jobSystem);
+
+        if (!MeshCache::Write(cachePath, m_path, m_vertices, m_indices, m_lods, m_bounds))
+        {
+            std::cout << "failed to write mesh cache " << cachePath << std::endl; // not fatal, we'll just parse the OBJ again next time
+        }
+
+        m_meshView.vertices = m_vertices.data();
+        m_meshView.vertexCount = static_cast<uint32_t>(m_vertices.size());
+        m_meshView.indices = m_indices.data();
+        m_meshView.indexCount = m_lods[0].indexCount;
+        m_meshView.lods = m_lods.data();
+        m_meshView.lodCount = static_cast<uint32_t>(m_lods.size());
+        m_meshView.bounds = m_bounds;
+        m_indexCount = m_meshView.indexCount;
+        m_vertexCache = MeshOptimizer::AnalyzeVertexCache(m_meshView.indices, m_meshView.indexCount, m_meshView.vertexCount);
+    }
+
+    void Mesh::BuildMeshCache(const std::string& path, JobSystem& jobSystem)
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<MeshLod> lods;
+        MeshBounds bounds;
+        ImportObj(path, vertices, indices, lods, bounds, jobSystem);
+
+        if (!MeshCache::Write(MeshCache::GetCachePath(path), path, vertices, indices, lods, bounds))
+        {
+            throw std::runtime_error("failed to write mesh cache for " + path);
+        }
+    }
+
+    void Mesh::ImportObj(const std::string& path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<MeshLod>& lods, MeshBounds& bounds, JobSystem& jobSystem)
+    {
+        MeshImporter::LoadObj(path, vertices, indices, jobSystem);
+
+        // Only ever runs when the cache is (re)built, so it's reported every time
+        MeshOptimizerStats stats = MeshOptimizer::Optimize(vertices, indices);
+        std::cout << "optimized " << path << ": ACMR " << stats.before.acmr << " -> " << stats.after.acmr << ", ATVR " << stats.before.atvr << " -> " << stats.after.atvr
+            << " in " << stats.vertexCacheMs + stats.overdrawMs + stats.vertexFetchMs << " ms" << std::endl;
+
+        // The LODs only add indices, the vertices (and so the bounds) are the full detail mesh's
+        bounds = ComputeBounds(vertices.data(), static_cast<uint32_t>(vertices.size()));
+        auto lodStart = std::chrono::high_resolution_clock::now();
+        MeshSimplifier::BuildLods(vertices, indices, bounds.radius, VM_LOD_MAX_ERROR_RATIO, lods);
+        auto lodEnd = std::chrono::high_resolution_clock::now();
+        std::cout << "simplified " << path << ":";
+        for (const MeshLod& lod : lods)
+        {
+            std::cout << " " << lod.indexCount / 3 << " triangles (error " << lod.error << ")";
+        }
+        std::cout << " in " << std::chrono::duration<float, std::chrono::milliseconds::period>(lodEnd - lodStart).count() << " ms" << std::endl;
+    }
+
+    uint64_t Mesh::GetContentHash()
+    {
+        uint64_t hashes[2] =
+        {
+            Helper::Hash64(m_meshView.vertices, sizeof(Vertex) * m_meshView.vertexCount),
+            Helper::Hash64(m_meshView.indices, sizeof(uint32_t) * m_meshView.indexCount)
+        };
+        return Helper::Hash64(hashes, sizeof(hashes));
+    }
+
+    MeshBounds Mesh::ComputeBounds(const Vertex* vertices, uint32_t vertexCount)
+    {
+        MeshBounds bounds;
+        if (vertexCount == 0)
+        {
+            return bounds;
+        }
+
+        bounds.min = vertices[0].pos;
+        bounds.max = vertices[0].pos;
+        for (uint32_t i = 1; i < vertexCount; i++)
+        {
+            bounds.min = glm::min(bounds.min, vertices[i].pos);
+            bounds.max = glm::max(bounds.max, vertices[i].pos);
+        }
+
+        // Centering on the box and measuring out to the farthest vertex is tighter than the box's half diagonal, and one more pass is cheap next to the import
+        bounds.center = (bounds.min + bounds.max) * 0.5f;
+        float f_radiusSquared = 0.0f;
+        for (uint32_t i = 0; i < vertexCount; i++)
+        {
+            glm::vec3 offset = vertices[i].pos - bounds.center;
+            f_radiusSquared = std::max(f_radiusSquared, glm::dot(offset, offset));
+        }
+        bounds.radius = std::sqrt(f_radiusSquared);
+
+        return bounds;
+    }
+
+    void Mesh::CreateBuffers(UploadQueue& uploadQueue, GeometryArena& geometryArena, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice)
+    {
+        // Refer to - https://vulkan-tutorial.com/en/Vertex_buffers/Staging_buffer
+        // No buffers of its own any more, the vertices and indices are copied into a range of one of the arena's pages
+        m_geometryArena = &geometryArena;
+        m_geometry = geometryArena.Allocate(m_meshView, uploadQueue, physicalDevice, logicalDevice);
+    }
+
+    void Mesh::ReleaseMeshData()
+    {
+        // UploadBuffer copies into staging memory right away, so nothing reads the mapping or the vectors after the range is allocated
+        m_meshFile.reset();
+        m_vertices = std::vector<Vertex>();
+        m_indices = std::vector<uint32_t>();
+        m_lods = std::vector<MeshLod>();
+        m_meshView.vertices = nullptr;
+        m_meshView.vertexCount = 0;
+        m_meshView.indices = nullptr;
+        m_meshView.indexCount = 0;
+        m_meshView.lods = nullptr;
+        m_meshView.lodCount = 0;
+    }
+
+    const MeshView& Mesh::GetMeshView()
+    {
+        return m_meshView;
+    }
+
+    std::string Mesh::GetPath()
+    {
+        return m_path;
+    }
+
+    VkBuffer& Mesh::GetVertexBuffer()
+    {
+        return m_geometry->vertexBuffer;
+    }
+
+    VkBuffer& Mesh::GetIndexBuffer()
+    {
+        return m_geometry->indexBuffer;
+    }
+
+    uint32_t Mesh::GetIndexCount()
+    {
+        return m_indexCount;
+    }
+
+    const GeometryRange& Mesh::GetGeometry()
+    {
+        return *m_geometry;
+    }
+
+    const MeshBounds& Mesh::GetBounds()
+    {
+        return m_bounds;
+    }
+
+    const VertexCacheStats& Mesh::GetVertexCacheStats()
+    {
+        return m_vertexCache;
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "Structs.h"
+#include "PhysicalDevice.h"
+#include "LogicalDevice.h"
+#include "UploadQueue.h"
+#include "MeshCache.h"
+#include "JobSystem.h"
+#include "GeometryArena.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+
+#define GLFW_INCLUDE_VULKAN
+#include <glfw3.h>
+
+#include <string>
+#include <vector>
+#include <memory>
+
+
+namespace VCore
+{
+	// Geometry for one mesh asset - loaded from its .vmesh cache or OBJ and uploaded into the GeometryArena's shared vertex and index buffers.
+	// Shared between every object that uses the same asset, get them from the MeshRegistry rather than creating them directly.
+	class Mesh
+	{
+	public:
+		Mesh(std::string path);
+		Mesh();
+		~Mesh();
+		// Gives the mesh's range back to the arena
+		void Cleanup();
+
+		// Uses the mesh's .vmesh cache if it's up to date, otherwise parses, optimizes and simplifies the OBJ and rewrites the cache
+		void Load(JobSystem& jobSystem);
+		// Offline conversion - parses, optimizes and simplifies path and writes its .vmesh cache next to it
+		static void BuildMeshCache(const std::string& path, JobSystem& jobSystem);
+		// Hash of the loaded vertices and indices, identical geometry under different paths hashes the same
+		uint64_t GetContentHash();
+		// Box around every vertex and the sphere around that box's center, what culling tests objects against
+		static MeshBounds ComputeBounds(const Vertex* vertices, uint32_t vertexCount);
+		// Uploads the loaded geometry into a range of geometryArena
+		void CreateBuffers(UploadQueue& uploadQueue, GeometryArena& geometryArena, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
+		// Drops the loaded geometry once it has been uploaded
+		void ReleaseMeshData();
+		// The loaded geometry, empty after ReleaseMeshData
+		const MeshView& GetMeshView();
+
+		std::string GetPath();
+		// The arena page's buffers, shared with every other mesh in the page
+		VkBuffer& GetVertexBuffer();
+		VkBuffer& GetIndexBuffer();
+		uint32_t GetIndexCount();
+		// Where the mesh sits in its page's buffers, draw with its firstIndex and firstVertex (as vertexOffset). Moves when the arena is compacted
+		const GeometryRange& GetGeometry();
+		const MeshBounds& GetBounds();
+		// How the loaded index order uses the vertex cache, see MeshOptimizer
+		const VertexCacheStats& GetVertexCacheStats();
+
+	private:
+		// The OBJ's deduplicated geometry, reordered by the MeshOptimizer and with the MeshSimplifier's LODs after the full detail indices, the way the cache stores it
+		static void ImportObj(const std::string& path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<MeshLod>& lods, MeshBounds& bounds, JobSystem& jobSystem);
+
+		std::string m_path;
+		std::vector<Vertex> m_vertices;
+		std::vector<uint32_t> m_indices;
+		std::vector<MeshLod> m_lods;
+		std::shared_ptr<MappedFile> m_meshFile; // set when the mesh came from a .vmesh cache, m_meshView then points into it instead of the vectors above
+		MeshView m_meshView;
+		uint32_t m_indexCount; // kept after the mesh data is released
+		MeshBounds m_bounds; // so are the bounds
+		VertexCacheStats m_vertexCache; // and these
+		GeometryArena* m_geometryArena;
+		GeometryRange* m_geometry; // owned by m_geometryArena, nullptr until CreateBuffers
+	};
+}
@@ -0,0 +1,334 @@
+#include "MeshCache.h"
+#include "Helper.h"
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+#include <cstddef>
+
+
+namespace VCore
+{
+    static_assert(sizeof(MeshCacheHeader) % 8 == 0, "the payload after the header has to stay aligned for Vertex and uint32_t reads");
+
+    MappedFile::MappedFile()
+    {
+        m_data = nullptr;
+        m_size = 0;
+        m_fileHandle = nullptr;
+        m_mappingHandle = nullptr;
+        m_fileDescriptor = -1;
+    }
+
+    MappedFile::~MappedFile()
+    {
+        Close();
+    }
+
+    bool MappedFile::Open(const std::string& path)
+    {
+        Close();
+
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+        m_fileHandle = file;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+        {
+            Close();
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr)
+        {
+            Close();
+            return false;
+        }
+        m_mappingHandle = mapping;
+
+        m_data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        m_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+        m_fileDescriptor = open(path.c_str(), O_RDONLY);
+        if (m_fileDescriptor < 0)
+        {
+            return false;
+        }
+
+        struct stat fileStat;
+        if (fstat(m_fileDescriptor, &fileStat) != 0 || fileStat.st_size == 0)
+        {
+            Close();
+            return false;
+        }
+
+        void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, m_fileDescriptor, 0);
+        m_data = data != MAP_FAILED ? static_cast<const uint8_t*>(data) : nullptr;
+        m_size = static_cast<size_t>(fileStat.st_size);
+#endif
+
+        if (m_data == nullptr)
+        {
+            Close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+#ifdef _WIN32
+        if (m_data != nullptr)
+        {
+            UnmapViewOfFile(m_data);
+        }
+        if (m_mappingHandle != nullptr)
+        {
+            CloseHandle(m_mappingHandle);
+        }
+        if (m_fileHandle != nullptr)
+        {
+            CloseHandle(m_fileHandle);
+        }
+#else
+        if (m_data != nullptr)
+        {
+            munmap(const_cast<uint8_t*>(m_data), m_size);
+        }
+        if (m_fileDescriptor >= 0)
+        {
+            close(m_fileDescriptor);
+        }
+#endif
+
+        m_data = nullptr;
+        m_size = 0;
+        m_fileHandle = nullptr;
+        m_mappingHandle = nullptr;
+        m_fileDescriptor = -1;
+    }
+
+    const uint8_t* MappedFile::GetData()
+    {
+        return m_data;
+    }
+
+    size_t MappedFile::GetSize()
+    {
+        return m_size;
+    }
+
+
+    std::string MeshCache::GetCachePath(const std::string& sourcePath)
+    {
+        // ../Models/viking_room.obj -> ../Models/viking_room.vmesh
+        return std::filesystem::path(sourcePath).replace_extension(".vmesh").string();
+    }
+
+    bool MeshCache::HashFile(const std::string& path, uint64_t& hash)
+    {
+        MappedFile file;
+        if (!file.Open(path))
+        {
+            return false;
+        }
+
+        hash = Helper::Hash64(file.GetData(), file.GetSize());
+        return true;
+    }
+
+    bool MeshCache::GetSourceInfo(const std::string& path, uint64_t& size, int64_t& writeTime)
+    {
+        std::error_code error;
+        size = static_cast<uint64_t>(std::filesystem::file_size(path, error));
+        if (error)
+        {
+            return false;
+        }
+
+        writeTime = static_cast<int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+        return !error;
+    }
+
+    bool MeshCache::WriteSourceWriteTime(const std::string& cachePath, int64_t writeTime)
+    {
+        // Only the header's field is rewritten, the payload checksum doesn't cover the header
+        std::fstream file(cachePath, std::ios::binary | std::ios::in | std::ios::out);
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        file.seekp(offsetof(MeshCacheHeader, sourceWriteTime));
+        file.write(reinterpret_cast<const char*>(&writeTime), sizeof(writeTime));
+        return file.good();
+    }
+
+    bool MeshCache::Load(const std::string& cachePath, const std::string& sourcePath, MappedFile& file, MeshView& view)
+    {
+        if (!file.Open(cachePath) || file.GetSize() < sizeof(MeshCacheHeader))
+        {
+            file.Close();
+            return false;
+        }
+
+        MeshCacheHeader header;
+        memcpy(&header, file.GetData(), sizeof(header));
+
+        size_t vertexBytes = static_cast<size_t>(header.vertexCount) * sizeof(Vertex);
+        size_t indexBytes = static_cast<size_t>(header.indexCount) * sizeof(uint32_t);
+        size_t lodBytes = static_cast<size_t>(header.lodCount) * sizeof(MeshLod);
+
+        if (memcmp(header.magic, "VMSH", 4) != 0 || header.version != MESH_CACHE_VERSION || header.vertexStride != sizeof(Vertex) ||
+            header.lodCount == 0 || header.lodCount > MESH_MAX_LODS || file.GetSize() != sizeof(MeshCacheHeader) + vertexBytes + indexBytes + lodBytes)
+        {
+            file.Close();
+            return false;
+        }
+
+        // Stale check - size + write time is the cheap path, only hash the source if they disagree
+        uint64_t sourceSize = 0;
+        int64_t sourceWriteTime = 0;
+        if (GetSourceInfo(sourcePath, sourceSize, sourceWriteTime))
+        {
+            if (sourceSize != header.sourceSize)
+            {
+                file.Close();
+                return false;
+            }
+
+            if (sourceWriteTime != header.sourceWriteTime)
+            {
+                uint64_t sourceHash = 0;
+                if (!HashFile(sourcePath, sourceHash) || sourceHash != header.sourceHash)
+                {
+                    file.Close();
+                    return false;
+                }
+
+                // Same content, the source was only touched (ie. a fresh checkout). Record its new write time so the next load takes the cheap path again.
+                // The mapping keeps the cache open read only, so it's closed for the write and mapped again after - if the write fails the cache is still good, just slow to check
+                file.Close();
+                WriteSourceWriteTime(cachePath, sourceWriteTime);
+                if (!file.Open(cachePath) || file.GetSize() != sizeof(MeshCacheHeader) + vertexBytes + indexBytes + lodBytes)
+                {
+                    file.Close();
+                    return false;
+                }
+            }
+        }
+        // No source file at all means the cache was shipped on its own, trust it
+
+        const uint8_t* payload = file.GetData() + sizeof(MeshCacheHeader);
+        if (Helper::Hash64(payload, vertexBytes + indexBytes + lodBytes) != header.payloadChecksum)
+        {
+            file.Close();
+            return false;
+        }
+
+        // Every LOD has to lie inside the indices, one after the other
+        const MeshLod* lods = reinterpret_cast<const MeshLod*>(payload + vertexBytes + indexBytes);
+        uint32_t ui_nextIndex = 0;
+        for (uint32_t i = 0; i < header.lodCount; i++)
+        {
+            if (lods[i].firstIndex != ui_nextIndex || lods[i].indexCount > header.indexCount - ui_nextIndex)
+            {
+                file.Close();
+                return false;
+            }
+            ui_nextIndex += lods[i].indexCount;
+        }
+
+        // The mapping is page aligned and the header is a multiple of 8 bytes, so all three arrays are suitably aligned to read in place
+        view.vertices = reinterpret_cast<const Vertex*>(payload);
+        view.vertexCount = header.vertexCount;
+        view.indices = reinterpret_cast<const uint32_t*>(payload + vertexBytes);
+        view.indexCount = lods[0].indexCount;
+        view.lods = lods;
+        view.lodCount = header.lodCount;
+        view.bounds = header.bounds;
+
+        return true;
+    }
+
+    bool MeshCache::Write(const std::string& cachePath, const std::string& sourcePath, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const std::vector<MeshLod>& lods, const MeshBounds& bounds)
+    {
+        MeshCacheHeader header{};
+        memcpy(header.magic, "VMSH", 4);
+        header.version = MESH_CACHE_VERSION;
+        header.vertexStride = sizeof(Vertex);
+        header.vertexCount = static_cast<uint32_t>(vertices.size());
+        header.indexCount = static_cast<uint32_t>(indices.size());
+        header.lodCount = static_cast<uint32_t>(lods.size());
+        header.bounds = bounds;
+
+        if (!GetSourceInfo(sourcePath, header.sourceSize, header.sourceWriteTime) || !HashFile(sourcePath, header.sourceHash))
+        {
+            return false;
+        }
+
+        // Checksum covers the vertex, index and LOD bytes back to back, exactly as they'll sit in the file
+        size_t vertexBytes = vertices.size() * sizeof(Vertex);
+        size_t indexBytes = indices.size() * sizeof(uint32_t);
+        size_t lodBytes = lods.size() * sizeof(MeshLod);
+        std::vector<uint8_t> payload(vertexBytes + indexBytes + lodBytes);
+        if (vertexBytes > 0)
+        {
+            memcpy(payload.data(), vertices.data(), vertexBytes);
+        }
+        if (indexBytes > 0)
+        {
+            memcpy(payload.data() + vertexBytes, indices.data(), indexBytes);
+        }
+        if (lodBytes > 0)
+        {
+            memcpy(payload.data() + vertexBytes + indexBytes, lods.data(), lodBytes);
+        }
+        header.payloadChecksum = Helper::Hash64(payload.data(), payload.size());
+
+        // Write to a temporary file and rename over the old cache so a crash mid write never leaves a half written cache behind
+        std::string tempPath = cachePath + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+            {
+                return false;
+            }
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+            if (!file.good())
+            {
+                return false;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, cachePath, error);
+        if (error)
+        {
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+
+        return true;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+#pragma once
+#include "Structs.h"
+
+#include <vector>
+#include <string>
+
+
+namespace VCore
+{
+	const uint32_t MESH_CACHE_VERSION = 5; // bump whenever the layout of the file, the layout of Vertex, the checksum hash or the MeshOptimizer's or MeshSimplifier's output changes
+	const uint32_t MESH_MAX_LODS = 4; // levels of detail per mesh, the full detail one included
+
+	// Read only memory mapping of a whole file. The OS pages it in on demand, so nothing is copied until the data is actually read.
+	class MappedFile
+	{
+	public:
+		MappedFile();
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool Open(const std::string& path);
+		void Close();
+		const uint8_t* GetData();
+		size_t GetSize();
+
+	private:
+		const uint8_t* m_data;
+		size_t m_size;
+		void* m_fileHandle; // HANDLE on Windows
+		void* m_mappingHandle;
+		int m_fileDescriptor; // everywhere else
+	};
+
+	// One level of detail: a triangle list over the mesh's shared vertices (see MeshSimplifier)
+	struct MeshLod
+	{
+		uint32_t firstIndex; // into the mesh's indices (the page's index buffer once it's in a GeometryRange)
+		uint32_t indexCount;
+		float error; // how far, in object space, the surface may be from the full detail one
+		uint32_t reserved;
+	};
+
+	// Everything is little endian and laid out exactly as in memory: header, vertexCount Vertex structs, indexCount uint32_t indices (every LOD's, back to back), lodCount MeshLods
+	struct MeshCacheHeader
+	{
+		char magic[4]; // "VMSH"
+		uint32_t version;
+		uint32_t vertexStride; // sizeof(Vertex) when written
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t lodCount;
+		uint64_t sourceSize; // the source file the cache was built from, to know when it goes stale
+		int64_t sourceWriteTime;
+		uint64_t sourceHash;
+		uint64_t payloadChecksum; // hash of the vertex, index and LOD bytes, catches truncated or corrupted files
+		MeshBounds bounds; // computed when the cache is written so loading never has to walk the vertices
+	};
+
+	// Points into a MappedFile, only valid while it stays open
+	struct MeshView
+	{
+		const Vertex* vertices = nullptr;
+		uint32_t vertexCount = 0;
+		const uint32_t* indices = nullptr;
+		uint32_t indexCount = 0; // the full detail triangles, the coarser LODs' indices follow them
+		const MeshLod* lods = nullptr; // lods[0] is the full detail one. None means the full detail one is all there is
+		uint32_t lodCount = 0;
+		MeshBounds bounds;
+
+		// Every LOD's indices
+		uint32_t GetTotalIndexCount() const
+		{
+			return lodCount > 0 ? lods[lodCount - 1].firstIndex + lods[lodCount - 1].indexCount : indexCount;
+		}
+	};
+
+	// Binary .vmesh files that sit next to their source model and hold the already deduplicated vertices and indices, so loading is a file mapping instead of an OBJ parse.
+	// A cache is used only if its version and vertex layout match and it was built from the current source file: same size and write time, or failing that (ie. a fresh checkout touched the file) the same content hash.
+	// A content hash match writes the new write time into the cache's header, so only the first load after a touch hashes the source.
+	class MeshCache
+	{
+	public:
+		static std::string GetCachePath(const std::string& sourcePath);
+		// Maps cachePath and fills view if the cache is valid for sourcePath, returns false if it's missing, stale or corrupt
+		static bool Load(const std::string& cachePath, const std::string& sourcePath, MappedFile& file, MeshView& view);
+		static bool Write(const std::string& cachePath, const std::string& sourcePath, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const std::vector<MeshLod>& lods, const MeshBounds& bounds);
+
+	private:
+		static bool HashFile(const std::string& path, uint64_t& hash);
+		static bool GetSourceInfo(const std::string& path, uint64_t& size, int64_t& writeTime);
+		// Updates the source write time in an existing cache's header, once its source turned out to have the same content under a new write time
+		static bool WriteSourceWriteTime(const std::string& cachePath, int64_t writeTime);
+	};
+}
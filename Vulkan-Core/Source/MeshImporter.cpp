@@ -0,0 +1,281 @@
+#define TINYOBJLOADER_IMPLEMENTATION // Loading obj files
+#include "MeshImporter.h"
+#include "VertexHashTable.h"
+#include "VulkanManager.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <unordered_map>
+#include <chrono>
+#include <iostream>
+#include <cmath>
+
+
+namespace VCore
+{
+    void MeshImporter::LoadObj(const std::string& path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, JobSystem& jobSystem)
+    {
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        ParseObj(path, attrib, shapes);
+        BuildVertices(attrib, shapes, vertices, indices, jobSystem);
+    }
+
+    void MeshImporter::ParseObj(const std::string& path, tinyobj::attrib_t& attrib, std::vector<tinyobj::shape_t>& shapes)
+    {
+        // Refer to - https://vulkan-tutorial.com/en/Loading_models
+        std::vector<tinyobj::material_t> materials;
+        std::string warn, err;
+
+        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str()))
+        {
+            throw std::runtime_error(warn + err);
+        }
+    }
+
+    Vertex MeshImporter::MakeVertex(const tinyobj::attrib_t& attrib, const tinyobj::index_t& index)
+    {
+        Vertex vertex{};
+
+        vertex.pos =
+        {
+            attrib.vertices[3 * index.vertex_index + 0],
+            attrib.vertices[3 * index.vertex_index + 1],
+            attrib.vertices[3 * index.vertex_index + 2]
+        };
+
+        vertex.texCoord =
+        {
+            attrib.texcoords[2 * index.texcoord_index + 0],
+            1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
+        };
+
+        vertex.color = { 1.0f, 1.0f, 1.0f };
+
+        vertex.normal =
+        {
+            attrib.normals[3 * index.normal_index + 0],
+            attrib.normals[3 * index.normal_index + 1],
+            attrib.normals[3 * index.normal_index + 2]
+        };
+
+        // Adding +0.0 turns -0.0 into +0.0 and leaves everything else alone, so vertices that compare equal as floats also have equal bytes for VertexHashTable
+        vertex.pos += glm::vec3(0.0f);
+        vertex.normal += glm::vec3(0.0f);
+        vertex.texCoord += glm::vec2(0.0f);
+
+        return vertex;
+    }
+
+    void MeshImporter::BuildVerticesReference(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        // Refer to - https://vulkan-tutorial.com/Loading_models#page_Vertex-deduplication
+        std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+
+        for (const auto& shape : shapes)
+        {
+            for (const auto& index : shape.mesh.indices)
+            {
+                Vertex vertex = MakeVertex(attrib, index);
+
+                // Keep only unique vertices
+                if (uniqueVertices.count(vertex) == 0)
+                {
+                    uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
+                    vertices.push_back(vertex);
+                }
+
+                indices.push_back(uniqueVertices[vertex]);
+            }
+        }
+    }
+
+    void MeshImporter::BuildVertices(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, JobSystem& jobSystem)
+    {
+        // Where each shape's corners start in the flattened list of all corners, so a job can find the shape its range begins in
+        std::vector<size_t> shapeStarts(shapes.size() + 1, 0);
+        for (size_t i = 0; i < shapes.size(); i++)
+        {
+            shapeStarts[i + 1] = shapeStarts[i] + shapes[i].mesh.indices.size();
+        }
+
+        size_t cornerCount = shapeStarts.back();
+        if (cornerCount >= UINT32_MAX)
+        {
+            throw std::runtime_error("failed to import mesh, too many face corners for 32 bit indices");
+        }
+
+        // Each chunk dedups its own corners, the chunks are merged afterwards
+        struct Chunk
+        {
+            std::vector<Vertex> vertices;
+            std::vector<uint64_t> hashes; // hash of each of the chunk's unique vertices, so merging doesn't hash them again
+            std::vector<uint32_t> localIndices; // per corner, into this chunk's vertices
+            std::vector<uint32_t> remap; // chunk vertex -> final vertex
+        };
+        const uint32_t ui_chunkSize = VM_IMPORT_CORNERS_PER_JOB;
+        std::vector<Chunk> chunks((cornerCount + ui_chunkSize - 1) / ui_chunkSize);
+
+        jobSystem.ParallelFor(static_cast<uint32_t>(cornerCount), ui_chunkSize, [&](uint32_t begin, uint32_t end, uint32_t threadIndex)
+        {
+            Chunk& chunk = chunks[begin / ui_chunkSize];
+            chunk.localIndices.resize(end - begin);
+
+            VertexHashTable table;
+            table.Reserve(end - begin);
+
+            size_t shape = std::upper_bound(shapeStarts.begin(), shapeStarts.end(), static_cast<size_t>(begin)) - shapeStarts.begin() - 1;
+            for (uint32_t corner = begin; corner < end; corner++)
+            {
+                while (corner >= shapeStarts[shape + 1])
+                {
+                    shape++;
+                }
+
+                Vertex vertex = MakeVertex(attrib, shapes[shape].mesh.indices[corner - shapeStarts[shape]]);
+                uint64_t hash = VertexHashTable::Hash(vertex);
+                bool b_inserted = false;
+                chunk.localIndices[corner - begin] = table.FindOrInsert(vertex, hash, chunk.vertices, b_inserted);
+                if (b_inserted)
+                {
+                    chunk.hashes.push_back(hash);
+                }
+            }
+        });
+
+        // Merge in chunk order - each chunk's vertices are in first use order, so the result matches a single pass over every corner
+        size_t chunkVertexCount = 0;
+        for (const Chunk& chunk : chunks)
+        {
+            chunkVertexCount += chunk.vertices.size();
+        }
+
+        VertexHashTable table;
+        table.Reserve(chunkVertexCount);
+        vertices.clear();
+        vertices.reserve(chunkVertexCount);
+
+        for (Chunk& chunk : chunks)
+        {
+            chunk.remap.resize(chunk.vertices.size());
+            for (size_t i = 0; i < chunk.vertices.size(); i++)
+            {
+                bool b_inserted = false;
+                chunk.remap[i] = table.FindOrInsert(chunk.vertices[i], chunk.hashes[i], vertices, b_inserted);
+            }
+
+            chunk.vertices = std::vector<Vertex>();
+            chunk.hashes = std::vector<uint64_t>();
+        }
+
+        indices.resize(cornerCount);
+        jobSystem.ParallelFor(static_cast<uint32_t>(cornerCount), ui_chunkSize, [&](uint32_t begin, uint32_t end, uint32_t threadIndex)
+        {
+            const Chunk& chunk = chunks[begin / ui_chunkSize];
+            for (uint32_t corner = begin; corner < end; corner++)
+            {
+                indices[corner] = chunk.remap[chunk.localIndices[corner - begin]];
+            }
+        });
+    }
+
+    void MeshImporter::MakeSyntheticMesh(uint32_t triangleCount, tinyobj::attrib_t& attrib, std::vector<tinyobj::shape_t>& shapes)
+    {
+        // gridSize * gridSize quads, two triangles each, every interior grid point shared by six triangles like a typical closed mesh
+        uint32_t ui_gridSize = std::max(1u, static_cast<uint32_t>(std::sqrt(triangleCount / 2.0)));
+        uint32_t ui_pointsPerRow = ui_gridSize + 1;
+        const uint32_t ui_trianglesPerShape = 1000000;
+        uint32_t ui_rowsPerShape = std::max(1u, ui_trianglesPerShape / (2 * ui_gridSize));
+
+        attrib = tinyobj::attrib_t();
+        shapes.clear();
+        attrib.vertices.reserve(static_cast<size_t>(ui_pointsPerRow) * ui_pointsPerRow * 3);
+        attrib.texcoords.reserve(static_cast<size_t>(ui_pointsPerRow) * ui_pointsPerRow * 2);
+
+        for (uint32_t y = 0; y < ui_pointsPerRow; y++)
+        {
+            for (uint32_t x = 0; x < ui_pointsPerRow; x++)
+            {
+                float u = static_cast<float>(x) / ui_gridSize;
+                float v = static_cast<float>(y) / ui_gridSize;
+                attrib.vertices.insert(attrib.vertices.end(), { u * 2.0f - 1.0f, v * 2.0f - 1.0f, 0.1f * std::sin(u * 20.0f) * std::cos(v * 20.0f) });
+                attrib.texcoords.insert(attrib.texcoords.end(), { u, v });
+            }
+        }
+        attrib.normals = { 0.0f, 0.0f, 1.0f };
+
+        for (uint32_t row = 0; row < ui_gridSize; row++)
+        {
+            if (row % ui_rowsPerShape == 0)
+            {
+                shapes.emplace_back();
+                shapes.back().name = "synthetic" + std::to_string(shapes.size());
+            }
+
+            std::vector<tinyobj::index_t>& shapeIndices = shapes.back().mesh.indices;
+            for (uint32_t column = 0; column < ui_gridSize; column++)
+            {
+                int i0 = static_cast<int>(row * ui_pointsPerRow + column);
+                int i1 = i0 + 1;
+                int i2 = i0 + static_cast<int>(ui_pointsPerRow);
+                int i3 = i2 + 1;
+
+                for (int point : { i0, i1, i2, i2, i1, i3 })
+                {
+                    tinyobj::index_t index;
+                    index.vertex_index = point;
+                    index.normal_index = 0;
+                    index.texcoord_index = point;
+                    shapeIndices.push_back(index);
+                }
+            }
+        }
+    }
+
+    void MeshImporter::BenchmarkMesh(const std::string& name, const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes, JobSystem& jobSystem)
+    {
+        std::vector<Vertex> referenceVertices;
+        std::vector<uint32_t> referenceIndices;
+        auto referenceStart = std::chrono::high_resolution_clock::now();
+        BuildVerticesReference(attrib, shapes, referenceVertices, referenceIndices);
+        auto referenceEnd = std::chrono::high_resolution_clock::now();
+
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        auto parallelStart = std::chrono::high_resolution_clock::now();
+        BuildVertices(attrib, shapes, vertices, indices, jobSystem);
+        auto parallelEnd = std::chrono::high_resolution_clock::now();
+
+        float f_referenceMs = std::chrono::duration<float, std::chrono::milliseconds::period>(referenceEnd - referenceStart).count();
+        float f_parallelMs = std::chrono::duration<float, std::chrono::milliseconds::period>(parallelEnd - parallelStart).count();
+
+        std::cout << name << ": " << indices.size() / 3 << " triangles, " << vertices.size() << " unique vertices" << std::endl;
+        std::cout << "    unordered_map, 1 thread: " << f_referenceMs << " ms" << std::endl;
+        std::cout << "    hash table, " << jobSystem.GetThreadCount() << " threads: " << f_parallelMs << " ms (" << f_referenceMs / std::max(f_parallelMs, 0.001f) << "x)" << std::endl;
+        std::cout << "    results " << (referenceVertices == vertices && referenceIndices == indices ? "match" : "DIFFER") << std::endl;
+    }
+
+    void MeshImporter::RunBenchmark(const std::vector<std::string>& paths, uint32_t syntheticTriangles, JobSystem& jobSystem)
+    {
+        for (const std::string& path : paths)
+        {
+            tinyobj::attrib_t attrib;
+            std::vector<tinyobj::shape_t> shapes;
+
+            auto parseStart = std::chrono::high_resolution_clock::now();
+            ParseObj(path, attrib, shapes);
+            auto parseEnd = std::chrono::high_resolution_clock::now();
+            std::cout << path << ": tinyobj parse " << std::chrono::duration<float, std::chrono::milliseconds::period>(parseEnd - parseStart).count() << " ms" << std::endl;
+
+            BenchmarkMesh(path, attrib, shapes, jobSystem);
+        }
+
+        if (syntheticTriangles > 0)
+        {
+            tinyobj::attrib_t attrib;
+            std::vector<tinyobj::shape_t> shapes;
+            MakeSyntheticMesh(syntheticTriangles, attrib, shapes);
+            BenchmarkMesh("synthetic grid", attrib, shapes, jobSystem);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+#include "Structs.h"
+#include "JobSystem.h"
+
+#include "tiny_obj_loader.h"
+
+#include <vector>
+#include <string>
+
+
+namespace VCore
+{
+	// OBJ import: tinyobj parses the text, then every face corner is expanded into a Vertex and deduplicated into a vertex + index list.
+	class MeshImporter
+	{
+	public:
+		// Parses path and builds deduplicated vertices/indices on the job system's threads
+		static void LoadObj(const std::string& path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, JobSystem& jobSystem);
+		static void ParseObj(const std::string& path, tinyobj::attrib_t& attrib, std::vector<tinyobj::shape_t>& shapes);
+
+		// The original single threaded path (std::unordered_map<Vertex, uint32_t>), kept as the reference the benchmark compares against
+		static void BuildVerticesReference(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+		// Splits the corners into chunks that are deduplicated in parallel with a VertexHashTable each, then merges the chunks in order.
+		// Produces the same vertex order and indices as BuildVerticesReference.
+		static void BuildVertices(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, JobSystem& jobSystem);
+
+		// Grid of roughly triangleCount triangles split over several shapes, shaped like tinyobj output, for benchmarking without a huge OBJ on disk
+		static void MakeSyntheticMesh(uint32_t triangleCount, tinyobj::attrib_t& attrib, std::vector<tinyobj::shape_t>& shapes);
+		// Times BuildVerticesReference against BuildVertices on each OBJ and on a synthetic mesh of syntheticTriangles triangles (0 to skip), and checks the results match
+		static void RunBenchmark(const std::vector<std::string>& paths, uint32_t syntheticTriangles, JobSystem& jobSystem);
+
+	private:
+		static Vertex MakeVertex(const tinyobj::attrib_t& attrib, const tinyobj::index_t& index);
+		static void BenchmarkMesh(const std::string& name, const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes, JobSystem& jobSystem);
+	};
+}
@@ -0,0 +1,399 @@
+#include "MeshOptimizer.h"
+#include "MeshImporter.h"
+
+#include <algorithm>
+#include <numeric>
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <cmath>
+
+
+namespace VCore
+{
+    // How much worse than its hard cluster's a soft cluster's ACMR may be. 1.05 is the paper's pick, overdraw ordering costs at most ~5% of the cache gains
+    static const float OVERDRAW_THRESHOLD = 1.05f;
+
+    MeshOptimizerStats MeshOptimizer::Optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        MeshOptimizerStats stats;
+        uint32_t ui_vertexCount = static_cast<uint32_t>(vertices.size());
+        stats.before = AnalyzeVertexCache(indices.data(), static_cast<uint32_t>(indices.size()), ui_vertexCount);
+        if (indices.size() % 3 != 0)
+        {
+            stats.after = stats.before;
+            return stats;
+        }
+
+        auto cacheStart = std::chrono::high_resolution_clock::now();
+        OptimizeVertexCache(indices, ui_vertexCount);
+        auto overdrawStart = std::chrono::high_resolution_clock::now();
+        stats.clusters = OptimizeOverdraw(indices, vertices, OVERDRAW_THRESHOLD);
+        auto fetchStart = std::chrono::high_resolution_clock::now();
+        stats.unusedVertices = OptimizeVertexFetch(vertices, indices);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        stats.after = AnalyzeVertexCache(indices.data(), static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(vertices.size()));
+        stats.vertexCacheMs = std::chrono::duration<float, std::chrono::milliseconds::period>(overdrawStart - cacheStart).count();
+        stats.overdrawMs = std::chrono::duration<float, std::chrono::milliseconds::period>(fetchStart - overdrawStart).count();
+        stats.vertexFetchMs = std::chrono::duration<float, std::chrono::milliseconds::period>(end - fetchStart).count();
+        return stats;
+    }
+
+    void MeshOptimizer::BuildAdjacency(const std::vector<uint32_t>& indices, uint32_t vertexCount, Adjacency& adjacency)
+    {
+        // Counting sort of the triangle corners by vertex
+        adjacency.offsets.assign(static_cast<size_t>(vertexCount) + 1, 0);
+        for (uint32_t index : indices)
+        {
+            adjacency.offsets[index + 1]++;
+        }
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            adjacency.offsets[v + 1] += adjacency.offsets[v];
+        }
+
+        adjacency.triangles.resize(indices.size());
+        std::vector<uint32_t> next(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            adjacency.triangles[next[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+
+    void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount)
+    {
+        uint32_t ui_triangleCount = static_cast<uint32_t>(indices.size() / 3);
+        if (ui_triangleCount == 0 || vertexCount == 0)
+        {
+            return;
+        }
+
+        Adjacency adjacency;
+        BuildAdjacency(indices, vertexCount, adjacency);
+
+        std::vector<uint32_t> liveTriangles(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+        }
+
+        // A vertex is in the cache while time - cacheTimes[v] <= CACHE_SIZE. Time starts past CACHE_SIZE so nothing is in the cache to begin with
+        std::vector<uint32_t> cacheTimes(vertexCount, 0);
+        uint32_t ui_time = CACHE_SIZE + 1;
+        std::vector<bool> emitted(ui_triangleCount, false);
+        std::vector<uint32_t> deadEnds;
+        std::vector<uint32_t> candidates;
+        std::vector<uint32_t> optimized;
+        optimized.reserve(indices.size());
+        uint32_t ui_cursor = 0;
+
+        int64_t fanning = 0;
+        while (fanning >= 0)
+        {
+            // Emit every triangle still around the fanning vertex. Their vertices are the next fanning vertex's candidates
+            candidates.clear();
+            uint32_t ui_fanning = static_cast<uint32_t>(fanning);
+            for (uint32_t a = adjacency.offsets[ui_fanning]; a < adjacency.offsets[ui_fanning + 1]; a++)
+            {
+                uint32_t ui_triangle = adjacency.triangles[a];
+                if (emitted[ui_triangle])
+                {
+                    continue;
+                }
+
+                for (uint32_t corner = 0; corner < 3; corner++)
+                {
+                    uint32_t v = indices[ui_triangle * 3 + corner];
+                    optimized.push_back(v);
+                    deadEnds.push_back(v);
+                    candidates.push_back(v);
+                    liveTriangles[v]--;
+                    if (ui_time - cacheTimes[v] > CACHE_SIZE)
+                    {
+                        cacheTimes[v] = ui_time;
+                        ui_time++;
+                    }
+                }
+                emitted[ui_triangle] = true;
+            }
+
+            fanning = GetNextVertex(candidates, cacheTimes, ui_time, liveTriangles, deadEnds, ui_cursor, vertexCount);
+        }
+
+        indices.swap(optimized);
+    }
+
+    int64_t MeshOptimizer::GetNextVertex(const std::vector<uint32_t>& candidates, const std::vector<uint32_t>& cacheTimes, uint32_t time, const std::vector<uint32_t>& liveTriangles,
+        std::vector<uint32_t>& deadEnds, uint32_t& cursor, uint32_t vertexCount)
+    {
+        // Fanning around v adds at most two new vertices per triangle. If v is still cached after that, prefer the one that has been in the cache longest
+        int64_t best = -1;
+        int64_t bestPriority = -1;
+        for (uint32_t v : candidates)
+        {
+            if (liveTriangles[v] == 0)
+            {
+                continue;
+            }
+            int64_t priority = 0;
+            if (time - cacheTimes[v] + 2 * liveTriangles[v] <= CACHE_SIZE)
+            {
+                priority = time - cacheTimes[v];
+            }
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                best = v;
+            }
+        }
+        if (best >= 0)
+        {
+            return best;
+        }
+
+        // Dead end. Go back through the recently emitted vertices, and failing that to the next vertex in input order with triangles left
+        while (!deadEnds.empty())
+        {
+            uint32_t v = deadEnds.back();
+            deadEnds.pop_back();
+            if (liveTriangles[v] > 0)
+            {
+                return v;
+            }
+        }
+        while (cursor < vertexCount)
+        {
+            if (liveTriangles[cursor] > 0)
+            {
+                return cursor;
+            }
+            cursor++;
+        }
+        return -1;
+    }
+
+    uint32_t MeshOptimizer::OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold)
+    {
+        uint32_t ui_triangleCount = static_cast<uint32_t>(indices.size() / 3);
+        if (ui_triangleCount == 0)
+        {
+            return 0;
+        }
+        uint32_t ui_vertexCount = static_cast<uint32_t>(vertices.size());
+
+        // Hard boundaries: a triangle that misses on all three vertices starts over with a cold cache, splitting there costs nothing
+        std::vector<uint32_t> hardStarts;
+        std::vector<uint32_t> hardMisses;
+        std::vector<uint32_t> cacheTimes(ui_vertexCount, 0);
+        uint32_t ui_time = CACHE_SIZE + 1;
+        for (uint32_t t = 0; t < ui_triangleCount; t++)
+        {
+            uint32_t ui_misses = 0;
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                uint32_t v = indices[t * 3 + corner];
+                if (ui_time - cacheTimes[v] > CACHE_SIZE)
+                {
+                    cacheTimes[v] = ui_time;
+                    ui_time++;
+                    ui_misses++;
+                }
+            }
+            if (t == 0 || ui_misses == 3)
+            {
+                hardStarts.push_back(t);
+                hardMisses.push_back(0);
+            }
+            hardMisses.back() += ui_misses;
+        }
+        hardStarts.push_back(ui_triangleCount);
+
+        // Soft boundaries: within a hard cluster, close a cluster as soon as it reuses the cache (counted from a cold start) nearly as well as the hard cluster does
+        std::vector<uint32_t> clusterStarts;
+        for (size_t h = 0; h + 1 < hardStarts.size(); h++)
+        {
+            uint32_t ui_start = hardStarts[h];
+            uint32_t ui_end = hardStarts[h + 1];
+            float f_hardAcmr = static_cast<float>(hardMisses[h]) / (ui_end - ui_start);
+
+            // Moving time on by more than the cache size empties it without touching cacheTimes
+            ui_time += CACHE_SIZE + 1;
+            uint32_t ui_clusterStart = ui_start;
+            uint32_t ui_clusterMisses = 0;
+            clusterStarts.push_back(ui_start);
+            for (uint32_t t = ui_start; t < ui_end; t++)
+            {
+                for (uint32_t corner = 0; corner < 3; corner++)
+                {
+                    uint32_t v = indices[t * 3 + corner];
+                    if (ui_time - cacheTimes[v] > CACHE_SIZE)
+                    {
+                        cacheTimes[v] = ui_time;
+                        ui_time++;
+                        ui_clusterMisses++;
+                    }
+                }
+
+                float f_clusterAcmr = static_cast<float>(ui_clusterMisses) / (t + 1 - ui_clusterStart);
+                if (t + 1 < ui_end && f_clusterAcmr <= threshold * f_hardAcmr)
+                {
+                    // The next cluster starts cold, as it may be drawn after anything
+                    ui_clusterStart = t + 1;
+                    ui_clusterMisses = 0;
+                    ui_time += CACHE_SIZE + 1;
+                    clusterStarts.push_back(ui_clusterStart);
+                }
+            }
+        }
+        clusterStarts.push_back(ui_triangleCount);
+        uint32_t ui_clusterCount = static_cast<uint32_t>(clusterStarts.size() - 1);
+
+        // Area weighted centroid and normal of every cluster and the whole mesh
+        std::vector<glm::vec3> clusterCentroids(ui_clusterCount, glm::vec3(0.0f));
+        std::vector<glm::vec3> clusterNormals(ui_clusterCount, glm::vec3(0.0f));
+        glm::vec3 meshCentroid = glm::vec3(0.0f);
+        float f_meshArea = 0.0f;
+        for (uint32_t c = 0; c < ui_clusterCount; c++)
+        {
+            float f_clusterArea = 0.0f;
+            for (uint32_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++)
+            {
+                glm::vec3 p0 = vertices[indices[t * 3]].pos;
+                glm::vec3 p1 = vertices[indices[t * 3 + 1]].pos;
+                glm::vec3 p2 = vertices[indices[t * 3 + 2]].pos;
+                glm::vec3 normal = glm::cross(p1 - p0, p2 - p0); // length is twice the area
+                float f_area = glm::length(normal);
+                clusterCentroids[c] += (p0 + p1 + p2) * (f_area / 3.0f);
+                clusterNormals[c] += normal;
+                f_clusterArea += f_area;
+            }
+            meshCentroid += clusterCentroids[c];
+            f_meshArea += f_clusterArea;
+            clusterCentroids[c] = f_clusterArea > 0.0f ? clusterCentroids[c] / f_clusterArea : vertices[indices[clusterStarts[c] * 3]].pos;
+        }
+        meshCentroid = f_meshArea > 0.0f ? meshCentroid / f_meshArea : glm::vec3(0.0f);
+
+        // Outward facing clusters far from the center first. Stable, so clusters that tie keep their cache friendly order
+        std::vector<float> sortKeys(ui_clusterCount);
+        for (uint32_t c = 0; c < ui_clusterCount; c++)
+        {
+            float f_length = glm::length(clusterNormals[c]);
+            sortKeys[c] = f_length > 0.0f ? glm::dot(clusterCentroids[c] - meshCentroid, clusterNormals[c] / f_length) : 0.0f;
+        }
+        std::vector<uint32_t> order(ui_clusterCount);
+        std::iota(order.begin(), order.end(), 0u);
+        std::stable_sort(order.begin(), order.end(), [&sortKeys](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+        std::vector<uint32_t> sorted;
+        sorted.reserve(indices.size());
+        for (uint32_t c : order)
+        {
+            sorted.insert(sorted.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c + 1] * 3);
+        }
+        indices.swap(sorted);
+
+        return ui_clusterCount;
+    }
+
+    uint32_t MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+        std::vector<Vertex> reordered;
+        reordered.reserve(vertices.size());
+
+        for (uint32_t& index : indices)
+        {
+            if (remap[index] == UINT32_MAX)
+            {
+                remap[index] = static_cast<uint32_t>(reordered.size());
+                reordered.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+
+        uint32_t ui_unused = static_cast<uint32_t>(vertices.size() - reordered.size());
+        vertices.swap(reordered);
+        return ui_unused;
+    }
+
+    VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount)
+    {
+        VertexCacheStats stats;
+        std::vector<uint32_t> cacheTimes(vertexCount, 0);
+        uint32_t ui_time = CACHE_SIZE + 1;
+        for (uint32_t i = 0; i < indexCount; i++)
+        {
+            uint32_t v = indices[i];
+            if (ui_time - cacheTimes[v] > CACHE_SIZE)
+            {
+                cacheTimes[v] = ui_time;
+                ui_time++;
+                stats.misses++;
+            }
+        }
+
+        stats.acmr = indexCount >= 3 ? static_cast<float>(stats.misses) / (indexCount / 3) : 0.0f;
+        stats.atvr = vertexCount > 0 ? static_cast<float>(stats.misses) / vertexCount : 0.0f;
+        return stats;
+    }
+
+    void MeshOptimizer::BenchmarkMesh(const std::string& name, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        MeshOptimizerStats stats = Optimize(vertices, indices);
+        size_t indexBytes = (vertices.size() <= 65536 ? sizeof(uint16_t) : sizeof(uint32_t)) * indices.size();
+
+        std::cout << name << ": " << indices.size() / 3 << " triangles, " << vertices.size() << " vertices (" << stats.unusedVertices << " unused dropped)" << std::endl;
+        std::cout << "    ACMR " << stats.before.acmr << " -> " << stats.after.acmr << ", ATVR " << stats.before.atvr << " -> " << stats.after.atvr
+            << " (FIFO cache of " << CACHE_SIZE << ", " << stats.before.misses << " -> " << stats.after.misses << " vertex shader runs)" << std::endl;
+        std::cout << "    vertex cache " << stats.vertexCacheMs << " ms, overdraw " << stats.overdrawMs << " ms (" << stats.clusters << " clusters), vertex fetch " << stats.vertexFetchMs << " ms" << std::endl;
+        std::cout << "    indices " << sizeof(uint32_t) * indices.size() / 1024 << " KiB as 32 bit, " << indexBytes / 1024 << " KiB uploaded" << std::endl;
+    }
+
+    void MeshOptimizer::RunBenchmark(const std::vector<std::string>& paths, uint32_t syntheticTriangles, JobSystem& jobSystem)
+    {
+        std::vector<std::pair<std::string, std::pair<std::vector<Vertex>, std::vector<uint32_t>>>> meshes;
+        for (const std::string& path : paths)
+        {
+            std::vector<Vertex> vertices;
+            std::vector<uint32_t> indices;
+            MeshImporter::LoadObj(path, vertices, indices, jobSystem);
+            meshes.push_back({ path, { vertices, indices } });
+        }
+
+        if (syntheticTriangles > 0)
+        {
+            tinyobj::attrib_t attrib;
+            std::vector<tinyobj::shape_t> shapes;
+            std::vector<Vertex> vertices;
+            std::vector<uint32_t> indices;
+            MeshImporter::MakeSyntheticMesh(syntheticTriangles, attrib, shapes);
+            MeshImporter::BuildVertices(attrib, shapes, vertices, indices, jobSystem);
+            meshes.push_back({ "synthetic grid", { vertices, indices } });
+        }
+
+        // Every mesh again with its triangles in random order, what an exporter that doesn't care about the GPU can hand over
+        size_t ui_importedCount = meshes.size();
+        std::mt19937 random(1234); // same order every run
+        for (size_t m = 0; m < ui_importedCount; m++)
+        {
+            std::vector<uint32_t>& indices = meshes[m].second.second;
+            std::vector<uint32_t> triangles(indices.size() / 3);
+            std::iota(triangles.begin(), triangles.end(), 0u);
+            std::shuffle(triangles.begin(), triangles.end(), random);
+
+            std::vector<uint32_t> shuffled;
+            shuffled.reserve(indices.size());
+            for (uint32_t t : triangles)
+            {
+                shuffled.insert(shuffled.end(), indices.begin() + t * 3, indices.begin() + t * 3 + 3);
+            }
+            meshes.push_back({ meshes[m].first + ", shuffled", { meshes[m].second.first, shuffled } });
+        }
+
+        for (auto& mesh : meshes)
+        {
+            BenchmarkMesh(mesh.first, mesh.second.first, mesh.second.second);
+        }
+    }
+}
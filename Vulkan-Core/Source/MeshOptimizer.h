@@ -0,0 +1,69 @@
+#pragma once
+#include "Structs.h"
+#include "JobSystem.h"
+
+#include <vector>
+#include <string>
+
+
+namespace VCore
+{
+	// How well an index order reuses the GPU's post transform vertex cache, simulated as a FIFO of MeshOptimizer::CACHE_SIZE entries
+	struct VertexCacheStats
+	{
+		uint32_t misses = 0; // vertices the vertex shader runs on
+		float acmr = 0.0f; // average cache miss ratio, misses per triangle. 3 is no reuse at all, ~0.5 the best a closed mesh can do
+		float atvr = 0.0f; // average transformed vertex ratio, misses per vertex. 1 is every vertex shaded exactly once
+	};
+
+	// What MeshOptimizer::Optimize did to one mesh
+	struct MeshOptimizerStats
+	{
+		VertexCacheStats before;
+		VertexCacheStats after;
+		uint32_t clusters = 0; // overdraw ordering's triangle clusters
+		uint32_t unusedVertices = 0; // dropped by the vertex fetch reorder
+		float vertexCacheMs = 0.0f;
+		float overdrawMs = 0.0f;
+		float vertexFetchMs = 0.0f;
+	};
+
+	// Refer to - https://gfx.cs.princeton.edu/pubs/Sander_2007_FTR/ (Tipsify) and https://github.com/zeux/meshoptimizer#vertex-cache-optimization
+	// Reorders an imported mesh for the GPU, once when its .vmesh cache is built, so every later load gets the optimized order for free:
+	// 1. Tipsify - triangles are emitted as fans around vertices that are still in the cache, so each vertex is shaded as few times as possible.
+	// 2. Overdraw - the vertex cache order is cut into clusters (wherever the cache restarts, and within those wherever a cluster already reuses the cache almost as well
+	//    as the whole run), then clusters on the outside of the mesh, facing out, are drawn first. Those are the ones most likely to hide what's behind them from most views.
+	// 3. Vertex fetch - vertices are renumbered in the order the indices first reach them, so the vertex fetch reads memory mostly front to back. Unused vertices are dropped.
+	class MeshOptimizer
+	{
+	public:
+		static const uint32_t CACHE_SIZE = 16;
+
+		// All three steps, in place. Leaves the mesh as it is if it isn't a triangle list
+		static MeshOptimizerStats Optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+		static void OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount);
+		// Needs indices in vertex cache order. threshold is how much worse than its hard cluster a soft cluster's ACMR may be, returns the cluster count
+		static uint32_t OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold);
+		// Returns how many unused vertices were dropped
+		static uint32_t OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+		static VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount);
+
+		// Imports each OBJ and a synthetic grid of syntheticTriangles triangles (0 to skip) in its import order and shuffled, optimizes them and prints the cache stats before and after
+		static void RunBenchmark(const std::vector<std::string>& paths, uint32_t syntheticTriangles, JobSystem& jobSystem);
+
+		// Where the triangles using each vertex are listed, offsets[v] to offsets[v + 1] in triangles. The MeshSimplifier walks it too
+		struct Adjacency
+		{
+			std::vector<uint32_t> offsets;
+			std::vector<uint32_t> triangles;
+		};
+
+		static void BuildAdjacency(const std::vector<uint32_t>& indices, uint32_t vertexCount, Adjacency& adjacency);
+
+	private:
+		// Tipsify's next fanning vertex: the candidate that will still be in the cache after its remaining triangles are emitted, oldest first, or a dead end
+		static int64_t GetNextVertex(const std::vector<uint32_t>& candidates, const std::vector<uint32_t>& cacheTimes, uint32_t time, const std::vector<uint32_t>& liveTriangles,
+			std::vector<uint32_t>& deadEnds, uint32_t& cursor, uint32_t vertexCount);
+		static void BenchmarkMesh(const std::string& name, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+	};
+}
@@ -0,0 +1,181 @@
+#include "MeshRegistry.h"
+
+#include <filesystem>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+
+namespace VCore
+{
+    MeshRegistry::MeshRegistry()
+    {
+        m_pathLookup = std::unordered_map<std::string, Mesh*>();
+        m_contentLookup = std::unordered_multimap<uint64_t, Mesh*>();
+        m_meshes = std::unordered_map<Mesh*, MeshEntry>();
+        m_meshesLoaded = 0;
+        m_sharedByPath = 0;
+        m_sharedByContent = 0;
+        m_hashCollisions = 0;
+    }
+
+    MeshRegistry::~MeshRegistry()
+    {
+    }
+
+    void MeshRegistry::Cleanup(LogicalDevice& logicalDevice)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (std::pair<Mesh* const, MeshEntry>& entry : m_meshes)
+        {
+            entry.second.mesh->Cleanup();
+        }
+        m_meshes.clear();
+        m_pathLookup.clear();
+        m_contentLookup.clear();
+        m_geometryArena.Cleanup(logicalDevice);
+    }
+
+    void MeshRegistry::SetVertexFormat(VertexFormat format)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_geometryArena.SetVertexFormat(format);
+    }
+
+    Mesh* MeshRegistry::Acquire(const std::string& path, JobSystem& jobSystem, UploadQueue& uploadQueue, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice)
+    {
+        // "../Models/a.obj" and "../Models/./a.obj" are the same asset
+        std::string key = std::filesystem::path(path).lexically_normal().generic_string();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto byPath = m_pathLookup.find(key);
+        if (byPath != m_pathLookup.end())
+        {
+            m_meshes[byPath->second].refCount++;
+            m_sharedByPath++;
+            return byPath->second;
+        }
+
+        // Loading happens under the lock - objects are created on one thread, and the importer already spreads the heavy part across the job system
+        std::unique_ptr<Mesh> mesh = std::make_unique<Mesh>(path);
+        mesh->Load(jobSystem);
+        uint64_t contentHash = mesh->GetContentHash();
+
+        auto byContent = m_contentLookup.equal_range(contentHash);
+        for (auto it = byContent.first; it != byContent.second; it++)
+        {
+            // The registered mesh dropped its data after uploading it, so it's loaded again to be compared. Only happens for a path seen for the first time
+            // whose hash matches, and the .vmesh cache makes that a mapping rather than a parse
+            Mesh registered(it->second->GetPath());
+            registered.Load(jobSystem);
+            if (!IsSameGeometry(mesh->GetMeshView(), registered.GetMeshView()))
+            {
+                m_hashCollisions++;
+                continue;
+            }
+
+            // Same geometry under another path - drop what we just loaded and remember the path for next time
+            m_meshes[it->second].refCount++;
+            m_pathLookup.emplace(key, it->second);
+            m_sharedByContent++;
+            return it->second;
+        }
+
+        mesh->CreateBuffers(uploadQueue, m_geometryArena, physicalDevice, logicalDevice);
+        mesh->ReleaseMeshData();
+        m_meshesLoaded++;
+
+        Mesh* handle = mesh.get();
+        MeshEntry entry;
+        entry.mesh = std::move(mesh);
+        entry.contentHash = contentHash;
+        entry.refCount = 1;
+        m_meshes.emplace(handle, std::move(entry));
+        m_pathLookup.emplace(key, handle);
+        m_contentLookup.emplace(contentHash, handle);
+
+        return handle;
+    }
+
+    void MeshRegistry::Release(Mesh* mesh, LogicalDevice& logicalDevice)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto existing = m_meshes.find(mesh);
+        if (existing == m_meshes.end() || --existing->second.refCount > 0)
+        {
+            return;
+        }
+
+        for (auto it = m_pathLookup.begin(); it != m_pathLookup.end();)
+        {
+            it = it->second == mesh ? m_pathLookup.erase(it) : std::next(it);
+        }
+        auto byContent = m_contentLookup.equal_range(existing->second.contentHash);
+        for (auto it = byContent.first; it != byContent.second; it++)
+        {
+            if (it->second == mesh)
+            {
+                m_contentLookup.erase(it);
+                break;
+            }
+        }
+
+        existing->second.mesh->Cleanup();
+        m_meshes.erase(existing);
+    }
+
+    bool MeshRegistry::IsSameGeometry(const MeshView& a, const MeshView& b)
+    {
+        if (a.vertexCount != b.vertexCount || a.indexCount != b.indexCount || a.GetTotalIndexCount() != b.GetTotalIndexCount())
+        {
+            return false;
+        }
+        return memcmp(a.vertices, b.vertices, sizeof(Vertex) * a.vertexCount) == 0 && memcmp(a.indices, b.indices, sizeof(uint32_t) * a.GetTotalIndexCount()) == 0;
+    }
+
+    void MeshRegistry::CompactGeometry(UploadQueue& uploadQueue, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_geometryArena.Compact(uploadQueue, physicalDevice, logicalDevice);
+    }
+
+    void MeshRegistry::PrintStats()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::cout << "meshes: " << m_meshesLoaded << " loaded and uploaded, " << m_sharedByPath << " shared by path, " << m_sharedByContent << " shared by content (" << m_hashCollisions << " hash collisions), "
+            << m_meshes.size() << " alive" << std::endl;
+        m_geometryArena.PrintStats();
+
+        uint32_t ui_stride = m_geometryArena.GetVertexStride();
+        std::cout << "  vertex format " << VertexCodec::GetName(m_geometryArena.GetVertexFormat()) << ": " << ui_stride << " of " << sizeof(Vertex) << " bytes per vertex" << std::endl;
+        for (std::pair<Mesh* const, MeshEntry>& entry : m_meshes)
+        {
+            const GeometryRange& geometry = entry.first->GetGeometry();
+            const VertexCacheStats& vertexCache = entry.first->GetVertexCacheStats();
+            std::cout << "    " << entry.first->GetPath() << ": " << geometry.vertexCount << " vertices, " << geometry.indexCount / 3 << " triangles, "
+                << (geometry.indexType == VK_INDEX_TYPE_UINT16 ? 16 : 32) << " bit indices, ACMR " << vertexCache.acmr << ", ATVR " << vertexCache.atvr;
+            if (geometry.lodCount > 1)
+            {
+                std::cout << ", LODs";
+                for (uint32_t l = 1; l < geometry.lodCount; l++)
+                {
+                    std::cout << " " << geometry.lods[l].indexCount / 3 << " (error " << geometry.lods[l].error << ")";
+                }
+            }
+            if (ui_stride < sizeof(Vertex))
+            {
+                // Quantization step is the largest distance between neighbouring positions the mesh can still tell apart
+                float f_step = std::max(geometry.positionScale.x, std::max(geometry.positionScale.y, geometry.positionScale.z)) / 65535.0f;
+                std::cout << ", saved " << sizeof(Vertex) - ui_stride << " bytes per vertex (" << static_cast<uint64_t>(geometry.vertexCount) * (sizeof(Vertex) - ui_stride) / 1024
+                    << " KiB), position step " << f_step;
+            }
+            std::cout << std::endl;
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "Mesh.h"
+#include "GeometryArena.h"
+#include "PhysicalDevice.h"
+#include "LogicalDevice.h"
+#include "UploadQueue.h"
+#include "JobSystem.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+
+
+namespace VCore
+{
+	// Hands out shared Meshes so each unique asset is loaded and uploaded once, however many objects use it.
+	// Meshes are looked up by (normalized) path first, then by the hash of their contents, so the same geometry under two different paths is still only uploaded once.
+	// Reference counted like the PipelineRegistry - a Mesh is destroyed when the last object releases it. Every mesh's geometry lives in the registry's GeometryArena. Thread safe.
+	class MeshRegistry
+	{
+	public:
+		MeshRegistry();
+		~MeshRegistry();
+
+		// Destroys any meshes still registered and the geometry arena
+		void Cleanup(LogicalDevice& logicalDevice);
+		// What mesh vertices are uploaded as (see VertexCodec). Call before the first Acquire, materials have to use the same format
+		void SetVertexFormat(VertexFormat format);
+
+		// Returns the mesh for path, loading and uploading it if nothing else holds it yet. The pointer stays valid until the matching Release
+		Mesh* Acquire(const std::string& path, JobSystem& jobSystem, UploadQueue& uploadQueue, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
+		void Release(Mesh* mesh, LogicalDevice& logicalDevice);
+		// Packs the geometry of the meshes still alive together after others were released (see GeometryArena::Compact). The device must be idle,
+		// and the buffers and offsets of every mesh read again afterwards
+		void CompactGeometry(UploadQueue& uploadQueue, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
+		// Also prints how many bytes per vertex the vertex format saved, per mesh
+		void PrintStats();
+
+	private:
+		struct MeshEntry
+		{
+			std::unique_ptr<Mesh> mesh;
+			uint64_t contentHash = 0;
+			uint32_t refCount = 0;
+		};
+
+		// Counts, then the bytes of every vertex and index (LODs included)
+		static bool IsSameGeometry(const MeshView& a, const MeshView& b);
+
+		std::unordered_map<std::string, Mesh*> m_pathLookup; // every path a mesh has been requested under
+		std::unordered_multimap<uint64_t, Mesh*> m_contentLookup; // meshes whose hashes collide are both in here
+		std::unordered_map<Mesh*, MeshEntry> m_meshes;
+		GeometryArena m_geometryArena;
+		std::mutex m_mutex;
+
+		// stats
+		uint32_t m_meshesLoaded;
+		uint32_t m_sharedByPath;
+		uint32_t m_sharedByContent;
+		uint32_t m_hashCollisions;
+	};
+}
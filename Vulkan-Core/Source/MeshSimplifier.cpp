@@ -0,0 +1,319 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <cmath>
+
+
+namespace VCore
+{
+    // A LOD has to have at most this share of the previous one's triangles to be worth its indices
+    static const float LOD_MIN_REDUCTION = 0.85f;
+
+    void MeshSimplifier::BuildLods(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, float radius, float maxErrorRatio, std::vector<MeshLod>& lods)
+    {
+        lods.clear();
+        lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.0f, 0 });
+        if (indices.size() % 3 != 0)
+        {
+            return;
+        }
+
+        // Simplifying each LOD from the last keeps them nested and cheap to build. Errors add up, as each is measured against the LOD before
+        float f_maxError = maxErrorRatio * radius;
+        std::vector<uint32_t> previous(indices);
+        for (uint32_t lod = 1; lod < MESH_MAX_LODS; lod++)
+        {
+            std::vector<uint32_t> simplified(previous);
+            uint32_t ui_target = static_cast<uint32_t>(previous.size() / 3 * LOD_REDUCTION);
+            float f_error = lods.back().error + Simplify(vertices, simplified, ui_target, f_maxError - lods.back().error);
+            if (simplified.empty() || simplified.size() > previous.size() * LOD_MIN_REDUCTION)
+            {
+                break;
+            }
+
+            MeshOptimizer::OptimizeVertexCache(simplified, static_cast<uint32_t>(vertices.size()));
+            lods.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(simplified.size()), f_error, 0 });
+            indices.insert(indices.end(), simplified.begin(), simplified.end());
+            previous.swap(simplified);
+        }
+    }
+
+    float MeshSimplifier::Simplify(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, uint32_t targetTriangles, float maxError)
+    {
+        uint32_t ui_vertexCount = static_cast<uint32_t>(vertices.size());
+        if (indices.size() % 3 != 0 || indices.size() / 3 <= targetTriangles || maxError <= 0.0f)
+        {
+            return 0.0f;
+        }
+
+        // Vertices split along a seam share a position id, and each position lists its vertices (its wedges)
+        std::vector<uint32_t> positionIds(ui_vertexCount);
+        std::vector<glm::vec3> positions;
+        std::unordered_map<glm::vec3, uint32_t> positionLookup;
+        for (uint32_t v = 0; v < ui_vertexCount; v++)
+        {
+            auto inserted = positionLookup.try_emplace(vertices[v].pos, static_cast<uint32_t>(positions.size()));
+            if (inserted.second)
+            {
+                positions.push_back(vertices[v].pos);
+            }
+            positionIds[v] = inserted.first->second;
+        }
+        uint32_t ui_positionCount = static_cast<uint32_t>(positions.size());
+
+        std::vector<uint32_t> wedgeOffsets(static_cast<size_t>(ui_positionCount) + 1, 0);
+        for (uint32_t v = 0; v < ui_vertexCount; v++)
+        {
+            wedgeOffsets[positionIds[v] + 1]++;
+        }
+        for (uint32_t p = 0; p < ui_positionCount; p++)
+        {
+            wedgeOffsets[p + 1] += wedgeOffsets[p];
+        }
+        std::vector<uint32_t> wedges(ui_vertexCount);
+        std::vector<uint32_t> nextWedge(wedgeOffsets.begin(), wedgeOffsets.end() - 1);
+        for (uint32_t v = 0; v < ui_vertexCount; v++)
+        {
+            wedges[nextWedge[positionIds[v]]++] = v;
+        }
+
+        // Quadrics of the surface as it is now, and how many triangles use each edge
+        std::vector<Quadric> quadrics(ui_positionCount);
+        std::unordered_map<uint64_t, uint32_t> edgeUses;
+        for (size_t t = 0; t < indices.size(); t += 3)
+        {
+            uint32_t p[3] = { positionIds[indices[t]], positionIds[indices[t + 1]], positionIds[indices[t + 2]] };
+            glm::vec3 normal = glm::cross(positions[p[1]] - positions[p[0]], positions[p[2]] - positions[p[0]]); // length is twice the area
+            float f_length = glm::length(normal);
+            if (f_length > 0.0f)
+            {
+                normal /= f_length;
+                Quadric plane;
+                AddPlane(plane, normal, -glm::dot(normal, positions[p[0]]), 0.5 * f_length);
+                for (uint32_t corner = 0; corner < 3; corner++)
+                {
+                    AddQuadric(quadrics[p[corner]], plane);
+                }
+            }
+
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                uint32_t a = p[corner];
+                uint32_t b = p[(corner + 1) % 3];
+                if (a != b)
+                {
+                    edgeUses[static_cast<uint64_t>(std::min(a, b)) << 32 | std::max(a, b)]++;
+                }
+            }
+        }
+
+        // Only an edge between exactly two triangles is inside the surface, the positions on any other stay put
+        std::vector<bool> locked(ui_positionCount, false);
+        for (const auto& edge : edgeUses)
+        {
+            if (edge.second != 2)
+            {
+                locked[static_cast<uint32_t>(edge.first >> 32)] = true;
+                locked[static_cast<uint32_t>(edge.first & 0xffffffff)] = true;
+            }
+        }
+
+        uint32_t ui_triangleCount = static_cast<uint32_t>(indices.size() / 3);
+        double maxCost = static_cast<double>(maxError) * maxError;
+        double worstCost = 0.0;
+        MeshOptimizer::Adjacency adjacency;
+        std::vector<Collapse> collapses;
+        std::vector<bool> touched(ui_positionCount);
+        std::vector<uint32_t> remap(ui_vertexCount);
+        std::vector<uint32_t> targets;
+
+        while (ui_triangleCount > targetTriangles)
+        {
+            MeshOptimizer::BuildAdjacency(indices, ui_vertexCount, adjacency);
+
+            // Both ways along every edge, cheapest first
+            collapses.clear();
+            for (size_t t = 0; t < indices.size(); t += 3)
+            {
+                for (uint32_t corner = 0; corner < 3; corner++)
+                {
+                    uint32_t a = positionIds[indices[t + corner]];
+                    uint32_t b = positionIds[indices[t + (corner + 1) % 3]];
+                    if (a == b)
+                    {
+                        continue;
+                    }
+                    if (!locked[a])
+                    {
+                        collapses.push_back({ a, b, Evaluate(quadrics[a], quadrics[b], positions[b]) });
+                    }
+                    if (!locked[b])
+                    {
+                        collapses.push_back({ b, a, Evaluate(quadrics[a], quadrics[b], positions[a]) });
+                    }
+                }
+            }
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+            // A collapse marks every position of the triangles it changes, so none of the others in this batch reads a triangle it rewrote
+            std::fill(touched.begin(), touched.end(), false);
+            std::iota(remap.begin(), remap.end(), 0u);
+            uint32_t ui_collapsed = 0;
+            for (const Collapse& collapse : collapses)
+            {
+                if (ui_triangleCount <= targetTriangles || collapse.cost > maxCost)
+                {
+                    break;
+                }
+                if (touched[collapse.from] || touched[collapse.to])
+                {
+                    continue;
+                }
+
+                // Every wedge of from needs a wedge of to it shares a triangle with to move onto, so a seam only collapses along itself.
+                // The triangles with both go away, the rest must not flip
+                bool b_valid = true;
+                uint32_t ui_removed = 0;
+                targets.clear();
+                for (uint32_t w = wedgeOffsets[collapse.from]; w < wedgeOffsets[collapse.from + 1] && b_valid; w++)
+                {
+                    uint32_t v = wedges[w];
+                    uint32_t ui_target = UINT32_MAX;
+                    for (uint32_t a = adjacency.offsets[v]; a < adjacency.offsets[v + 1]; a++)
+                    {
+                        const uint32_t* triangle = &indices[static_cast<size_t>(adjacency.triangles[a]) * 3];
+                        glm::vec3 corners[3];
+                        glm::vec3 moved[3];
+                        bool b_removed = false;
+                        for (uint32_t corner = 0; corner < 3; corner++)
+                        {
+                            corners[corner] = positions[positionIds[triangle[corner]]];
+                            moved[corner] = triangle[corner] == v ? positions[collapse.to] : corners[corner];
+                            if (positionIds[triangle[corner]] == collapse.to)
+                            {
+                                b_removed = true;
+                                ui_target = triangle[corner];
+                            }
+                        }
+                        if (b_removed)
+                        {
+                            ui_removed++;
+                            continue;
+                        }
+                        if (glm::dot(glm::cross(corners[1] - corners[0], corners[2] - corners[0]), glm::cross(moved[1] - moved[0], moved[2] - moved[0])) <= 0.0f)
+                        {
+                            b_valid = false;
+                            break;
+                        }
+                    }
+                    if (ui_target == UINT32_MAX && adjacency.offsets[v + 1] > adjacency.offsets[v])
+                    {
+                        b_valid = false;
+                    }
+                    targets.push_back(ui_target);
+                }
+                if (!b_valid)
+                {
+                    continue;
+                }
+
+                for (uint32_t w = wedgeOffsets[collapse.from]; w < wedgeOffsets[collapse.from + 1]; w++)
+                {
+                    uint32_t v = wedges[w];
+                    if (targets[w - wedgeOffsets[collapse.from]] != UINT32_MAX)
+                    {
+                        remap[v] = targets[w - wedgeOffsets[collapse.from]];
+                    }
+                    for (uint32_t a = adjacency.offsets[v]; a < adjacency.offsets[v + 1]; a++)
+                    {
+                        for (uint32_t corner = 0; corner < 3; corner++)
+                        {
+                            touched[positionIds[indices[static_cast<size_t>(adjacency.triangles[a]) * 3 + corner]]] = true;
+                        }
+                    }
+                }
+                touched[collapse.from] = true;
+                touched[collapse.to] = true;
+                AddQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+                worstCost = std::max(worstCost, collapse.cost);
+                ui_triangleCount -= ui_removed;
+                ui_collapsed++;
+            }
+
+            if (ui_collapsed == 0)
+            {
+                break;
+            }
+
+            // Point every index at the vertex it collapsed onto and drop the triangles that lost their area
+            size_t ui_kept = 0;
+            for (size_t t = 0; t < indices.size(); t += 3)
+            {
+                uint32_t a = remap[indices[t]];
+                uint32_t b = remap[indices[t + 1]];
+                uint32_t c = remap[indices[t + 2]];
+                if (positionIds[a] == positionIds[b] || positionIds[b] == positionIds[c] || positionIds[c] == positionIds[a])
+                {
+                    continue;
+                }
+                indices[ui_kept++] = a;
+                indices[ui_kept++] = b;
+                indices[ui_kept++] = c;
+            }
+            indices.resize(ui_kept);
+            ui_triangleCount = static_cast<uint32_t>(ui_kept / 3);
+        }
+
+        return static_cast<float>(std::sqrt(worstCost));
+    }
+
+    void MeshSimplifier::AddPlane(Quadric& quadric, const glm::vec3& normal, float distance, double weight)
+    {
+        double x = normal.x;
+        double y = normal.y;
+        double z = normal.z;
+        double d = distance;
+        double plane[10] = { x * x, x * y, x * z, x * d, y * y, y * z, y * d, z * z, z * d, d * d };
+        for (uint32_t i = 0; i < 10; i++)
+        {
+            quadric.a[i] += plane[i] * weight;
+        }
+        quadric.weight += weight;
+    }
+
+    void MeshSimplifier::AddQuadric(Quadric& quadric, const Quadric& other)
+    {
+        for (uint32_t i = 0; i < 10; i++)
+        {
+            quadric.a[i] += other.a[i];
+        }
+        quadric.weight += other.weight;
+    }
+
+    double MeshSimplifier::Evaluate(const Quadric& a, const Quadric& b, const glm::vec3& position)
+    {
+        double q[10];
+        for (uint32_t i = 0; i < 10; i++)
+        {
+            q[i] = a.a[i] + b.a[i];
+        }
+        double weight = a.weight + b.weight;
+        if (weight <= 0.0)
+        {
+            return 0.0;
+        }
+
+        // v^T Q v with v = (x, y, z, 1), the off diagonal terms count twice
+        double x = position.x;
+        double y = position.y;
+        double z = position.z;
+        double value = q[0] * x * x + 2.0 * q[1] * x * y + 2.0 * q[2] * x * z + 2.0 * q[3] * x
+            + q[4] * y * y + 2.0 * q[5] * y * z + 2.0 * q[6] * y
+            + q[7] * z * z + 2.0 * q[8] * z
+            + q[9];
+        return std::max(value, 0.0) / weight;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "Structs.h"
+#include "MeshCache.h"
+
+#include <vector>
+
+
+namespace VCore
+{
+	// Refer to - https://www.cs.cmu.edu/~garland/Papers/quadrics.pdf and https://github.com/zeux/meshoptimizer#simplification
+	// Builds coarser levels of detail of an imported mesh, once when its .vmesh cache is built. Every LOD is only a new index list over the same vertices,
+	// so the LODs share one vertex range in the GeometryArena and cost nothing but their indices:
+	// - Each vertex position carries a quadric, the summed squared distance to the planes of the triangles around it (weighted by their area).
+	//   Collapsing an edge moves one position onto the other, and what that costs is how far the surviving position is from the planes of both.
+	// - Collapses are made cheapest first, a batch at a time, never two touching the same triangles in one batch. A collapse that would flip a triangle is skipped.
+	// - Vertices split along UV or normal seams move together, and only along the seam. Positions on an open border or a non-manifold edge never move, so holes don't grow.
+	class MeshSimplifier
+	{
+	public:
+		// Each LOD keeps about LOD_REDUCTION of the previous one's triangles
+		static constexpr float LOD_REDUCTION = 0.5f;
+
+		// Appends up to MESH_MAX_LODS - 1 coarser triangle lists to indices, each simplified from the one before, and describes them all in lods (lods[0] the original).
+		// Stops early once a LOD would drop too few triangles or its error would pass maxErrorRatio * radius
+		static void BuildLods(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, float radius, float maxErrorRatio, std::vector<MeshLod>& lods);
+		// Collapses edges of the triangle list in indices until at most targetTriangles are left or the next collapse would move the surface further than maxError.
+		// Returns how far the simplified surface may be from the one passed in
+		static float Simplify(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, uint32_t targetTriangles, float maxError);
+
+	private:
+		// Symmetric 4x4 matrix of the plane equations summed into it, upper triangle row by row
+		struct Quadric
+		{
+			double a[10] = {};
+			double weight = 0.0;
+		};
+
+		struct Collapse
+		{
+			uint32_t from; // position ids
+			uint32_t to;
+			double cost; // squared distance
+		};
+
+		static void AddPlane(Quadric& quadric, const glm::vec3& normal, float distance, double weight);
+		static void AddQuadric(Quadric& quadric, const Quadric& other);
+		// Weighted mean squared distance of position from the quadric's planes
+		static double Evaluate(const Quadric& a, const Quadric& b, const glm::vec3& position);
+	};
+}
@@ -3,11 +3,14 @@
 #include "PhysicalDevice.h"
 #include "LogicalDevice.h"
 #include "WinSys.h"
+#include "MeshRegistry.h"
+#include "JobSystem.h"
 
 #define GLFW_INCLUDE_VULKAN
 #include <glfw3.h>
 
 #include <vector>
+#include <memory>
 
 
 namespace VCore
@@ -17,34 +20,24 @@ namespace VCore
 	public:
 		Model();
 		~Model();
-		void CleanupUniformBuffers(LogicalDevice& logicalDevice);
-		void CleanupIndexBuffers(LogicalDevice& logicalDevice);
-		void CleanupVertexBuffers(LogicalDevice& logicalDevice);
+		void ReleaseMesh(MeshRegistry& meshRegistry, LogicalDevice& logicalDevice);
 
 		void SetModelPath(std::string path);
 		std::string GetModelPath();
-		void LoadModel();
-		void CreateVertexBuffer(VkCommandPool commandPool, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
-		void CreateIndexBuffer(VkCommandPool commandPool, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
-		void CreateUniformBuffers(PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
-		void UpdateUniformBuffer(uint32_t currentImage, WinSys& winSystem, float multiplier);
+		// Gets the shared mesh for the model path from the registry (loaded and uploaded once per unique asset)
+		void AcquireMesh(MeshRegistry& meshRegistry, JobSystem& jobSystem, UploadQueue& uploadQueue, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
+		Mesh* GetMesh();
+		void SetTransform(const glm::mat4& transform);
+		glm::mat4& GetTransform();
 		std::vector<VkCommandBuffer>& GetCommandBuffer();
-		std::vector<VkBuffer>& GetUniformBuffers();
 		VkBuffer& GetVertexBuffer();
 		VkBuffer& GetIndexBuffer();		
-		std::vector<uint32_t>& GetIndices();
+		uint32_t GetIndexCount();
 
 	private:
 		std::string m_modelPath;
-		std::vector<Vertex> m_vertices;
-		std::vector<uint32_t> m_indices;
-		VkBuffer m_vertexBuffer;
-		VkBuffer m_indexBuffer;
-		VkDeviceMemory m_vertexBufferMemory;
-		VkDeviceMemory m_indexBufferMemory;
-		std::vector<VkBuffer> m_uniformBuffers;
-		std::vector<VkDeviceMemory> m_uniformBuffersMemory;
-		std::vector<void*> m_uniformBuffersMapped;
+		Mesh* m_mesh; // owned by the MeshRegistry, shared with every other model using the same asset
+		glm::mat4 m_transform;
 		std::vector<VkCommandBuffer> m_commandBuffer;
 	};
 }
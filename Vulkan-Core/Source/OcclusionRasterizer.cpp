@@ -0,0 +1,609 @@
+#include "OcclusionRasterizer.h"
+#include "GameObject.h"
+#include "Mesh.h"
+#include "VulkanManager.h"
+
+#include <gtc/matrix_transform.hpp>
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cfloat>
+#include <climits>
+#include <map>
+
+#if defined(_M_X64) || defined(__x86_64__)
+    #define OCCLUSION_SSE // SSE2 is always there on x64
+    #include <immintrin.h>
+#endif
+
+
+namespace VCore
+{
+    static const uint32_t TILE_SIZE = 8; // pixels along each side of a tile, a multiple of the four pixels the SSE kernels work on
+    static const float GUARD_BAND = 8192.0f; // pixels a vertex can be off the buffer before its triangles are skipped, keeps the edge functions well within float precision
+
+    OcclusionRasterizer::OcclusionRasterizer()
+    {
+        m_width = 0;
+        m_height = 0;
+        m_tilesX = 0;
+        m_tilesY = 0;
+        m_depth = std::vector<float>();
+        m_tileMaxDepth = std::vector<float>();
+        m_viewProj = glm::mat4(1.0f);
+    #ifdef OCCLUSION_SSE
+        m_b_simd = true;
+    #else
+        m_b_simd = false;
+    #endif
+        m_meshes = std::vector<OccluderMesh>();
+        m_occluders = std::vector<Occluder>();
+        m_transforms = std::vector<glm::mat4>();
+        m_screenVertices = std::vector<glm::vec4>();
+        m_triangles = std::vector<Triangle>();
+        m_totalTested = 0;
+        m_totalOccluded = 0;
+        m_totalTrianglesDrawn = 0;
+        m_rasterTimeMs = 0.0f;
+        m_frames = 0;
+
+        SetResolution(VM_OCCLUSION_WIDTH, VM_OCCLUSION_WIDTH * 3 / 4);
+    }
+
+    OcclusionRasterizer::~OcclusionRasterizer()
+    {
+    }
+
+    void OcclusionRasterizer::SetResolution(uint32_t width, uint32_t height)
+    {
+        m_tilesX = std::max((width + TILE_SIZE - 1) / TILE_SIZE, 1u);
+        m_tilesY = std::max((height + TILE_SIZE - 1) / TILE_SIZE, 1u);
+        m_width = m_tilesX * TILE_SIZE;
+        m_height = m_tilesY * TILE_SIZE;
+        m_depth.assign(m_width * m_height, 1.0f);
+        m_tileMaxDepth.assign(m_tilesX * m_tilesY, 1.0f);
+    }
+
+    void OcclusionRasterizer::Build(std::vector<GameObject>& gameObjects, JobSystem& jobSystem)
+    {
+        m_meshes.clear();
+        m_occluders.clear();
+        m_screenVertices.clear();
+        m_triangles.clear();
+
+        for (uint32_t i = 0; i < static_cast<uint32_t>(gameObjects.size()); i++)
+        {
+            GameObject& object = gameObjects[i];
+            // Instanced objects' transforms live in the TransformSystem, only regular objects can hide others
+            if (object.IsOccluder() && !object.GetMaterial()->IsInstanced() && object.GetModel().GetMesh() != nullptr)
+            {
+                AddOccluder(i, object.GetModel().GetMesh()->GetPath(), jobSystem);
+            }
+        }
+        m_transforms.resize(m_occluders.size());
+    }
+
+    void OcclusionRasterizer::AddOccluder(uint32_t object, const std::string& path, JobSystem& jobSystem)
+    {
+        uint32_t ui_mesh = 0;
+        while (ui_mesh < m_meshes.size() && m_meshes[ui_mesh].path != path)
+        {
+            ui_mesh++;
+        }
+
+        if (ui_mesh == m_meshes.size())
+        {
+            // The registry's Mesh dropped its geometry once it was uploaded, so occluders load their own copy (a file mapping when the .vmesh cache is up to date)
+            Mesh source = Mesh(path);
+            source.Load(jobSystem);
+            const MeshView& view = source.GetMeshView();
+
+            OccluderMesh mesh;
+            mesh.path = path;
+            mesh.positions.resize(view.vertexCount);
+            for (uint32_t v = 0; v < view.vertexCount; v++)
+            {
+                mesh.positions[v] = view.vertices[v].pos;
+            }
+            mesh.indices.assign(view.indices, view.indices + view.indexCount);
+            m_meshes.push_back(std::move(mesh));
+        }
+
+        Occluder occluder;
+        occluder.object = object;
+        occluder.mesh = ui_mesh;
+        occluder.firstVertex = static_cast<uint32_t>(m_screenVertices.size());
+        occluder.firstTriangle = static_cast<uint32_t>(m_triangles.size());
+        m_occluders.push_back(occluder);
+
+        m_screenVertices.resize(m_screenVertices.size() + m_meshes[ui_mesh].positions.size());
+        m_triangles.resize(m_triangles.size() + m_meshes[ui_mesh].indices.size() / 3);
+    }
+
+    void OcclusionRasterizer::Cleanup()
+    {
+        m_meshes.clear();
+        m_occluders.clear();
+        m_transforms.clear();
+        m_screenVertices.clear();
+        m_triangles.clear();
+    }
+
+    void OcclusionRasterizer::RenderOccluders(std::vector<GameObject>& gameObjects, const glm::mat4& viewProj, glm::vec3 objectOffset, JobSystem& jobSystem)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (size_t i = 0; i < m_occluders.size(); i++)
+        {
+            m_transforms[i] = gameObjects[m_occluders[i].object].GetModel().GetTransform();
+        }
+        Rasterize(viewProj, objectOffset, jobSystem);
+
+        auto end = std::chrono::high_resolution_clock::now();
+        m_rasterTimeMs += std::chrono::duration<float, std::chrono::milliseconds::period>(end - start).count();
+        m_frames++;
+    }
+
+    void OcclusionRasterizer::Rasterize(const glm::mat4& viewProj, glm::vec3 objectOffset, JobSystem& jobSystem)
+    {
+        m_viewProj = viewProj;
+
+        // Vertices to pixels and triangle setup, a job per occluder
+        jobSystem.ParallelFor(static_cast<uint32_t>(m_occluders.size()), 1, [&](uint32_t begin, uint32_t end, uint32_t threadIndex)
+        {
+            for (uint32_t o = begin; o < end; o++)
+            {
+                const Occluder& occluder = m_occluders[o];
+                const OccluderMesh& mesh = m_meshes[occluder.mesh];
+                glm::mat4 matrix = viewProj * m_transforms[o];
+                glm::vec4* screenVertices = &m_screenVertices[occluder.firstVertex];
+
+                for (size_t v = 0; v < mesh.positions.size(); v++)
+                {
+                    glm::vec4 clip = matrix * glm::vec4(mesh.positions[v] + objectOffset, 1.0f);
+                    if (clip.z < 0.0f || clip.w <= 0.0f)
+                    {
+                        screenVertices[v] = glm::vec4(0.0f); // in front of the near plane, its triangles are skipped
+                        continue;
+                    }
+                    // Same mapping as the viewport, row 0 at NDC y = -1
+                    float f_inverseW = 1.0f / clip.w;
+                    screenVertices[v] = glm::vec4((clip.x * f_inverseW * 0.5f + 0.5f) * m_width, (clip.y * f_inverseW * 0.5f + 0.5f) * m_height, clip.z * f_inverseW, 1.0f);
+                }
+
+                SetupTriangles(screenVertices, mesh.indices.data(), static_cast<uint32_t>(mesh.indices.size() / 3), &m_triangles[occluder.firstTriangle]);
+            }
+        });
+
+        // Every tile row is cleared and filled by one job, so no two jobs write the same pixels
+        jobSystem.ParallelFor(m_tilesY, 1, [&](uint32_t begin, uint32_t end, uint32_t threadIndex)
+        {
+            for (uint32_t tileRow = begin; tileRow < end; tileRow++)
+            {
+                RasterizeTileRow(tileRow, m_b_simd);
+            }
+        });
+
+        for (const Triangle& triangle : m_triangles)
+        {
+            m_totalTrianglesDrawn += triangle.maxY >= 0 ? 1 : 0;
+        }
+    }
+
+    void OcclusionRasterizer::SetupTriangles(const glm::vec4* screenVertices, const uint32_t* indices, uint32_t triangleCount, Triangle* triangles)
+    {
+        const float f_width = static_cast<float>(m_width);
+        const float f_height = static_cast<float>(m_height);
+
+        for (uint32_t t = 0; t < triangleCount; t++)
+        {
+            Triangle& triangle = triangles[t];
+            triangle.maxY = -1; // skipped unless it makes it through setup
+
+            glm::vec4 v[3] = { screenVertices[indices[t * 3]], screenVertices[indices[t * 3 + 1]], screenVertices[indices[t * 3 + 2]] };
+            bool b_usable = true;
+            for (int i = 0; i < 3; i++)
+            {
+                b_usable = b_usable && v[i].w != 0.0f && v[i].x > -GUARD_BAND && v[i].x < f_width + GUARD_BAND && v[i].y > -GUARD_BAND && v[i].y < f_height + GUARD_BAND;
+            }
+            if (!b_usable)
+            {
+                continue;
+            }
+
+            // Pixel x spans [x, x + 1), only pixels entirely inside the triangle's box can be entirely covered
+            float f_minX = std::min(std::min(v[0].x, v[1].x), v[2].x);
+            float f_maxX = std::max(std::max(v[0].x, v[1].x), v[2].x);
+            float f_minY = std::min(std::min(v[0].y, v[1].y), v[2].y);
+            float f_maxY = std::max(std::max(v[0].y, v[1].y), v[2].y);
+            int minX = std::max(static_cast<int>(std::ceil(f_minX)), 0);
+            int maxX = std::min(static_cast<int>(std::floor(f_maxX)) - 1, static_cast<int>(m_width) - 1);
+            int minY = std::max(static_cast<int>(std::ceil(f_minY)), 0);
+            int maxY = std::min(static_cast<int>(std::floor(f_maxY)) - 1, static_cast<int>(m_height) - 1);
+            float f_area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[1].y - v[0].y) * (v[2].x - v[0].x);
+            if (minX > maxX || minY > maxY || std::abs(f_area) < 1e-6f)
+            {
+                continue; // off the buffer, too thin to cover a whole pixel or degenerate
+            }
+
+            // Edge i runs from vertex i to the next one, and is the area at the vertex opposite it
+            for (int i = 0; i < 3; i++)
+            {
+                const glm::vec4& a = v[i];
+                const glm::vec4& b = v[(i + 1) % 3];
+                triangle.edgeA[i] = a.y - b.y;
+                triangle.edgeB[i] = b.x - a.x;
+                triangle.edgeC[i] = a.x * b.y - a.y * b.x;
+            }
+
+            // Depth is linear in screen space, weighted by each vertex's opposite edge
+            float f_inverseArea = 1.0f / f_area;
+            triangle.depthA = (triangle.edgeA[1] * v[0].z + triangle.edgeA[2] * v[1].z + triangle.edgeA[0] * v[2].z) * f_inverseArea;
+            triangle.depthB = (triangle.edgeB[1] * v[0].z + triangle.edgeB[2] * v[1].z + triangle.edgeB[0] * v[2].z) * f_inverseArea;
+            triangle.depthC = (triangle.edgeC[1] * v[0].z + triangle.edgeC[2] * v[1].z + triangle.edgeC[0] * v[2].z) * f_inverseArea;
+
+            // Clockwise triangles are flipped so inside is always positive - both facings are drawn, a wall hides what's behind it from either side
+            if (f_area < 0.0f)
+            {
+                for (int i = 0; i < 3; i++)
+                {
+                    triangle.edgeA[i] = -triangle.edgeA[i];
+                    triangle.edgeB[i] = -triangle.edgeB[i];
+                    triangle.edgeC[i] = -triangle.edgeC[i];
+                }
+            }
+
+            // The kernels evaluate at pixel centers, so an occluder only writes pixels it covers entirely, at the farthest depth it has inside them.
+            // A linear function is smallest (largest) in a pixel at the corner half a pixel away along both axes, so each edge is pulled in and the depth pushed back by
+            // half of |a| + |b|. An object that sticks out past a silhouette by less than a pixel is then never hidden by it - the price is uncovered pixels along every edge
+            for (int i = 0; i < 3; i++)
+            {
+                triangle.edgeC[i] -= 0.5f * (std::abs(triangle.edgeA[i]) + std::abs(triangle.edgeB[i]));
+            }
+            triangle.depthC += 0.5f * (std::abs(triangle.depthA) + std::abs(triangle.depthB));
+
+            triangle.minX = minX;
+            triangle.maxX = maxX;
+            triangle.minY = minY;
+            triangle.maxY = maxY;
+        }
+    }
+
+    void OcclusionRasterizer::RasterizeTileRow(uint32_t tileRow, bool b_simd)
+    {
+        int rowBegin = static_cast<int>(tileRow * TILE_SIZE);
+        int rowEnd = rowBegin + static_cast<int>(TILE_SIZE);
+        std::fill(m_depth.begin() + rowBegin * m_width, m_depth.begin() + rowEnd * m_width, 1.0f);
+
+        for (const Triangle& triangle : m_triangles)
+        {
+            if (triangle.maxY < rowBegin || triangle.minY >= rowEnd)
+            {
+                continue;
+            }
+
+            // Both kernels walk whole groups of four, the edge functions alone decide which pixels are inside so they always agree
+            int columnBegin = triangle.minX & ~3;
+            int columnEnd = (triangle.maxX | 3) + 1;
+
+            for (int y = std::max(triangle.minY, rowBegin); y <= std::min(triangle.maxY, rowEnd - 1); y++)
+            {
+                float f_y = static_cast<float>(y) + 0.5f;
+                float rowEdge[3];
+                for (int i = 0; i < 3; i++)
+                {
+                    rowEdge[i] = triangle.edgeB[i] * f_y + triangle.edgeC[i];
+                }
+                float f_rowDepth = triangle.depthB * f_y + triangle.depthC;
+                float* depthRow = &m_depth[y * m_width];
+
+            #ifdef OCCLUSION_SSE
+                if (b_simd)
+                {
+                    // Four pixels per step: the coverage mask of the three edges and the depth test together pick which pixels take the triangle's depth
+                    const __m128 pixelOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+                    const __m128 zero = _mm_setzero_ps();
+                    __m128 edgeA[3];
+                    __m128 edgeRow[3];
+                    for (int i = 0; i < 3; i++)
+                    {
+                        edgeA[i] = _mm_set1_ps(triangle.edgeA[i]);
+                        edgeRow[i] = _mm_set1_ps(rowEdge[i]);
+                    }
+                    __m128 depthA = _mm_set1_ps(triangle.depthA);
+                    __m128 depthRowTerm = _mm_set1_ps(f_rowDepth);
+
+                    for (int x = columnBegin; x < columnEnd; x += 4)
+                    {
+                        __m128 pixelX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), pixelOffsets);
+                        __m128 covered = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[0], pixelX), edgeRow[0]), zero);
+                        covered = _mm_and_ps(covered, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[1], pixelX), edgeRow[1]), zero));
+                        covered = _mm_and_ps(covered, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[2], pixelX), edgeRow[2]), zero));
+                        if (_mm_movemask_ps(covered) == 0)
+                        {
+                            continue;
+                        }
+
+                        __m128 depth = _mm_add_ps(_mm_mul_ps(depthA, pixelX), depthRowTerm);
+                        __m128 stored = _mm_loadu_ps(depthRow + x);
+                        __m128 mask = _mm_and_ps(covered, _mm_cmplt_ps(depth, stored));
+                        _mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(mask, depth), _mm_andnot_ps(mask, stored)));
+                    }
+                    continue;
+                }
+            #endif
+
+                for (int x = columnBegin; x < columnEnd; x++)
+                {
+                    float f_x = static_cast<float>(x) + 0.5f;
+                    bool b_covered = triangle.edgeA[0] * f_x + rowEdge[0] >= 0.0f && triangle.edgeA[1] * f_x + rowEdge[1] >= 0.0f && triangle.edgeA[2] * f_x + rowEdge[2] >= 0.0f;
+                    float f_depth = triangle.depthA * f_x + f_rowDepth;
+                    if (b_covered && f_depth < depthRow[x])
+                    {
+                        depthRow[x] = f_depth;
+                    }
+                }
+            }
+        }
+
+        // Farthest depth of every tile in the row, so tests can skip tiles that are entirely in front of them
+        for (uint32_t tileColumn = 0; tileColumn < m_tilesX; tileColumn++)
+        {
+            float f_maxDepth = 0.0f;
+            for (int y = rowBegin; y < rowEnd; y++)
+            {
+                const float* depthRow = &m_depth[y * m_width + tileColumn * TILE_SIZE];
+                for (uint32_t x = 0; x < TILE_SIZE; x++)
+                {
+                    f_maxDepth = std::max(f_maxDepth, depthRow[x]);
+                }
+            }
+            m_tileMaxDepth[tileRow * m_tilesX + tileColumn] = f_maxDepth;
+        }
+    }
+
+    bool OcclusionRasterizer::IsOccluded(glm::vec3 center, float radius, bool b_simd)
+    {
+        // Screen rectangle and nearest depth of the box around the sphere
+        glm::vec2 minimum = glm::vec2(FLT_MAX);
+        glm::vec2 maximum = glm::vec2(-FLT_MAX);
+        float f_nearest = FLT_MAX;
+        // The corners are the projected center plus or minus each of viewProj's first three columns scaled by the radius, one matrix multiply instead of eight
+        glm::vec4 clipCenter = m_viewProj * glm::vec4(center, 1.0f);
+        glm::vec4 clipX = m_viewProj[0] * radius;
+        glm::vec4 clipY = m_viewProj[1] * radius;
+        glm::vec4 clipZ = m_viewProj[2] * radius;
+        for (int i = 0; i < 8; i++)
+        {
+            glm::vec4 clip = clipCenter + ((i & 1) ? clipX : -clipX) + ((i & 2) ? clipY : -clipY) + ((i & 4) ? clipZ : -clipZ);
+            if (clip.z < 0.0f || clip.w <= 0.0f)
+            {
+                return false; // reaches in front of the near plane
+            }
+            float f_inverseW = 1.0f / clip.w;
+            glm::vec2 pixel = glm::vec2((clip.x * f_inverseW * 0.5f + 0.5f) * m_width, (clip.y * f_inverseW * 0.5f + 0.5f) * m_height);
+            minimum = glm::min(minimum, pixel);
+            maximum = glm::max(maximum, pixel);
+            f_nearest = std::min(f_nearest, clip.z * f_inverseW);
+        }
+
+        // Every pixel the rectangle touches. Clamped as floats first, the rectangle of a sphere close to the camera can be huge
+        int minX = static_cast<int>(std::floor(std::clamp(minimum.x, 0.0f, static_cast<float>(m_width))));
+        int maxX = static_cast<int>(std::floor(std::clamp(maximum.x, -1.0f, static_cast<float>(m_width) - 1.0f)));
+        int minY = static_cast<int>(std::floor(std::clamp(minimum.y, 0.0f, static_cast<float>(m_height))));
+        int maxY = static_cast<int>(std::floor(std::clamp(maximum.y, -1.0f, static_cast<float>(m_height) - 1.0f)));
+        if (minX > maxX || minY > maxY)
+        {
+            return false; // off screen, that's the frustum test's call
+        }
+
+        for (int tileY = minY / static_cast<int>(TILE_SIZE); tileY <= maxY / static_cast<int>(TILE_SIZE); tileY++)
+        {
+            for (int tileX = minX / static_cast<int>(TILE_SIZE); tileX <= maxX / static_cast<int>(TILE_SIZE); tileX++)
+            {
+                if (m_tileMaxDepth[tileY * m_tilesX + tileX] < f_nearest)
+                {
+                    continue; // everything drawn in the tile is in front of the sphere
+                }
+
+                int columnBegin = std::max(minX, tileX * static_cast<int>(TILE_SIZE));
+                int columnEnd = std::min(maxX + 1, (tileX + 1) * static_cast<int>(TILE_SIZE));
+                int rowBegin = std::max(minY, tileY * static_cast<int>(TILE_SIZE));
+                int rowEnd = std::min(maxY + 1, (tileY + 1) * static_cast<int>(TILE_SIZE));
+
+                for (int y = rowBegin; y < rowEnd; y++)
+                {
+                    const float* depthRow = &m_depth[y * m_width];
+
+                #ifdef OCCLUSION_SSE
+                    if (b_simd)
+                    {
+                        // Whole groups of four, with the pixels outside the rectangle masked off
+                        __m128 nearest = _mm_set1_ps(f_nearest);
+                        __m128i first = _mm_set1_epi32(columnBegin - 1);
+                        __m128i last = _mm_set1_epi32(columnEnd);
+                        for (int x = columnBegin & ~3; x < columnEnd; x += 4)
+                        {
+                            __m128i column = _mm_add_epi32(_mm_set1_epi32(x), _mm_setr_epi32(0, 1, 2, 3));
+                            __m128 inside = _mm_castsi128_ps(_mm_and_si128(_mm_cmpgt_epi32(column, first), _mm_cmplt_epi32(column, last)));
+                            __m128 behind = _mm_cmpge_ps(_mm_loadu_ps(depthRow + x), nearest);
+                            if (_mm_movemask_ps(_mm_and_ps(inside, behind)) != 0)
+                            {
+                                return false; // the sphere is in front of what's drawn here
+                            }
+                        }
+                        continue;
+                    }
+                #endif
+
+                    for (int x = columnBegin; x < columnEnd; x++)
+                    {
+                        if (depthRow[x] >= f_nearest)
+                        {
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+
+    void OcclusionRasterizer::TestSpheres(const float* centerX, const float* centerY, const float* centerZ, const float* radius, uint32_t count, uint8_t* visible)
+    {
+        TestSpheresWith(centerX, centerY, centerZ, radius, count, visible, m_b_simd);
+    }
+
+    void OcclusionRasterizer::TestSpheresWith(const float* centerX, const float* centerY, const float* centerZ, const float* radius, uint32_t count, uint8_t* visible, bool b_simd)
+    {
+        uint32_t ui_tested = 0;
+        uint32_t ui_occluded = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            // Only what's still visible is worth testing
+            if (visible[i])
+            {
+                ui_tested++;
+                if (IsOccluded(glm::vec3(centerX[i], centerY[i], centerZ[i]), radius[i], b_simd))
+                {
+                    visible[i] = 0;
+                    ui_occluded++;
+                }
+            }
+        }
+        m_totalTested += ui_tested;
+        m_totalOccluded += ui_occluded;
+    }
+
+    uint32_t OcclusionRasterizer::GetWidth()
+    {
+        return m_width;
+    }
+
+    uint32_t OcclusionRasterizer::GetHeight()
+    {
+        return m_height;
+    }
+
+    void OcclusionRasterizer::PrintStats()
+    {
+        uint32_t ui_frames = std::max(m_frames, 1u);
+        size_t triangleCount = m_triangles.size();
+        std::cout << "software occlusion: " << m_width << "x" << m_height << ", " << m_occluders.size() << " occluders (" << triangleCount << " triangles, " << m_totalTrianglesDrawn / ui_frames
+            << " rasterized per frame on average) in " << m_rasterTimeMs / ui_frames << " ms per frame, " << m_totalTested.load() / ui_frames << " spheres tested and "
+            << m_totalOccluded.load() / ui_frames << " occluded per frame on average" << std::endl;
+    }
+
+    void OcclusionRasterizer::RunBenchmark(const std::string& occluderPath, const std::string& candidatePath, uint32_t sphereCount, uint32_t width, uint32_t height, JobSystem& jobSystem)
+    {
+        const uint32_t ui_iterations = 20;
+
+        JobSystem singleThread;
+        singleThread.Init(0);
+
+        // The occluder scaled up in the middle, looked at from a corner so its walls stand between the camera and a good share of the candidates
+        OcclusionRasterizer rasterizer;
+        rasterizer.SetResolution(width, height);
+        rasterizer.AddOccluder(0, occluderPath, jobSystem);
+        rasterizer.m_transforms.assign(1, glm::scale(glm::mat4(1.0f), glm::vec3(4.0f)));
+
+        glm::mat4 proj = glm::perspective(glm::radians(45.0f), static_cast<float>(width) / static_cast<float>(height), 0.1f, 100.0f);
+        proj[1][1] *= -1;
+        glm::mat4 viewProj = proj * glm::lookAt(glm::vec3(8.0f, 8.0f, 3.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+
+        // Small copies of the candidate mesh scattered through and around it
+        Mesh candidate = Mesh(candidatePath);
+        candidate.Load(jobSystem);
+        MeshBounds bounds = candidate.GetBounds();
+        const float f_scale = 0.05f;
+        std::mt19937 random(1234); // same spheres every run
+        std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+        std::vector<float> centerX(sphereCount);
+        std::vector<float> centerY(sphereCount);
+        std::vector<float> centerZ(sphereCount);
+        std::vector<float> radius(sphereCount, bounds.radius * f_scale);
+        for (uint32_t i = 0; i < sphereCount; i++)
+        {
+            glm::vec3 center = bounds.center * f_scale + glm::vec3(distribution(random) * 16.0f - 10.0f, distribution(random) * 16.0f - 10.0f, distribution(random) * 4.0f);
+            centerX[i] = center.x;
+            centerY[i] = center.y;
+            centerZ[i] = center.z;
+        }
+
+        auto timeRaster = [&](bool b_simd, JobSystem& jobs, std::vector<float>& depth)
+        {
+            rasterizer.m_b_simd = b_simd;
+            auto start = std::chrono::high_resolution_clock::now();
+            for (uint32_t i = 0; i < ui_iterations; i++)
+            {
+                rasterizer.Rasterize(viewProj, glm::vec3(0.0f), jobs);
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            depth = rasterizer.m_depth;
+            return std::chrono::duration<float, std::chrono::milliseconds::period>(end - start).count() / ui_iterations;
+        };
+
+        auto timeTests = [&](bool b_simd, bool b_threaded, std::vector<uint8_t>& visible)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (uint32_t i = 0; i < ui_iterations; i++)
+            {
+                visible.assign(sphereCount, 1);
+                if (b_threaded)
+                {
+                    jobSystem.ParallelFor(sphereCount, VM_CULL_OBJECTS_PER_JOB, [&](uint32_t begin, uint32_t end, uint32_t threadIndex)
+                    {
+                        rasterizer.TestSpheresWith(&centerX[begin], &centerY[begin], &centerZ[begin], &radius[begin], end - begin, &visible[begin], b_simd);
+                    });
+                }
+                else
+                {
+                    rasterizer.TestSpheresWith(centerX.data(), centerY.data(), centerZ.data(), radius.data(), sphereCount, visible.data(), b_simd);
+                }
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            return std::chrono::duration<float, std::chrono::milliseconds::period>(end - start).count() / ui_iterations;
+        };
+
+        std::vector<float> referenceDepth;
+        float f_scalarRasterMs = timeRaster(false, singleThread, referenceDepth);
+        uint32_t ui_covered = static_cast<uint32_t>(std::count_if(referenceDepth.begin(), referenceDepth.end(), [](float depth) { return depth < 1.0f; }));
+        std::cout << "occlusion: " << occluderPath << " (" << rasterizer.m_triangles.size() << " triangles) into " << rasterizer.m_width << "x" << rasterizer.m_height << ", "
+            << ui_covered << " pixels covered, " << ui_iterations << " runs each" << std::endl;
+        std::cout << "  rasterize scalar, 1 thread: " << f_scalarRasterMs << " ms" << std::endl;
+
+    #ifdef OCCLUSION_SSE
+        const char* kernelName = "sse";
+    #else
+        const char* kernelName = "scalar";
+    #endif
+        for (int i = 0; i < 2; i++)
+        {
+            bool b_threaded = i == 1;
+            std::vector<float> depth;
+            float f_ms = timeRaster(true, b_threaded ? jobSystem : singleThread, depth);
+            std::cout << "  rasterize " << kernelName << ", " << (b_threaded ? jobSystem.GetThreadCount() : 1) << (b_threaded && jobSystem.GetThreadCount() > 1 ? " threads: " : " thread: ") << f_ms << " ms ("
+                << f_scalarRasterMs / std::max(f_ms, 0.001f) << "x), " << (depth == referenceDepth ? "matches scalar" : "DIFFERS FROM SCALAR") << std::endl;
+        }
+
+        std::vector<uint8_t> reference;
+        float f_scalarTestMs = timeTests(false, false, reference);
+        uint32_t ui_visible = static_cast<uint32_t>(std::count(reference.begin(), reference.end(), 1));
+        std::cout << "  " << sphereCount << " " << candidatePath << " spheres, " << sphereCount - ui_visible << " occluded" << std::endl;
+        std::cout << "  test scalar, 1 thread: " << f_scalarTestMs << " ms" << std::endl;
+        for (int i = 0; i < 2; i++)
+        {
+            bool b_threaded = i == 1;
+            std::vector<uint8_t> visible;
+            float f_ms = timeTests(true, b_threaded, visible);
+            std::cout << "  test " << kernelName << ", " << (b_threaded ? jobSystem.GetThreadCount() : 1) << (b_threaded && jobSystem.GetThreadCount() > 1 ? " threads: " : " thread: ") << f_ms << " ms ("
+                << f_scalarTestMs / std::max(f_ms, 0.001f) << "x), " << (visible == reference ? "matches scalar" : "DIFFERS FROM SCALAR") << std::endl;
+        }
+
+        singleThread.Shutdown();
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include "Structs.h"
+#include "JobSystem.h"
+
+#include <glm.hpp>
+
+#include <vector>
+#include <string>
+#include <atomic>
+
+
+namespace VCore
+{
+	class GameObject;
+
+	// Refer to - https://www.intel.com/content/www/us/en/developer/articles/technical/masked-software-occlusion-culling.html
+	// Low resolution software depth buffer for culling on the CPU, for when the GPU is the bottleneck. Objects flagged as occluders are rasterized into it every frame,
+	// then the FrustumCuller tests candidate bounding spheres against it on the job system's threads, before anything is recorded.
+	// Triangles are rasterized four pixels at a time with SSE (scalar elsewhere): a coverage mask from the three edge functions and the depth test picks which pixels take the new depth.
+	// Occluders under-cover: a triangle only writes the pixels it covers entirely, at the farthest depth it reaches inside each, so partly covered pixels along silhouettes stay open.
+	// The buffer is split into 8x8 tiles that also keep their farthest depth, so most tests never touch single pixels.
+	// Depth is Vulkan's 0 (near) to 1 (far). Occluders are only ever dropped, never guessed at, so a culled object is always hidden: triangles crossing the near plane
+	// or far outside the screen are skipped rather than clipped.
+	// RenderOccluders is main thread only, TestSpheres can run from any number of threads at once.
+	class OcclusionRasterizer
+	{
+	public:
+		OcclusionRasterizer();
+		~OcclusionRasterizer();
+
+		// Depth buffer size in pixels, rounded up to whole tiles. Lower is faster to fill and test but hides less. Call before Build
+		void SetResolution(uint32_t width, uint32_t height);
+		// Keeps a copy of the positions and indices of every object flagged with GameObject::SetOccluder. Call again if occluders are added or removed
+		void Build(std::vector<GameObject>& gameObjects, JobSystem& jobSystem);
+		void Cleanup();
+
+		// Clears the buffer and rasterizes every occluder as seen through viewProj, in bands of tile rows split across the job system.
+		// objectOffset is the offset the shaders add to every vertex (see FrustumCuller::SetObjectOffset). Call once per frame before any TestSpheres
+		void RenderOccluders(std::vector<GameObject>& gameObjects, const glm::mat4& viewProj, glm::vec3 objectOffset, JobSystem& jobSystem);
+		// Writes 0 to visible[i] if sphere i (structure of arrays, world space) is entirely behind the occluders, leaves it alone otherwise
+		void TestSpheres(const float* centerX, const float* centerY, const float* centerZ, const float* radius, uint32_t count, uint8_t* visible);
+
+		uint32_t GetWidth();
+		uint32_t GetHeight();
+		void PrintStats();
+
+		// Rasterizes occluderPath's mesh and tests sphereCount copies of candidatePath's mesh scattered behind and around it, scalar against SSE on one thread and across the job system,
+		// at a width x height buffer. Checks both kernels fill the same depth and cull the same spheres
+		static void RunBenchmark(const std::string& occluderPath, const std::string& candidatePath, uint32_t sphereCount, uint32_t width, uint32_t height, JobSystem& jobSystem);
+
+	private:
+		struct OccluderMesh
+		{
+			std::string path;
+			std::vector<glm::vec3> positions;
+			std::vector<uint32_t> indices;
+		};
+
+		struct Occluder
+		{
+			uint32_t object; // index into the game objects passed to Build
+			uint32_t mesh; // index into m_meshes
+			uint32_t firstVertex; // into m_screenVertices
+			uint32_t firstTriangle; // into m_triangles
+		};
+
+		// Set up once per frame, then rasterized by every band it overlaps
+		struct Triangle
+		{
+			float edgeA[3]; // edge function i at pixel center (x, y) is edgeA[i] * x + (edgeB[i] * y + edgeC[i]), every edge is >= 0 when the whole pixel is inside
+			float edgeB[3];
+			float edgeC[3];
+			float depthA; // farthest depth in the pixel centered at (x, y) is depthA * x + (depthB * y + depthC)
+			float depthB;
+			float depthC;
+			int minX; // pixel bounds, maxY is -1 when the triangle was skipped
+			int maxX;
+			int minY;
+			int maxY;
+		};
+
+		void AddOccluder(uint32_t object, const std::string& path, JobSystem& jobSystem);
+		// Everything RenderOccluders does once the occluders' transforms are in m_transforms
+		void Rasterize(const glm::mat4& viewProj, glm::vec3 objectOffset, JobSystem& jobSystem);
+		void SetupTriangles(const glm::vec4* screenVertices, const uint32_t* indices, uint32_t triangleCount, Triangle* triangles);
+		void RasterizeTileRow(uint32_t tileRow, bool b_simd);
+		bool IsOccluded(glm::vec3 center, float radius, bool b_simd);
+		void TestSpheresWith(const float* centerX, const float* centerY, const float* centerZ, const float* radius, uint32_t count, uint8_t* visible, bool b_simd);
+
+		uint32_t m_width;
+		uint32_t m_height;
+		uint32_t m_tilesX;
+		uint32_t m_tilesY;
+		std::vector<float> m_depth; // [row][column], cleared to 1
+		std::vector<float> m_tileMaxDepth; // [tile row][tile column], farthest depth in each tile
+		glm::mat4 m_viewProj; // of the last RenderOccluders
+		bool m_b_simd; // SSE kernels when available, the benchmark switches them off to time the scalar ones
+
+		std::vector<OccluderMesh> m_meshes;
+		std::vector<Occluder> m_occluders;
+		std::vector<glm::mat4> m_transforms; // of every occluder, copied from its object each frame
+		std::vector<glm::vec4> m_screenVertices; // pixel x, pixel y, depth, 0 if the vertex is in front of the near plane (1 otherwise)
+		std::vector<Triangle> m_triangles;
+
+		// stats
+		std::atomic<uint64_t> m_totalTested;
+		std::atomic<uint64_t> m_totalOccluded;
+		uint64_t m_totalTrianglesDrawn;
+		float m_rasterTimeMs;
+		uint32_t m_frames;
+	};
+}
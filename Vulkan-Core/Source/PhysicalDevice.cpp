@@ -3,6 +3,7 @@
 #include "PhysicalDevice.h"
 #include "Structs.h"
 #include "Helper.h"
+#include "Config.h"
 
 #include <stdexcept>
 #include <vector>
@@ -15,6 +16,9 @@ namespace VCore
         m_physicalDevice = VK_NULL_HANDLE;
         m_physicalDeviceProperties = VkPhysicalDeviceProperties();
         m_msaaSamples = VK_SAMPLE_COUNT_1_BIT;
+        m_b_bindlessSupported = false;
+        m_b_drawIndirectCountSupported = false;
+        m_b_drawIndirectFirstInstanceSupported = false;
     }
 
     PhysicalDevice::~PhysicalDevice()
@@ -27,6 +31,11 @@ namespace VCore
         return m_physicalDevice;
     }
 
+    VkPhysicalDeviceProperties& PhysicalDevice::GetProperties()
+    {
+        return m_physicalDeviceProperties;
+    }
+
     void PhysicalDevice::Init(VkInstance instance, VkSurfaceKHR surface)
     {
         PickPhysicalDevice(instance, surface);
@@ -56,6 +65,47 @@ namespace VCore
                 vkGetPhysicalDeviceProperties(device, &m_physicalDeviceProperties);
                 m_physicalDevice = device;
                 m_msaaSamples = Helper::GetMaxUsableSampleCount(device);
+
+                VkPhysicalDeviceFeatures deviceFeatures;
+                vkGetPhysicalDeviceFeatures(device, &deviceFeatures);
+                m_b_drawIndirectFirstInstanceSupported = deviceFeatures.drawIndirectFirstInstance;
+
+                // Features2 is core from 1.1, and the 1.2 feature struct needs a 1.2 device
+                if (m_physicalDeviceProperties.apiVersion >= VK_API_VERSION_1_2)
+                {
+                    VkPhysicalDeviceVulkan12Features vulkan12Features{};
+                    vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+                    VkPhysicalDeviceFeatures2 features2{};
+                    features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+                    features2.pNext = &vulkan12Features;
+                    vkGetPhysicalDeviceFeatures2(device, &features2);
+
+                    // bindless.vert picks its object buffer with a push constant, which is dynamically uniform indexing of a storage buffer array
+                    bool b_bindlessFeatures = vulkan12Features.descriptorIndexing && vulkan12Features.runtimeDescriptorArray && vulkan12Features.descriptorBindingPartiallyBound &&
+                        vulkan12Features.shaderSampledImageArrayNonUniformIndexing && vulkan12Features.descriptorBindingSampledImageUpdateAfterBind &&
+                        vulkan12Features.descriptorBindingStorageBufferUpdateAfterBind && vulkan12Features.descriptorBindingUpdateUnusedWhilePending &&
+                        features2.features.shaderStorageBufferArrayDynamicIndexing;
+
+                    // The table's set is update after bind, so its arrays count against these limits rather than the regular ones. The texture array is fragment only,
+                    // the object buffers are also read by the fragment stage, so that stage sees both
+                    VkPhysicalDeviceVulkan12Properties vulkan12Properties{};
+                    vulkan12Properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+                    VkPhysicalDeviceProperties2 properties2{};
+                    properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+                    properties2.pNext = &vulkan12Properties;
+                    vkGetPhysicalDeviceProperties2(device, &properties2);
+
+                    bool b_bindlessLimits = vulkan12Properties.maxDescriptorSetUpdateAfterBindSampledImages >= VM_BINDLESS_MAX_TEXTURES &&
+                        vulkan12Properties.maxDescriptorSetUpdateAfterBindSamplers >= VM_BINDLESS_MAX_TEXTURES &&
+                        vulkan12Properties.maxDescriptorSetUpdateAfterBindStorageBuffers >= VM_BINDLESS_MAX_BUFFERS &&
+                        vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSampledImages >= VM_BINDLESS_MAX_TEXTURES &&
+                        vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSamplers >= VM_BINDLESS_MAX_TEXTURES &&
+                        vulkan12Properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers >= VM_BINDLESS_MAX_BUFFERS &&
+                        vulkan12Properties.maxPerStageUpdateAfterBindResources >= VM_BINDLESS_MAX_TEXTURES + VM_BINDLESS_MAX_BUFFERS;
+
+                    m_b_bindlessSupported = b_bindlessFeatures && b_bindlessLimits;
+                    m_b_drawIndirectCountSupported = vulkan12Features.drawIndirectCount;
+                }
                 break;
             }
         }
@@ -70,6 +120,15 @@ namespace VCore
     {
         QueueFamilyIndices indices = Helper::FindQueueFamilies(physicalDevice, surface); // Get QueueFamilies
 
+        // Headless rendering has no surface, so the swap chain extension and swap chain support don't matter
+        if (surface == VK_NULL_HANDLE)
+        {
+            VkPhysicalDeviceFeatures supportedFeatures;
+            vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
+            return indices.isComplete() && supportedFeatures.samplerAnisotropy;
+        }
+
         bool b_extensionsSupported = Helper::CheckDeviceExtensionSupport(physicalDevice); // Check for extension support
 
         bool b_swapChainAdequate = false;
@@ -112,6 +171,21 @@ namespace VCore
         return score;
     }
 
+    bool PhysicalDevice::SupportsBindless()
+    {
+        return m_b_bindlessSupported;
+    }
+
+    bool PhysicalDevice::SupportsDrawIndirectCount()
+    {
+        return m_b_drawIndirectCountSupported;
+    }
+
+    bool PhysicalDevice::SupportsDrawIndirectFirstInstance()
+    {
+        return m_b_drawIndirectFirstInstanceSupported;
+    }
+
     uint32_t PhysicalDevice::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
     {
         // Refer to - https://vulkan-tutorial.com/en/Vertex_buffers/Vertex_buffer_creation
@@ -13,10 +13,17 @@ namespace VCore
         ~PhysicalDevice();
 
         VkPhysicalDevice GetDevice();
+        VkPhysicalDeviceProperties& GetProperties();
         void Init(VkInstance instance, VkSurfaceKHR surface);
         void PickPhysicalDevice(VkInstance instance, VkSurfaceKHR surface);
         bool IsDeviceSuitable(VkPhysicalDevice device, VkSurfaceKHR surface);
         int RateDeviceSuitability(VkPhysicalDevice device);
+        // Vulkan 1.2 with the descriptor indexing features BindlessTable and bindless.vert need, and update after bind limits that fit the table's arrays
+        bool SupportsBindless();
+        // Vulkan 1.2 drawIndirectCount, GpuCuller falls back to plain indirect draws without it
+        bool SupportsDrawIndirectCount();
+        // Indirect draws with a firstInstance other than 0, GpuCuller can't be used without it
+        bool SupportsDrawIndirectFirstInstance();
         uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
         void Cleanup();
 
@@ -24,5 +31,8 @@ namespace VCore
         VkPhysicalDevice m_physicalDevice;
         VkPhysicalDeviceProperties m_physicalDeviceProperties;
         VkSampleCountFlagBits m_msaaSamples;
+        bool m_b_bindlessSupported;
+        bool m_b_drawIndirectCountSupported;
+        bool m_b_drawIndirectFirstInstanceSupported;
     };
 }
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "PipelineCache.h"
+#include "Helper.h"
+
+#include <stdexcept>
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+#include <iostream>
+
+
+namespace VCore
+{
+    static const uint32_t PIPELINE_CACHE_FILE_VERSION = 1;
+
+    PipelineCache::PipelineCache()
+    {
+        m_pipelineCache = VK_NULL_HANDLE;
+        m_path = "";
+        m_b_loadedFromDisk = false;
+    }
+
+    PipelineCache::~PipelineCache()
+    {
+    }
+
+    void PipelineCache::Init(PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice, const std::string& path)
+    {
+        m_path = path;
+
+        std::vector<char> initialData;
+        m_b_loadedFromDisk = ReadCacheFile(physicalDevice, initialData);
+
+        VkPipelineCacheCreateInfo cacheInfo{};
+        cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cacheInfo.initialDataSize = m_b_loadedFromDisk ? initialData.size() : 0;
+        cacheInfo.pInitialData = m_b_loadedFromDisk ? initialData.data() : nullptr;
+
+        if (vkCreatePipelineCache(logicalDevice.GetDevice(), &cacheInfo, nullptr, &m_pipelineCache) != VK_SUCCESS)
+        {
+            // The driver is still allowed to reject data that passed our checks, start empty in that case
+            cacheInfo.initialDataSize = 0;
+            cacheInfo.pInitialData = nullptr;
+            m_b_loadedFromDisk = false;
+
+            if (vkCreatePipelineCache(logicalDevice.GetDevice(), &cacheInfo, nullptr, &m_pipelineCache) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create pipeline cache!");
+            }
+        }
+    }
+
+    bool PipelineCache::ReadCacheFile(PhysicalDevice& physicalDevice, std::vector<char>& data)
+    {
+        std::ifstream file(m_path, std::ios::ate | std::ios::binary);
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        size_t fileSize = static_cast<size_t>(file.tellg());
+        if (fileSize < sizeof(FileHeader) + sizeof(VkPipelineCacheHeaderVersionOne))
+        {
+            return false;
+        }
+
+        FileHeader header;
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+        if (memcmp(header.magic, "VPSO", 4) != 0 || header.version != PIPELINE_CACHE_FILE_VERSION || header.dataSize != fileSize - sizeof(FileHeader))
+        {
+            return false;
+        }
+
+        data.resize(static_cast<size_t>(header.dataSize));
+        file.read(data.data(), data.size());
+        if (!file.good() || Helper::Hash64(data.data(), data.size()) != header.dataChecksum)
+        {
+            return false;
+        }
+
+        // Every driver's cache data starts with this header - make sure it came from this driver and device
+        VkPipelineCacheHeaderVersionOne cacheHeader;
+        memcpy(&cacheHeader, data.data(), sizeof(cacheHeader));
+
+        const VkPhysicalDeviceProperties& properties = physicalDevice.GetProperties();
+        if (cacheHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE || cacheHeader.headerSize < sizeof(VkPipelineCacheHeaderVersionOne) ||
+            cacheHeader.vendorID != properties.vendorID || cacheHeader.deviceID != properties.deviceID ||
+            memcmp(cacheHeader.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+        {
+            std::cout << "pipeline cache " << m_path << " was written by a different driver or device, starting with an empty cache" << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    void PipelineCache::Save(LogicalDevice& logicalDevice)
+    {
+        if (m_pipelineCache == VK_NULL_HANDLE || m_path.empty())
+        {
+            return;
+        }
+
+        size_t dataSize = 0;
+        if (vkGetPipelineCacheData(logicalDevice.GetDevice(), m_pipelineCache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0)
+        {
+            return;
+        }
+
+        std::vector<char> data(dataSize);
+        if (vkGetPipelineCacheData(logicalDevice.GetDevice(), m_pipelineCache, &dataSize, data.data()) != VK_SUCCESS)
+        {
+            return;
+        }
+        data.resize(dataSize);
+
+        FileHeader header{};
+        memcpy(header.magic, "VPSO", 4);
+        header.version = PIPELINE_CACHE_FILE_VERSION;
+        header.dataSize = dataSize;
+        header.dataChecksum = Helper::Hash64(data.data(), data.size());
+
+        // Write to a temporary file and rename over the old one so a crash mid write can't leave a truncated cache behind
+        std::string tempPath = m_path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+            {
+                return;
+            }
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(data.data(), data.size());
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, m_path, error);
+        if (error)
+        {
+            std::filesystem::remove(tempPath, error);
+        }
+    }
+
+    void PipelineCache::Cleanup(LogicalDevice& logicalDevice)
+    {
+        vkDestroyPipelineCache(logicalDevice.GetDevice(), m_pipelineCache, nullptr);
+        m_pipelineCache = VK_NULL_HANDLE;
+    }
+
+    VkPipelineCache PipelineCache::GetPipelineCache()
+    {
+        return m_pipelineCache;
+    }
+
+    bool PipelineCache::WasLoadedFromDisk()
+    {
+        return m_b_loadedFromDisk;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+#include "PhysicalDevice.h"
+#include "LogicalDevice.h"
+
+#define GLFW_INCLUDE_VULKAN
+#include <glfw3.h>
+
+#include <string>
+#include <vector>
+
+
+namespace VCore
+{
+	// Refer to - https://docs.vulkan.org/spec/latest/chapters/pipelines.html#pipelines-cache
+	// VkPipelineCache persisted to disk between runs, so pipelines whose shaders the driver has already compiled are pulled straight out of the cache.
+	// The saved data is only handed back to the driver if it was written by the same driver on the same device (vendor, device id and pipelineCacheUUID in the cache header) and our checksum still matches -
+	// some drivers don't cope well with cache data that isn't theirs.
+	class PipelineCache
+	{
+	public:
+		PipelineCache();
+		~PipelineCache();
+
+		// Creates the cache, seeded from path if the file exists and is valid for this device
+		void Init(PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice, const std::string& path);
+		void Save(LogicalDevice& logicalDevice);
+		void Cleanup(LogicalDevice& logicalDevice);
+		VkPipelineCache GetPipelineCache();
+		bool WasLoadedFromDisk();
+
+	private:
+		struct FileHeader
+		{
+			char magic[4]; // "VPSO"
+			uint32_t version;
+			uint64_t dataSize;
+			uint64_t dataChecksum;
+		};
+
+		bool ReadCacheFile(PhysicalDevice& physicalDevice, std::vector<char>& data);
+
+		VkPipelineCache m_pipelineCache;
+		std::string m_path;
+		bool m_b_loadedFromDisk;
+	};
+}
@@ -0,0 +1,113 @@
+#include "PipelineCompiler.h"
+
+#include <iostream>
+#include <algorithm>
+
+
+namespace VCore
+{
+    PipelineCompiler::PipelineCompiler()
+    {
+        m_pendingCount = 0;
+        m_compileLatenciesMs = std::vector<float>();
+        m_failedCompiles = 0;
+        m_affectedFrames = 0;
+        m_skippedDraws = 0;
+        m_fallbackDraws = 0;
+    }
+
+    PipelineCompiler::~PipelineCompiler()
+    {
+    }
+
+    void PipelineCompiler::Init(uint32_t threadCount)
+    {
+        // Separate from the draw recording JobSystem on purpose - a ParallelFor there would otherwise pick up a compile while helping and stall the frame
+        m_jobSystem.Init(threadCount);
+    }
+
+    void PipelineCompiler::Shutdown()
+    {
+        WaitIdle();
+        m_jobSystem.Shutdown();
+    }
+
+    void PipelineCompiler::Compile(std::shared_ptr<Material> material, WinSys& winSystem, RenderPass& renderPass, PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice)
+    {
+        auto queuedTime = std::chrono::high_resolution_clock::now();
+        m_pendingCount++;
+        // Read here rather than on the worker, the swap chain may be recreated while the compile waits in the queue
+        VkSampleCountFlagBits samples = winSystem.GetMsaa();
+
+        m_jobSystem.Submit([this, material, samples, &renderPass, &pipelineRegistry, &logicalDevice, queuedTime]()
+        {
+            try
+            {
+                material->CreateGraphicsPipeline(logicalDevice, samples, renderPass, pipelineRegistry);
+
+                auto readyTime = std::chrono::high_resolution_clock::now();
+                std::lock_guard<std::mutex> lock(m_statsMutex);
+                m_compileLatenciesMs.push_back(std::chrono::duration<float, std::chrono::milliseconds::period>(readyTime - queuedTime).count());
+            }
+            catch (const std::exception& e)
+            {
+                // Nothing to rethrow to, the material never becomes ready and is skipped or drawn with its fallback from now on
+                std::cerr << "pipeline compile failed: " << e.what() << std::endl;
+                material->MarkPipelineFailed();
+                std::lock_guard<std::mutex> lock(m_statsMutex);
+                m_failedCompiles++;
+            }
+            catch (...)
+            {
+                // Anything escaping the job would take down the worker thread with it
+                std::cerr << "pipeline compile failed: unknown exception" << std::endl;
+                material->MarkPipelineFailed();
+                std::lock_guard<std::mutex> lock(m_statsMutex);
+                m_failedCompiles++;
+            }
+
+            m_pendingCount--;
+        });
+    }
+
+    void PipelineCompiler::WaitIdle()
+    {
+        while (m_pendingCount.load() > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    uint32_t PipelineCompiler::GetPendingCount()
+    {
+        return m_pendingCount.load();
+    }
+
+    void PipelineCompiler::RecordFrame(uint32_t skippedDraws, uint32_t fallbackDraws)
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        if (skippedDraws > 0 || fallbackDraws > 0)
+        {
+            m_affectedFrames++;
+        }
+        m_skippedDraws += skippedDraws;
+        m_fallbackDraws += fallbackDraws;
+    }
+
+    void PipelineCompiler::PrintStats()
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+
+        float f_totalMs = 0.0f;
+        float f_maxMs = 0.0f;
+        for (float latency : m_compileLatenciesMs)
+        {
+            f_totalMs += latency;
+            f_maxMs = std::max(f_maxMs, latency);
+        }
+        float f_averageMs = m_compileLatenciesMs.empty() ? 0.0f : f_totalMs / m_compileLatenciesMs.size();
+
+        std::cout << "pipeline compiles: " << m_compileLatenciesMs.size() << " done, " << m_failedCompiles << " failed, " << m_pendingCount.load() << " pending, latency avg " << f_averageMs << " ms / max " << f_maxMs << " ms, "
+            << m_affectedFrames << " frames affected (" << m_skippedDraws << " draws skipped, " << m_fallbackDraws << " drawn with a fallback)" << std::endl;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include "Material.h"
+#include "JobSystem.h"
+#include "PipelineRegistry.h"
+#include "LogicalDevice.h"
+#include "WinSys.h"
+#include "RenderPass.h"
+
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+
+
+namespace VCore
+{
+	// Compiles Material pipelines on its own worker threads so the frame loop never waits on the driver's shader compiler.
+	// Until a material's pipeline is ready, RenderPass skips its objects (or draws them with the material's fallback), and those frames are counted here.
+	class PipelineCompiler
+	{
+	public:
+		PipelineCompiler();
+		~PipelineCompiler();
+
+		void Init(uint32_t threadCount);
+		// Waits for compiles still in flight, call before the device or anything the compiles use goes away
+		void Shutdown();
+
+		// Queues material's pipeline. Its descriptor set layout has to exist already (Material::CreateMaterialResources). The sample count is taken from
+		// winSystem now, renderPass and pipelineRegistry have to stay alive until the compile finishes. A compile that throws marks the material's pipeline as failed
+		void Compile(std::shared_ptr<Material> material, WinSys& winSystem, RenderPass& renderPass, PipelineRegistry& pipelineRegistry, LogicalDevice& logicalDevice);
+		void WaitIdle();
+		uint32_t GetPendingCount();
+
+		// Called once per frame with how many draws couldn't use their own pipeline
+		void RecordFrame(uint32_t skippedDraws, uint32_t fallbackDraws);
+		void PrintStats();
+
+	private:
+		JobSystem m_jobSystem;
+		std::atomic<uint32_t> m_pendingCount;
+
+		// stats
+		std::mutex m_statsMutex;
+		std::vector<float> m_compileLatenciesMs; // queued -> ready
+		uint32_t m_failedCompiles;
+		uint64_t m_affectedFrames;
+		uint64_t m_skippedDraws;
+		uint64_t m_fallbackDraws;
+	};
+}
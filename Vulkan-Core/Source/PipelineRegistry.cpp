@@ -0,0 +1,293 @@
+#include "PipelineRegistry.h"
+#include "Helper.h"
+
+#include <stdexcept>
+#include <iostream>
+
+
+namespace VCore
+{
+    PipelineRegistry::PipelineRegistry()
+    {
+        m_pipelineCache = PipelineCache();
+        m_setLayouts = std::unordered_map<uint64_t, std::vector<SetLayoutEntry>>();
+        m_pipelines = std::unordered_map<uint64_t, std::vector<PipelineEntry>>();
+        m_pipelinesCreated = 0;
+        m_pipelinesShared = 0;
+        m_setLayoutsCreated = 0;
+        m_setLayoutsShared = 0;
+        m_hashCollisions = 0;
+    }
+
+    PipelineRegistry::~PipelineRegistry()
+    {
+    }
+
+    void PipelineRegistry::Init(PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice, const std::string& cachePath)
+    {
+        m_pipelineCache.Init(physicalDevice, logicalDevice, cachePath);
+    }
+
+    void PipelineRegistry::Cleanup(LogicalDevice& logicalDevice)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_pipelineCache.Save(logicalDevice);
+        m_pipelineCache.Cleanup(logicalDevice);
+
+        for (std::pair<const uint64_t, std::vector<PipelineEntry>>& bucket : m_pipelines)
+        {
+            for (PipelineEntry& entry : bucket.second)
+            {
+                vkDestroyPipeline(logicalDevice.GetDevice(), entry.pipeline, nullptr);
+                vkDestroyPipelineLayout(logicalDevice.GetDevice(), entry.layout, nullptr);
+            }
+        }
+        m_pipelines.clear();
+
+        for (std::pair<const uint64_t, std::vector<SetLayoutEntry>>& bucket : m_setLayouts)
+        {
+            for (SetLayoutEntry& entry : bucket.second)
+            {
+                vkDestroyDescriptorSetLayout(logicalDevice.GetDevice(), entry.layout, nullptr);
+            }
+        }
+        m_setLayouts.clear();
+    }
+
+    VkPipelineCache PipelineRegistry::GetPipelineCache()
+    {
+        return m_pipelineCache.GetPipelineCache();
+    }
+
+    VkPipeline PipelineRegistry::CreateComputePipeline(const std::string& shaderPath, VkPipelineLayout pipelineLayout, LogicalDevice& logicalDevice)
+    {
+        // Refer to - https://vulkan-tutorial.com/Compute_Shader
+        std::vector<char> shaderCode = Helper::ReadFile(shaderPath);
+
+        VkShaderModuleCreateInfo moduleInfo{};
+        moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = shaderCode.size();
+        moduleInfo.pCode = reinterpret_cast<const uint32_t*>(shaderCode.data());
+
+        VkShaderModule shaderModule = VK_NULL_HANDLE;
+        if (vkCreateShaderModule(logicalDevice.GetDevice(), &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create compute shader module!");
+        }
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = shaderModule;
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = pipelineLayout;
+
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VkResult result = vkCreateComputePipelines(logicalDevice.GetDevice(), GetPipelineCache(), 1, &pipelineInfo, nullptr, &pipeline);
+        vkDestroyShaderModule(logicalDevice.GetDevice(), shaderModule, nullptr);
+        if (result != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create compute pipeline!");
+        }
+
+        return pipeline;
+    }
+
+    VkDescriptorSetLayout PipelineRegistry::AcquireDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings, LogicalDevice& logicalDevice, VkDescriptorSetLayoutCreateFlags flags, const std::vector<VkDescriptorBindingFlags>& bindingFlags)
+    {
+        if (!bindingFlags.empty() && bindingFlags.size() != bindings.size())
+        {
+            throw std::runtime_error("failed to create descriptor set layout, binding flags don't match the bindings!");
+        }
+
+        // Key on the fields one by one, the struct itself has a pointer in it (immutable samplers aren't used here)
+        std::vector<uint32_t> keyData;
+        keyData.push_back(static_cast<uint32_t>(flags));
+        for (size_t i = 0; i < bindings.size(); i++)
+        {
+            const VkDescriptorSetLayoutBinding& binding = bindings[i];
+            uint32_t ui_bindingFlags = bindingFlags.empty() ? 0 : static_cast<uint32_t>(bindingFlags[i]);
+            keyData.insert(keyData.end(), { binding.binding, static_cast<uint32_t>(binding.descriptorType), binding.descriptorCount, static_cast<uint32_t>(binding.stageFlags), ui_bindingFlags });
+        }
+        uint64_t key = Helper::Hash64(keyData.data(), keyData.size() * sizeof(uint32_t));
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // The hash only picks the bucket, the key itself has to match too
+        std::vector<SetLayoutEntry>& entries = m_setLayouts[key];
+        for (SetLayoutEntry& entry : entries)
+        {
+            if (entry.keyData == keyData)
+            {
+                entry.refCount++;
+                m_setLayoutsShared++;
+                return entry.layout;
+            }
+        }
+        if (!entries.empty())
+        {
+            m_hashCollisions++;
+        }
+
+        // Refer to - https://vulkan-tutorial.com/en/Uniform_buffers/Descriptor_layout_and_buffer
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.flags = flags;
+        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutInfo.pBindings = bindings.data();
+
+        // Refer to - https://docs.vulkan.org/samples/latest/samples/extensions/descriptor_indexing/README.html
+        VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+        bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        bindingFlagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+        bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+        if (!bindingFlags.empty())
+        {
+            layoutInfo.pNext = &bindingFlagsInfo;
+        }
+
+        SetLayoutEntry entry;
+        if (vkCreateDescriptorSetLayout(logicalDevice.GetDevice(), &layoutInfo, nullptr, &entry.layout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create descriptor set layout!");
+        }
+        entry.keyData = std::move(keyData);
+        entry.refCount = 1;
+        entries.push_back(std::move(entry));
+        m_setLayoutsCreated++;
+
+        return entries.back().layout;
+    }
+
+    void PipelineRegistry::ReleaseDescriptorSetLayout(VkDescriptorSetLayout descriptorSetLayout, LogicalDevice& logicalDevice)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (auto bucket = m_setLayouts.begin(); bucket != m_setLayouts.end(); bucket++)
+        {
+            std::vector<SetLayoutEntry>& entries = bucket->second;
+            for (auto it = entries.begin(); it != entries.end(); it++)
+            {
+                if (it->layout == descriptorSetLayout)
+                {
+                    if (--it->refCount == 0)
+                    {
+                        vkDestroyDescriptorSetLayout(logicalDevice.GetDevice(), it->layout, nullptr);
+                        entries.erase(it);
+                        if (entries.empty())
+                        {
+                            m_setLayouts.erase(bucket);
+                        }
+                    }
+                    return;
+                }
+            }
+        }
+    }
+
+    bool PipelineRegistry::AcquirePipeline(const std::vector<char>& key, VkPipeline& pipeline, VkPipelineLayout& pipelineLayout)
+    {
+        uint64_t hash = Helper::Hash64(key.data(), key.size());
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto bucket = m_pipelines.find(hash);
+        if (bucket == m_pipelines.end())
+        {
+            return false;
+        }
+
+        for (PipelineEntry& entry : bucket->second)
+        {
+            if (entry.keyData == key)
+            {
+                entry.refCount++;
+                m_pipelinesShared++;
+                pipeline = entry.pipeline;
+                pipelineLayout = entry.layout;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void PipelineRegistry::AddPipeline(const std::vector<char>& key, VkPipeline& pipeline, VkPipelineLayout& pipelineLayout, LogicalDevice& logicalDevice)
+    {
+        uint64_t hash = Helper::Hash64(key.data(), key.size());
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::vector<PipelineEntry>& entries = m_pipelines[hash];
+        for (PipelineEntry& entry : entries)
+        {
+            if (entry.keyData == key)
+            {
+                // Lost a race with another thread building the same pipeline - keep theirs
+                vkDestroyPipeline(logicalDevice.GetDevice(), pipeline, nullptr);
+                vkDestroyPipelineLayout(logicalDevice.GetDevice(), pipelineLayout, nullptr);
+
+                entry.refCount++;
+                m_pipelinesShared++;
+                pipeline = entry.pipeline;
+                pipelineLayout = entry.layout;
+                return;
+            }
+        }
+        if (!entries.empty())
+        {
+            m_hashCollisions++;
+        }
+
+        PipelineEntry entry;
+        entry.keyData = key;
+        entry.pipeline = pipeline;
+        entry.layout = pipelineLayout;
+        entry.refCount = 1;
+        entries.push_back(std::move(entry));
+        m_pipelinesCreated++;
+    }
+
+    void PipelineRegistry::ReleasePipeline(const std::vector<char>& key, LogicalDevice& logicalDevice)
+    {
+        uint64_t hash = Helper::Hash64(key.data(), key.size());
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto bucket = m_pipelines.find(hash);
+        if (bucket == m_pipelines.end())
+        {
+            return;
+        }
+
+        std::vector<PipelineEntry>& entries = bucket->second;
+        for (auto it = entries.begin(); it != entries.end(); it++)
+        {
+            if (it->keyData == key)
+            {
+                if (--it->refCount == 0)
+                {
+                    vkDestroyPipeline(logicalDevice.GetDevice(), it->pipeline, nullptr);
+                    vkDestroyPipelineLayout(logicalDevice.GetDevice(), it->layout, nullptr);
+                    entries.erase(it);
+                    if (entries.empty())
+                    {
+                        m_pipelines.erase(bucket);
+                    }
+                }
+                return;
+            }
+        }
+    }
+
+    void PipelineRegistry::PrintStats()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::cout << "pipelines: " << m_pipelinesCreated << " created, " << m_pipelinesShared << " shared, "
+            << m_setLayoutsCreated << " descriptor set layouts created, " << m_setLayoutsShared << " shared (" << m_hashCollisions << " hash collisions), pipeline cache "
+            << (m_pipelineCache.WasLoadedFromDisk() ? "loaded from disk" : "started empty") << std::endl;
+    }
+}
\ No newline at end of file
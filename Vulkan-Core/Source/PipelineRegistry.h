@@ -0,0 +1,73 @@
+#pragma once
+#include "PhysicalDevice.h"
+#include "LogicalDevice.h"
+#include "PipelineCache.h"
+
+#define GLFW_INCLUDE_VULKAN
+#include <glfw3.h>
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <mutex>
+
+
+namespace VCore
+{
+	// Shares descriptor set layouts, pipeline layouts and pipelines between Materials. Materials with the same bindings get the same descriptor set layout, and materials with the
+	// same shader bytes and pipeline state (which then includes the same descriptor set layout) get the same VkPipeline, so only the first one pays for shader compilation.
+	// Everything is reference counted and destroyed when the last Material lets go. Thread safe.
+	class PipelineRegistry
+	{
+	public:
+		PipelineRegistry();
+		~PipelineRegistry();
+
+		void Init(PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice, const std::string& cachePath);
+		// Saves the pipeline cache to disk and destroys anything still registered
+		void Cleanup(LogicalDevice& logicalDevice);
+		VkPipelineCache GetPipelineCache();
+		// Builds a compute pipeline from shaderPath (SPIR-V) through the pipeline cache. It isn't registered, the caller destroys it
+		VkPipeline CreateComputePipeline(const std::string& shaderPath, VkPipelineLayout pipelineLayout, LogicalDevice& logicalDevice);
+
+		// flags and bindingFlags (empty, or one per binding) are part of the key as well as the bindings, an update after bind layout never matches a regular one
+		VkDescriptorSetLayout AcquireDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings, LogicalDevice& logicalDevice, VkDescriptorSetLayoutCreateFlags flags = 0, const std::vector<VkDescriptorBindingFlags>& bindingFlags = {});
+		void ReleaseDescriptorSetLayout(VkDescriptorSetLayout descriptorSetLayout, LogicalDevice& logicalDevice);
+
+		// key is every byte the pipeline was built from. It's hashed to find the bucket and then compared in full, so a hash collision can't hand out the wrong pipeline
+		// If a pipeline with this key exists, takes a reference to it and returns true
+		bool AcquirePipeline(const std::vector<char>& key, VkPipeline& pipeline, VkPipelineLayout& pipelineLayout);
+		// Registers a newly built pipeline with one reference. If another thread registered the same key first, the new objects are destroyed and the existing ones returned instead.
+		void AddPipeline(const std::vector<char>& key, VkPipeline& pipeline, VkPipelineLayout& pipelineLayout, LogicalDevice& logicalDevice);
+		void ReleasePipeline(const std::vector<char>& key, LogicalDevice& logicalDevice);
+		void PrintStats();
+
+	private:
+		struct SetLayoutEntry
+		{
+			std::vector<uint32_t> keyData;
+			VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+			uint32_t refCount = 0;
+		};
+
+		struct PipelineEntry
+		{
+			std::vector<char> keyData;
+			VkPipeline pipeline = VK_NULL_HANDLE;
+			VkPipelineLayout layout = VK_NULL_HANDLE;
+			uint32_t refCount = 0;
+		};
+
+		PipelineCache m_pipelineCache;
+		std::unordered_map<uint64_t, std::vector<SetLayoutEntry>> m_setLayouts; // every entry whose key hashes to the same value
+		std::unordered_map<uint64_t, std::vector<PipelineEntry>> m_pipelines;
+		std::mutex m_mutex;
+
+		// stats
+		uint32_t m_pipelinesCreated;
+		uint32_t m_pipelinesShared;
+		uint32_t m_setLayoutsCreated;
+		uint32_t m_setLayoutsShared;
+		uint32_t m_hashCollisions;
+	};
+}
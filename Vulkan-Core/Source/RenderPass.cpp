@@ -6,7 +6,7 @@
 #include <gtc/type_ptr.hpp>
 
 #include <stdexcept>
-#include <chrono>
+#include <algorithm>
 
 
 namespace VCore
@@ -14,7 +14,13 @@ namespace VCore
 	RenderPass::RenderPass()
 	{
 		m_renderPass = VK_NULL_HANDLE;
+		m_loadRenderPass = VK_NULL_HANDLE;
         m_commandBuffers = std::vector<VkCommandBuffer>();
+        m_threadCommandPools = std::vector<std::vector<VkCommandPool>>();
+        m_secondaryCommandBuffers = std::vector<std::vector<VkCommandBuffer>>();
+        m_b_secondaryRecording = std::vector<char>();
+        m_bindStates = std::vector<BindState>();
+        m_drawList = DrawList();
 	}
 
 	RenderPass::~RenderPass()
@@ -24,6 +30,7 @@ namespace VCore
     void RenderPass::Cleanup(LogicalDevice& logicalDevice)
     {
         vkDestroyRenderPass(logicalDevice.GetDevice(), m_renderPass, nullptr);
+        vkDestroyRenderPass(logicalDevice.GetDevice(), m_loadRenderPass, nullptr);
     }
 
 
@@ -52,7 +59,7 @@ namespace VCore
         depthAttachment.format = Helper::FindDepthFormat(physicalDevice.GetDevice());
         depthAttachment.samples = winSystem.GetMsaa();
         depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE; // kept for the DepthPyramid and the late render pass
         depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -71,7 +78,7 @@ namespace VCore
         colorAttachmentResolve.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         colorAttachmentResolve.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         colorAttachmentResolve.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        colorAttachmentResolve.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        colorAttachmentResolve.finalLayout = winSystem.IsHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; // headless frames get copied back to the host instead of presented
         // Resolve still
         VkAttachmentReference colorAttachmentResolveRef{};
         colorAttachmentResolveRef.attachment = 2;
@@ -113,9 +120,31 @@ namespace VCore
         {
             throw std::runtime_error("failed to create render pass!");
         }
+
+        // Same pass, but carrying on from what the first one drew (BeginLateRenderPass). Only load ops and layouts differ, so it's compatible with
+        // every pipeline, framebuffer and secondary command buffer made for m_renderPass
+        attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        attachments[0].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        attachments[1].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        // The first pass' color and depth writes have to land before this one loads them
+        VkSubpassDependency loadDependency{};
+        loadDependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+        loadDependency.dstSubpass = 0;
+        loadDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        loadDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        loadDependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        loadDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        renderPassInfo.pDependencies = &loadDependency;
+
+        if (vkCreateRenderPass(logicalDevice.GetDevice(), &renderPassInfo, nullptr, &m_loadRenderPass) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create render pass!");
+        }
     }
 
-    void RenderPass::BeginRenderPass(uint32_t imageIndex, WinSys& winSystem)
+    void RenderPass::BeginCommandBuffer()
     {
         // Reset to make sure it is able to be recorded
         vkResetCommandBuffer(m_commandBuffers[VM_currentFrame], 0);
@@ -129,7 +158,10 @@ namespace VCore
         {
             throw std::runtime_error("failed to begin recording command buffer!");
         }
+    }
 
+    void RenderPass::BeginRenderPass(uint32_t imageIndex, WinSys& winSystem)
+    {
         // For Depth buffer
         std::array<VkClearValue, 2> clearValues{};
         clearValues[0].color = { {0.2f, 0.2f, 0.2f, 0.0f} };
@@ -144,6 +176,35 @@ namespace VCore
         renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
         renderPassInfo.pClearValues = clearValues.data();
 
+        // Begin render pass - draws are recorded into secondary command buffers (RecordDrawCommands), the primary only executes them
+        vkCmdBeginRenderPass(m_commandBuffers[VM_currentFrame], &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    }
+
+    void RenderPass::BeginSecondaryCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, WinSys& winSystem)
+    {
+        // Secondary command buffers continuing a render pass have to be told which render pass and subpass they'll be executed in
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = m_renderPass;
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = winSystem.GetFrameBuffers()[imageIndex]; // optional, but can let the driver optimize
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to begin recording secondary command buffer!");
+        }
+
+        // (dynamic state isn't inherited from the primary, so every secondary sets its own)
+        SetViewport(commandBuffer, winSystem);
+    }
+
+    void RenderPass::SetViewport(VkCommandBuffer commandBuffer, WinSys& winSystem)
+    {
         // we did specify viewport and scissor state for this pipeline to be dynamic. So we need to set them in the command buffer before issuing our draw command:
         VkViewport viewport{};
         viewport.x = 0.0f;
@@ -152,22 +213,146 @@ namespace VCore
         viewport.height = static_cast<float>(winSystem.GetExtent().height);
         viewport.minDepth = 0.0f;
         viewport.maxDepth = 1.0f;
-        vkCmdSetViewport(m_commandBuffers[VM_currentFrame], 0, 1, &viewport);
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 
         VkRect2D scissor{};
         scissor.offset = { 0, 0 };
         scissor.extent = winSystem.GetExtent();
-        vkCmdSetScissor(m_commandBuffers[VM_currentFrame], 0, 1, &scissor);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    }
 
-        // Begin render pass
+    VkCommandBuffer RenderPass::GetThreadCommandBuffer(uint32_t threadIndex, uint32_t imageIndex, WinSys& winSystem, FrameConstants& frameConstants, BindlessTable* bindlessTable)
+    {
+        VkCommandBuffer commandBuffer = m_secondaryCommandBuffers[VM_currentFrame][threadIndex];
+        if (!m_b_secondaryRecording[threadIndex])
+        {
+            BeginSecondaryCommandBuffer(commandBuffer, imageIndex, winSystem);
+            // Every pipeline layout shares set 0, so it stays bound across pipeline changes (descriptor binding isn't inherited from the primary either)
+            frameConstants.Bind(commandBuffer, VM_currentFrame);
+            if (bindlessTable != nullptr)
+            {
+                // The only other descriptor binding this command buffer does
+                bindlessTable->Bind(commandBuffer);
+            }
+            m_b_secondaryRecording[threadIndex] = 1;
+            m_bindStates[threadIndex] = BindState();
+        }
+        return commandBuffer;
+    }
+
+    DrawStats RenderPass::RecordDrawCommands(uint32_t imageIndex, WinSys& winSystem, std::vector<GameObject>& gameObjects, FrustumCuller& frustumCuller, InstanceBatcher& instanceBatcher, GpuCuller* gpuCuller, FrameConstants& frameConstants, JobSystem& jobSystem, BindlessTable* bindlessTable, LodSelector& lodSelector, LogicalDevice& logicalDevice)
+    {
+        std::vector<VkCommandPool>& threadPools = m_threadCommandPools[VM_currentFrame];
+        std::vector<VkCommandBuffer>& secondaries = m_secondaryCommandBuffers[VM_currentFrame];
+
+        // The fence for this frame has been waited on, so everything allocated from this frame's pools is free to reuse. Resetting the pool is cheaper than resetting buffers one by one
+        for (VkCommandPool pool : threadPools)
+        {
+            vkResetCommandPool(logicalDevice.GetDevice(), pool, 0);
+        }
+        std::fill(m_b_secondaryRecording.begin(), m_b_secondaryRecording.end(), 0);
+        std::vector<DrawStats> threadStats(secondaries.size());
+
+        // Only what survived culling goes in the list, so the jobs stay evenly loaded however much of the scene is off screen. Instanced objects aren't in it, they're drawn with their batch.
+        // A batch's instance data was culled and written before recording started (InstanceBatcher::WriteTransforms), or is culled by the GPU ahead of the render pass,
+        // in which case every batch is recorded and its draw count decides whether it draws anything
+        std::vector<InstanceBatch>& batches = gpuCuller != nullptr ? gpuCuller->GetBatches() : instanceBatcher.GetDrawBatches();
+        VkBuffer instanceBuffer = gpuCuller != nullptr ? gpuCuller->GetInstanceBuffer(VM_currentFrame) : instanceBatcher.GetInstanceBuffer(VM_currentFrame);
+        m_drawList.Build(gameObjects, frustumCuller.GetVisibleObjects(), batches, gpuCuller != nullptr, frustumCuller.GetViewProj(), frustumCuller.GetObjectOffset(), lodSelector);
+
+        // Each thread only ever touches its own pool/command buffer, so no locking is needed while recording.
+        // Jobs take contiguous runs of the sorted list, so draws sharing state mostly land in the same command buffer and skip their binds
+        const std::vector<DrawItem>& draws = m_drawList.GetDraws();
+        jobSystem.ParallelFor(static_cast<uint32_t>(draws.size()), VM_DRAWS_PER_JOB, [&](uint32_t begin, uint32_t end, uint32_t threadIndex)
+        {
+            VkCommandBuffer commandBuffer = GetThreadCommandBuffer(threadIndex, imageIndex, winSystem, frameConstants, bindlessTable);
+
+            for (uint32_t i = begin; i < end; i++)
+            {
+                RecordCommandBuffer(commandBuffer, draws[i], instanceBuffer, gpuCuller, m_bindStates[threadIndex], threadStats[threadIndex]);
+            }
+        });
+
+        // Only threads that picked up work have anything to execute
+        std::vector<VkCommandBuffer> recorded;
+        for (size_t i = 0; i < secondaries.size(); i++)
+        {
+            if (m_b_secondaryRecording[i])
+            {
+                if (vkEndCommandBuffer(secondaries[i]) != VK_SUCCESS)
+                {
+                    throw std::runtime_error("failed to record secondary command buffer!");
+                }
+                recorded.push_back(secondaries[i]);
+                m_drawList.AddBindStats(m_bindStates[i].stats);
+            }
+        }
+
+        if (!recorded.empty())
+        {
+            vkCmdExecuteCommands(m_commandBuffers[VM_currentFrame], static_cast<uint32_t>(recorded.size()), recorded.data());
+        }
+
+        DrawStats stats;
+        for (const DrawStats& threadStat : threadStats)
+        {
+            stats.drawn += threadStat.drawn;
+            stats.fallback += threadStat.fallback;
+            stats.skipped += threadStat.skipped;
+            stats.triangles += threadStat.triangles;
+            stats.fullDetailTriangles += threadStat.fullDetailTriangles;
+        }
+        return stats;
+    }
+
+    void RenderPass::BeginLateRenderPass(uint32_t imageIndex, WinSys& winSystem)
+    {
+        VkRenderPassBeginInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = m_loadRenderPass;
+        renderPassInfo.framebuffer = winSystem.GetFrameBuffers()[imageIndex];
+        renderPassInfo.renderArea.offset = { 0, 0 };
+        renderPassInfo.renderArea.extent = winSystem.GetExtent();
+        renderPassInfo.clearValueCount = 0; // nothing is cleared
+
+        // Only a draw per batch, so they're recorded straight into the primary
         vkCmdBeginRenderPass(m_commandBuffers[VM_currentFrame], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        SetViewport(m_commandBuffers[VM_currentFrame], winSystem);
+    }
+
+    void RenderPass::RecordLateDraws(GpuCuller& gpuCuller, FrameConstants& frameConstants, BindlessTable* bindlessTable)
+    {
+        VkCommandBuffer commandBuffer = m_commandBuffers[VM_currentFrame];
+        frameConstants.Bind(commandBuffer, VM_currentFrame);
+        if (bindlessTable != nullptr)
+        {
+            bindlessTable->Bind(commandBuffer);
+        }
+
+        // The GpuCuller counts what these actually draw, the stats here would only repeat the batch sizes already counted by RecordDrawCommands.
+        // Batches are already grouped by mesh and material, so they go in their own order
+        DrawStats stats;
+        BindState state;
+        std::vector<InstanceBatch>& batches = gpuCuller.GetBatches();
+        for (uint32_t i = 0; i < batches.size(); i++)
+        {
+            DrawItem draw;
+            draw.object = batches[i].object;
+            draw.batch = &batches[i];
+            draw.gpuBatch = i;
+            RecordCommandBuffer(commandBuffer, draw, gpuCuller.GetInstanceBuffer(VM_currentFrame), &gpuCuller, state, stats);
+        }
+        m_drawList.AddBindStats(state.stats);
     }
 
     void RenderPass::EndRenderPass()
     {
         // End render pass
         vkCmdEndRenderPass(m_commandBuffers[VM_currentFrame]);
+    }
 
+    void RenderPass::EndCommandBuffer()
+    {
         // Finish recording the command buffer
         if (vkEndCommandBuffer(m_commandBuffers[VM_currentFrame]) != VK_SUCCESS)
         {
@@ -175,39 +360,183 @@ namespace VCore
         }
     }
 
-    void RenderPass::RecordCommandBuffer(uint32_t imageIndex, WinSys& winSystem, GameObject& object)
+    void RenderPass::RecordCommandBuffer(VkCommandBuffer commandBuffer, const DrawItem& draw, VkBuffer instanceBuffer, GpuCuller* gpuCuller, BindState& state, DrawStats& stats)
     {
-        VkPipeline& graphicsPipeline = object.GetMaterial()->GetGraphicsPipeline();
-        VkPipelineLayout& pipelineLayout = object.GetMaterial()->GetPipelineLayout();
-        VkDescriptorSet& descriptorSet = object.GetDescriptorSets()[VM_currentFrame];
-        VkBuffer& vertexBuffer = object.GetModel().GetVertexBuffer();
-        VkBuffer& indexBuffer = object.GetModel().GetIndexBuffer();
-        std::vector<uint32_t>& indices = object.GetModel().GetIndices();
+        GameObject& object = *draw.object;
+        const InstanceBatch* batch = draw.batch;
+        uint32_t instanceCount = batch != nullptr ? batch->instanceCount : 1;
+        uint32_t firstInstance = batch != nullptr ? batch->firstInstance : 0;
+
+        // Never wait on a pipeline that's still compiling, draw the fallback or nothing this frame instead
+        Material* material = object.GetMaterial()->GetDrawMaterial();
+        if (material == nullptr)
+        {
+            stats.skipped += instanceCount;
+            return;
+        }
+        if (material == object.GetMaterial().get())
+        {
+            stats.drawn += instanceCount;
+        }
+        else
+        {
+            stats.fallback += instanceCount;
+        }
+
+        VkPipeline& graphicsPipeline = material->GetGraphicsPipeline();
+        VkPipelineLayout& pipelineLayout = material->GetPipelineLayout();
+        // Meshes share their arena page's buffers, so only draws moving to another page bind new ones
+        const GeometryRange& geometry = object.GetModel().GetMesh()->GetGeometry();
+        VkBuffer vertexBuffer = geometry.vertexBuffer;
+        VkBuffer indexBuffer = geometry.indexBuffer;
+        BindlessTable* bindlessTable = material->GetBindlessTable();
+
+        // A different layout may not be compatible with the set 1 and push constants bound under the old one, so they're bound again (set 0 is shared by every layout)
+        if (pipelineLayout != state.pipelineLayout)
+        {
+            state.pipelineLayout = pipelineLayout;
+            state.descriptorSet = VK_NULL_HANDLE;
+            state.b_objectConstants = false;
+            state.b_bindlessConstants = false;
+        }
 
         // Push constants
-        static auto startTime = std::chrono::high_resolution_clock::now();
-        auto currentTime = std::chrono::high_resolution_clock::now();
-        float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
-        float data[3] = { time }; // where sizeof(float) == 4 bytes
-        uint32_t offset = 0;
-        uint32_t size = 12;
-        vkCmdPushConstants(m_commandBuffers[VM_currentFrame], pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, offset, size, data);        
+        if (bindlessTable != nullptr)
+        {
+            // Objects write disjoint slots of this frame's object buffer
+            ObjectData objectData{};
+            objectData.model = object.GetModel().GetTransform();
+            bindlessTable->WriteObject(VM_currentFrame, object.GetObjectIndex(), objectData);
+
+            // Everything the shaders need to find this object's data and texture in the global set
+            BindlessPushConstants pushConstants{};
+            pushConstants.position = glm::vec3(VM_elapsedTime, 0.0f, 0.0f);
+            pushConstants.objectIndex = object.GetObjectIndex();
+            pushConstants.textureIndex = material->GetTextureIndex();
+            pushConstants.objectBufferIndex = bindlessTable->GetObjectBufferIndex(VM_currentFrame);
+            pushConstants.positionOffset = glm::vec4(geometry.positionOffset, 0.0f);
+            pushConstants.positionScale = glm::vec4(geometry.positionScale, 0.0f);
+            const BindlessPushConstants& last = state.bindlessConstants;
+            if (state.b_bindlessConstants && last.position == pushConstants.position && last.objectIndex == pushConstants.objectIndex && last.textureIndex == pushConstants.textureIndex && last.objectBufferIndex == pushConstants.objectBufferIndex
+                && last.positionOffset == pushConstants.positionOffset && last.positionScale == pushConstants.positionScale)
+            {
+                state.stats.skippedPushConstants++;
+            }
+            else
+            {
+                vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(BindlessPushConstants), &pushConstants);
+                state.bindlessConstants = pushConstants;
+                state.b_bindlessConstants = true;
+                state.b_objectConstants = false;
+                state.stats.pushConstants++;
+            }
+        }
+        else
+        {
+            // The transform travels with the draw instead of through a per object uniform buffer. Instanced materials ignore it and read InstanceData
+            ObjectPushConstants pushConstants{};
+            pushConstants.model = object.GetModel().GetTransform();
+            pushConstants.position = glm::vec3(VM_elapsedTime, 0.0f, 0.0f);
+            pushConstants.positionOffset = glm::vec4(geometry.positionOffset, 0.0f);
+            pushConstants.positionScale = glm::vec4(geometry.positionScale, 0.0f);
+            const ObjectPushConstants& last = state.objectConstants;
+            if (state.b_objectConstants && last.model == pushConstants.model && last.position == pushConstants.position && last.positionOffset == pushConstants.positionOffset && last.positionScale == pushConstants.positionScale)
+            {
+                state.stats.skippedPushConstants++;
+            }
+            else
+            {
+                vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(ObjectPushConstants), &pushConstants);
+                state.objectConstants = pushConstants;
+                state.b_objectConstants = true;
+                state.b_bindlessConstants = false;
+                state.stats.pushConstants++;
+            }
+        }
 
         // Bind the graphics pipeline
-        vkCmdBindPipeline(m_commandBuffers[VM_currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+        if (graphicsPipeline != state.pipeline)
+        {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+            state.pipeline = graphicsPipeline;
+            state.stats.pipelines++;
+        }
+        else
+        {
+            state.stats.skippedPipelines++;
+        }
 
         // Bind the vertex buffer
-        VkBuffer vertexBuffers[] = { vertexBuffer };
         VkDeviceSize offsets[] = { 0 };
-        vkCmdBindVertexBuffers(m_commandBuffers[VM_currentFrame], 0, 1, vertexBuffers, offsets);
+        if (vertexBuffer != state.vertexBuffer)
+        {
+            VkBuffer vertexBuffers[] = { vertexBuffer };
+            vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+            state.vertexBuffer = vertexBuffer;
+            state.stats.vertexBuffers++;
+        }
+        else
+        {
+            state.stats.skippedVertexBuffers++;
+        }
+        if (batch != nullptr)
+        {
+            // Instance data sits at binding 1, firstInstance picks out the batch's range
+            if (instanceBuffer != state.instanceBuffer)
+            {
+                vkCmdBindVertexBuffers(commandBuffer, 1, 1, &instanceBuffer, offsets);
+                state.instanceBuffer = instanceBuffer;
+                state.stats.vertexBuffers++;
+            }
+            else
+            {
+                state.stats.skippedVertexBuffers++;
+            }
+        }
+
+        // Bind the index buffer. Its type goes with the page, so the same buffer never needs rebinding as another type
+        if (indexBuffer != state.indexBuffer)
+        {
+            vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, geometry.indexType);
+            state.indexBuffer = indexBuffer;
+            state.stats.indexBuffers++;
+        }
+        else
+        {
+            state.stats.skippedIndexBuffers++;
+        }
 
-        // Bind the index buffer
-        vkCmdBindIndexBuffer(m_commandBuffers[VM_currentFrame], indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+        // Bindless draws already have the global set bound
+        if (bindlessTable == nullptr)
+        {
+            // The material's textures, shared by every object with this material. Set 0 stays bound
+            VkDescriptorSet descriptorSet = object.GetDescriptorSets()[VM_currentFrame];
+            if (descriptorSet != state.descriptorSet)
+            {
+                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 1, 1, &descriptorSet, 0, nullptr);
+                state.descriptorSet = descriptorSet;
+                state.stats.descriptorSets++;
+            }
+            else
+            {
+                state.stats.skippedDescriptorSets++;
+            }
+        }
 
-        vkCmdBindDescriptorSets(m_commandBuffers[VM_currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+        if (gpuCuller != nullptr)
+        {
+            // Index range, instance count and first instance all come from the culling shader's output
+            gpuCuller->RecordDraw(commandBuffer, VM_currentFrame, draw.gpuBatch);
+            return;
+        }
 
         // Refer to - https://vulkan-tutorial.com/en/Vertex_buffers/Index_buffer
-        vkCmdDrawIndexed(m_commandBuffers[VM_currentFrame], static_cast<uint32_t>(indices.size()), 1, 0, 0, 0); // reusing vertices with index buffers.
+        // Every LOD indexes the same vertices, only the index range differs
+        const MeshLod& lod = geometry.lods[draw.lod];
+        vkCmdDrawIndexed(commandBuffer, lod.indexCount, instanceCount, lod.firstIndex, static_cast<int32_t>(geometry.firstVertex), firstInstance); // reusing vertices with index buffers.
+        stats.triangles += static_cast<uint64_t>(lod.indexCount / 3) * instanceCount;
+        stats.fullDetailTriangles += static_cast<uint64_t>(geometry.indexCount / 3) * instanceCount;
+        // The GeometryArena does what the note below asks for, for every mesh at once
         // NOTE FROM THE WIKI: The previous chapter already mentioned that you should allocate multiple resources like buffers from a single memory allocation, but in fact you should go a step further. Driver developers recommend that you also store multiple buffers, like the vertex and index buffer, into a single VkBuffer and use offsets in commands like vkCmdBindVertexBuffers. The advantage is that your data is more cache friendly in that case, because it's closer together. It is even possible to reuse the same chunk of memory for multiple resources if they are not used during the same render operations, provided that their data is refreshed, of course. This is known as aliasing and some Vulkan functions have explicit flags to specify that you want to do this.
     }
 
@@ -232,8 +561,67 @@ namespace VCore
         }
     }
 
+    void RenderPass::CreateThreadCommandBuffers(uint32_t queueFamilyIndex, uint32_t threadCount, LogicalDevice& logicalDevice)
+    {
+        // Command pools are not thread safe, so every recording thread gets its own, and one per frame in flight so a frame's pools can be reset while the other frame is still executing
+        m_threadCommandPools.resize(VM_MAX_FRAMES_IN_FLIGHT);
+        m_secondaryCommandBuffers.resize(VM_MAX_FRAMES_IN_FLIGHT);
+        m_b_secondaryRecording.assign(threadCount, 0);
+        m_bindStates.assign(threadCount, BindState());
+
+        for (size_t frame = 0; frame < VM_MAX_FRAMES_IN_FLIGHT; frame++)
+        {
+            m_threadCommandPools[frame].resize(threadCount);
+            m_secondaryCommandBuffers[frame].resize(threadCount);
+
+            for (uint32_t thread = 0; thread < threadCount; thread++)
+            {
+                VkCommandPoolCreateInfo poolInfo{};
+                poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+                poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT; // re-recorded every frame, reset as a whole pool
+                poolInfo.queueFamilyIndex = queueFamilyIndex;
+
+                if (vkCreateCommandPool(logicalDevice.GetDevice(), &poolInfo, nullptr, &m_threadCommandPools[frame][thread]) != VK_SUCCESS)
+                {
+                    throw std::runtime_error("failed to create thread command pool!");
+                }
+
+                VkCommandBufferAllocateInfo allocInfo{};
+                allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+                allocInfo.commandPool = m_threadCommandPools[frame][thread];
+                allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+                allocInfo.commandBufferCount = 1;
+
+                if (vkAllocateCommandBuffers(logicalDevice.GetDevice(), &allocInfo, &m_secondaryCommandBuffers[frame][thread]) != VK_SUCCESS)
+                {
+                    throw std::runtime_error("failed to allocate secondary command buffers!");
+                }
+            }
+        }
+    }
+
+    void RenderPass::CleanupThreadCommandBuffers(LogicalDevice& logicalDevice)
+    {
+        // Destroying the pools frees their command buffers too
+        for (std::vector<VkCommandPool>& framePools : m_threadCommandPools)
+        {
+            for (VkCommandPool pool : framePools)
+            {
+                vkDestroyCommandPool(logicalDevice.GetDevice(), pool, nullptr);
+            }
+        }
+
+        m_threadCommandPools.clear();
+        m_secondaryCommandBuffers.clear();
+    }
+
     std::vector<VkCommandBuffer>& RenderPass::GetCommandBuffers()
     {
         return m_commandBuffers;
     }
+
+    DrawList& RenderPass::GetDrawList()
+    {
+        return m_drawList;
+    }
 }
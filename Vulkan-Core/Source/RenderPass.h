@@ -2,6 +2,12 @@
 #include "PhysicalDevice.h"
 #include "LogicalDevice.h"
 #include "WinSys.h"
+#include "JobSystem.h"
+#include "BindlessTable.h"
+#include "InstanceBatcher.h"
+#include "GpuCuller.h"
+#include "FrameConstants.h"
+#include "DrawList.h"
 
 #define GLFW_INCLUDE_VULKAN
 #include <glfw3.h>
@@ -13,6 +19,17 @@ namespace VCore
 {
 	class GameObject;
 
+	// What happened to a frame's draws, objects whose material pipeline is still compiling are either drawn with the material's fallback or skipped.
+	// Triangles are what the CPU recorded draws drew at their LOD and would have at full detail, GpuCuller draws aren't known until the GPU has culled them
+	struct DrawStats
+	{
+		uint32_t drawn = 0;
+		uint32_t fallback = 0;
+		uint32_t skipped = 0;
+		uint64_t triangles = 0;
+		uint64_t fullDetailTriangles = 0;
+	};
+
 	class RenderPass
 	{
 	public:
@@ -23,14 +40,49 @@ namespace VCore
 		void CreateRenderPass(WinSys& winSystem, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
 		VkRenderPass& GetRenderPass();
 		void CreateCommandBuffers(VkCommandPool commandPool, LogicalDevice& logicalDevice);
+		// One command pool per recording thread per frame in flight, each with a secondary command buffer the thread records its share of the draws into
+		void CreateThreadCommandBuffers(uint32_t queueFamilyIndex, uint32_t threadCount, LogicalDevice& logicalDevice);
+		void CleanupThreadCommandBuffers(LogicalDevice& logicalDevice);
 		std::vector<VkCommandBuffer>& GetCommandBuffers();
-		void RecordCommandBuffer(uint32_t imageIndex, WinSys& winSystem, GameObject& object);
+		// Expects set 0 (FrameConstants) to be bound already. The transform is pushed, or written to the bindless object buffer. Only binds what differs from state, and updates it.
+		// With a batch, draws all of its instances using object's mesh, material and descriptor sets, reading InstanceData from instanceBuffer.
+		// With a gpuCuller too, the draw is its indirect draw for the draw's gpuBatch instead (stats then count every instance in the batch, culled or not). Otherwise it draws the draw's LOD
+		void RecordCommandBuffer(VkCommandBuffer commandBuffer, const DrawItem& draw, VkBuffer instanceBuffer, GpuCuller* gpuCuller, BindState& state, DrawStats& stats);
+		// Sorts the frustumCuller's visible gameObjects and the instanceBatcher's draw batches by state (DrawList), splits the sorted draws across the job system's threads,
+		// records them into secondary command buffers and executes those from the primary.
+		// Both have to have been culled this frame already (FrustumCuller::CullObjects, InstanceBatcher::WriteTransforms), objects with instanced materials are only drawn through their batch.
+		// With a gpuCuller the instanced batches are its indirect draws instead, culled on the GPU (GpuCuller::RecordCull, recorded before the render pass began).
+		// frameConstants' set is bound once per command buffer. With a bindlessTable its set is bound once per command buffer too and every material is expected to be bindless.
+		// lodSelector picks each draw's level of detail, its view has to be set for the frame
+		DrawStats RecordDrawCommands(uint32_t imageIndex, WinSys& winSystem, std::vector<GameObject>& gameObjects, FrustumCuller& frustumCuller, InstanceBatcher& instanceBatcher, GpuCuller* gpuCuller, FrameConstants& frameConstants, JobSystem& jobSystem, BindlessTable* bindlessTable, LodSelector& lodSelector, LogicalDevice& logicalDevice);
+		// Resets and begins this frame's primary command buffer, anything recorded before BeginRenderPass (compute dispatches) goes here
+		void BeginCommandBuffer();
 		void BeginRenderPass(uint32_t imageIndex, WinSys& winSystem);
+		// Begins the render pass again after BeginRenderPass/EndRenderPass, keeping the color and depth drawn so far (for work recorded in between, like building a DepthPyramid).
+		// Draws go straight into the primary command buffer
+		void BeginLateRenderPass(uint32_t imageIndex, WinSys& winSystem);
+		// Records gpuCuller's batches as culled by its last RecordCull, inside BeginLateRenderPass
+		void RecordLateDraws(GpuCuller& gpuCuller, FrameConstants& frameConstants, BindlessTable* bindlessTable);
 		void EndRenderPass();
+		void EndCommandBuffer();
+		// Sort order and how many binds it saved
+		DrawList& GetDrawList();
 
 	private:
+		void BeginSecondaryCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, WinSys& winSystem);
+		void SetViewport(VkCommandBuffer commandBuffer, WinSys& winSystem);
+		// This thread's secondary command buffer, begun the first time the thread picks up work this frame
+		VkCommandBuffer GetThreadCommandBuffer(uint32_t threadIndex, uint32_t imageIndex, WinSys& winSystem, FrameConstants& frameConstants, BindlessTable* bindlessTable);
+
 		VkRenderPass m_renderPass;
+		VkRenderPass m_loadRenderPass; // m_renderPass with LOAD ops, for BeginLateRenderPass
 		std::vector<VkCommandBuffer> m_commandBuffers;
+		// [frame in flight][thread]
+		std::vector<std::vector<VkCommandPool>> m_threadCommandPools;
+		std::vector<std::vector<VkCommandBuffer>> m_secondaryCommandBuffers;
+		std::vector<char> m_b_secondaryRecording; // per thread, char rather than bool so threads can write their own slot without sharing a byte
+		std::vector<BindState> m_bindStates; // per thread, what its secondary command buffer has bound
+		DrawList m_drawList;
 	};
 }
 
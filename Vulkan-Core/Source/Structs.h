@@ -7,6 +7,8 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <gtx/hash.hpp>
 
+#include "VertexLayout.h"
+
 #include <array>
 #include <optional>
 #include <vector>
@@ -18,6 +20,7 @@ namespace VCore
     {
         std::optional<uint32_t> graphicsFamily; // Make sure graphics can be rendered
         std::optional<uint32_t> presentFamily; // Make sure device can present images to the surface we created
+        std::optional<uint32_t> transferFamily; // Optional - a transfer only family (usually a separate DMA engine) that uploads can run on without competing with rendering
 
         bool isComplete() 
         {
@@ -40,53 +43,122 @@ namespace VCore
         glm::vec2 texCoord;
         glm::vec3 normal;
 
-        bool operator==(const Vertex& other) const
-        {
-            return pos == other.pos && color == other.color && texCoord == other.texCoord && normal == other.normal;
-        }
+        bool operator==(const Vertex& other) const;
+    };
 
-        static VkVertexInputBindingDescription getBindingDescription()
-        {
-            VkVertexInputBindingDescription bindingDescription{};
-            bindingDescription.binding = 0;
-            bindingDescription.stride = sizeof(Vertex);
-            bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    // Locations 0 - 3 in every vertex shader, see Shaders/vertex_input.glsl
+    using FullVertexLayout = VertexLayout<Vertex, 0, VK_VERTEX_INPUT_RATE_VERTEX,
+        VCORE_VERTEX_ATTRIBUTE(Vertex, pos, 0),
+        VCORE_VERTEX_ATTRIBUTE(Vertex, color, 1),
+        VCORE_VERTEX_ATTRIBUTE(Vertex, texCoord, 2),
+        VCORE_VERTEX_ATTRIBUTE(Vertex, normal, 3)>;
 
-            return bindingDescription;
-        }
-
-        static std::array<VkVertexInputAttributeDescription, 4> getAttributeDescriptions()
-        {
-            std::array<VkVertexInputAttributeDescription, 4> attributeDescriptions{};
+    inline bool Vertex::operator==(const Vertex& other) const
+    {
+        return FullVertexLayout::Equal(*this, other);
+    }
 
-            attributeDescriptions[0].binding = 0;
-            attributeDescriptions[0].location = 0;
-            attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-            attributeDescriptions[0].offset = offsetof(Vertex, pos);
+    // Object space bounds of a mesh, computed once when it's imported and stored in its .vmesh cache (see Mesh::ComputeBounds)
+    struct MeshBounds
+    {
+        glm::vec3 min = glm::vec3(0.0f);
+        glm::vec3 max = glm::vec3(0.0f);
+        glm::vec3 center = glm::vec3(0.0f); // bounding sphere, centered on the box
+        float radius = 0.0f;
+    };
 
-            attributeDescriptions[1].binding = 0;
-            attributeDescriptions[1].location = 1;
-            attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-            attributeDescriptions[1].offset = offsetof(Vertex, color);
+    // Per instance data for instanced materials, read through a second vertex binding that advances once per instance (see InstanceBatcher)
+    struct InstanceData
+    {
+        glm::mat4 model;
+        glm::vec4 params; // free for the shaders, e.g. a tint
+    };
 
-            attributeDescriptions[2].binding = 0;
-            attributeDescriptions[2].location = 2;
-            attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-            attributeDescriptions[2].offset = offsetof(Vertex, texCoord);
+    // Follows on from Vertex's locations, the model matrix takes 4 - 7 (one per column) and params 8
+    using InstanceDataLayout = VertexLayout<InstanceData, 1, VK_VERTEX_INPUT_RATE_INSTANCE,
+        VCORE_VERTEX_ATTRIBUTE(InstanceData, model, 4),
+        VCORE_VERTEX_ATTRIBUTE(InstanceData, params, 8)>;
 
-            attributeDescriptions[3].binding = 0;
-            attributeDescriptions[3].location = 3;
-            attributeDescriptions[3].format = VK_FORMAT_R32G32B32_SFLOAT;
-            attributeDescriptions[3].offset = offsetof(Vertex, normal);
+    // Per frame constants, written once per frame into the UniformRing and read through set 0 binding 0 by every shader (see FrameConstants)
+    struct CameraData
+    {
+        glm::mat4 view;
+        glm::mat4 proj;
+        glm::mat4 viewProj;
+        glm::vec4 position; // world space eye, w unused
+    };
 
-            return attributeDescriptions;
-        }
+    // Per draw data for regular and instanced materials, matches the push_constant block in Shaders/shader.vert, shader2.vert and instanced.vert
+    struct ObjectPushConstants
+    {
+        glm::mat4 model; // ignored by instanced materials, which take theirs from InstanceData
+        glm::vec3 position;
+        float padding; // std430 aligns the vec4s below to 16 bytes
+        glm::vec4 positionOffset; // the mesh's GeometryRange, undoes compact vertex quantization (see VertexCodec)
+        glm::vec4 positionScale;
     };
 
-    struct UniformBufferObject {
+    // Per object data for bindless materials, one per draw in the BindlessTable's object buffers
+    struct ObjectData
+    {
         glm::mat4 model;
-        glm::mat4 view;
-        glm::mat4 proj;
+    };
+
+    // One instanced batch as the GPU culling shader sees it, matches Batch in Shaders/cull.comp (see GpuCuller)
+    struct CullBatch
+    {
+        glm::vec4 sphere; // object space bounding sphere of the batch's mesh, w is the radius
+        uint32_t firstInstance;
+        uint32_t pad[3];
+    };
+
+    // Per dispatch data for the GPU culling shader, matches the push_constant block in Shaders/cull.comp
+    struct CullPushConstants
+    {
+        glm::vec4 planes[6];
+        glm::vec4 objectOffset;
+        uint32_t instanceCount;
+        uint32_t batchCount;
+        uint32_t phase; // 0, or 1 for the second pass of occlusion culling
+    };
+
+    // What the GPU culling shader culled in a frame, matches the Counters block in Shaders/cull.comp
+    struct GpuCullCounters
+    {
+        uint32_t frustumCulled;
+        uint32_t occlusionCulled;
+    };
+
+    // Per frame data for occlusion culling, matches the Occlusion block in Shaders/cull.comp (std140)
+    struct OcclusionConstants
+    {
+        glm::mat4 viewProj;
+        glm::vec2 pyramidSize; // level 0, in texels
+        uint32_t pyramidLevels;
+        uint32_t pad;
+    };
+
+    // Per dispatch data for building a depth pyramid level, matches the push_constant block in Shaders/depth_pyramid.comp
+    struct DepthPyramidPushConstants
+    {
+        uint32_t sourceWidth;
+        uint32_t sourceHeight;
+        uint32_t width;
+        uint32_t height;
+        uint32_t level;
+        uint32_t sampleCount;
+    };
+
+    // Per draw data for bindless materials, matches the push_constant block in Shaders/bindless.vert and bindless.frag (std430 - the uints pack right after the vec3)
+    struct BindlessPushConstants
+    {
+        glm::vec3 position;
+        uint32_t objectIndex; // into the object buffer below
+        uint32_t textureIndex; // into the texture array
+        uint32_t objectBufferIndex; // this frame's object buffer in the storage buffer array
+        uint32_t padding[2]; // std430 aligns the vec4s below to 16 bytes
+        glm::vec4 positionOffset; // the mesh's GeometryRange, undoes compact vertex quantization (see VertexCodec)
+        glm::vec4 positionScale;
     };
 }
 
@@ -96,9 +168,6 @@ template<> struct std::hash<VCore::Vertex>
 {
     size_t operator()(VCore::Vertex const& vertex) const 
     {
-        return ((std::hash<glm::vec3>()(vertex.pos) ^
-            (std::hash<glm::vec3>()(vertex.color) << 1)) >> 1) ^
-            (std::hash<glm::vec2>()(vertex.texCoord) << 1) ^
-            (std::hash<glm::vec3>()(vertex.normal) << 1);
+        return VCore::FullVertexLayout::Hash(vertex);
     }
 };
\ No newline at end of file
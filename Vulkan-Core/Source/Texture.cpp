@@ -11,7 +11,7 @@ namespace VCore
         m_texturePath = "";
         m_imageView = VK_NULL_HANDLE;
         m_image = VK_NULL_HANDLE;
-        m_textureImageMemory = VK_NULL_HANDLE;
+        m_textureImageMemory = Allocation();
         m_textureSampler = VK_NULL_HANDLE;
         m_mipLevels = 1;
 	}
@@ -23,8 +23,8 @@ namespace VCore
     void Texture::Cleanup(LogicalDevice& logicalDevice)
     {
         vkDestroySampler(logicalDevice.GetDevice(), m_textureSampler, nullptr);
-        vkFreeMemory(logicalDevice.GetDevice(), m_textureImageMemory, nullptr);
         vkDestroyImage(logicalDevice.GetDevice(), m_image, nullptr);
+        logicalDevice.GetAllocator().Free(m_textureImageMemory);
         vkDestroyImageView(logicalDevice.GetDevice(), m_imageView, nullptr);
     }
 
@@ -49,7 +49,7 @@ namespace VCore
         return m_image;
     }
 
-    VkDeviceMemory& Texture::GetTextureImageMemory()
+    Allocation& Texture::GetTextureImageMemory()
     {
         return m_textureImageMemory;
     }
@@ -64,9 +64,9 @@ namespace VCore
         return m_mipLevels;
     }
 
-    void Texture::CreateTextureImage(WinSys& winSystem, VkCommandPool commandPool, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice)
+    void Texture::CreateTextureImage(WinSys& winSystem, UploadQueue& uploadQueue, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice)
     {
-        VkImage newImage = winSystem.CreateTextureImage(m_texturePath, m_mipLevels, commandPool, physicalDevice, logicalDevice, m_textureImageMemory);
+        VkImage newImage = winSystem.CreateTextureImage(m_texturePath, m_mipLevels, uploadQueue, physicalDevice, logicalDevice, m_textureImageMemory);
         VkImageView textureImageView = winSystem.CreateImageView(newImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, m_mipLevels, logicalDevice);
         m_image = newImage;
         m_imageView = textureImageView;
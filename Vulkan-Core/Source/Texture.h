@@ -21,17 +21,17 @@ namespace VCore
 		std::string GetTexturePath();
 		VkImageView& GetImageView();
 		VkImage& GetImage();
-		VkDeviceMemory& GetTextureImageMemory();
+		Allocation& GetTextureImageMemory();
 		VkSampler& GetTextureSampler();
 		uint32_t GetMipLevels();
-		void CreateTextureImage(WinSys& winSystem, VkCommandPool commandPool, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
+		void CreateTextureImage(WinSys& winSystem, UploadQueue& uploadQueue, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
 		void CreateTextureSampler(PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
 
 	private:
 		std::string m_texturePath;
 		VkImageView m_imageView;
 		VkImage m_image;
-		VkDeviceMemory m_textureImageMemory;
+		Allocation m_textureImageMemory;
 		VkSampler m_textureSampler;
 		uint32_t m_mipLevels;
 	};
@@ -0,0 +1,647 @@
+#include "TransformSystem.h"
+#include "VulkanManager.h"
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <cstring>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__)
+    #define TRANSFORMS_X64 // SSE2 is always there on x64, AVX2 is checked at runtime
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+#endif
+
+// MSVC lets any function use any intrinsic, GCC and Clang need the AVX2 kernel marked so it can be built without compiling everything else for AVX2
+#if defined(__GNUC__) || defined(__clang__)
+    #define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+    #define TARGET_AVX2
+#endif
+
+
+namespace VCore
+{
+    // Raw pointers into the arrays, shared by the kernels
+    struct TransformStreams
+    {
+        const float* positionX;
+        const float* positionY;
+        const float* positionZ;
+        const float* rotationX;
+        const float* rotationY;
+        const float* rotationZ;
+        const float* rotationW;
+        const float* scaleX;
+        const float* scaleY;
+        const float* scaleZ;
+    };
+
+    // The world matrix of transform index in glm's column major order (m[column * 4 + row]), matching glm::translate * glm::mat4_cast * glm::scale
+    static void BuildWorld(const TransformStreams& streams, uint32_t index, float* world)
+    {
+        float x = streams.rotationX[index];
+        float y = streams.rotationY[index];
+        float z = streams.rotationZ[index];
+        float w = streams.rotationW[index];
+        float sx = streams.scaleX[index];
+        float sy = streams.scaleY[index];
+        float sz = streams.scaleZ[index];
+
+        world[0] = (1.0f - 2.0f * (y * y + z * z)) * sx;
+        world[1] = 2.0f * (x * y + w * z) * sx;
+        world[2] = 2.0f * (x * z - w * y) * sx;
+        world[3] = 0.0f;
+        world[4] = 2.0f * (x * y - w * z) * sy;
+        world[5] = (1.0f - 2.0f * (x * x + z * z)) * sy;
+        world[6] = 2.0f * (y * z + w * x) * sy;
+        world[7] = 0.0f;
+        world[8] = 2.0f * (x * z + w * y) * sz;
+        world[9] = 2.0f * (y * z - w * x) * sz;
+        world[10] = (1.0f - 2.0f * (x * x + y * y)) * sz;
+        world[11] = 0.0f;
+        world[12] = streams.positionX[index];
+        world[13] = streams.positionY[index];
+        world[14] = streams.positionZ[index];
+        world[15] = 1.0f;
+    }
+
+    static void ComputeScalar(const TransformStreams& streams, const uint32_t* indices, uint32_t begin, uint32_t end, const float* viewProj, char* destination, size_t stride)
+    {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            float world[16];
+            BuildWorld(streams, indices != nullptr ? indices[i] : i, world);
+
+            if (viewProj != nullptr)
+            {
+                float result[16];
+                for (uint32_t column = 0; column < 4; column++)
+                {
+                    for (uint32_t row = 0; row < 4; row++)
+                    {
+                        result[column * 4 + row] = viewProj[row] * world[column * 4] + viewProj[4 + row] * world[column * 4 + 1] + viewProj[8 + row] * world[column * 4 + 2] + viewProj[12 + row] * world[column * 4 + 3];
+                    }
+                }
+                memcpy(destination + i * stride, result, sizeof(result));
+            }
+            else
+            {
+                memcpy(destination + i * stride, world, sizeof(world));
+            }
+        }
+    }
+
+#ifdef TRANSFORMS_X64
+    static inline __m128 LoadSse(const float* stream, const uint32_t* indices, uint32_t i)
+    {
+        if (indices == nullptr)
+        {
+            return _mm_loadu_ps(stream + i);
+        }
+        return _mm_setr_ps(stream[indices[i]], stream[indices[i + 1]], stream[indices[i + 2]], stream[indices[i + 3]]);
+    }
+
+    // Four transforms at a time - every __m128 holds the same matrix element of four objects, which are transposed back into columns on the way out
+    static void ComputeSse(const TransformStreams& streams, const uint32_t* indices, uint32_t begin, uint32_t end, const float* viewProj, char* destination, size_t stride)
+    {
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 two = _mm_set1_ps(2.0f);
+
+        for (uint32_t i = begin; i + 4 <= end; i += 4)
+        {
+            __m128 x = LoadSse(streams.rotationX, indices, i);
+            __m128 y = LoadSse(streams.rotationY, indices, i);
+            __m128 z = LoadSse(streams.rotationZ, indices, i);
+            __m128 w = LoadSse(streams.rotationW, indices, i);
+            __m128 sx = LoadSse(streams.scaleX, indices, i);
+            __m128 sy = LoadSse(streams.scaleY, indices, i);
+            __m128 sz = LoadSse(streams.scaleZ, indices, i);
+
+            __m128 xx = _mm_mul_ps(x, x);
+            __m128 yy = _mm_mul_ps(y, y);
+            __m128 zz = _mm_mul_ps(z, z);
+            __m128 xy = _mm_mul_ps(x, y);
+            __m128 xz = _mm_mul_ps(x, z);
+            __m128 yz = _mm_mul_ps(y, z);
+            __m128 wx = _mm_mul_ps(w, x);
+            __m128 wy = _mm_mul_ps(w, y);
+            __m128 wz = _mm_mul_ps(w, z);
+
+            // [column * 4 + row], the fourth row of the first three columns is always 0 and the last column is (position, 1)
+            __m128 m[16];
+            m[0] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+            m[1] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+            m[2] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+            m[3] = _mm_setzero_ps();
+            m[4] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+            m[5] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+            m[6] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+            m[7] = _mm_setzero_ps();
+            m[8] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+            m[9] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+            m[10] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+            m[11] = _mm_setzero_ps();
+            m[12] = LoadSse(streams.positionX, indices, i);
+            m[13] = LoadSse(streams.positionY, indices, i);
+            m[14] = LoadSse(streams.positionZ, indices, i);
+            m[15] = one;
+
+            if (viewProj != nullptr)
+            {
+                // viewProj * world, skipping the known 0s and 1 of the world matrix's fourth row
+                __m128 result[16];
+                for (uint32_t column = 0; column < 4; column++)
+                {
+                    for (uint32_t row = 0; row < 4; row++)
+                    {
+                        __m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(viewProj[row]), m[column * 4]), _mm_mul_ps(_mm_set1_ps(viewProj[4 + row]), m[column * 4 + 1])), _mm_mul_ps(_mm_set1_ps(viewProj[8 + row]), m[column * 4 + 2]));
+                        result[column * 4 + row] = column == 3 ? _mm_add_ps(sum, _mm_set1_ps(viewProj[12 + row])) : sum;
+                    }
+                }
+                memcpy(m, result, sizeof(m));
+            }
+
+            for (uint32_t column = 0; column < 4; column++)
+            {
+                __m128 object0 = m[column * 4];
+                __m128 object1 = m[column * 4 + 1];
+                __m128 object2 = m[column * 4 + 2];
+                __m128 object3 = m[column * 4 + 3];
+                _MM_TRANSPOSE4_PS(object0, object1, object2, object3);
+
+                _mm_storeu_ps(reinterpret_cast<float*>(destination + i * stride) + column * 4, object0);
+                _mm_storeu_ps(reinterpret_cast<float*>(destination + (i + 1) * stride) + column * 4, object1);
+                _mm_storeu_ps(reinterpret_cast<float*>(destination + (i + 2) * stride) + column * 4, object2);
+                _mm_storeu_ps(reinterpret_cast<float*>(destination + (i + 3) * stride) + column * 4, object3);
+            }
+        }
+    }
+
+    // Same as ComputeSse with eight transforms at a time. Indexed loads use the AVX2 gather
+    TARGET_AVX2 static void ComputeAvx2(const TransformStreams& streams, const uint32_t* indices, uint32_t begin, uint32_t end, const float* viewProj, char* destination, size_t stride)
+    {
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 two = _mm256_set1_ps(2.0f);
+
+        for (uint32_t i = begin; i + 8 <= end; i += 8)
+        {
+            __m256 x, y, z, w, sx, sy, sz;
+            __m256 m[16];
+
+            if (indices == nullptr)
+            {
+                x = _mm256_loadu_ps(streams.rotationX + i);
+                y = _mm256_loadu_ps(streams.rotationY + i);
+                z = _mm256_loadu_ps(streams.rotationZ + i);
+                w = _mm256_loadu_ps(streams.rotationW + i);
+                sx = _mm256_loadu_ps(streams.scaleX + i);
+                sy = _mm256_loadu_ps(streams.scaleY + i);
+                sz = _mm256_loadu_ps(streams.scaleZ + i);
+                m[12] = _mm256_loadu_ps(streams.positionX + i);
+                m[13] = _mm256_loadu_ps(streams.positionY + i);
+                m[14] = _mm256_loadu_ps(streams.positionZ + i);
+            }
+            else
+            {
+                __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i));
+                x = _mm256_i32gather_ps(streams.rotationX, index, 4);
+                y = _mm256_i32gather_ps(streams.rotationY, index, 4);
+                z = _mm256_i32gather_ps(streams.rotationZ, index, 4);
+                w = _mm256_i32gather_ps(streams.rotationW, index, 4);
+                sx = _mm256_i32gather_ps(streams.scaleX, index, 4);
+                sy = _mm256_i32gather_ps(streams.scaleY, index, 4);
+                sz = _mm256_i32gather_ps(streams.scaleZ, index, 4);
+                m[12] = _mm256_i32gather_ps(streams.positionX, index, 4);
+                m[13] = _mm256_i32gather_ps(streams.positionY, index, 4);
+                m[14] = _mm256_i32gather_ps(streams.positionZ, index, 4);
+            }
+
+            __m256 xx = _mm256_mul_ps(x, x);
+            __m256 yy = _mm256_mul_ps(y, y);
+            __m256 zz = _mm256_mul_ps(z, z);
+            __m256 xy = _mm256_mul_ps(x, y);
+            __m256 xz = _mm256_mul_ps(x, z);
+            __m256 yz = _mm256_mul_ps(y, z);
+            __m256 wx = _mm256_mul_ps(w, x);
+            __m256 wy = _mm256_mul_ps(w, y);
+            __m256 wz = _mm256_mul_ps(w, z);
+
+            m[0] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), sx);
+            m[1] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx);
+            m[2] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx);
+            m[3] = _mm256_setzero_ps();
+            m[4] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy);
+            m[5] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), sy);
+            m[6] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy);
+            m[7] = _mm256_setzero_ps();
+            m[8] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz);
+            m[9] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz);
+            m[10] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), sz);
+            m[11] = _mm256_setzero_ps();
+            m[15] = one;
+
+            if (viewProj != nullptr)
+            {
+                __m256 result[16];
+                for (uint32_t column = 0; column < 4; column++)
+                {
+                    for (uint32_t row = 0; row < 4; row++)
+                    {
+                        __m256 sum = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(viewProj[row]), m[column * 4]), _mm256_mul_ps(_mm256_set1_ps(viewProj[4 + row]), m[column * 4 + 1])), _mm256_mul_ps(_mm256_set1_ps(viewProj[8 + row]), m[column * 4 + 2]));
+                        result[column * 4 + row] = column == 3 ? _mm256_add_ps(sum, _mm256_set1_ps(viewProj[12 + row])) : sum;
+                    }
+                }
+                memcpy(m, result, sizeof(m));
+            }
+
+            for (uint32_t column = 0; column < 4; column++)
+            {
+                // A 4x4 transpose within each 128 bit half - the low half ends up with objects 0-3, the high half with objects 4-7
+                __m256 low0 = _mm256_unpacklo_ps(m[column * 4], m[column * 4 + 1]);
+                __m256 high0 = _mm256_unpackhi_ps(m[column * 4], m[column * 4 + 1]);
+                __m256 low1 = _mm256_unpacklo_ps(m[column * 4 + 2], m[column * 4 + 3]);
+                __m256 high1 = _mm256_unpackhi_ps(m[column * 4 + 2], m[column * 4 + 3]);
+                __m256 objects[4];
+                objects[0] = _mm256_shuffle_ps(low0, low1, _MM_SHUFFLE(1, 0, 1, 0));
+                objects[1] = _mm256_shuffle_ps(low0, low1, _MM_SHUFFLE(3, 2, 3, 2));
+                objects[2] = _mm256_shuffle_ps(high0, high1, _MM_SHUFFLE(1, 0, 1, 0));
+                objects[3] = _mm256_shuffle_ps(high0, high1, _MM_SHUFFLE(3, 2, 3, 2));
+
+                for (uint32_t object = 0; object < 4; object++)
+                {
+                    _mm_storeu_ps(reinterpret_cast<float*>(destination + (i + object) * stride) + column * 4, _mm256_castps256_ps128(objects[object]));
+                    _mm_storeu_ps(reinterpret_cast<float*>(destination + (i + object + 4) * stride) + column * 4, _mm256_extractf128_ps(objects[object], 1));
+                }
+            }
+        }
+    }
+
+    static bool SupportsAvx2()
+    {
+    #ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+        {
+            return false;
+        }
+        // AVX has to be supported by the CPU and its registers saved by the OS (OSXSAVE + XCR0) before AVX2 is usable
+        __cpuid(info, 1);
+        bool b_osxsave = (info[2] & (1 << 27)) != 0;
+        bool b_avx = (info[2] & (1 << 28)) != 0;
+        if (!b_osxsave || !b_avx || (_xgetbv(0) & 0x6) != 0x6)
+        {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    #else
+        return __builtin_cpu_supports("avx2");
+    #endif
+    }
+#endif
+
+    TransformSystem::TransformSystem()
+    {
+        m_positionX = std::vector<float>();
+        m_positionY = std::vector<float>();
+        m_positionZ = std::vector<float>();
+        m_rotationX = std::vector<float>();
+        m_rotationY = std::vector<float>();
+        m_rotationZ = std::vector<float>();
+        m_rotationW = std::vector<float>();
+        m_scaleX = std::vector<float>();
+        m_scaleY = std::vector<float>();
+        m_scaleZ = std::vector<float>();
+        m_kernel = GetBestKernel();
+    }
+
+    TransformSystem::~TransformSystem()
+    {
+    }
+
+    uint32_t TransformSystem::Add(glm::vec3 position, glm::quat rotation, glm::vec3 scale)
+    {
+        uint32_t index = GetCount();
+
+        m_positionX.push_back(0.0f);
+        m_positionY.push_back(0.0f);
+        m_positionZ.push_back(0.0f);
+        m_rotationX.push_back(0.0f);
+        m_rotationY.push_back(0.0f);
+        m_rotationZ.push_back(0.0f);
+        m_rotationW.push_back(1.0f);
+        m_scaleX.push_back(1.0f);
+        m_scaleY.push_back(1.0f);
+        m_scaleZ.push_back(1.0f);
+
+        SetPosition(index, position);
+        SetRotation(index, rotation);
+        SetScale(index, scale);
+
+        return index;
+    }
+
+    uint32_t TransformSystem::Add(const glm::mat4& transform)
+    {
+        glm::vec3 columns[3] = { glm::vec3(transform[0].x, transform[0].y, transform[0].z), glm::vec3(transform[1].x, transform[1].y, transform[1].z), glm::vec3(transform[2].x, transform[2].y, transform[2].z) };
+        glm::vec3 scale = glm::vec3(glm::length(columns[0]), glm::length(columns[1]), glm::length(columns[2]));
+
+        // A mirrored transform can't be a rotation, so the mirror goes into the scale
+        if (glm::dot(glm::cross(columns[0], columns[1]), columns[2]) < 0.0f)
+        {
+            scale.x = -scale.x;
+        }
+
+        glm::mat3 rotation(1.0f);
+        for (int i = 0; i < 3; i++)
+        {
+            if (scale[i] != 0.0f)
+            {
+                rotation[i] = columns[i] / scale[i];
+            }
+        }
+
+        return Add(glm::vec3(transform[3].x, transform[3].y, transform[3].z), glm::quat_cast(rotation), scale);
+    }
+
+    void TransformSystem::Clear()
+    {
+        m_positionX.clear();
+        m_positionY.clear();
+        m_positionZ.clear();
+        m_rotationX.clear();
+        m_rotationY.clear();
+        m_rotationZ.clear();
+        m_rotationW.clear();
+        m_scaleX.clear();
+        m_scaleY.clear();
+        m_scaleZ.clear();
+    }
+
+    uint32_t TransformSystem::GetCount()
+    {
+        return static_cast<uint32_t>(m_positionX.size());
+    }
+
+    void TransformSystem::SetPosition(uint32_t index, glm::vec3 position)
+    {
+        m_positionX[index] = position.x;
+        m_positionY[index] = position.y;
+        m_positionZ[index] = position.z;
+    }
+
+    void TransformSystem::SetRotation(uint32_t index, glm::quat rotation)
+    {
+        // The kernels assume unit quaternions
+        rotation = glm::normalize(rotation);
+        m_rotationX[index] = rotation.x;
+        m_rotationY[index] = rotation.y;
+        m_rotationZ[index] = rotation.z;
+        m_rotationW[index] = rotation.w;
+    }
+
+    void TransformSystem::SetScale(uint32_t index, glm::vec3 scale)
+    {
+        m_scaleX[index] = scale.x;
+        m_scaleY[index] = scale.y;
+        m_scaleZ[index] = scale.z;
+    }
+
+    glm::vec3 TransformSystem::GetPosition(uint32_t index)
+    {
+        return glm::vec3(m_positionX[index], m_positionY[index], m_positionZ[index]);
+    }
+
+    glm::quat TransformSystem::GetRotation(uint32_t index)
+    {
+        return glm::quat(m_rotationW[index], m_rotationX[index], m_rotationY[index], m_rotationZ[index]);
+    }
+
+    glm::vec3 TransformSystem::GetScale(uint32_t index)
+    {
+        return glm::vec3(m_scaleX[index], m_scaleY[index], m_scaleZ[index]);
+    }
+
+    void TransformSystem::ComputeWorld(const uint32_t* indices, uint32_t count, void* destination, size_t stride)
+    {
+        Compute(indices, 0, count, nullptr, static_cast<char*>(destination), stride);
+    }
+
+    void TransformSystem::ComputeWorldViewProj(const uint32_t* indices, uint32_t count, const glm::mat4& viewProj, void* destination, size_t stride)
+    {
+        Compute(indices, 0, count, &viewProj[0].x, static_cast<char*>(destination), stride);
+    }
+
+    void TransformSystem::ComputeWorld(const uint32_t* indices, uint32_t count, void* destination, size_t stride, JobSystem& jobSystem)
+    {
+        // Pieces write disjoint ranges of destination and only read the arrays
+        jobSystem.ParallelFor(count, VM_TRANSFORMS_PER_JOB, [&](uint32_t begin, uint32_t end, uint32_t threadIndex)
+        {
+            Compute(indices, begin, end, nullptr, static_cast<char*>(destination), stride);
+        });
+    }
+
+    void TransformSystem::ComputeWorldViewProj(const uint32_t* indices, uint32_t count, const glm::mat4& viewProj, void* destination, size_t stride, JobSystem& jobSystem)
+    {
+        jobSystem.ParallelFor(count, VM_TRANSFORMS_PER_JOB, [&](uint32_t begin, uint32_t end, uint32_t threadIndex)
+        {
+            Compute(indices, begin, end, &viewProj[0].x, static_cast<char*>(destination), stride);
+        });
+    }
+
+    void TransformSystem::ComputeBoundingSpheres(const uint32_t* indices, uint32_t count, const MeshBounds& bounds, float* centerX, float* centerY, float* centerZ, float* radius)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint32_t index = indices[i];
+            float sx = m_scaleX[index];
+            float sy = m_scaleY[index];
+            float sz = m_scaleZ[index];
+
+            // Rotate the scaled center by the unit quaternion - v + 2w(q x v) + 2q x (q x v)
+            glm::vec3 q = glm::vec3(m_rotationX[index], m_rotationY[index], m_rotationZ[index]);
+            glm::vec3 v = bounds.center * glm::vec3(sx, sy, sz);
+            glm::vec3 t = 2.0f * glm::cross(q, v);
+            glm::vec3 center = v + m_rotationW[index] * t + glm::cross(q, t);
+
+            centerX[i] = center.x + m_positionX[index];
+            centerY[i] = center.y + m_positionY[index];
+            centerZ[i] = center.z + m_positionZ[index];
+            radius[i] = bounds.radius * std::max(std::max(std::fabs(sx), std::fabs(sy)), std::fabs(sz));
+        }
+    }
+
+    void TransformSystem::Compute(const uint32_t* indices, uint32_t begin, uint32_t end, const float* viewProj, char* destination, size_t stride)
+    {
+        TransformStreams streams;
+        streams.positionX = m_positionX.data();
+        streams.positionY = m_positionY.data();
+        streams.positionZ = m_positionZ.data();
+        streams.rotationX = m_rotationX.data();
+        streams.rotationY = m_rotationY.data();
+        streams.rotationZ = m_rotationZ.data();
+        streams.rotationW = m_rotationW.data();
+        streams.scaleX = m_scaleX.data();
+        streams.scaleY = m_scaleY.data();
+        streams.scaleZ = m_scaleZ.data();
+
+        // The SIMD kernels stop at the last full group, the scalar one finishes the rest
+        uint32_t simdEnd = begin;
+    #ifdef TRANSFORMS_X64
+        if (m_kernel == Kernel::Avx2)
+        {
+            simdEnd = begin + (end - begin) / 8 * 8;
+            ComputeAvx2(streams, indices, begin, simdEnd, viewProj, destination, stride);
+        }
+        else if (m_kernel == Kernel::Sse)
+        {
+            simdEnd = begin + (end - begin) / 4 * 4;
+            ComputeSse(streams, indices, begin, simdEnd, viewProj, destination, stride);
+        }
+    #endif
+        ComputeScalar(streams, indices, simdEnd, end, viewProj, destination, stride);
+    }
+
+    void TransformSystem::SetKernel(Kernel kernel)
+    {
+        // Never pick something the CPU can't run
+        m_kernel = static_cast<Kernel>(std::min(static_cast<int>(kernel), static_cast<int>(GetBestKernel())));
+    }
+
+    TransformSystem::Kernel TransformSystem::GetKernel()
+    {
+        return m_kernel;
+    }
+
+    TransformSystem::Kernel TransformSystem::GetBestKernel()
+    {
+    #ifdef TRANSFORMS_X64
+        static const Kernel bestKernel = SupportsAvx2() ? Kernel::Avx2 : Kernel::Sse;
+        return bestKernel;
+    #else
+        return Kernel::Scalar;
+    #endif
+    }
+
+    std::string TransformSystem::GetKernelName(Kernel kernel)
+    {
+        switch (kernel)
+        {
+        case Kernel::Avx2:
+            return "avx2";
+        case Kernel::Sse:
+            return "sse";
+        default:
+            return "scalar";
+        }
+    }
+
+    void TransformSystem::PrintStats()
+    {
+        std::cout << "transforms: " << GetCount() << " transforms, " << GetKernelName(m_kernel) << " kernel" << std::endl;
+    }
+
+    void TransformSystem::RunBenchmark(uint32_t count, JobSystem& jobSystem)
+    {
+        const uint32_t ui_iterations = 20;
+
+        TransformSystem transforms;
+        std::mt19937 random(1234); // same transforms every run
+        std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            glm::vec3 position = glm::vec3(distribution(random), distribution(random), distribution(random)) * 100.0f;
+            glm::quat rotation = glm::quat(distribution(random), distribution(random), distribution(random), distribution(random));
+            glm::vec3 scale = glm::vec3(distribution(random) + 2.0f, distribution(random) + 2.0f, distribution(random) + 2.0f);
+            transforms.Add(position, rotation, scale);
+        }
+
+        // Instances are written through an index list (the InstanceBatcher's order), which is mostly the order the objects were added in
+        std::vector<uint32_t> indices(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            indices[i] = i;
+        }
+
+        glm::mat4 viewProj = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f) * glm::lookAt(glm::vec3(200.0f), glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+
+        // Averaged over several runs, as if writing InstanceData into an instance buffer
+        auto timeRuns = [&](bool b_viewProj, bool b_threaded, std::vector<InstanceData>& output)
+        {
+            output.assign(count, InstanceData{});
+            auto start = std::chrono::high_resolution_clock::now();
+            for (uint32_t i = 0; i < ui_iterations; i++)
+            {
+                if (b_threaded && b_viewProj)
+                {
+                    transforms.ComputeWorldViewProj(indices.data(), count, viewProj, output.data(), sizeof(InstanceData), jobSystem);
+                }
+                else if (b_threaded)
+                {
+                    transforms.ComputeWorld(indices.data(), count, output.data(), sizeof(InstanceData), jobSystem);
+                }
+                else if (b_viewProj)
+                {
+                    transforms.ComputeWorldViewProj(indices.data(), count, viewProj, output.data(), sizeof(InstanceData));
+                }
+                else
+                {
+                    transforms.ComputeWorld(indices.data(), count, output.data(), sizeof(InstanceData));
+                }
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            return std::chrono::duration<float, std::chrono::milliseconds::period>(end - start).count() / ui_iterations;
+        };
+
+        // Largest difference against the scalar kernel, relative to the size of the values
+        auto compare = [&](const std::vector<InstanceData>& reference, const std::vector<InstanceData>& output)
+        {
+            float f_maxError = 0.0f;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                for (int column = 0; column < 4; column++)
+                {
+                    for (int row = 0; row < 4; row++)
+                    {
+                        float f_expected = reference[i].model[column][row];
+                        float f_error = std::fabs(output[i].model[column][row] - f_expected) / std::max(1.0f, std::fabs(f_expected));
+                        f_maxError = std::max(f_maxError, f_error);
+                    }
+                }
+            }
+            return f_maxError;
+        };
+
+        std::cout << "transforms: " << count << " objects, " << ui_iterations << " runs each" << std::endl;
+
+        for (int i = 0; i < 2; i++)
+        {
+            bool b_viewProj = i == 1;
+            std::cout << (b_viewProj ? "  world * view * projection" : "  world") << std::endl;
+
+            transforms.SetKernel(Kernel::Scalar);
+            std::vector<InstanceData> reference;
+            float f_scalarMs = timeRuns(b_viewProj, false, reference);
+            std::cout << "    scalar, 1 thread: " << f_scalarMs << " ms" << std::endl;
+
+            for (int kernel = static_cast<int>(Kernel::Sse); kernel <= static_cast<int>(GetBestKernel()); kernel++)
+            {
+                transforms.SetKernel(static_cast<Kernel>(kernel));
+                std::vector<InstanceData> output;
+                float f_ms = timeRuns(b_viewProj, false, output);
+                std::cout << "    " << GetKernelName(transforms.GetKernel()) << ", 1 thread: " << f_ms << " ms (" << f_scalarMs / std::max(f_ms, 0.001f) << "x), max error " << compare(reference, output) << std::endl;
+            }
+
+            transforms.SetKernel(GetBestKernel());
+            std::vector<InstanceData> output;
+            float f_threadedMs = timeRuns(b_viewProj, true, output);
+            std::cout << "    " << GetKernelName(transforms.GetKernel()) << ", " << jobSystem.GetThreadCount() << " threads: " << f_threadedMs << " ms (" << f_scalarMs / std::max(f_threadedMs, 0.001f) << "x), max error " << compare(reference, output) << std::endl;
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "Structs.h"
+#include "JobSystem.h"
+
+#include <glm.hpp>
+#include <gtc/quaternion.hpp>
+
+#include <vector>
+#include <string>
+
+
+namespace VCore
+{
+	// Refer to - https://www.intel.com/content/www/us/en/developer/articles/technical/memory-layout-transformations.html
+	// Positions, rotations and scales of dynamic objects stored as a structure of arrays, so world matrices can be built several objects at a time with SSE/AVX2
+	// (picked at runtime, with a scalar fallback). Matrices are written straight to where they're consumed, usually a mapped per frame buffer, at any stride.
+	// Set* are main thread only. The Compute* calls only read, so they can run from any number of threads at once.
+	class TransformSystem
+	{
+	public:
+		enum class Kernel
+		{
+			Scalar,
+			Sse,
+			Avx2
+		};
+
+		TransformSystem();
+		~TransformSystem();
+
+		// Returns the transform's index. Rotations are normalized on the way in
+		uint32_t Add(glm::vec3 position, glm::quat rotation, glm::vec3 scale);
+		// Decomposes a translate * rotate * scale matrix (shear and projection are dropped)
+		uint32_t Add(const glm::mat4& transform);
+		void Clear();
+		uint32_t GetCount();
+
+		void SetPosition(uint32_t index, glm::vec3 position);
+		void SetRotation(uint32_t index, glm::quat rotation);
+		void SetScale(uint32_t index, glm::vec3 scale);
+		glm::vec3 GetPosition(uint32_t index);
+		glm::quat GetRotation(uint32_t index);
+		glm::vec3 GetScale(uint32_t index);
+
+		// Writes the world matrix of transform indices[i] (or just i when indices is nullptr) to destination + i * stride, for i in [0, count)
+		void ComputeWorld(const uint32_t* indices, uint32_t count, void* destination, size_t stride);
+		// Same, but writes viewProj * world
+		void ComputeWorldViewProj(const uint32_t* indices, uint32_t count, const glm::mat4& viewProj, void* destination, size_t stride);
+		// Splits the work across the job system in VM_TRANSFORMS_PER_JOB sized pieces
+		void ComputeWorld(const uint32_t* indices, uint32_t count, void* destination, size_t stride, JobSystem& jobSystem);
+		void ComputeWorldViewProj(const uint32_t* indices, uint32_t count, const glm::mat4& viewProj, void* destination, size_t stride, JobSystem& jobSystem);
+		// World space bounding sphere of bounds under transform indices[i], as four arrays ready for FrustumCuller::TestSpheres
+		void ComputeBoundingSpheres(const uint32_t* indices, uint32_t count, const MeshBounds& bounds, float* centerX, float* centerY, float* centerZ, float* radius);
+
+		// The best kernel the CPU supports is picked on construction, lower ones can be forced for comparison
+		void SetKernel(Kernel kernel);
+		Kernel GetKernel();
+		static Kernel GetBestKernel();
+		static std::string GetKernelName(Kernel kernel);
+		void PrintStats();
+
+		// Times every supported kernel on count random transforms, single threaded and across the job system, and checks them against the scalar results
+		static void RunBenchmark(uint32_t count, JobSystem& jobSystem);
+
+	private:
+		// Transforms [begin, end) of indices (or [begin, end) themselves), viewProj is optional
+		void Compute(const uint32_t* indices, uint32_t begin, uint32_t end, const float* viewProj, char* destination, size_t stride);
+
+		std::vector<float> m_positionX;
+		std::vector<float> m_positionY;
+		std::vector<float> m_positionZ;
+		std::vector<float> m_rotationX;
+		std::vector<float> m_rotationY;
+		std::vector<float> m_rotationZ;
+		std::vector<float> m_rotationW;
+		std::vector<float> m_scaleX;
+		std::vector<float> m_scaleY;
+		std::vector<float> m_scaleZ;
+		Kernel m_kernel;
+	};
+}
@@ -0,0 +1,89 @@
+#include "UniformRing.h"
+#include "WinSys.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+
+namespace VCore
+{
+    UniformRing::UniformRing()
+    {
+        m_buffers = std::vector<VkBuffer>();
+        m_buffersMemory = std::vector<Allocation>();
+        m_bytesPerFrame = 0;
+        m_alignment = 1;
+        m_peakBytes = 0;
+    }
+
+    UniformRing::~UniformRing()
+    {
+    }
+
+    void UniformRing::Init(uint32_t framesInFlight, VkDeviceSize bytesPerFrame, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice)
+    {
+        // Dynamic offsets have to be a multiple of this (a power of two, up to 256 bytes)
+        m_alignment = std::max<VkDeviceSize>(physicalDevice.GetProperties().limits.minUniformBufferOffsetAlignment, 1);
+        m_bytesPerFrame = bytesPerFrame;
+
+        m_buffers.resize(framesInFlight);
+        m_buffersMemory.resize(framesInFlight);
+        m_heads = std::vector<std::atomic<VkDeviceSize>>(framesInFlight);
+
+        for (uint32_t i = 0; i < framesInFlight; i++)
+        {
+            WinSys::CreateBuffer(bytesPerFrame, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_buffers[i], m_buffersMemory[i], physicalDevice, logicalDevice);
+            m_heads[i] = 0;
+        }
+    }
+
+    void UniformRing::Cleanup(LogicalDevice& logicalDevice)
+    {
+        for (size_t i = 0; i < m_buffers.size(); i++)
+        {
+            vkDestroyBuffer(logicalDevice.GetDevice(), m_buffers[i], nullptr);
+            logicalDevice.GetAllocator().Free(m_buffersMemory[i]);
+        }
+        m_buffers.clear();
+        m_buffersMemory.clear();
+    }
+
+    uint32_t UniformRing::Push(uint32_t frame, const void* data, VkDeviceSize size)
+    {
+        VkDeviceSize alignedSize = (size + m_alignment - 1) & ~(m_alignment - 1);
+        VkDeviceSize offset = m_heads[frame].fetch_add(alignedSize);
+
+        if (offset + size > m_bytesPerFrame)
+        {
+            throw std::runtime_error("failed to push uniform data, the frame's uniform ring is full (raise VM_UNIFORM_RING_SIZE)!");
+        }
+
+        // Host coherent, so the write is visible to the GPU once the frame is submitted without a flush
+        memcpy(static_cast<char*>(m_buffersMemory[frame].mapped) + offset, data, size);
+        return static_cast<uint32_t>(offset);
+    }
+
+    void UniformRing::Reset(uint32_t frame)
+    {
+        // Only the main thread resets, and never while the frame is being recorded
+        VkDeviceSize used = std::min(m_heads[frame].load(), m_bytesPerFrame);
+        m_peakBytes = std::max(m_peakBytes, used);
+        m_heads[frame] = 0;
+    }
+
+    VkBuffer& UniformRing::GetBuffer(uint32_t frame)
+    {
+        return m_buffers[frame];
+    }
+
+    void UniformRing::PrintStats()
+    {
+        for (std::atomic<VkDeviceSize>& head : m_heads)
+        {
+            m_peakBytes = std::max(m_peakBytes, std::min(head.load(), m_bytesPerFrame)); // frames not reset yet
+        }
+        std::cout << "uniform ring: " << m_buffers.size() << " buffers of " << m_bytesPerFrame / 1024 << " KB, peak " << m_peakBytes / 1024 << " KB used in a frame" << std::endl;
+    }
+}
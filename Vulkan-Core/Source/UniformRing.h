@@ -0,0 +1,44 @@
+#pragma once
+#include "PhysicalDevice.h"
+#include "LogicalDevice.h"
+#include "MemoryAllocator.h"
+
+#define GLFW_INCLUDE_VULKAN
+#include <glfw3.h>
+
+#include <vector>
+#include <atomic>
+
+
+namespace VCore
+{
+	// Refer to - https://docs.vulkan.org/samples/latest/samples/api/dynamic_uniform_buffers/README.html
+	// One big persistently mapped uniform buffer per frame in flight that every draw's uniform data is streamed into, instead of a buffer per object per frame.
+	// Draws sub-allocate linearly (lock free, so recording threads can push at the same time) and bind their slice through a UNIFORM_BUFFER_DYNAMIC offset.
+	// Everything pushed for a frame is dropped at once by Reset, after that frame's fence has been waited on.
+	class UniformRing
+	{
+	public:
+		UniformRing();
+		~UniformRing();
+
+		void Init(uint32_t framesInFlight, VkDeviceSize bytesPerFrame, PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
+		void Cleanup(LogicalDevice& logicalDevice);
+
+		// Copies data into frame's buffer and returns the dynamic offset to bind it with. Thread safe
+		uint32_t Push(uint32_t frame, const void* data, VkDeviceSize size);
+		// Call after waiting on frame's fence
+		void Reset(uint32_t frame);
+		VkBuffer& GetBuffer(uint32_t frame);
+		void PrintStats();
+
+	private:
+		std::vector<VkBuffer> m_buffers; // [frame in flight]
+		std::vector<Allocation> m_buffersMemory;
+		std::vector<std::atomic<VkDeviceSize>> m_heads; // next free byte in each frame's buffer
+		VkDeviceSize m_bytesPerFrame;
+		VkDeviceSize m_alignment; // minUniformBufferOffsetAlignment
+
+		VkDeviceSize m_peakBytes; // stats
+	};
+}
@@ -0,0 +1,485 @@
+#include "UploadQueue.h"
+#include "WinSys.h"
+#include "Helper.h"
+
+#include <stdexcept>
+#include <iostream>
+
+
+namespace VCore
+{
+    UploadQueue::UploadQueue()
+    {
+        m_logicalDevice = nullptr;
+        m_physicalDevice = nullptr;
+        m_graphicsFamily = 0;
+        m_transferFamily = 0;
+        m_b_dedicatedTransfer = false;
+        m_transferQueue = VK_NULL_HANDLE;
+        m_graphicsCommandPool = VK_NULL_HANDLE;
+        m_transferCommandPool = VK_NULL_HANDLE;
+
+        m_stagingBuffer = VK_NULL_HANDLE;
+        m_stagingMemory = Allocation();
+        m_ringSize = 0;
+        m_ringHead = 0;
+        m_ringTail = 0;
+        m_ringUsed = 0;
+
+        m_freeBatches = std::vector<Batch>();
+        m_inFlightBatches = std::deque<Batch>();
+        m_currentBatch = Batch();
+        m_b_batchOpen = false;
+        m_nextBatchId = 1;
+        m_retiredBatchId = 0;
+
+        m_submittedBatches = 0;
+        m_uploadCount = 0;
+        m_stagedBytes = 0;
+    }
+
+    UploadQueue::~UploadQueue()
+    {
+    }
+
+    void UploadQueue::Init(PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice, VkSurfaceKHR surface, VkDeviceSize stagingSize, bool b_useTransferQueue)
+    {
+        m_physicalDevice = &physicalDevice;
+        m_logicalDevice = &logicalDevice;
+
+        QueueFamilyIndices indices = Helper::FindQueueFamilies(physicalDevice.GetDevice(), surface);
+        m_graphicsFamily = indices.graphicsFamily.value();
+        m_b_dedicatedTransfer = b_useTransferQueue && indices.transferFamily.has_value() && logicalDevice.GetTransferQueue() != VK_NULL_HANDLE;
+        m_transferFamily = m_b_dedicatedTransfer ? indices.transferFamily.value() : m_graphicsFamily;
+        m_transferQueue = m_b_dedicatedTransfer ? logicalDevice.GetTransferQueue() : logicalDevice.GetGraphicsQueue();
+
+        // Command buffers are short lived and re-recorded every time a batch is reused
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        poolInfo.queueFamilyIndex = m_graphicsFamily;
+
+        if (vkCreateCommandPool(logicalDevice.GetDevice(), &poolInfo, nullptr, &m_graphicsCommandPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create upload command pool!");
+        }
+
+        if (m_b_dedicatedTransfer)
+        {
+            poolInfo.queueFamilyIndex = m_transferFamily;
+
+            if (vkCreateCommandPool(logicalDevice.GetDevice(), &poolInfo, nullptr, &m_transferCommandPool) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create transfer command pool!");
+            }
+        }
+
+        m_ringSize = stagingSize;
+        WinSys::CreateBuffer(m_ringSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_stagingBuffer, m_stagingMemory, physicalDevice, logicalDevice);
+    }
+
+    void UploadQueue::Cleanup(LogicalDevice& logicalDevice)
+    {
+        WaitIdle();
+
+        for (Batch& batch : m_freeBatches)
+        {
+            vkDestroyFence(logicalDevice.GetDevice(), batch.fence, nullptr);
+            if (batch.transferComplete != VK_NULL_HANDLE)
+            {
+                vkDestroySemaphore(logicalDevice.GetDevice(), batch.transferComplete, nullptr);
+            }
+        }
+        m_freeBatches.clear();
+
+        vkDestroyBuffer(logicalDevice.GetDevice(), m_stagingBuffer, nullptr);
+        logicalDevice.GetAllocator().Free(m_stagingMemory);
+
+        // Destroying the pools frees the command buffers allocated from them
+        vkDestroyCommandPool(logicalDevice.GetDevice(), m_graphicsCommandPool, nullptr);
+        if (m_transferCommandPool != VK_NULL_HANDLE)
+        {
+            vkDestroyCommandPool(logicalDevice.GetDevice(), m_transferCommandPool, nullptr);
+        }
+    }
+
+    UploadQueue::Batch& UploadQueue::GetCurrentBatch()
+    {
+        if (m_b_batchOpen)
+        {
+            return m_currentBatch;
+        }
+
+        // Reuse a retired batch if there is one, otherwise create the sync objects and command buffers for a new one
+        if (!m_freeBatches.empty())
+        {
+            m_currentBatch = std::move(m_freeBatches.back());
+            m_freeBatches.pop_back();
+        }
+        else
+        {
+            m_currentBatch = Batch();
+
+            VkFenceCreateInfo fenceInfo{};
+            fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            if (vkCreateFence(m_logicalDevice->GetDevice(), &fenceInfo, nullptr, &m_currentBatch.fence) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create upload fence!");
+            }
+
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = m_graphicsCommandPool;
+            allocInfo.commandBufferCount = 1;
+            if (vkAllocateCommandBuffers(m_logicalDevice->GetDevice(), &allocInfo, &m_currentBatch.graphicsCommands) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to allocate upload command buffer!");
+            }
+
+            if (m_b_dedicatedTransfer)
+            {
+                allocInfo.commandPool = m_transferCommandPool;
+                if (vkAllocateCommandBuffers(m_logicalDevice->GetDevice(), &allocInfo, &m_currentBatch.transferCommands) != VK_SUCCESS)
+                {
+                    throw std::runtime_error("failed to allocate transfer command buffer!");
+                }
+
+                VkSemaphoreCreateInfo semaphoreInfo{};
+                semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+                if (vkCreateSemaphore(m_logicalDevice->GetDevice(), &semaphoreInfo, nullptr, &m_currentBatch.transferComplete) != VK_SUCCESS)
+                {
+                    throw std::runtime_error("failed to create transfer semaphore!");
+                }
+            }
+        }
+
+        m_currentBatch.id = m_nextBatchId++;
+        m_currentBatch.b_transferRecording = false;
+        m_currentBatch.b_graphicsRecording = false;
+        m_currentBatch.ringBytes = 0;
+        m_currentBatch.ringEnd = m_ringHead;
+        m_b_batchOpen = true;
+
+        return m_currentBatch;
+    }
+
+    void UploadQueue::BeginCommands(VkCommandBuffer commandBuffer)
+    {
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to begin recording upload command buffer!");
+        }
+    }
+
+    bool UploadQueue::AllocateFromRing(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset)
+    {
+        if (m_ringUsed == m_ringSize)
+        {
+            return false;
+        }
+
+        VkDeviceSize alignedHead = (m_ringHead + alignment - 1) & ~(alignment - 1);
+        VkDeviceSize consumed = 0;
+
+        if (m_ringHead >= m_ringTail)
+        {
+            // Free space is [head, end) followed by [0, tail)
+            if (alignedHead + size <= m_ringSize)
+            {
+                offset = alignedHead;
+                consumed = alignedHead + size - m_ringHead;
+            }
+            else if (size <= m_ringTail)
+            {
+                // Wrap around - the unused space at the end belongs to this batch until it retires
+                offset = 0;
+                consumed = (m_ringSize - m_ringHead) + size;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        else
+        {
+            // Free space is [head, tail)
+            if (alignedHead + size > m_ringTail)
+            {
+                return false;
+            }
+            offset = alignedHead;
+            consumed = alignedHead + size - m_ringHead;
+        }
+
+        m_ringHead = offset + size;
+        m_ringUsed += consumed;
+        m_currentBatch.ringBytes += consumed;
+        m_currentBatch.ringEnd = m_ringHead;
+
+        return true;
+    }
+
+    StagingRange UploadQueue::Stage(const void* data, VkDeviceSize size, VkDeviceSize alignment)
+    {
+        StagingRange range{};
+        m_stagedBytes += size;
+
+        if (size > m_ringSize)
+        {
+            // Bigger than the whole ring, give it a buffer of its own that lives as long as the batch
+            Batch& batch = GetCurrentBatch();
+            VkBuffer buffer{};
+            Allocation memory{};
+            WinSys::CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, buffer, memory, *m_physicalDevice, *m_logicalDevice, AllocationStrategy::LINEAR);
+            memcpy(memory.mapped, data, static_cast<size_t>(size));
+            batch.oversizedBuffers.push_back(buffer);
+            batch.oversizedMemory.push_back(memory);
+
+            range.buffer = buffer;
+            range.offset = 0;
+            return range;
+        }
+
+        GetCurrentBatch();
+        VkDeviceSize offset = 0;
+        while (!AllocateFromRing(size, alignment, offset))
+        {
+            // Ring is full - submit what we have and wait for the oldest batch to hand its space back
+            if (m_b_batchOpen && m_currentBatch.ringBytes > 0)
+            {
+                Flush();
+            }
+            RetireOldestBatch(true);
+            GetCurrentBatch();
+        }
+
+        memcpy(static_cast<char*>(m_stagingMemory.mapped) + offset, data, static_cast<size_t>(size));
+
+        range.buffer = m_stagingBuffer;
+        range.offset = offset;
+        return range;
+    }
+
+    VkCommandBuffer UploadQueue::GetGraphicsCommands()
+    {
+        Batch& batch = GetCurrentBatch();
+
+        if (!batch.b_graphicsRecording)
+        {
+            BeginCommands(batch.graphicsCommands);
+            batch.b_graphicsRecording = true;
+        }
+
+        m_uploadCount++;
+        return batch.graphicsCommands;
+    }
+
+    void UploadQueue::UploadBuffer(const void* data, VkDeviceSize size, VkBuffer dstBuffer, VkAccessFlags dstAccessMask, VkPipelineStageFlags dstStageMask, VkDeviceSize dstOffset, bool b_graphicsQueue)
+    {
+        StagingRange staging = Stage(data, size);
+        Batch& batch = GetCurrentBatch();
+
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = staging.offset;
+        copyRegion.dstOffset = dstOffset;
+        copyRegion.size = size;
+
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.buffer = dstBuffer;
+        barrier.offset = dstOffset;
+        barrier.size = size;
+
+        if (m_b_dedicatedTransfer && !b_graphicsQueue)
+        {
+            // Refer to - https://registry.khronos.org/vulkan/specs/1.3-extensions/html/vkspec.html#synchronization-queue-transfers
+            // The buffer is exclusive to one family at a time, so the transfer queue releases it after the copy and the graphics queue acquires it with a matching barrier
+            if (!batch.b_transferRecording)
+            {
+                BeginCommands(batch.transferCommands);
+                batch.b_transferRecording = true;
+            }
+
+            vkCmdCopyBuffer(batch.transferCommands, staging.buffer, dstBuffer, 1, &copyRegion);
+
+            barrier.srcQueueFamilyIndex = m_transferFamily;
+            barrier.dstQueueFamilyIndex = m_graphicsFamily;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = 0;
+            vkCmdPipelineBarrier(batch.transferCommands, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = dstAccessMask;
+            vkCmdPipelineBarrier(GetGraphicsCommands(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStageMask, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+        }
+        else
+        {
+            VkCommandBuffer commandBuffer = GetGraphicsCommands();
+            vkCmdCopyBuffer(commandBuffer, staging.buffer, dstBuffer, 1, &copyRegion);
+
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = dstAccessMask;
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStageMask, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+        }
+    }
+
+    uint64_t UploadQueue::Flush()
+    {
+        if (!m_b_batchOpen)
+        {
+            return m_nextBatchId - 1;
+        }
+
+        Batch& batch = m_currentBatch;
+
+        // The fence is signaled by the graphics submit, so there always is one (even if it's empty) to keep completion tracking in one place
+        if (!batch.b_graphicsRecording)
+        {
+            BeginCommands(batch.graphicsCommands);
+            batch.b_graphicsRecording = true;
+        }
+
+        VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        VkSubmitInfo graphicsSubmit{};
+        graphicsSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+
+        if (batch.b_transferRecording)
+        {
+            vkEndCommandBuffer(batch.transferCommands);
+
+            VkSubmitInfo transferSubmit{};
+            transferSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            transferSubmit.commandBufferCount = 1;
+            transferSubmit.pCommandBuffers = &batch.transferCommands;
+            transferSubmit.signalSemaphoreCount = 1;
+            transferSubmit.pSignalSemaphores = &batch.transferComplete;
+
+            if (vkQueueSubmit(m_transferQueue, 1, &transferSubmit, VK_NULL_HANDLE) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to submit transfer command buffer!");
+            }
+
+            // The acquire barriers in the graphics commands must not run before the copies finish
+            graphicsSubmit.waitSemaphoreCount = 1;
+            graphicsSubmit.pWaitSemaphores = &batch.transferComplete;
+            graphicsSubmit.pWaitDstStageMask = &waitStage;
+        }
+
+        vkEndCommandBuffer(batch.graphicsCommands);
+        graphicsSubmit.commandBufferCount = 1;
+        graphicsSubmit.pCommandBuffers = &batch.graphicsCommands;
+
+        if (vkQueueSubmit(m_logicalDevice->GetGraphicsQueue(), 1, &graphicsSubmit, batch.fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to submit upload command buffer!");
+        }
+
+        uint64_t batchId = batch.id;
+        m_inFlightBatches.push_back(std::move(m_currentBatch));
+        m_b_batchOpen = false;
+        m_submittedBatches++;
+
+        return batchId;
+    }
+
+    bool UploadQueue::RetireOldestBatch(bool b_wait)
+    {
+        if (m_inFlightBatches.empty())
+        {
+            return false;
+        }
+
+        Batch& batch = m_inFlightBatches.front();
+
+        if (b_wait)
+        {
+            vkWaitForFences(m_logicalDevice->GetDevice(), 1, &batch.fence, VK_TRUE, UINT64_MAX);
+        }
+        else if (vkGetFenceStatus(m_logicalDevice->GetDevice(), batch.fence) != VK_SUCCESS)
+        {
+            return false;
+        }
+
+        vkResetFences(m_logicalDevice->GetDevice(), 1, &batch.fence);
+
+        for (size_t i = 0; i < batch.oversizedBuffers.size(); i++)
+        {
+            vkDestroyBuffer(m_logicalDevice->GetDevice(), batch.oversizedBuffers[i], nullptr);
+            m_logicalDevice->GetAllocator().Free(batch.oversizedMemory[i]);
+        }
+        batch.oversizedBuffers.clear();
+        batch.oversizedMemory.clear();
+
+        // Batches retire in submission order, so the ring tail simply moves up to where this batch stopped allocating
+        if (batch.ringBytes > 0)
+        {
+            m_ringUsed -= batch.ringBytes;
+            m_ringTail = batch.ringEnd;
+        }
+        if (m_ringUsed == 0)
+        {
+            m_ringHead = 0;
+            m_ringTail = 0;
+            if (m_b_batchOpen)
+            {
+                m_currentBatch.ringEnd = 0;
+            }
+        }
+
+        m_retiredBatchId = batch.id;
+        m_freeBatches.push_back(std::move(batch));
+        m_inFlightBatches.pop_front();
+
+        return true;
+    }
+
+    bool UploadQueue::IsComplete(uint64_t batchId)
+    {
+        Update();
+        return batchId <= m_retiredBatchId;
+    }
+
+    void UploadQueue::Wait(uint64_t batchId)
+    {
+        if (m_b_batchOpen && batchId >= m_currentBatch.id)
+        {
+            Flush();
+        }
+
+        while (m_retiredBatchId < batchId && !m_inFlightBatches.empty())
+        {
+            RetireOldestBatch(true);
+        }
+    }
+
+    void UploadQueue::WaitIdle()
+    {
+        Flush();
+
+        while (!m_inFlightBatches.empty())
+        {
+            RetireOldestBatch(true);
+        }
+    }
+
+    void UploadQueue::Update()
+    {
+        // Stops at the first batch still running - later batches may have finished too, but the ring has to be released in order
+        while (RetireOldestBatch(false))
+        {
+        }
+    }
+
+    void UploadQueue::PrintStats()
+    {
+        std::cout << "uploads: " << m_uploadCount << " recorded in " << m_submittedBatches << " batches, " << m_stagedBytes / 1024 << " KiB staged"
+            << (m_b_dedicatedTransfer ? " (dedicated transfer queue)" : " (graphics queue)") << std::endl;
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include "PhysicalDevice.h"
+#include "LogicalDevice.h"
+#include "MemoryAllocator.h"
+
+#define GLFW_INCLUDE_VULKAN
+#include <glfw3.h>
+
+#include <vector>
+#include <deque>
+
+
+namespace VCore
+{
+	// Where staged data lives until the batch that reads it has finished on the GPU
+	struct StagingRange
+	{
+		VkBuffer buffer;
+		VkDeviceSize offset;
+	};
+
+	// Batches asset uploads (buffer copies, image layout transitions, buffer to image copies and mip generation) into a few command buffers instead of
+	// submitting and vkQueueWaitIdle'ing once per operation. Completion is tracked with a fence per batch, and staging data is copied into a ring buffer
+	// that gets reused as soon as the batches reading from it retire.
+	// If the device exposes a dedicated transfer queue family, buffer copies run there (the DMA engine) and ownership is handed to the graphics queue,
+	// unless they're into a buffer the graphics queue is already using (see UploadBuffer).
+	// Image work always goes on the graphics queue since mip generation uses vkCmdBlitImage.
+	class UploadQueue
+	{
+	public:
+		UploadQueue();
+		~UploadQueue();
+
+		void Init(PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice, VkSurfaceKHR surface, VkDeviceSize stagingSize, bool b_useTransferQueue = true);
+		void Cleanup(LogicalDevice& logicalDevice);
+
+		// Copies data into staging memory owned by the current batch. Call before GetGraphicsCommands(), staging may flush the batch to free ring space.
+		StagingRange Stage(const void* data, VkDeviceSize size, VkDeviceSize alignment = 16);
+		// Command buffer for graphics queue work in the current batch (image transitions, copies and blits) - recorded commands run in the order they were added
+		VkCommandBuffer GetGraphicsCommands();
+		// Stages data and copies it into dstBuffer at dstOffset. dstAccessMask/dstStageMask describe the first use of the buffer (ie. vertex attribute reads at vertex input).
+		// b_graphicsQueue keeps the copy on the graphics queue even with a dedicated transfer queue - for buffers the graphics queue already owns and reads from (ie. GeometryArena pages),
+		// which can't be released to another family one range at a time while draws use the rest
+		void UploadBuffer(const void* data, VkDeviceSize size, VkBuffer dstBuffer, VkAccessFlags dstAccessMask, VkPipelineStageFlags dstStageMask, VkDeviceSize dstOffset = 0, bool b_graphicsQueue = false);
+
+		// Submits the current batch and returns its id (0 if nothing has been recorded yet)
+		uint64_t Flush();
+		bool IsComplete(uint64_t batchId);
+		void Wait(uint64_t batchId);
+		// Flushes and waits for every batch
+		void WaitIdle();
+		// Retires finished batches so their staging memory can be reused. Cheap, call once per frame
+		void Update();
+		void PrintStats();
+
+	private:
+		struct Batch
+		{
+			uint64_t id = 0;
+			VkCommandBuffer transferCommands = VK_NULL_HANDLE;
+			VkCommandBuffer graphicsCommands = VK_NULL_HANDLE;
+			VkFence fence = VK_NULL_HANDLE;
+			VkSemaphore transferComplete = VK_NULL_HANDLE;
+			bool b_transferRecording = false;
+			bool b_graphicsRecording = false;
+			VkDeviceSize ringBytes = 0; // ring space consumed by this batch (including wrap around waste)
+			VkDeviceSize ringEnd = 0; // ring head after this batch's last allocation
+			std::vector<VkBuffer> oversizedBuffers; // staging too big for the ring, released when the batch retires
+			std::vector<Allocation> oversizedMemory;
+		};
+
+		Batch& GetCurrentBatch();
+		bool AllocateFromRing(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+		bool RetireOldestBatch(bool b_wait);
+		void BeginCommands(VkCommandBuffer commandBuffer);
+
+		LogicalDevice* m_logicalDevice;
+		PhysicalDevice* m_physicalDevice;
+		uint32_t m_graphicsFamily;
+		uint32_t m_transferFamily;
+		bool m_b_dedicatedTransfer;
+		VkQueue m_transferQueue;
+		VkCommandPool m_graphicsCommandPool;
+		VkCommandPool m_transferCommandPool;
+
+		// Staging ring
+		VkBuffer m_stagingBuffer;
+		Allocation m_stagingMemory;
+		VkDeviceSize m_ringSize;
+		VkDeviceSize m_ringHead;
+		VkDeviceSize m_ringTail;
+		VkDeviceSize m_ringUsed;
+
+		std::vector<Batch> m_freeBatches;
+		std::deque<Batch> m_inFlightBatches;
+		Batch m_currentBatch;
+		bool m_b_batchOpen;
+		uint64_t m_nextBatchId;
+		uint64_t m_retiredBatchId; // every batch with an id <= this has completed
+
+		// stats
+		uint64_t m_submittedBatches;
+		uint64_t m_uploadCount;
+		VkDeviceSize m_stagedBytes;
+	};
+}
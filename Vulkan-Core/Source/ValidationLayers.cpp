@@ -63,13 +63,19 @@ namespace VCore
     }
 
     // Get extensions for debug validation layers
-    std::vector<const char*> ValidationLayers::GetRequiredExtensions() 
+    std::vector<const char*> ValidationLayers::GetRequiredExtensions(bool b_headless) 
     {
-        uint32_t ui_glfwExtensionCount = 0;
-        const char** glfwExtensions;
-        glfwExtensions = glfwGetRequiredInstanceExtensions(&ui_glfwExtensionCount);
+        std::vector<const char*> extensions;
 
-        std::vector<const char*> extensions(glfwExtensions, glfwExtensions + ui_glfwExtensionCount);
+        // glfw isn't initialized when running headless, and no surface extensions are needed without a window
+        if (!b_headless)
+        {
+            uint32_t ui_glfwExtensionCount = 0;
+            const char** glfwExtensions;
+            glfwExtensions = glfwGetRequiredInstanceExtensions(&ui_glfwExtensionCount);
+
+            extensions.assign(glfwExtensions, glfwExtensions + ui_glfwExtensionCount);
+        }
 
         if (b_ENABLE_VALIDATION_LAYERS) {
             extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -16,7 +16,7 @@ namespace VCore
 
         void SetupDebugMessenger(VkInstance instance);
         bool CheckSupport();
-        std::vector<const char*> GetRequiredExtensions(); // Get extensions for debug validation layers
+        std::vector<const char*> GetRequiredExtensions(bool b_headless = false); // Get extensions for debug validation layers (and glfw's window extensions unless running headless)
         // Create info for debug messenger so we don't have to repeat code for debug messenger for vkCreateInstance and vkDestroyInstance calls
         void PopulateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
         std::vector<const char*>::size_type Size();
@@ -0,0 +1,171 @@
+#include "VertexCodec.h"
+
+#include <gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace VCore
+{
+    // Fills in one compact vertex of either format, the color only if TCompact has one. positionOffset and toGrid map the mesh's bounds onto 0 - 65535
+    template<typename TCompact>
+    static TCompact EncodeCompact(const Vertex& vertex, glm::vec3 positionOffset, glm::vec3 toGrid, Snorm16x2 normal)
+    {
+        TCompact encoded{};
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float f_step = (vertex.pos[axis] - positionOffset[axis]) * toGrid[axis];
+            encoded.position.v[axis] = static_cast<uint16_t>(std::clamp(std::lround(f_step), 0l, 65535l));
+        }
+        encoded.normal = normal;
+        encoded.texCoord = { glm::packHalf1x16(vertex.texCoord.x), glm::packHalf1x16(vertex.texCoord.y) };
+
+        if constexpr (requires { encoded.color; })
+        {
+            encoded.color.v[3] = 255;
+            for (int channel = 0; channel < 3; channel++)
+            {
+                encoded.color.v[channel] = static_cast<uint8_t>(std::lround(std::clamp(vertex.color[channel], 0.0f, 1.0f) * 255.0f));
+            }
+        }
+        return encoded;
+    }
+
+    uint32_t VertexCodec::GetStride(VertexFormat format)
+    {
+        switch (format)
+        {
+        case VertexFormat::COMPACT:
+            return CompactVertexLayout::stride;
+        case VertexFormat::COMPACT_COLOR:
+            return CompactColorVertexLayout::stride;
+        default:
+            return FullVertexLayout::stride;
+        }
+    }
+
+    VkVertexInputBindingDescription VertexCodec::GetBindingDescription(VertexFormat format)
+    {
+        switch (format)
+        {
+        case VertexFormat::COMPACT:
+            return CompactVertexLayout::GetBindingDescription();
+        case VertexFormat::COMPACT_COLOR:
+            return CompactColorVertexLayout::GetBindingDescription();
+        default:
+            return FullVertexLayout::GetBindingDescription();
+        }
+    }
+
+    std::vector<VkVertexInputAttributeDescription> VertexCodec::GetAttributeDescriptions(VertexFormat format)
+    {
+        switch (format)
+        {
+        case VertexFormat::COMPACT:
+            return CompactVertexLayout::GetAttributeDescriptionList();
+        case VertexFormat::COMPACT_COLOR:
+            return CompactColorVertexLayout::GetAttributeDescriptionList();
+        default:
+            return FullVertexLayout::GetAttributeDescriptionList();
+        }
+    }
+
+    void VertexCodec::Encode(VertexFormat format, const Vertex* vertices, uint32_t count, const MeshBounds& bounds, std::vector<uint8_t>& out, glm::vec3& positionOffset, glm::vec3& positionScale)
+    {
+        out.clear();
+
+        if (format == VertexFormat::FULL)
+        {
+            positionOffset = glm::vec3(0.0f);
+            positionScale = glm::vec3(1.0f);
+            FullVertexLayout::Pack(vertices, count, out);
+            return;
+        }
+
+        // The box is the quantization grid, 65536 steps per axis. A flat axis (extent 0) stores 0 and gets all of its position from the offset
+        positionOffset = bounds.min;
+        positionScale = bounds.max - bounds.min;
+        glm::vec3 toGrid = glm::vec3(
+            positionScale.x > 0.0f ? 65535.0f / positionScale.x : 0.0f,
+            positionScale.y > 0.0f ? 65535.0f / positionScale.y : 0.0f,
+            positionScale.z > 0.0f ? 65535.0f / positionScale.z : 0.0f);
+
+        out.reserve(static_cast<size_t>(count) * GetStride(format));
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const Vertex& vertex = vertices[i];
+            if (format == VertexFormat::COMPACT_COLOR)
+            {
+                CompactColorVertex encoded = EncodeCompact<CompactColorVertex>(vertex, positionOffset, toGrid, EncodeNormal(vertex.normal));
+                CompactColorVertexLayout::Pack(&encoded, 1, out);
+            }
+            else
+            {
+                CompactVertex encoded = EncodeCompact<CompactVertex>(vertex, positionOffset, toGrid, EncodeNormal(vertex.normal));
+                CompactVertexLayout::Pack(&encoded, 1, out);
+            }
+        }
+    }
+
+    Snorm16x2 VertexCodec::EncodeNormal(glm::vec3 normal)
+    {
+        // Project onto the octahedron |x| + |y| + |z| = 1, then fold the lower half over the diagonals so it covers the whole square.
+        // A zero normal (the OBJ had none) comes out as (0, 0), which decodes to +z
+        float f_length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+        glm::vec2 octahedron = f_length > 0.0f ? glm::vec2(normal.x, normal.y) / f_length : glm::vec2(0.0f);
+        if (f_length > 0.0f && normal.z < 0.0f)
+        {
+            octahedron = glm::vec2(
+                (1.0f - std::abs(octahedron.y)) * (octahedron.x >= 0.0f ? 1.0f : -1.0f),
+                (1.0f - std::abs(octahedron.x)) * (octahedron.y >= 0.0f ? 1.0f : -1.0f));
+        }
+
+        Snorm16x2 encoded;
+        encoded.v[0] = static_cast<int16_t>(std::lround(std::clamp(octahedron.x, -1.0f, 1.0f) * 32767.0f));
+        encoded.v[1] = static_cast<int16_t>(std::lround(std::clamp(octahedron.y, -1.0f, 1.0f) * 32767.0f));
+        return encoded;
+    }
+
+    std::string VertexCodec::GetShaderPath(const std::string& path, VertexFormat format)
+    {
+        if (format == VertexFormat::FULL)
+        {
+            return path;
+        }
+
+        std::string suffix = format == VertexFormat::COMPACT ? "_compact" : "_compact_color";
+        size_t extension = path.rfind(".spv");
+        if (extension == std::string::npos)
+        {
+            return path + suffix;
+        }
+        return path.substr(0, extension) + suffix + path.substr(extension);
+    }
+
+    const char* VertexCodec::GetName(VertexFormat format)
+    {
+        switch (format)
+        {
+        case VertexFormat::COMPACT:
+            return "compact";
+        case VertexFormat::COMPACT_COLOR:
+            return "compact-color";
+        default:
+            return "full";
+        }
+    }
+
+    bool VertexCodec::Parse(const std::string& name, VertexFormat& format)
+    {
+        for (VertexFormat candidate : { VertexFormat::FULL, VertexFormat::COMPACT, VertexFormat::COMPACT_COLOR })
+        {
+            if (name == GetName(candidate))
+            {
+                format = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+}
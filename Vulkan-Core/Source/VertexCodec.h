@@ -0,0 +1,74 @@
+#pragma once
+#include "Structs.h"
+
+#define GLFW_INCLUDE_VULKAN
+#include <glfw3.h>
+#include <glm.hpp>
+
+#include <vector>
+#include <string>
+
+
+namespace VCore
+{
+	// How mesh vertices are stored in the GeometryArena and read by the vertex shaders. One format for the whole scene, picked before anything is loaded
+	enum class VertexFormat
+	{
+		FULL, // Vertex as is, 44 bytes of floats
+		COMPACT, // 16 bytes: 16 bit positions quantized to the mesh's bounds, octahedral 16 bit normals and half float UVs. No color, the shaders use white
+		COMPACT_COLOR // 20 bytes: COMPACT plus an 8 bit RGBA color
+	};
+
+	// VertexFormat::COMPACT as stored. Same locations as Vertex's, so the instance attributes still start at 4. Without a color there's nothing at location 1
+	struct CompactVertex
+	{
+		Unorm16x4 position; // quantized to the mesh's bounds, w unused
+		Snorm16x2 normal; // octahedral
+		Half2 texCoord;
+	};
+
+	using CompactVertexLayout = VertexLayout<CompactVertex, 0, VK_VERTEX_INPUT_RATE_VERTEX,
+		VCORE_VERTEX_ATTRIBUTE(CompactVertex, position, 0),
+		VCORE_VERTEX_ATTRIBUTE(CompactVertex, texCoord, 2),
+		VCORE_VERTEX_ATTRIBUTE(CompactVertex, normal, 3)>;
+
+	// VertexFormat::COMPACT_COLOR as stored
+	struct CompactColorVertex
+	{
+		Unorm16x4 position;
+		Snorm16x2 normal;
+		Half2 texCoord;
+		Unorm8x4 color;
+	};
+
+	using CompactColorVertexLayout = VertexLayout<CompactColorVertex, 0, VK_VERTEX_INPUT_RATE_VERTEX,
+		VCORE_VERTEX_ATTRIBUTE(CompactColorVertex, position, 0),
+		VCORE_VERTEX_ATTRIBUTE(CompactColorVertex, color, 1),
+		VCORE_VERTEX_ATTRIBUTE(CompactColorVertex, texCoord, 2),
+		VCORE_VERTEX_ATTRIBUTE(CompactColorVertex, normal, 3)>;
+
+	// Refer to - https://www.jcgt.org/published/0003/02/01/ (octahedral normals) and https://gpuopen.com/learn/vertex-compression/
+	// Turns the full precision vertices meshes are imported and cached as into the format the GPU reads, at upload time, so the .vmesh caches never change.
+	// Each format is a struct declared through a VertexLayout, which is where the strides and attribute descriptions come from.
+	// The compact formats only use formats the vertex input fetch converts to floats (UNORM, SNORM, SFLOAT), so the shaders are left with undoing the quantization
+	// (the per mesh positionOffset and positionScale pushed with every draw) and decoding the normal. Compact shaders are built from the same sources with
+	// -DCOMPACT_VERTEX (and -DVERTEX_COLOR), see Shaders/vertex_input.glsl and GetShaderPath.
+	class VertexCodec
+	{
+	public:
+		static uint32_t GetStride(VertexFormat format);
+		static VkVertexInputBindingDescription GetBindingDescription(VertexFormat format);
+		static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions(VertexFormat format);
+		// Writes count vertices in format to out (count * GetStride bytes). Positions are quantized to bounds, object space position = positionOffset + stored * positionScale
+		static void Encode(VertexFormat format, const Vertex* vertices, uint32_t count, const MeshBounds& bounds, std::vector<uint8_t>& out, glm::vec3& positionOffset, glm::vec3& positionScale);
+		// The build of the vertex shader at path for format, "vert.spv" -> "vert_compact.spv" / "vert_compact_color.spv"
+		static std::string GetShaderPath(const std::string& path, VertexFormat format);
+		static const char* GetName(VertexFormat format);
+		// "full", "compact" or "compact-color", false if name is none of them
+		static bool Parse(const std::string& name, VertexFormat& format);
+
+	private:
+		// Folds the unit sphere onto the octahedron and that onto a square, undone by OctDecode in Shaders/vertex_input.glsl
+		static Snorm16x2 EncodeNormal(glm::vec3 normal);
+	};
+}
@@ -0,0 +1,96 @@
+#include "VertexHashTable.h"
+#include "Helper.h"
+
+#include <cstring>
+
+
+namespace VCore
+{
+    static const uint32_t EMPTY_SLOT = UINT32_MAX;
+    static_assert(sizeof(Vertex) == 11 * sizeof(float), "Vertex is hashed and compared as raw bytes, it can't have padding");
+
+    VertexHashTable::VertexHashTable()
+    {
+        m_slots = std::vector<Slot>();
+        m_mask = 0;
+        m_count = 0;
+    }
+
+    VertexHashTable::~VertexHashTable()
+    {
+    }
+
+    void VertexHashTable::Reserve(size_t count)
+    {
+        // Keep the load factor at or under 1/2 so probe sequences stay short
+        size_t capacity = 16;
+        while (capacity < count * 2)
+        {
+            capacity *= 2;
+        }
+
+        // Only while empty - once vertices are in, growing needs the vertex array to rehash (FindOrInsert handles that)
+        if (capacity > m_slots.size() && m_count == 0)
+        {
+            m_slots.assign(capacity, Slot{ 0, EMPTY_SLOT });
+            m_mask = capacity - 1;
+        }
+    }
+
+    uint64_t VertexHashTable::Hash(const Vertex& vertex)
+    {
+        return Helper::Hash64(&vertex, sizeof(Vertex));
+    }
+
+    uint32_t VertexHashTable::FindOrInsert(const Vertex& vertex, uint64_t hash, std::vector<Vertex>& vertices, bool& b_inserted)
+    {
+        if ((m_count + 1) * 2 > m_slots.size())
+        {
+            Grow(vertices);
+        }
+
+        uint32_t hashTag = static_cast<uint32_t>(hash >> 32);
+        size_t slot = static_cast<size_t>(hash) & m_mask;
+
+        while (m_slots[slot].index != EMPTY_SLOT)
+        {
+            if (m_slots[slot].hashTag == hashTag && memcmp(&vertices[m_slots[slot].index], &vertex, sizeof(Vertex)) == 0)
+            {
+                b_inserted = false;
+                return m_slots[slot].index;
+            }
+            slot = (slot + 1) & m_mask;
+        }
+
+        uint32_t index = static_cast<uint32_t>(vertices.size());
+        vertices.push_back(vertex);
+        m_slots[slot] = Slot{ hashTag, index };
+        m_count++;
+
+        b_inserted = true;
+        return index;
+    }
+
+    void VertexHashTable::Grow(const std::vector<Vertex>& vertices)
+    {
+        // Slots don't keep the full hash, so rehash from the vertices themselves. Only happens if Reserve was too small.
+        std::vector<Slot> oldSlots = std::move(m_slots);
+        size_t capacity = oldSlots.empty() ? 16 : oldSlots.size() * 2;
+        m_slots.assign(capacity, Slot{ 0, EMPTY_SLOT });
+        m_mask = capacity - 1;
+
+        for (const Slot& oldSlot : oldSlots)
+        {
+            if (oldSlot.index != EMPTY_SLOT)
+            {
+                uint64_t hash = Hash(vertices[oldSlot.index]);
+                size_t slot = static_cast<size_t>(hash) & m_mask;
+                while (m_slots[slot].index != EMPTY_SLOT)
+                {
+                    slot = (slot + 1) & m_mask;
+                }
+                m_slots[slot] = oldSlot;
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+#include "Structs.h"
+
+#include <vector>
+
+
+namespace VCore
+{
+	// Open addressing (linear probing) set of vertices used for deduplication. Slots only hold an index into the caller's vertex array plus part of the hash,
+	// so the table stays small and flat instead of allocating a node per vertex the way std::unordered_map<Vertex, uint32_t> does.
+	// Vertices compare by their bytes, Vertex has no padding so that is the same as comparing every float (aside from -0.0 / NaN, see MeshImporter::MakeVertex).
+	class VertexHashTable
+	{
+	public:
+		VertexHashTable();
+		~VertexHashTable();
+
+		// Sizes an empty table for count vertices so inserting them never has to rehash
+		void Reserve(size_t count);
+		// Returns the index of vertex in vertices, appending it first if it isn't there yet (b_inserted tells which happened)
+		uint32_t FindOrInsert(const Vertex& vertex, uint64_t hash, std::vector<Vertex>& vertices, bool& b_inserted);
+		static uint64_t Hash(const Vertex& vertex);
+
+	private:
+		struct Slot
+		{
+			uint32_t hashTag; // high half of the hash, rejects almost every mismatch without touching the vertex array
+			uint32_t index;
+		};
+
+		void Grow(const std::vector<Vertex>& vertices);
+
+		std::vector<Slot> m_slots;
+		size_t m_mask;
+		size_t m_count;
+	};
+}
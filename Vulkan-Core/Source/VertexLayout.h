@@ -0,0 +1,194 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <glfw3.h>
+#include <glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+
+namespace VCore
+{
+	// Packed attribute types for lean vertex formats. The vertex input fetch converts all of them to floats, see VertexAttributeTraits for the format each is read as
+	struct Unorm16x4
+	{
+		uint16_t v[4];
+		bool operator==(const Unorm16x4& other) const = default;
+	};
+
+	struct Snorm16x2
+	{
+		int16_t v[2];
+		bool operator==(const Snorm16x2& other) const = default;
+	};
+
+	struct Half2
+	{
+		uint16_t v[2]; // glm::packHalf1x16
+		bool operator==(const Half2& other) const = default;
+	};
+
+	struct Unorm8x4
+	{
+		uint8_t v[4];
+		bool operator==(const Unorm8x4& other) const = default;
+	};
+
+	// The VkFormat a C++ field type is read as and how many shader locations it takes up. A field of any other type doesn't compile
+	template<typename T> struct VertexAttributeTraits;
+	template<> struct VertexAttributeTraits<float> { static constexpr VkFormat format = VK_FORMAT_R32_SFLOAT; static constexpr uint32_t locations = 1; };
+	template<> struct VertexAttributeTraits<glm::vec2> { static constexpr VkFormat format = VK_FORMAT_R32G32_SFLOAT; static constexpr uint32_t locations = 1; };
+	template<> struct VertexAttributeTraits<glm::vec3> { static constexpr VkFormat format = VK_FORMAT_R32G32B32_SFLOAT; static constexpr uint32_t locations = 1; };
+	template<> struct VertexAttributeTraits<glm::vec4> { static constexpr VkFormat format = VK_FORMAT_R32G32B32A32_SFLOAT; static constexpr uint32_t locations = 1; };
+	template<> struct VertexAttributeTraits<glm::mat4> { static constexpr VkFormat format = VK_FORMAT_R32G32B32A32_SFLOAT; static constexpr uint32_t locations = 4; }; // one location per column
+	template<> struct VertexAttributeTraits<Unorm16x4> { static constexpr VkFormat format = VK_FORMAT_R16G16B16A16_UNORM; static constexpr uint32_t locations = 1; };
+	template<> struct VertexAttributeTraits<Snorm16x2> { static constexpr VkFormat format = VK_FORMAT_R16G16_SNORM; static constexpr uint32_t locations = 1; };
+	template<> struct VertexAttributeTraits<Half2> { static constexpr VkFormat format = VK_FORMAT_R16G16_SFLOAT; static constexpr uint32_t locations = 1; };
+	template<> struct VertexAttributeTraits<Unorm8x4> { static constexpr VkFormat format = VK_FORMAT_R8G8B8A8_UNORM; static constexpr uint32_t locations = 1; };
+
+	// One field of a vertex struct and the shader location it's read at. Declare them with VCORE_VERTEX_ATTRIBUTE, which fills in the type and offset
+	template<typename TAttribute, uint32_t Offset, uint32_t Location>
+	struct VertexAttribute
+	{
+		using Type = TAttribute;
+		static constexpr uint32_t offset = Offset;
+		static constexpr uint32_t location = Location;
+		static constexpr uint32_t size = sizeof(TAttribute);
+		static constexpr uint32_t locations = VertexAttributeTraits<TAttribute>::locations;
+		static constexpr VkFormat format = VertexAttributeTraits<TAttribute>::format;
+	};
+
+#define VCORE_VERTEX_ATTRIBUTE(Struct, member, location) VCore::VertexAttribute<decltype(Struct::member), static_cast<uint32_t>(offsetof(Struct, member)), location>
+
+	// False if any two of the attributes' location ranges overlap
+	template<typename... Attributes>
+	constexpr bool VertexLocationsAreUnique()
+	{
+		constexpr uint32_t ui_count = sizeof...(Attributes);
+		constexpr std::array<uint32_t, ui_count> first = { Attributes::location... };
+		constexpr std::array<uint32_t, ui_count> end = { (Attributes::location + Attributes::locations)... };
+		for (uint32_t i = 0; i < ui_count; i++)
+		{
+			for (uint32_t j = i + 1; j < ui_count; j++)
+			{
+				if (first[i] < end[j] && first[j] < end[i])
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// Refer to - https://vulkan-tutorial.com/Vertex_buffers/Vertex_input_description and https://en.cppreference.com/w/cpp/language/fold
+	// Everything the renderer needs to know about a vertex (or instance) struct, worked out at compile time from the list of its fields:
+	//   using MyVertexLayout = VertexLayout<MyVertex, 0, VK_VERTEX_INPUT_RATE_VERTEX, VCORE_VERTEX_ATTRIBUTE(MyVertex, pos, 0), VCORE_VERTEX_ATTRIBUTE(MyVertex, uv, 2)>;
+	// gives the binding and attribute descriptions for the pipeline, field by field Equal and Hash for deduplication (see std::hash<Vertex>) and Pack for uploads.
+	// Every byte of TVertex has to belong to a declared field, so the struct is as tightly packed as the vertex buffer and uploads are a straight copy.
+	// A field the struct doesn't have, a type with no VertexAttributeTraits, padding or two fields on the same location are compile errors rather than garbage on screen
+	template<typename TVertex, uint32_t Binding, VkVertexInputRate InputRate, typename... Attributes>
+	class VertexLayout
+	{
+	public:
+		static constexpr uint32_t binding = Binding;
+		static constexpr uint32_t stride = sizeof(TVertex);
+		static constexpr uint32_t attributeCount = (Attributes::locations + ...);
+
+		static constexpr VkVertexInputBindingDescription GetBindingDescription()
+		{
+			VkVertexInputBindingDescription bindingDescription{};
+			bindingDescription.binding = Binding;
+			bindingDescription.stride = stride;
+			bindingDescription.inputRate = InputRate;
+			return bindingDescription;
+		}
+
+		static constexpr std::array<VkVertexInputAttributeDescription, attributeCount> GetAttributeDescriptions()
+		{
+			// A multi location field (a mat4) is one description per location, each a column further into the field
+			std::array<VkVertexInputAttributeDescription, attributeCount> attributeDescriptions{};
+			uint32_t ui_next = 0;
+			auto add = [&](uint32_t location, uint32_t locations, VkFormat format, uint32_t offset, uint32_t size)
+			{
+				for (uint32_t i = 0; i < locations; i++)
+				{
+					attributeDescriptions[ui_next++] = { location + i, Binding, format, offset + size / locations * i };
+				}
+			};
+			(add(Attributes::location, Attributes::locations, Attributes::format, Attributes::offset, Attributes::size), ...);
+			return attributeDescriptions;
+		}
+
+		static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptionList()
+		{
+			constexpr auto attributeDescriptions = GetAttributeDescriptions();
+			return std::vector<VkVertexInputAttributeDescription>(attributeDescriptions.begin(), attributeDescriptions.end());
+		}
+
+		static bool Equal(const TVertex& a, const TVertex& b)
+		{
+			return (FieldsEqual<Attributes>(a, b) && ...);
+		}
+
+		static size_t Hash(const TVertex& vertex)
+		{
+			size_t seed = 0;
+			((seed ^= HashField<Attributes>(vertex) + 0x9e3779b9 + (seed << 6) + (seed >> 2)), ...);
+			return seed;
+		}
+
+		// Appends count vertices to out exactly as the vertex buffer holds them
+		static void Pack(const TVertex* vertices, uint32_t count, std::vector<uint8_t>& out)
+		{
+			size_t start = out.size();
+			out.resize(start + static_cast<size_t>(count) * stride);
+			if (count > 0)
+			{
+				memcpy(out.data() + start, vertices, static_cast<size_t>(count) * stride);
+			}
+		}
+
+	private:
+		static_assert(std::is_trivially_copyable_v<TVertex>, "a vertex is uploaded with a plain copy");
+		static_assert(((Attributes::offset + Attributes::size <= sizeof(TVertex)) && ...), "an attribute reaches past the end of the vertex");
+		static_assert((Attributes::size + ...) == sizeof(TVertex), "the vertex has padding or fields the layout doesn't declare");
+		static_assert(VertexLocationsAreUnique<Attributes...>(), "two attributes share a location");
+
+		// Read through a copy rather than a cast, the field's type is all the layout knows about it
+		template<typename TAttribute>
+		static typename TAttribute::Type ReadField(const TVertex& vertex)
+		{
+			typename TAttribute::Type value;
+			memcpy(&value, reinterpret_cast<const uint8_t*>(&vertex) + TAttribute::offset, sizeof(value));
+			return value;
+		}
+
+		template<typename TAttribute>
+		static bool FieldsEqual(const TVertex& a, const TVertex& b)
+		{
+			return ReadField<TAttribute>(a) == ReadField<TAttribute>(b);
+		}
+
+		// glm's float types go through gtx/hash so 0.0 and -0.0 hash the same as they compare, the packed integer types hash their bytes
+		template<typename TAttribute>
+		static size_t HashField(const TVertex& vertex)
+		{
+			typename TAttribute::Type value = ReadField<TAttribute>(vertex);
+			if constexpr (std::is_default_constructible_v<std::hash<typename TAttribute::Type>>)
+			{
+				return std::hash<typename TAttribute::Type>()(value);
+			}
+			else
+			{
+				return std::hash<std::string_view>()(std::string_view(reinterpret_cast<const char*>(&value), sizeof(value)));
+			}
+		}
+	};
+}
@@ -1,5 +1,10 @@
 #pragma once
 #include "VulkanManager.h"
+#include "Helper.h"
+#include "MeshImporter.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshRegistry.h"
 
 namespace VCore 
 {
@@ -3,16 +3,19 @@
 #include "Helper.h"
 
 // Refer to - https://vulkan-tutorial.com/en/Uniform_buffers/Descriptor_layout_and_buffer
-#include <gtc/matrix_transform.hpp> // Not used currently but might need it later
+#include <gtc/matrix_transform.hpp>
 
 #include <chrono> // Time keeping
 #include <memory>
+#include <iostream>
+#include <cmath>
 
 
 namespace VCore
 {
     ValidationLayers VM_validationLayers = ValidationLayers();
     uint32_t VM_currentFrame = 0;
+    float VM_elapsedTime = 0.0f;
 
     VulkanManager::VulkanManager()
     {
@@ -24,10 +27,23 @@ namespace VCore
 
         // gpu communication
         m_commandPool = VK_NULL_HANDLE;
+        m_uploadQueue = UploadQueue();
+        m_workerThreadCount = JobSystem::GetDefaultWorkerCount();
+        m_recordTimeMs = 0.0f;
+        m_recordedFrames = 0;
         m_imageAvailableSemaphore = std::vector<VkSemaphore>();
         m_renderFinishedSemaphore = std::vector<VkSemaphore>();
         m_inFlightFence = std::vector<VkFence>();
         m_b_framebufferResized = false;
+        m_b_bindlessRequested = false;
+        m_b_bindless = false;
+        m_b_gpuCulling = false;
+        m_b_occlusionCulling = false;
+        m_b_softwareOcclusion = false;
+        m_occlusionWidth = VM_OCCLUSION_WIDTH;
+        m_b_headlessCompaction = false;
+        m_vertexFormat = VertexFormat::FULL;
+        m_lodSelector = LodSelector();
 
         m_materials = std::map<std::string, std::shared_ptr<Material>>();
 
@@ -35,13 +51,24 @@ namespace VCore
         std::shared_ptr<Material> blueMaterial = std::make_shared<Material>("../Shaders/compiledShaders/vert2.spv", "../Shaders/compiledShaders/frag2.spv");
         roomMaterial->AddTexture("../Textures/viking_room.png");       
         blueMaterial->AddTexture("../Textures/blue.png");
+        roomMaterial->SetBindlessShaders("../Shaders/compiledShaders/bindless_vert.spv", "../Shaders/compiledShaders/bindless_frag.spv");
+        blueMaterial->SetBindlessShaders("../Shaders/compiledShaders/bindless_vert.spv", "../Shaders/compiledShaders/bindless_frag2.spv");
         m_materials.emplace("room", roomMaterial);
         m_materials.emplace("blue", blueMaterial);
 
+        // One texture like the room and blue materials, so it ends up with their descriptor set layout and can draw their objects with their sets
+        m_fallbackMaterial = std::make_shared<Material>("../Shaders/compiledShaders/vert2.spv", "../Shaders/compiledShaders/frag2.spv");
+        m_fallbackMaterial->AddTexture("../Textures/blue.png");
+        m_fallbackMaterial->SetBindlessShaders("../Shaders/compiledShaders/bindless_vert.spv", "../Shaders/compiledShaders/bindless_frag2.spv");
+        m_materials.emplace("fallback", m_fallbackMaterial);
+        roomMaterial->SetFallback(m_fallbackMaterial);
+        blueMaterial->SetFallback(m_fallbackMaterial);
+
         GameObject vikingRoom;
         GameObject ghostHand;
         vikingRoom.SetMaterial(roomMaterial);
         vikingRoom.GetModel().SetModelPath("../Models/viking_room.obj");
+        vikingRoom.SetOccluder(true); // its walls hide whatever is behind them
         ghostHand.SetMaterial(blueMaterial);
         ghostHand.GetModel().SetModelPath("../Models/ghostHand.obj");
         
@@ -56,6 +83,9 @@ namespace VCore
 
     void VulkanManager::Cleanup()
     {
+        // Compiles still in flight are using the window system, render pass, materials and device
+        m_pipelineCompiler.Shutdown();
+
         // Semaphores and Fences
         for (size_t i = 0; i < VM_MAX_FRAMES_IN_FLIGHT; i++)
         {
@@ -68,19 +98,47 @@ namespace VCore
 
         for (std::pair<std::string, std::shared_ptr<Material>> materialPair : m_materials)
         {
-            materialPair.second->CleanupDescriptorSetLayout(m_logicalDevice);
-            materialPair.second->CleanupGraphicsPipeline(m_logicalDevice);
+            materialPair.second->CleanupGraphicsPipeline(m_pipelineRegistry, m_logicalDevice);
+            materialPair.second->CleanupDescriptorSetLayout(m_pipelineRegistry, m_logicalDevice);
+            materialPair.second->CleanupTextures(m_descriptorAllocator, m_logicalDevice);
         }
 
         for (GameObject& object : m_gameObjects)
         {
-            object.CleanupDescriptorPool(m_logicalDevice);
-            object.GetModel().CleanupUniformBuffers(m_logicalDevice);
-            object.GetModel().CleanupIndexBuffers(m_logicalDevice);
-            object.GetModel().CleanupVertexBuffers(m_logicalDevice);
+            object.GetModel().ReleaseMesh(m_meshRegistry, m_logicalDevice);
+        }
+        m_meshRegistry.Cleanup(m_logicalDevice);
+        m_instanceBatcher.Cleanup(m_logicalDevice);
+        if (m_b_gpuCulling)
+        {
+            m_gpuCuller.Cleanup(m_pipelineRegistry, m_logicalDevice);
         }
+        if (m_b_occlusionCulling)
+        {
+            m_depthPyramid.Cleanup(m_pipelineRegistry, m_logicalDevice);
+        }
+        if (m_b_softwareOcclusion)
+        {
+            m_frustumCuller.SetOcclusionRasterizer(nullptr);
+            m_occlusionRasterizer.Cleanup();
+        }
+        m_frameConstants.Cleanup(m_pipelineRegistry, m_logicalDevice);
+        for (uint32_t i = 0; i < VM_MAX_FRAMES_IN_FLIGHT; i++)
+        {
+            m_descriptorAllocator.Invalidate((uint64_t)m_uniformRing.GetBuffer(i)); // FrameConstants' cached sets
+        }
+        m_uniformRing.Cleanup(m_logicalDevice);
 
         vkDestroyCommandPool(m_logicalDevice.GetDevice(), m_commandPool, nullptr);
+        m_renderPass.CleanupThreadCommandBuffers(m_logicalDevice);
+        m_uploadQueue.Cleanup(m_logicalDevice);
+        m_descriptorAllocator.Cleanup(m_logicalDevice); // frees every object's descriptor sets with their pools
+        m_jobSystem.Shutdown();
+        if (m_b_bindless)
+        {
+            m_bindlessTable.Cleanup(m_pipelineRegistry, m_logicalDevice);
+        }
+        m_pipelineRegistry.Cleanup(m_logicalDevice); // saves the pipeline cache for next time
 
         m_renderPass.Cleanup(m_logicalDevice);
         m_logicalDevice.Cleanup();
@@ -101,14 +159,265 @@ namespace VCore
         Cleanup();
     }
 
+    void VulkanManager::RunHeadless(uint32_t width, uint32_t height, uint32_t frameCount, std::vector<uint8_t>& pixels)
+    {
+        m_winSystem.InitHeadless(width, height);
+        InitVulkan();
+        // Captures have to match from run to run, so don't let frames go out while objects are still being skipped
+        m_pipelineCompiler.WaitIdle();
+
+        m_recordTimeMs = 0.0f;
+        m_recordedFrames = 0;
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        for (uint32_t i = 0; i < frameCount; i++)
+        {
+            VM_elapsedTime = i * VM_HEADLESS_TIME_STEP;
+            DrawFrameHeadless();
+        }
+
+        vkDeviceWaitIdle(m_logicalDevice.GetDevice());
+
+        auto endTime = std::chrono::high_resolution_clock::now();
+        float f_totalMs = std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count();
+        if (frameCount > 0)
+        {
+            std::cout << "headless: " << frameCount << " frames at " << width << "x" << height << " in " << f_totalMs << " ms (" << f_totalMs / frameCount << " ms/frame, " << frameCount * 1000.0f / f_totalMs << " fps)" << std::endl;
+            std::cout << "record: " << GetAverageRecordTime() << " ms/frame for " << m_gameObjects.size() << " objects on " << m_jobSystem.GetThreadCount() << " threads" << std::endl;
+        }
+
+        if (m_b_headlessCompaction)
+        {
+            // The room is loaded first, so releasing it leaves a hole at the start of its page that the compaction has to move everything after it into
+            std::cout << "compaction: releasing " << m_gameObjects[0].GetModel().GetModelPath() << ", before compacting" << std::endl;
+            ReleaseObjectMesh(0);
+            m_meshRegistry.PrintStats();
+            CompactGeometry();
+            std::cout << "compaction: after compacting" << std::endl;
+            m_meshRegistry.PrintStats();
+
+            // Timed on its own, so the numbers below are only the frames drawn out of the compacted pages
+            m_recordTimeMs = 0.0f;
+            m_recordedFrames = 0;
+            startTime = std::chrono::high_resolution_clock::now();
+            for (uint32_t i = 0; i < frameCount; i++)
+            {
+                VM_elapsedTime = i * VM_HEADLESS_TIME_STEP;
+                DrawFrameHeadless();
+            }
+            vkDeviceWaitIdle(m_logicalDevice.GetDevice());
+
+            endTime = std::chrono::high_resolution_clock::now();
+            f_totalMs = std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count();
+            if (frameCount > 0)
+            {
+                std::cout << "headless after compaction: " << frameCount << " frames in " << f_totalMs << " ms (" << f_totalMs / frameCount << " ms/frame, " << frameCount * 1000.0f / f_totalMs << " fps)" << std::endl;
+                std::cout << "record after compaction: " << GetAverageRecordTime() << " ms/frame" << std::endl;
+            }
+        }
+
+        m_winSystem.ReadbackOffscreenImage(pixels, m_commandPool, m_physicalDevice, m_logicalDevice);
+        m_logicalDevice.GetAllocator().PrintStats();
+        m_pipelineRegistry.PrintStats();
+        m_pipelineCompiler.PrintStats();
+        m_descriptorAllocator.PrintStats();
+        m_meshRegistry.PrintStats();
+        m_instanceBatcher.PrintStats();
+        m_transformSystem.PrintStats();
+        m_frustumCuller.PrintStats();
+        m_lodSelector.PrintStats();
+        m_renderPass.GetDrawList().PrintStats();
+        if (m_b_gpuCulling)
+        {
+            m_gpuCuller.PrintStats();
+        }
+        if (m_b_softwareOcclusion)
+        {
+            m_occlusionRasterizer.PrintStats();
+        }
+        m_uniformRing.PrintStats();
+        if (m_b_bindless)
+        {
+            m_bindlessTable.PrintStats();
+        }
+
+        Cleanup();
+    }
+
+    void VulkanManager::SetWorkerThreadCount(uint32_t workerCount)
+    {
+        m_workerThreadCount = workerCount;
+    }
+
+    void VulkanManager::SetBindless(bool b_bindless)
+    {
+        m_b_bindlessRequested = b_bindless;
+    }
+
+    void VulkanManager::SetGpuCulling(bool b_gpuCulling)
+    {
+        m_b_gpuCulling = b_gpuCulling;
+    }
+
+    void VulkanManager::SetOcclusionCulling(bool b_occlusionCulling)
+    {
+        m_b_occlusionCulling = b_occlusionCulling;
+        if (b_occlusionCulling)
+        {
+            m_b_gpuCulling = true;
+        }
+    }
+
+    void VulkanManager::SetSoftwareOcclusion(bool b_softwareOcclusion, uint32_t width)
+    {
+        m_b_softwareOcclusion = b_softwareOcclusion;
+        m_occlusionWidth = width;
+    }
+
+    void VulkanManager::SetVertexFormat(VertexFormat vertexFormat)
+    {
+        m_vertexFormat = vertexFormat;
+    }
+
+    void VulkanManager::SetLodErrorBudget(float pixels)
+    {
+        m_lodSelector.SetErrorBudget(pixels);
+    }
+
+    void VulkanManager::SetHeadlessCompaction(bool b_compaction)
+    {
+        m_b_headlessCompaction = b_compaction;
+    }
+
+    void VulkanManager::AddPropCopies(uint32_t count)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        // Checked now rather than when the slots run out halfway through creating the objects' resources
+        if (m_b_bindlessRequested && count > VM_BINDLESS_MAX_OBJECTS - m_gameObjects.size())
+        {
+            throw std::runtime_error("failed to add " + std::to_string(count) + " prop copies, bindless has room for " + std::to_string(VM_BINDLESS_MAX_OBJECTS - m_gameObjects.size())
+                + " more objects (VM_BINDLESS_MAX_OBJECTS is " + std::to_string(VM_BINDLESS_MAX_OBJECTS) + ")!");
+        }
+
+        // Every copy shares the mesh (through the MeshRegistry) and this material, so they all end up in the same instanced batches
+        std::shared_ptr<Material> propMaterial = std::make_shared<Material>("../Shaders/compiledShaders/vert2.spv", "../Shaders/compiledShaders/frag2.spv");
+        propMaterial->AddTexture("../Textures/blue.png");
+        propMaterial->SetInstanced("../Shaders/compiledShaders/instanced_vert.spv");
+        propMaterial->SetBindlessShaders("../Shaders/compiledShaders/bindless_vert.spv", "../Shaders/compiledShaders/bindless_frag2.spv");
+        m_materials.emplace("prop", propMaterial);
+
+        uint32_t ui_gridSize = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(count))));
+        const float f_spacing = 0.25f;
+        const float f_scale = 0.1f;
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            float f_x = (static_cast<float>(i % ui_gridSize) - ui_gridSize * 0.5f) * f_spacing;
+            float f_y = (static_cast<float>(i / ui_gridSize) - ui_gridSize * 0.5f) * f_spacing;
+
+            GameObject prop;
+            prop.SetMaterial(propMaterial);
+            prop.GetModel().SetModelPath("../Models/ghostHand.obj");
+            prop.GetModel().SetTransform(glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(f_x, f_y, 0.0f)), glm::vec3(f_scale)));
+            m_gameObjects.push_back(prop);
+        }
+    }
+
+    Camera& VulkanManager::GetCamera()
+    {
+        return m_camera;
+    }
+
+    TransformSystem& VulkanManager::GetTransformSystem()
+    {
+        return m_transformSystem;
+    }
+
+    void VulkanManager::CompactGeometry()
+    {
+        // The pages being replaced may still be read by the frames in flight
+        vkDeviceWaitIdle(m_logicalDevice.GetDevice());
+        m_meshRegistry.CompactGeometry(m_uploadQueue, m_physicalDevice, m_logicalDevice);
+
+        // The CPU path reads every mesh's range as it records, the indirect commands have theirs baked in
+        if (m_b_gpuCulling)
+        {
+            m_gpuCuller.RefreshGeometry();
+        }
+    }
+
+    void VulkanManager::ReleaseObjectMesh(uint32_t objectIndex)
+    {
+        if (objectIndex >= m_gameObjects.size() || m_gameObjects[objectIndex].GetMaterial()->IsInstanced())
+        {
+            throw std::runtime_error("failed to release mesh, object " + std::to_string(objectIndex) + " isn't a regular object (instanced objects' meshes are held by their batches)!");
+        }
+
+        // The frames in flight may still draw it
+        vkDeviceWaitIdle(m_logicalDevice.GetDevice());
+        m_gameObjects[objectIndex].GetModel().ReleaseMesh(m_meshRegistry, m_logicalDevice);
+
+        // An occluder without a mesh has nothing left to hide others with, and the FrustumCuller skips objects without one
+        if (m_b_softwareOcclusion)
+        {
+            m_occlusionRasterizer.Build(m_gameObjects, m_jobSystem);
+        }
+    }
+
+    FrustumCuller& VulkanManager::GetFrustumCuller()
+    {
+        return m_frustumCuller;
+    }
+
+    float VulkanManager::GetAverageRecordTime()
+    {
+        return m_recordedFrames > 0 ? m_recordTimeMs / m_recordedFrames : 0.0f;
+    }
+
+    void VulkanManager::AddMaterial(std::string name, std::shared_ptr<Material> material)
+    {
+        if (m_b_bindless)
+        {
+            material->EnableBindless(m_bindlessTable);
+        }
+        material->SetVertexFormat(m_vertexFormat);
+        if (material->GetFallback() == nullptr)
+        {
+            material->SetFallback(m_fallbackMaterial); // only used if the layouts end up matching (Material::GetDrawMaterial)
+        }
+        material->CreateMaterialResources(m_winSystem, m_uploadQueue, m_pipelineRegistry, m_renderPass, m_physicalDevice, m_logicalDevice);
+        m_materials.emplace(name, material);
+        m_pipelineCompiler.Compile(material, m_winSystem, m_renderPass, m_pipelineRegistry, m_logicalDevice);
+    }
+
     void VulkanManager::InitVulkan()
     {
         CreateInstance();
         VM_validationLayers.SetupDebugMessenger(m_instance);
-        m_winSystem.CreateSurface(m_instance);
-        m_physicalDevice.Init(m_instance, m_winSystem.GetSurface());
-        m_logicalDevice.Init(m_physicalDevice, m_winSystem.GetSurface());
-        m_winSystem.CreateSwapChain(m_physicalDevice, m_logicalDevice);
+        if (m_winSystem.IsHeadless())
+        {
+            // No surface - GetSurface() stays VK_NULL_HANDLE, which tells device selection not to require presentation support
+            m_physicalDevice.Init(m_instance, m_winSystem.GetSurface());
+            m_b_bindless = UseBindless();
+            m_b_gpuCulling = UseGpuCulling();
+            m_b_occlusionCulling = m_b_occlusionCulling && m_b_gpuCulling;
+            m_logicalDevice.Init(m_physicalDevice, m_winSystem.GetSurface(), m_b_bindless, m_b_gpuCulling && m_physicalDevice.SupportsDrawIndirectCount(), m_b_gpuCulling);
+            m_winSystem.CreateOffscreenTarget(m_physicalDevice, m_logicalDevice);
+        }
+        else
+        {
+            m_winSystem.CreateSurface(m_instance);
+            m_physicalDevice.Init(m_instance, m_winSystem.GetSurface());
+            m_b_bindless = UseBindless();
+            m_b_gpuCulling = UseGpuCulling();
+            m_b_occlusionCulling = m_b_occlusionCulling && m_b_gpuCulling;
+            m_logicalDevice.Init(m_physicalDevice, m_winSystem.GetSurface(), m_b_bindless, m_b_gpuCulling && m_physicalDevice.SupportsDrawIndirectCount(), m_b_gpuCulling);
+            m_winSystem.CreateSwapChain(m_physicalDevice, m_logicalDevice);
+        }
         m_winSystem.CreateImageViews(m_logicalDevice);
         m_renderPass.CreateRenderPass(m_winSystem, m_physicalDevice, m_logicalDevice);
         m_winSystem.CreateColorResources(m_physicalDevice, m_logicalDevice);
@@ -116,18 +425,100 @@ namespace VCore
         m_winSystem.CreateFramebuffers(m_logicalDevice, m_renderPass.GetRenderPass());
         CreateCommandPool();
         m_renderPass.CreateCommandBuffers(m_commandPool, m_logicalDevice);
+        m_jobSystem.Init(m_workerThreadCount);
+        m_renderPass.CreateThreadCommandBuffers(Helper::FindQueueFamilies(m_physicalDevice.GetDevice(), m_winSystem.GetSurface()).graphicsFamily.value(), m_jobSystem.GetThreadCount(), m_logicalDevice);
+        m_uploadQueue.Init(m_physicalDevice, m_logicalDevice, m_winSystem.GetSurface(), VM_STAGING_RING_SIZE);
+        m_pipelineRegistry.Init(m_physicalDevice, m_logicalDevice, VM_PIPELINE_CACHE_PATH);
+        m_pipelineCompiler.Init(VM_PIPELINE_COMPILE_THREADS);
+        m_descriptorAllocator.Init(VM_MAX_FRAMES_IN_FLIGHT);
+        m_uniformRing.Init(VM_MAX_FRAMES_IN_FLIGHT, VM_UNIFORM_RING_SIZE, m_physicalDevice, m_logicalDevice);
+        m_frameConstants.Init(VM_MAX_FRAMES_IN_FLIGHT, m_b_bindless, m_uniformRing, m_descriptorAllocator, m_pipelineRegistry, m_logicalDevice);
+        if (m_b_bindless)
+        {
+            m_bindlessTable.Init(VM_MAX_FRAMES_IN_FLIGHT, m_frameConstants.GetDescriptorSetLayout(), m_pipelineRegistry, m_physicalDevice, m_logicalDevice);
+        }
 
         for (std::pair<std::string, std::shared_ptr<Material>> materialPair : m_materials)
         {
-            materialPair.second->CreateMaterialResources(m_winSystem, m_commandPool, m_renderPass, m_physicalDevice, m_logicalDevice);       
+            if (m_b_bindless)
+            {
+                materialPair.second->EnableBindless(m_bindlessTable);
+            }
+            materialPair.second->SetVertexFormat(m_vertexFormat);
+            materialPair.second->CreateMaterialResources(m_winSystem, m_uploadQueue, m_pipelineRegistry, m_renderPass, m_physicalDevice, m_logicalDevice);       
+            if (materialPair.second == m_fallbackMaterial)
+            {
+                // Built right here so it's ready for the first frame, a fallback that is compiling as well wouldn't help anyone
+                m_fallbackMaterial->CreateGraphicsPipeline(m_logicalDevice, m_winSystem.GetMsaa(), m_renderPass, m_pipelineRegistry);
+                continue;
+            }
+            // Pipelines compile while the rest of the scene loads
+            m_pipelineCompiler.Compile(materialPair.second, m_winSystem, m_renderPass, m_pipelineRegistry, m_logicalDevice);
         }
 
+        m_meshRegistry.SetVertexFormat(m_vertexFormat);
         for (GameObject& object : m_gameObjects)
         {
-            object.CreateResources(m_winSystem, m_commandPool, m_renderPass, m_physicalDevice, m_logicalDevice);
+            object.CreateResources(m_winSystem, m_uploadQueue, m_jobSystem, m_meshRegistry, m_descriptorAllocator, m_renderPass, m_physicalDevice, m_logicalDevice);
+        }
+        // Needs every object's mesh, so after the objects' resources
+        m_instanceBatcher.Build(m_gameObjects, m_transformSystem, m_physicalDevice, m_logicalDevice);
+        if (m_b_gpuCulling)
+        {
+            if (m_b_occlusionCulling)
+            {
+                m_depthPyramid.Init("../Shaders/compiledShaders/depth_pyramid_comp.spv", "../Shaders/compiledShaders/depth_pyramid_ms_comp.spv", m_winSystem, m_pipelineRegistry, m_logicalDevice);
+                m_depthPyramid.Create(m_winSystem, m_descriptorAllocator, m_physicalDevice, m_logicalDevice);
+                m_gpuCuller.Init("../Shaders/compiledShaders/cull_occlusion_comp.spv", m_physicalDevice.SupportsDrawIndirectCount(), &m_depthPyramid, m_pipelineRegistry, m_logicalDevice);
+            }
+            else
+            {
+                m_gpuCuller.Init("../Shaders/compiledShaders/cull_comp.spv", m_physicalDevice.SupportsDrawIndirectCount(), nullptr, m_pipelineRegistry, m_logicalDevice);
+            }
+            m_gpuCuller.Build(m_instanceBatcher, m_physicalDevice, m_logicalDevice);
         }
+        if (m_b_softwareOcclusion)
+        {
+            VkExtent2D extent = m_winSystem.GetExtent();
+            m_occlusionRasterizer.SetResolution(m_occlusionWidth, m_occlusionWidth * extent.height / std::max(extent.width, 1u)); // keeps the window's aspect ratio
+            m_occlusionRasterizer.Build(m_gameObjects, m_jobSystem);
+            m_frustumCuller.SetOcclusionRasterizer(&m_occlusionRasterizer);
+        }
+
+        // Kick off whatever is left in the upload batch. No need to wait - the uploads are submitted to the graphics queue ahead of the first frame, and barriers order them before any reads
+        m_uploadQueue.Flush();
 
         CreateSyncObjects();
+
+        if (b_ENABLE_VALIDATION_LAYERS)
+        {
+            m_logicalDevice.GetAllocator().PrintStats();
+            m_uploadQueue.PrintStats();
+            m_pipelineRegistry.PrintStats();
+            m_descriptorAllocator.PrintStats();
+            m_meshRegistry.PrintStats();
+            m_instanceBatcher.PrintStats();
+            m_transformSystem.PrintStats();
+        }
+    }
+
+    bool VulkanManager::UseBindless()
+    {
+        if (m_b_bindlessRequested && !m_physicalDevice.SupportsBindless())
+        {
+            std::cout << "bindless requested but the device doesn't support descriptor indexing or its update after bind limits are below VM_BINDLESS_MAX_TEXTURES / VM_BINDLESS_MAX_BUFFERS, using per object descriptor sets" << std::endl;
+        }
+        return m_b_bindlessRequested && m_physicalDevice.SupportsBindless();
+    }
+
+    bool VulkanManager::UseGpuCulling()
+    {
+        // Every batch's draw command (and phase 1's) starts at its own slice of the instance buffer through firstInstance
+        if (m_b_gpuCulling && !m_physicalDevice.SupportsDrawIndirectFirstInstance())
+        {
+            std::cout << "gpu culling requested but the device doesn't support drawIndirectFirstInstance, culling instances on the CPU" << (m_b_occlusionCulling ? " without occlusion culling" : "") << std::endl;
+        }
+        return m_b_gpuCulling && m_physicalDevice.SupportsDrawIndirectFirstInstance();
     }
 
     void VulkanManager::CreateInstance()
@@ -145,7 +536,7 @@ namespace VCore
         appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
         appInfo.pEngineName = "No Engine";
         appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-        appInfo.apiVersion = VK_API_VERSION_1_0;
+        appInfo.apiVersion = VK_API_VERSION_1_2; // 1.2 for descriptor indexing (bindless), devices that only support older versions still work without it
 
         // Struct to tell Vulkan which global extensions and validation layers we want to use
         VkInstanceCreateInfo createInfo{};
@@ -153,14 +544,7 @@ namespace VCore
         createInfo.pApplicationInfo = &appInfo; // Reference our VkApplicationInfo struct above
 
         // Must get an extenstion to work with the window because Vulkan is platform agnostic
-        uint32_t ui_glfwExtensionCount = 0;
-        const char** glfwExtensions;
-
-        // glfws built in function to get extensions needed for our platform
-        glfwExtensions = glfwGetRequiredInstanceExtensions(&ui_glfwExtensionCount);
-
-        createInfo.enabledExtensionCount = ui_glfwExtensionCount;
-        createInfo.ppEnabledExtensionNames = glfwExtensions;
+        // (the full list, including glfw's, is filled in below by GetRequiredExtensions)
 
 
         // NOTE FROM THE WIKI: The debugCreateInfo variable is placed outside the if statement to ensure that it is not destroyed before the vkCreateInstance call.By creating an additional debug messenger this way it will automatically be used during vkCreateInstance and vkDestroyInstance and cleaned up after that.
@@ -185,7 +569,7 @@ namespace VCore
 
 
         // Get extensions for use with debug messenger
-        auto extensions = VM_validationLayers.GetRequiredExtensions();
+        auto extensions = VM_validationLayers.GetRequiredExtensions(m_winSystem.IsHeadless());
         createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
         createInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -199,10 +583,14 @@ namespace VCore
 
     void VulkanManager::MainLoop(bool& _quit)
     {
+        auto startTime = std::chrono::high_resolution_clock::now();
+
         // Window is completely controlled by glfw, including closing using the "x" button on top right (we need event handling)
         while (!glfwWindowShouldClose(m_winSystem.GetWindow()))
         {
             glfwPollEvents();
+            auto currentTime = std::chrono::high_resolution_clock::now();
+            VM_elapsedTime = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
             DrawFrame();
         }
 
@@ -262,6 +650,14 @@ namespace VCore
         
         // At the start of the frame, we want to wait until the previous frame has finished, so that the command buffer and semaphores are available to use. To do that, we call vkWaitForFences:
         vkWaitForFences(m_logicalDevice.GetDevice(), 1, &m_inFlightFence[VM_currentFrame], VK_TRUE, UINT64_MAX);
+        m_uploadQueue.Update(); // hand finished uploads' staging memory back to the ring
+        m_descriptorAllocator.ResetFrame(VM_currentFrame, m_logicalDevice); // this frame's transient descriptor sets are no longer in use
+        m_uniformRing.Reset(VM_currentFrame); // and neither is its uniform data
+        CameraData cameraData = m_camera.GetCameraData(m_winSystem.GetExtent());
+        m_frameConstants.Update(VM_currentFrame, cameraData, m_uniformRing);
+        m_frustumCuller.SetFrustum(cameraData.viewProj);
+        m_lodSelector.SetView(cameraData.proj, m_winSystem.GetExtent().height);
+        m_frustumCuller.SetObjectOffset(glm::vec3(VM_elapsedTime, 0.0f, 0.0f)); // matches the position RenderPass pushes with every draw
 
         // acquire an image from the swap chain
         uint32_t imageIndex;
@@ -273,7 +669,7 @@ namespace VCore
         if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_b_framebufferResized)
         {
             m_b_framebufferResized = false;
-            m_winSystem.RecreateSwapChain(m_logicalDevice, m_physicalDevice, m_renderPass.GetRenderPass()); // THIS IS BROKEN AND SEMAPHORE DOESN'T WORK ON NEXT AQUIREIMAGEKHR CALL ON RESIZE
+            RecreateSwapChain(); // THIS IS BROKEN AND SEMAPHORE DOESN'T WORK ON NEXT AQUIREIMAGEKHR CALL ON RESIZE
             return;
         }
         else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) 
@@ -285,15 +681,14 @@ namespace VCore
         vkResetFences(m_logicalDevice.GetDevice(), 1, &m_inFlightFence[VM_currentFrame]);
 
 
-        m_renderPass.BeginRenderPass(imageIndex, m_winSystem);
+        auto recordStart = std::chrono::high_resolution_clock::now();
 
-        for (GameObject &object : m_gameObjects)
-        {
-            m_renderPass.RecordCommandBuffer(imageIndex, m_winSystem, object);
-            object.GetModel().UpdateUniformBuffer(VM_currentFrame, m_winSystem, 0.5f);
-        }
+        DrawStats drawStats = RecordFrame(imageIndex);
 
-        m_renderPass.EndRenderPass();
+        auto recordEnd = std::chrono::high_resolution_clock::now();
+        m_recordTimeMs += std::chrono::duration<float, std::chrono::milliseconds::period>(recordEnd - recordStart).count();
+        m_recordedFrames++;
+        m_pipelineCompiler.RecordFrame(drawStats.skipped, drawStats.fallback);
 
 
         // Submit the command buffer
@@ -335,7 +730,7 @@ namespace VCore
         // Check on swap chain integrity after present
         if (result == VK_ERROR_OUT_OF_DATE_KHR)
         {
-            m_winSystem.RecreateSwapChain(m_logicalDevice, m_physicalDevice, m_renderPass.GetRenderPass());
+            RecreateSwapChain();
         }
         else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
         {
@@ -345,6 +740,105 @@ namespace VCore
         VM_currentFrame = (VM_currentFrame + 1) % VM_MAX_FRAMES_IN_FLIGHT;
     }
 
+    void VulkanManager::DrawFrameHeadless()
+    {
+        // Same as DrawFrame, minus the swap chain. There is only one offscreen image, so there's nothing to acquire or present and no semaphores to wait on.
+        // Render pass ordering (store -> next load) keeps consecutive frames into the same image correct.
+        vkWaitForFences(m_logicalDevice.GetDevice(), 1, &m_inFlightFence[VM_currentFrame], VK_TRUE, UINT64_MAX);
+        m_uploadQueue.Update(); // hand finished uploads' staging memory back to the ring
+        vkResetFences(m_logicalDevice.GetDevice(), 1, &m_inFlightFence[VM_currentFrame]);
+        m_descriptorAllocator.ResetFrame(VM_currentFrame, m_logicalDevice);
+        m_uniformRing.Reset(VM_currentFrame);
+        CameraData cameraData = m_camera.GetCameraData(m_winSystem.GetExtent());
+        m_frameConstants.Update(VM_currentFrame, cameraData, m_uniformRing);
+        m_frustumCuller.SetFrustum(cameraData.viewProj);
+        m_lodSelector.SetView(cameraData.proj, m_winSystem.GetExtent().height);
+        m_frustumCuller.SetObjectOffset(glm::vec3(VM_elapsedTime, 0.0f, 0.0f)); // matches the position RenderPass pushes with every draw
+
+        uint32_t imageIndex = 0;
+
+        auto recordStart = std::chrono::high_resolution_clock::now();
+
+        DrawStats drawStats = RecordFrame(imageIndex);
+
+        auto recordEnd = std::chrono::high_resolution_clock::now();
+        m_recordTimeMs += std::chrono::duration<float, std::chrono::milliseconds::period>(recordEnd - recordStart).count();
+        m_recordedFrames++;
+        m_pipelineCompiler.RecordFrame(drawStats.skipped, drawStats.fallback);
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.waitSemaphoreCount = 0;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &m_renderPass.GetCommandBuffers()[VM_currentFrame];
+        submitInfo.signalSemaphoreCount = 0;
+
+        if (vkQueueSubmit(m_logicalDevice.GetGraphicsQueue(), 1, &submitInfo, m_inFlightFence[VM_currentFrame]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to submit draw command buffer.");
+        }
+
+        VM_currentFrame = (VM_currentFrame + 1) % VM_MAX_FRAMES_IN_FLIGHT;
+    }
+
+    DrawStats VulkanManager::RecordFrame(uint32_t imageIndex)
+    {
+        VkCommandBuffer commandBuffer = m_renderPass.GetCommandBuffers()[VM_currentFrame];
+
+        // Only what's on screen gets recorded. Instanced objects are culled as their batches are packed, and only the survivors' world matrices are built into this frame's instance buffer.
+        // With GPU culling every instance's matrix is written instead, and the culling dispatch ahead of the render pass packs the survivors
+        if (m_b_softwareOcclusion)
+        {
+            // Every sphere test below (objects and CPU culled instances) also checks the occluders' depth
+            m_occlusionRasterizer.RenderOccluders(m_gameObjects, m_frustumCuller.GetViewProj(), m_frustumCuller.GetObjectOffset(), m_jobSystem);
+        }
+        m_frustumCuller.CullObjects(m_gameObjects, m_jobSystem);
+        m_renderPass.BeginCommandBuffer();
+        if (m_b_gpuCulling)
+        {
+            m_gpuCuller.WriteInstances(VM_currentFrame, m_transformSystem, m_frustumCuller, m_jobSystem);
+            m_gpuCuller.RecordCull(commandBuffer, VM_currentFrame, m_frustumCuller, m_descriptorAllocator, m_logicalDevice);
+        }
+        else
+        {
+            m_instanceBatcher.WriteTransforms(VM_currentFrame, m_transformSystem, m_frustumCuller, m_jobSystem);
+        }
+        m_renderPass.BeginRenderPass(imageIndex, m_winSystem);
+        DrawStats drawStats = m_renderPass.RecordDrawCommands(imageIndex, m_winSystem, m_gameObjects, m_frustumCuller, m_instanceBatcher, m_b_gpuCulling ? &m_gpuCuller : nullptr, m_frameConstants, m_jobSystem, m_b_bindless ? &m_bindlessTable : nullptr, m_lodSelector, m_logicalDevice);
+        m_renderPass.EndRenderPass();
+
+        // With occlusion culling the pass above drew the regular objects and last frame's visible instances. Their depth becomes the pyramid that the rest of the instances
+        // are tested against, and whatever turns out to be visible is drawn on top
+        if (m_b_occlusionCulling)
+        {
+            m_depthPyramid.Record(commandBuffer, m_winSystem);
+            m_gpuCuller.RecordCull(commandBuffer, VM_currentFrame, m_frustumCuller, m_descriptorAllocator, m_logicalDevice, 1);
+            m_renderPass.BeginLateRenderPass(imageIndex, m_winSystem);
+            m_renderPass.RecordLateDraws(m_gpuCuller, m_frameConstants, m_b_bindless ? &m_bindlessTable : nullptr);
+            m_renderPass.EndRenderPass();
+        }
+        m_renderPass.EndCommandBuffer();
+        m_lodSelector.RecordFrame(drawStats.triangles, drawStats.fullDetailTriangles);
+
+        return drawStats;
+    }
+
+    void VulkanManager::RecreateSwapChain()
+    {
+        m_winSystem.RecreateSwapChain(m_logicalDevice, m_physicalDevice, m_renderPass.GetRenderPass()); // waits for the device to go idle
+        if (m_b_occlusionCulling)
+        {
+            // The pyramid matches the new depth attachment, and the culling descriptor sets point at the new pyramid
+            m_depthPyramid.Create(m_winSystem, m_descriptorAllocator, m_physicalDevice, m_logicalDevice);
+            m_gpuCuller.Build(m_instanceBatcher, m_physicalDevice, m_logicalDevice);
+        }
+        if (m_b_softwareOcclusion)
+        {
+            VkExtent2D extent = m_winSystem.GetExtent();
+            m_occlusionRasterizer.SetResolution(m_occlusionWidth, m_occlusionWidth * extent.height / std::max(extent.width, 1u)); // keeps the window's aspect ratio
+        }
+    }
+
     void VulkanManager::FramebufferResizeCallback(GLFWwindow* window, int width, int height)
     {
         // Called when GLFW detects the window has been resized.  It has a pointer to our app that we gave it in initWindow that we use here to set our m_b_framebufferResized member to true
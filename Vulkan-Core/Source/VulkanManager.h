@@ -1,11 +1,26 @@
 #pragma once
 #include "Structs.h"
+#include "Config.h"
 #include "ValidationLayers.h"
 #include "PhysicalDevice.h"
 #include "LogicalDevice.h"
 #include "WinSys.h"
 #include "RenderPass.h"
 #include "GameObject.h"
+#include "JobSystem.h"
+#include "PipelineRegistry.h"
+#include "PipelineCompiler.h"
+#include "DescriptorAllocator.h"
+#include "BindlessTable.h"
+#include "MeshRegistry.h"
+#include "InstanceBatcher.h"
+#include "UniformRing.h"
+#include "FrameConstants.h"
+#include "Camera.h"
+#include "TransformSystem.h"
+#include "FrustumCuller.h"
+#include "GpuCuller.h"
+#include "OcclusionRasterizer.h"
 
 #define GLFW_INCLUDE_VULKAN
 #include <glfw3.h>
@@ -30,8 +45,8 @@ namespace VCore
     #endif
 
     extern ValidationLayers VM_validationLayers;
-    const int VM_MAX_FRAMES_IN_FLIGHT = 2;
     extern uint32_t VM_currentFrame;
+    extern float VM_elapsedTime; // Seconds since the first frame, fed to the shaders through push constants (fixed step when headless so captures are reproducible)
 
     class VulkanManager
     {
@@ -39,21 +54,71 @@ namespace VCore
         VulkanManager();
         ~VulkanManager();
         void Run(bool &_quit);
+        // Renders frameCount frames into an offscreen image without creating a window or swap chain, then copies the last frame into pixels (RGBA8, width * height * 4 bytes)
+        void RunHeadless(uint32_t width, uint32_t height, uint32_t frameCount, std::vector<uint8_t>& pixels);
+        // Worker threads used to record draw commands (the main thread always records too). Call before Run/RunHeadless, defaults to JobSystem::GetDefaultWorkerCount()
+        void SetWorkerThreadCount(uint32_t workerCount);
+        // Average CPU time spent recording draw commands per frame during the last RunHeadless
+        float GetAverageRecordTime();
+        // Adds a material after InitVulkan. Its textures and layout are created right away and its pipeline is compiled in the background - objects using it are skipped
+        // (or drawn with its fallback) until then
+        void AddMaterial(std::string name, std::shared_ptr<Material> material);
+        // Render every material bindless (one global descriptor set, see BindlessTable) if the device supports it. Call before Run/RunHeadless
+        void SetBindless(bool b_bindless);
+        // Cull instanced batches with a compute shader and draw them indirectly (see GpuCuller) instead of culling and packing them on the CPU. Call before Run/RunHeadless
+        void SetGpuCulling(bool b_gpuCulling);
+        // Also cull GPU culled instances hidden behind what's already been drawn (see DepthPyramid): last frame's visible set is drawn first, the pyramid built from its depth,
+        // and everything else tested against it before being drawn. Turns GPU culling on. Call before Run/RunHeadless
+        void SetOcclusionCulling(bool b_occlusionCulling);
+        // Also cull objects hidden behind the ones flagged with GameObject::SetOccluder, on the CPU before anything is recorded (see OcclusionRasterizer).
+        // width is the software depth buffer's, its height follows the window. Call before Run/RunHeadless
+        void SetSoftwareOcclusion(bool b_softwareOcclusion, uint32_t width = VM_OCCLUSION_WIDTH);
+        // What mesh vertices are stored as on the GPU, for every mesh and material (see VertexCodec). The compact formats need the vertex shaders' compact builds. Call before Run/RunHeadless
+        void SetVertexFormat(VertexFormat vertexFormat);
+        // Pixels a coarser level of detail may be off by on screen before a finer one is drawn (see LodSelector), 0 draws every mesh at full detail
+        void SetLodErrorBudget(float pixels);
+        // Adds count copies of the ghost hand on a grid, all sharing one instanced material so they're drawn in a handful of instanced draws. Call before Run/RunHeadless, and after SetBindless -
+        // bindless gives every object a slot in its object buffers, so it throws if the scene would end up with more than VM_BINDLESS_MAX_OBJECTS objects
+        void AddPropCopies(uint32_t count);
+        // Packs the geometry of the meshes still loaded together, giving back the space of the ones released since (see GeometryArena::Compact).
+        // Waits for the device to go idle first, so call it between frames rather than every frame
+        void CompactGeometry();
+        // Gives back a regular (not instanced) object's mesh, the object stays but isn't drawn any more. Waits for the device to go idle first.
+        // Its geometry is only reclaimed by the next CompactGeometry
+        void ReleaseObjectMesh(uint32_t objectIndex);
+        // RunHeadless only - after its frames, releases the viking room's mesh, compacts the geometry (printing the MeshRegistry's stats before and after)
+        // and renders the frames again, so the capture is drawn out of the compacted pages
+        void SetHeadlessCompaction(bool b_compaction);
+        // View and projection every object is drawn with, read once per frame
+        Camera& GetCamera();
+        // Positions, rotations and scales of instanced objects (GameObject::GetTransformIndex), turned into world matrices every frame
+        TransformSystem& GetTransformSystem();
+        // Drops objects outside the camera's view before anything is recorded, its counters say how many were tested, culled and drawn last frame
+        FrustumCuller& GetFrustumCuller();
 
         // Was private, moved to public for WinSys
         static void FramebufferResizeCallback(GLFWwindow* window, int width, int height);
 
     private:
         void InitVulkan();
+        bool UseBindless();
+        // Whether the device can draw GpuCuller's commands, falls back to CPU culling (and no occlusion culling) if not
+        bool UseGpuCulling();
         void CreateInstance();
         void MainLoop(bool& _quit);
         void CreateCommandPool();
         void CreateSyncObjects();
         void DrawFrame();
+        void DrawFrameHeadless();
+        // Everything DrawFrame and DrawFrameHeadless record into this frame's command buffer, from culling to the end of the render pass(es)
+        DrawStats RecordFrame(uint32_t imageIndex);
+        // Swap chain and everything sized to it
+        void RecreateSwapChain();
         void Cleanup();
 
         std::vector<GameObject> m_gameObjects;
         std::map<std::string, std::shared_ptr<Material>> m_materials;
+        std::shared_ptr<Material> m_fallbackMaterial; // also in m_materials, compiled before the first frame so objects have something to draw with while their own pipelines compile
         VkInstance m_instance;
         WinSys m_winSystem;
         PhysicalDevice m_physicalDevice;
@@ -61,6 +126,34 @@ namespace VCore
         RenderPass m_renderPass;
         bool m_b_framebufferResized;
         VkCommandPool m_commandPool;
+        UploadQueue m_uploadQueue;
+        JobSystem m_jobSystem;
+        PipelineRegistry m_pipelineRegistry;
+        PipelineCompiler m_pipelineCompiler;
+        DescriptorAllocator m_descriptorAllocator;
+        BindlessTable m_bindlessTable;
+        MeshRegistry m_meshRegistry;
+        InstanceBatcher m_instanceBatcher;
+        UniformRing m_uniformRing;
+        FrameConstants m_frameConstants;
+        Camera m_camera;
+        TransformSystem m_transformSystem;
+        FrustumCuller m_frustumCuller;
+        LodSelector m_lodSelector;
+        GpuCuller m_gpuCuller;
+        bool m_b_gpuCulling;
+        DepthPyramid m_depthPyramid;
+        bool m_b_occlusionCulling;
+        OcclusionRasterizer m_occlusionRasterizer;
+        bool m_b_softwareOcclusion;
+        uint32_t m_occlusionWidth;
+        bool m_b_headlessCompaction;
+        VertexFormat m_vertexFormat;
+        bool m_b_bindlessRequested;
+        bool m_b_bindless; // requested and supported
+        uint32_t m_workerThreadCount;
+        float m_recordTimeMs; // accumulated draw recording time, for reporting thread scaling
+        uint32_t m_recordedFrames;
         std::vector<VkSemaphore> m_imageAvailableSemaphore;
         std::vector<VkSemaphore> m_renderFinishedSemaphore;
         std::vector<VkFence> m_inFlightFence;
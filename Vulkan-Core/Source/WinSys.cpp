@@ -29,15 +29,19 @@ namespace VCore
         m_swapChainImageViews = std::vector<VkImageView>();
         m_swapChainFramebuffers = std::vector<VkFramebuffer>();
 
+        // headless
+        m_b_headless = false;
+        m_offscreenImageMemory = Allocation();
+
         // antialiasing
         m_msaaSamples = VK_SAMPLE_COUNT_1_BIT;
         m_colorImage = VK_NULL_HANDLE;
-        m_colorImageMemory = VK_NULL_HANDLE;
+        m_colorImageMemory = Allocation();
         m_colorImageView = VK_NULL_HANDLE;
 
         // depth testing
         m_depthImage = VK_NULL_HANDLE;
-        m_depthImageMemory = VK_NULL_HANDLE;
+        m_depthImageMemory = Allocation();
         m_depthImageView = VK_NULL_HANDLE;
 	}
 
@@ -47,6 +51,12 @@ namespace VCore
 
     void WinSys::CleanupSystem(VkInstance instance)
     {
+        // No window or surface was ever created when running headless
+        if (m_b_headless)
+        {
+            return;
+        }
+
         vkDestroySurfaceKHR(instance, m_surface, nullptr);
         glfwDestroyWindow(m_window);
         glfwTerminate();
@@ -57,12 +67,12 @@ namespace VCore
         // Antialiasing (msaa) color samples
         vkDestroyImageView(logicalDevice.GetDevice(), m_colorImageView, nullptr);
         vkDestroyImage(logicalDevice.GetDevice(), m_colorImage, nullptr);
-        vkFreeMemory(logicalDevice.GetDevice(), m_colorImageMemory, nullptr);
+        logicalDevice.GetAllocator().Free(m_colorImageMemory);
 
         // Depth buffer testing
         vkDestroyImageView(logicalDevice.GetDevice(), m_depthImageView, nullptr);
         vkDestroyImage(logicalDevice.GetDevice(), m_depthImage, nullptr);
-        vkFreeMemory(logicalDevice.GetDevice(), m_depthImageMemory, nullptr);
+        logicalDevice.GetAllocator().Free(m_depthImageMemory);
 
         // Image views
         for (auto imageView : m_swapChainImageViews)
@@ -75,8 +85,16 @@ namespace VCore
             vkDestroyFramebuffer(logicalDevice.GetDevice(), framebuffer, nullptr);
         }
 
-        // Swapchain
-        vkDestroySwapchainKHR(logicalDevice.GetDevice(), m_swapChain, nullptr);
+        // Swapchain (or the offscreen image standing in for it when headless)
+        if (m_b_headless)
+        {
+            vkDestroyImage(logicalDevice.GetDevice(), m_swapChainImages[0], nullptr);
+            logicalDevice.GetAllocator().Free(m_offscreenImageMemory);
+        }
+        else
+        {
+            vkDestroySwapchainKHR(logicalDevice.GetDevice(), m_swapChain, nullptr);
+        }
     }
 
 
@@ -116,6 +134,96 @@ namespace VCore
         return m_surface;
     }
 
+    void WinSys::InitHeadless(uint32_t width, uint32_t height)
+    {
+        // No glfw window or surface is created. The extent and format normally picked from the surface capabilities are fixed here instead.
+        m_b_headless = true;
+        m_windowWidth = static_cast<int>(width);
+        m_windowHeight = static_cast<int>(height);
+        m_swapChainExtent = { width, height };
+        m_swapChainImageFormat = VK_FORMAT_R8G8B8A8_SRGB; // Same byte order as the readback buffer, so frames can be written straight to disk
+    }
+
+    bool WinSys::IsHeadless()
+    {
+        return m_b_headless;
+    }
+
+    void WinSys::CreateOffscreenTarget(PhysicalDevice &physicalDevice, LogicalDevice &logicalDevice)
+    {
+        // Stands in for the swap chain when running headless. The image takes the place of the single swap chain image, so CreateImageViews and CreateFramebuffers work on it unchanged.
+        // It is the resolve target of the render pass, and TRANSFER_SRC lets us copy finished frames back to host memory.
+        VkImage offscreenImage = VK_NULL_HANDLE;
+        CreateImage(m_swapChainExtent.width, m_swapChainExtent.height, 1, VK_SAMPLE_COUNT_1_BIT, m_swapChainImageFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, offscreenImage, m_offscreenImageMemory, physicalDevice, logicalDevice);
+
+        m_swapChainImages.clear();
+        m_swapChainImages.push_back(offscreenImage);
+    }
+
+    void WinSys::ReadbackOffscreenImage(std::vector<uint8_t>& pixels, VkCommandPool commandPool, PhysicalDevice &physicalDevice, LogicalDevice &logicalDevice)
+    {
+        // Copies the last rendered frame into host memory as tightly packed RGBA8 rows
+        VkDeviceSize imageSize = static_cast<VkDeviceSize>(m_swapChainExtent.width) * m_swapChainExtent.height * 4;
+
+        VkBuffer readbackBuffer{};
+        Allocation readbackBufferMemory{};
+        CreateBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, readbackBuffer, readbackBufferMemory, physicalDevice, logicalDevice, AllocationStrategy::LINEAR);
+
+        VkCommandBuffer commandBuffer = Helper::BeginSingleTimeCommands(commandPool, logicalDevice);
+
+        // The render pass leaves the image in TRANSFER_SRC_OPTIMAL, we only need to make the resolve writes visible to the copy
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = m_swapChainImages[0];
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = 0;
+        region.bufferRowLength = 0; // tightly packed
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = { 0, 0, 0 };
+        region.imageExtent = { m_swapChainExtent.width, m_swapChainExtent.height, 1 };
+
+        vkCmdCopyImageToBuffer(commandBuffer, m_swapChainImages[0], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer, 1, &region);
+
+        // Make the copied bytes visible to the host before we map them
+        VkBufferMemoryBarrier hostBarrier{};
+        hostBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        hostBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        hostBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        hostBarrier.buffer = readbackBuffer;
+        hostBarrier.offset = 0;
+        hostBarrier.size = imageSize;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &hostBarrier, 0, nullptr);
+
+        Helper::EndSingleTimeCommands(commandPool, commandBuffer, logicalDevice);
+
+        pixels.resize(static_cast<size_t>(imageSize));
+        memcpy(pixels.data(), readbackBufferMemory.mapped, static_cast<size_t>(imageSize)); // host visible allocations are persistently mapped
+
+        vkDestroyBuffer(logicalDevice.GetDevice(), readbackBuffer, nullptr);
+        logicalDevice.GetAllocator().Free(readbackBufferMemory);
+    }
+
     VkSurfaceFormatKHR WinSys::ChooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats)
     {
         // Refer to https://vulkan-tutorial.com/en/Drawing_a_triangle/Presentation/Swap_chain for colorSpace info
@@ -351,10 +459,21 @@ namespace VCore
         VkFormat depthFormat = Helper::FindDepthFormat(physicalDevice.GetDevice());
         uint32_t singleMipLevel = 1;
 
-        CreateImage(m_swapChainExtent.width, m_swapChainExtent.height, 1, m_msaaSamples, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_depthImage, m_depthImageMemory, physicalDevice, logicalDevice);
+        // Sampled too, the DepthPyramid is built from it for occlusion culling
+        CreateImage(m_swapChainExtent.width, m_swapChainExtent.height, 1, m_msaaSamples, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_depthImage, m_depthImageMemory, physicalDevice, logicalDevice);
         m_depthImageView = CreateImageView(m_depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, singleMipLevel, logicalDevice);
     }
 
+    VkImage& WinSys::GetDepthImage()
+    {
+        return m_depthImage;
+    }
+
+    VkImageView& WinSys::GetDepthImageView()
+    {
+        return m_depthImageView;
+    }
+
     VkFormat WinSys::GetImageFormat()
     {
         return m_swapChainImageFormat;
@@ -380,7 +499,7 @@ namespace VCore
         return m_swapChain;
     }
 
-    void WinSys::CreateImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, PhysicalDevice &physicalDevice, LogicalDevice &logicalDevice)
+    void WinSys::CreateImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, Allocation& imageMemory, PhysicalDevice &physicalDevice, LogicalDevice &logicalDevice)
     {
         VkImageCreateInfo imageInfo{};
         imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -404,25 +523,17 @@ namespace VCore
         VkMemoryRequirements memRequirements{};
         vkGetImageMemoryRequirements(logicalDevice.GetDevice(), image, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = physicalDevice.FindMemoryType(memRequirements.memoryTypeBits, properties);
+        // Sub-allocated from a shared block. Optimal tiling images live in separate blocks from buffers and linear images so bufferImageGranularity never comes into play
+        uint32_t ui_memoryTypeIndex = physicalDevice.FindMemoryType(memRequirements.memoryTypeBits, properties);
+        imageMemory = logicalDevice.GetAllocator().Allocate(memRequirements, ui_memoryTypeIndex, tiling == VK_IMAGE_TILING_OPTIMAL);
 
-        if (vkAllocateMemory(logicalDevice.GetDevice(), &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
-        {
-            throw std::runtime_error("failed to allocate image memory!");
-        }
-
-        vkBindImageMemory(logicalDevice.GetDevice(), image, imageMemory, 0);
+        vkBindImageMemory(logicalDevice.GetDevice(), image, imageMemory.memory, imageMemory.offset);
     }
 
-    void WinSys::TransitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels, VkCommandPool commandPool, LogicalDevice &logicalDevice)
+    void WinSys::TransitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels, VkCommandBuffer commandBuffer)
     {
         // Refer to - https://vulkan-tutorial.com/en/Texture_mapping/Images
 
-        VkCommandBuffer commandBuffer = Helper::BeginSingleTimeCommands(commandPool, logicalDevice);
-
         VkImageMemoryBarrier barrier{};
         barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
         barrier.pNext = 0;
@@ -460,16 +571,12 @@ namespace VCore
         }
 
         vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
-
-        Helper::EndSingleTimeCommands(commandPool, commandBuffer, logicalDevice);
     }
 
-    void WinSys::CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, VkCommandPool commandPool, LogicalDevice &logicalDevice)
+    void WinSys::CopyBufferToImage(VkBuffer buffer, VkDeviceSize bufferOffset, VkImage image, uint32_t width, uint32_t height, VkCommandBuffer commandBuffer)
     {
-        VkCommandBuffer commandBuffer = Helper::BeginSingleTimeCommands(commandPool, logicalDevice);
-
         VkBufferImageCopy region{};
-        region.bufferOffset = 0;
+        region.bufferOffset = bufferOffset; // where the pixels sit in the staging ring
         region.bufferRowLength = 0;
         region.bufferImageHeight = 0;
 
@@ -493,11 +600,9 @@ namespace VCore
             1,
             &region
         );
-
-        Helper::EndSingleTimeCommands(commandPool, commandBuffer, logicalDevice);
     }
 
-    void WinSys::GenerateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels, VkCommandPool commandPool, PhysicalDevice &physicalDevice, LogicalDevice &logicalDevice)
+    void WinSys::GenerateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels, VkCommandBuffer commandBuffer, PhysicalDevice &physicalDevice)
     {
         // Refer to - https://vulkan-tutorial.com/en/Generating_Mipmaps
 
@@ -509,8 +614,6 @@ namespace VCore
             throw std::runtime_error("texture image format does not support linear blitting!");
         }
 
-        VkCommandBuffer commandBuffer = Helper::BeginSingleTimeCommands(commandPool, logicalDevice);
-
         VkImageMemoryBarrier barrier{};
         barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
         barrier.image = image;
@@ -585,11 +688,9 @@ namespace VCore
             0, nullptr,
             0, nullptr,
             1, &barrier);
-
-        Helper::EndSingleTimeCommands(commandPool, commandBuffer, logicalDevice);
     }
 
-    VkImage WinSys::CreateTextureImage(std::string path, uint32_t mipLevels, VkCommandPool commandPool, PhysicalDevice &physicalDevice, LogicalDevice &logicalDevice, VkDeviceMemory textureImageMemory)
+    VkImage WinSys::CreateTextureImage(std::string path, uint32_t mipLevels, UploadQueue& uploadQueue, PhysicalDevice &physicalDevice, LogicalDevice &logicalDevice, Allocation& textureImageMemory)
     {
         // Refer to - https://vulkan-tutorial.com/en/Texture_mapping/Images
         // And refer to - https://vulkan-tutorial.com/en/Generating_Mipmaps
@@ -607,14 +708,8 @@ namespace VCore
 
         mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
 
-        VkBuffer stagingBuffer{};
-        VkDeviceMemory stagingBufferMemory{};
-        CreateBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory, physicalDevice, logicalDevice);
-
-        void* data{};
-        vkMapMemory(logicalDevice.GetDevice(), stagingBufferMemory, 0, imageSize, 0, &data);
-        memcpy(data, pixels, static_cast<size_t>(imageSize));
-        vkUnmapMemory(logicalDevice.GetDevice(), stagingBufferMemory);
+        // Copy the pixels into the upload queue's staging ring (16 byte aligned covers the 4 byte texel alignment buffer to image copies need)
+        StagingRange staging = uploadQueue.Stage(pixels, imageSize, 16);
 
         // Cleanup pixel array
         stbi_image_free(pixels);
@@ -622,19 +717,18 @@ namespace VCore
 
         CreateImage(texWidth, texHeight, mipLevels, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, newImage, textureImageMemory, physicalDevice, logicalDevice);
 
-        TransitionImageLayout(newImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels, commandPool, logicalDevice);
-        CopyBufferToImage(stagingBuffer, newImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), commandPool, logicalDevice);
+        // All recorded into the current upload batch - nothing runs until the batch is flushed, and the staging memory stays alive until it retires
+        VkCommandBuffer commandBuffer = uploadQueue.GetGraphicsCommands();
+        TransitionImageLayout(newImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels, commandBuffer);
+        CopyBufferToImage(staging.buffer, staging.offset, newImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), commandBuffer);
         // transitionImageLayout(m_textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, m_mipLevels);
         //  Removed this call ^^ because we are transiting to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL while generating mipmaps instead now
-        GenerateMipmaps(newImage, VK_FORMAT_R8G8B8A8_SRGB, texWidth, texHeight, mipLevels, commandPool, physicalDevice, logicalDevice);
-
-        vkDestroyBuffer(logicalDevice.GetDevice(), stagingBuffer, nullptr);
-        vkFreeMemory(logicalDevice.GetDevice(), stagingBufferMemory, nullptr);
+        GenerateMipmaps(newImage, VK_FORMAT_R8G8B8A8_SRGB, texWidth, texHeight, mipLevels, commandBuffer, physicalDevice);
 
         return newImage;
     }
 
-    void WinSys::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory, PhysicalDevice& physicalDevice, LogicalDevice &logicalDevice)
+    void WinSys::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, Allocation& bufferMemory, PhysicalDevice& physicalDevice, LogicalDevice &logicalDevice, AllocationStrategy strategy)
     {
         // Refer to - https://vulkan-tutorial.com/en/Vertex_buffers/Vertex_buffer_creation
         VkBufferCreateInfo bufferInfo{};
@@ -651,29 +745,11 @@ namespace VCore
         VkMemoryRequirements memRequirements{};
         vkGetBufferMemoryRequirements(logicalDevice.GetDevice(), buffer, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = physicalDevice.FindMemoryType(memRequirements.memoryTypeBits, properties);
-
         // NOTE FROM THE WIKI: It should be noted that in a real world application, you're not supposed to actually call vkAllocateMemory for every individual buffer. The maximum number of simultaneous memory allocations is limited by the maxMemoryAllocationCount physical device limit
-        if (vkAllocateMemory(logicalDevice.GetDevice(), &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
-        {
-            throw std::runtime_error("failed to allocate vertex buffer memory!");
-        }
-
-        vkBindBufferMemory(logicalDevice.GetDevice(), buffer, bufferMemory, 0);
-    }
+        // So the buffer is bound at an offset inside one of the allocator's shared blocks instead. Host visible memory comes back already mapped (bufferMemory.mapped)
+        uint32_t ui_memoryTypeIndex = physicalDevice.FindMemoryType(memRequirements.memoryTypeBits, properties);
+        bufferMemory = logicalDevice.GetAllocator().Allocate(memRequirements, ui_memoryTypeIndex, false, strategy);
 
-    void WinSys::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkCommandPool commandPool, LogicalDevice &logicalDevice)
-    {
-        VkCommandBuffer commandBuffer = Helper::BeginSingleTimeCommands(commandPool, logicalDevice);
-
-        // We're only going to use the command buffer once and wait with returning from the function until the copy operation has finished executing. It's good practice to tell the driver about our intent using 
-        VkBufferCopy copyRegion{};
-        copyRegion.size = size;
-        vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-
-        Helper::EndSingleTimeCommands(commandPool, commandBuffer, logicalDevice);
+        vkBindBufferMemory(logicalDevice.GetDevice(), buffer, bufferMemory.memory, bufferMemory.offset);
     }
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include "PhysicalDevice.h"
 #include "LogicalDevice.h"
+#include "UploadQueue.h"
 
 #define GLFW_INCLUDE_VULKAN
 #include <glfw3.h>
@@ -24,6 +25,11 @@ namespace VCore
 		void CreateSurface(VkInstance instance);		
 		GLFWwindow* GetWindow();
 		VkSurfaceKHR GetSurface();
+		// Headless rendering (no window, surface or swapchain) - renders into a single offscreen image that can be read back to the host
+		void InitHeadless(uint32_t width, uint32_t height);
+		bool IsHeadless();
+		void CreateOffscreenTarget(PhysicalDevice &physicalDevice, LogicalDevice &logicalDevice);
+		void ReadbackOffscreenImage(std::vector<uint8_t>& pixels, VkCommandPool commandPool, PhysicalDevice &physicalDevice, LogicalDevice &logicalDevice);
 		// NOTE FROM WIKI: If the swapChainAdequate conditions were met then the support is definitely sufficient, but there may still be many different modes of varying optimality. We'll now write a couple of functions to find the right settings for the best possible swap chain. There are three types of settings to determine:
 		// Surface format (color depth)
 		VkSurfaceFormatKHR ChooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
@@ -38,17 +44,19 @@ namespace VCore
 		VkImageView CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels, LogicalDevice &logicalDevice);
 
 		// textures
-		void CreateImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, PhysicalDevice &physicalDevice, LogicalDevice &logicalDevice);
-		void TransitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels, VkCommandPool commandPool, LogicalDevice &logicalDevice);
-		void CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, VkCommandPool commandPool, LogicalDevice &logicalDevice);
-		void GenerateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels, VkCommandPool commandPool, PhysicalDevice &physicalDevice, LogicalDevice &logicalDevice);
-		VkImage CreateTextureImage(std::string path, uint32_t mipLevels, VkCommandPool commandPool, PhysicalDevice &physicalDevice, LogicalDevice &logicalDevice, VkDeviceMemory textureImageMemory);
+		void CreateImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, Allocation& imageMemory, PhysicalDevice &physicalDevice, LogicalDevice &logicalDevice);
+		// These record into commandBuffer (usually UploadQueue::GetGraphicsCommands()) rather than submitting on their own
+		void TransitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels, VkCommandBuffer commandBuffer);
+		void CopyBufferToImage(VkBuffer buffer, VkDeviceSize bufferOffset, VkImage image, uint32_t width, uint32_t height, VkCommandBuffer commandBuffer);
+		void GenerateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels, VkCommandBuffer commandBuffer, PhysicalDevice &physicalDevice);
+		VkImage CreateTextureImage(std::string path, uint32_t mipLevels, UploadQueue& uploadQueue, PhysicalDevice &physicalDevice, LogicalDevice &logicalDevice, Allocation& textureImageMemory);
 
 		void CreateColorResources(PhysicalDevice &physicalDevice, LogicalDevice &logicalDevice);
 		void CreateDepthResources(PhysicalDevice &physicalDevice, LogicalDevice &logicalDevice); // depth testing
+		VkImage& GetDepthImage();
+		VkImageView& GetDepthImageView();
 
-		static void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory, PhysicalDevice& physicalDevice, LogicalDevice &logicalDevice);
-		static void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkCommandPool commandPool, LogicalDevice &logicalDevice);
+		static void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, Allocation& bufferMemory, PhysicalDevice& physicalDevice, LogicalDevice &logicalDevice, AllocationStrategy strategy = AllocationStrategy::FREE_LIST);
 
 		VkFormat GetImageFormat();
 		VkSampleCountFlagBits GetMsaa();
@@ -68,15 +76,19 @@ namespace VCore
 		std::vector<VkImageView> m_swapChainImageViews;
 		std::vector<VkFramebuffer> m_swapChainFramebuffers;
 
+		// headless
+		bool m_b_headless;
+		Allocation m_offscreenImageMemory;
+
 		// antialiasing
 		VkSampleCountFlagBits m_msaaSamples;
 		VkImage m_colorImage;
-		VkDeviceMemory m_colorImageMemory;
+		Allocation m_colorImageMemory;
 		VkImageView m_colorImageView;
 
 		// depth testing
 		VkImage m_depthImage;
-		VkDeviceMemory m_depthImageMemory;
+		Allocation m_depthImageMemory;
 		VkImageView m_depthImageView;
 	};
 }
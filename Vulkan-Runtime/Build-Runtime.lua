@@ -29,6 +29,21 @@ project "Vulkan-Runtime"
         "Vulkan-Core"
    }
 
+   -- Shaders are compiled with every build, so the SPIR-V the runtime loads never falls behind the GLSL (or the descriptor set layouts the code creates)
+   filter "system:windows"
+       prebuildcommands
+       {
+            "call ..\\Shaders\\compile.bat nopause"
+       }
+
+   filter "system:not windows"
+       prebuildcommands
+       {
+            "sh ../Shaders/compile.sh"
+       }
+
+   filter {}
+
    targetdir ("../Binaries/" .. OutputDir .. "/%{prj.name}")
    objdir ("../Binaries/Intermediates/" .. OutputDir .. "/%{prj.name}")
 
@@ -1,15 +1,434 @@
-#pragma once
 #include "Vulkan-Core.h"
 
 // standard library
 #include <iostream>
 #include <stdexcept>
 #include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
 
-int main()
+// -1 if flag wasn't given, otherwise its value (e.g. --threads N, the number of worker threads to record draw commands on). Removes the flag from argv so the other modes don't see it.
+int TakeValue(int& argc, char* argv[], const char* flag)
 {
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], flag) == 0)
+        {
+            int value = std::stoi(argv[i + 1]);
+            for (int j = i; j + 2 < argc; j++)
+            {
+                argv[j] = argv[j + 2];
+            }
+            argc -= 2;
+            return value;
+        }
+    }
+    return -1;
+}
+
+// Empty if flag wasn't given, otherwise the word after it (e.g. --vertex-format compact). Removes both from argv like TakeValue
+std::string TakeString(int& argc, char* argv[], const char* flag)
+{
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], flag) == 0)
+        {
+            std::string value = argv[i + 1];
+            for (int j = i; j + 2 < argc; j++)
+            {
+                argv[j] = argv[j + 2];
+            }
+            argc -= 2;
+            return value;
+        }
+    }
+    return "";
+}
+
+// Removes flag from the arguments, returns whether it was there
+bool TakeFlag(int& argc, char* argv[], const char* flag)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], flag) == 0)
+        {
+            for (int j = i; j + 1 < argc; j++)
+            {
+                argv[j] = argv[j + 1];
+            }
+            argc -= 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Headless usage: Vulkan-Runtime --headless <frames> [capture.ppm] [golden.ppm] [--threads N] [--bindless] [--copies N] [--gpu-culling] [--occlusion-culling] [--software-occlusion] [--occlusion-width N]
+//                        [--vertex-format full|compact|compact-color] [--lod-error pixels] [--compact-geometry]
+// Renders without a window (works on software drivers like lavapipe), prints frame timings, optionally writes the last frame to capture.ppm and compares it against golden.ppm.
+// --compact-geometry then releases the viking room's mesh, compacts the geometry and renders the frames again (see VulkanManager::SetHeadlessCompaction), the capture comes from that second run
+int RunHeadless(int argc, char* argv[], int threads, bool b_bindless, bool b_gpuCulling, bool b_occlusionCulling, bool b_softwareOcclusion, int occlusionWidth, int copies, VCore::VertexFormat vertexFormat, float lodError,
+    bool b_compactGeometry)
+{
+    const uint32_t ui_width = 800;
+    const uint32_t ui_height = 600;
+    const double d_tolerance = 2.0; // mean absolute difference per channel (0-255) allowed between a capture and its golden image - covers driver rounding differences
+
+    // At least one frame has to be drawn, the readback copies out of the image the last frame left behind
+    long frameCount = argc > 2 ? std::stol(argv[2]) : 1;
+    if (frameCount < 1)
+    {
+        std::cerr << "usage: Vulkan-Runtime --headless <frames> [capture.ppm] [golden.ppm], frames has to be at least 1" << std::endl;
+        return EXIT_FAILURE;
+    }
+    uint32_t ui_frameCount = static_cast<uint32_t>(frameCount);
+    std::string capturePath = argc > 3 ? argv[3] : "";
+    std::string goldenPath = argc > 4 ? argv[4] : "";
+
+    std::vector<uint8_t> pixels;
+    VCore::VulkanManager app = VCore::VulkanManager();
+    if (threads >= 0)
+    {
+        app.SetWorkerThreadCount(static_cast<uint32_t>(threads));
+    }
+    app.SetBindless(b_bindless);
+    app.SetGpuCulling(b_gpuCulling);
+    app.SetOcclusionCulling(b_occlusionCulling);
+    app.SetSoftwareOcclusion(b_softwareOcclusion, occlusionWidth > 0 ? static_cast<uint32_t>(occlusionWidth) : VCore::VM_OCCLUSION_WIDTH);
+    app.SetVertexFormat(vertexFormat);
+    app.SetLodErrorBudget(lodError);
+    app.SetHeadlessCompaction(b_compactGeometry);
+    app.AddPropCopies(copies > 0 ? static_cast<uint32_t>(copies) : 0);
+    app.RunHeadless(ui_width, ui_height, ui_frameCount, pixels);
+
+    if (!capturePath.empty())
+    {
+        VCore::Helper::WritePPM(capturePath, ui_width, ui_height, pixels);
+    }
+
+    if (!goldenPath.empty())
+    {
+        uint32_t ui_goldenWidth = 0;
+        uint32_t ui_goldenHeight = 0;
+        std::vector<uint8_t> goldenPixels;
+        VCore::Helper::ReadPPM(goldenPath, ui_goldenWidth, ui_goldenHeight, goldenPixels);
+
+        if (ui_goldenWidth != ui_width || ui_goldenHeight != ui_height)
+        {
+            std::cerr << "golden image size mismatch" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        // Compare RGB only, alpha isn't stored in the PPM files
+        double d_totalDiff = 0.0;
+        for (size_t i = 0; i < goldenPixels.size(); i++)
+        {
+            if (i % 4 != 3)
+            {
+                d_totalDiff += std::abs(static_cast<int>(pixels[i]) - static_cast<int>(goldenPixels[i]));
+            }
+        }
+        double d_meanDiff = d_totalDiff / (static_cast<double>(ui_width) * ui_height * 3);
+
+        std::cout << "golden comparison: mean difference " << d_meanDiff << " (tolerance " << d_tolerance << ")" << std::endl;
+        if (d_meanDiff > d_tolerance)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// Scaling usage: Vulkan-Runtime --scaling <frames>
+// Renders headless once per thread count, from the main thread alone up to one thread per hardware thread, and prints draw recording time for each
+int RunScaling(int argc, char* argv[])
+{
+    const uint32_t ui_width = 800;
+    const uint32_t ui_height = 600;
+    long frameCount = argc > 2 ? std::stol(argv[2]) : 100;
+    if (frameCount < 1)
+    {
+        std::cerr << "usage: Vulkan-Runtime --scaling <frames>, frames has to be at least 1" << std::endl;
+        return EXIT_FAILURE;
+    }
+    uint32_t ui_frameCount = static_cast<uint32_t>(frameCount);
+    uint32_t ui_maxWorkers = VCore::JobSystem::GetDefaultWorkerCount();
+
+    std::vector<float> recordTimes;
+    for (uint32_t workers = 0; workers <= ui_maxWorkers; workers++)
+    {
+        std::vector<uint8_t> pixels;
+        VCore::VulkanManager app = VCore::VulkanManager();
+        app.SetWorkerThreadCount(workers);
+        app.RunHeadless(ui_width, ui_height, ui_frameCount, pixels);
+        recordTimes.push_back(app.GetAverageRecordTime());
+    }
+
+    std::cout << std::endl << "threads\trecord ms/frame\tspeedup" << std::endl;
+    for (size_t i = 0; i < recordTimes.size(); i++)
+    {
+        float f_speedup = recordTimes[i] > 0.0f ? recordTimes[0] / recordTimes[i] : 0.0f;
+        std::cout << i + 1 << "\t" << recordTimes[i] << "\t\t" << f_speedup << "x" << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// Converter usage: Vulkan-Runtime --convert-mesh <model.obj> [more.obj ...]
+// Writes a .vmesh cache next to each model so the first launch doesn't have to parse them either
+int ConvertMeshes(int argc, char* argv[], int threads)
+{
+    VCore::JobSystem jobSystem;
+    jobSystem.Init(threads >= 0 ? static_cast<uint32_t>(threads) : VCore::JobSystem::GetDefaultWorkerCount());
+
+    for (int i = 2; i < argc; i++)
+    {
+        VCore::Mesh::BuildMeshCache(argv[i], jobSystem);
+        std::cout << argv[i] << " -> " << VCore::MeshCache::GetCachePath(argv[i]) << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// Import benchmark usage: Vulkan-Runtime --bench-import [triangles] [model.obj ...]
+// Compares the old unordered_map vertex deduplication against the parallel hash table import on each model (viking_room.obj by default) and on a synthetic grid of triangles triangles (10 million by default)
+int BenchmarkImport(int argc, char* argv[], int threads)
+{
+    uint32_t ui_syntheticTriangles = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 10000000;
+    std::vector<std::string> paths;
+    for (int i = 3; i < argc; i++)
+    {
+        paths.push_back(argv[i]);
+    }
+    if (paths.empty())
+    {
+        paths.push_back("../Models/viking_room.obj");
+    }
+
+    VCore::JobSystem jobSystem;
+    jobSystem.Init(threads >= 0 ? static_cast<uint32_t>(threads) : VCore::JobSystem::GetDefaultWorkerCount());
+    VCore::MeshImporter::RunBenchmark(paths, ui_syntheticTriangles, jobSystem);
+
+    return EXIT_SUCCESS;
+}
+
+// Mesh optimization benchmark usage: Vulkan-Runtime --bench-mesh-opt [triangles] [model.obj ...]
+// Runs the MeshOptimizer on each model (viking_room.obj by default) and a synthetic grid of triangles triangles (1 million by default), as imported and with shuffled triangles,
+// and prints the vertex cache ACMR and ATVR before and after with the time each step took
+int BenchmarkMeshOptimizer(int argc, char* argv[], int threads)
+{
+    uint32_t ui_syntheticTriangles = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 1000000;
+    std::vector<std::string> paths;
+    for (int i = 3; i < argc; i++)
+    {
+        paths.push_back(argv[i]);
+    }
+    if (paths.empty())
+    {
+        paths.push_back("../Models/viking_room.obj");
+    }
+
+    VCore::JobSystem jobSystem;
+    jobSystem.Init(threads >= 0 ? static_cast<uint32_t>(threads) : VCore::JobSystem::GetDefaultWorkerCount());
+    VCore::MeshOptimizer::RunBenchmark(paths, ui_syntheticTriangles, jobSystem);
+
+    return EXIT_SUCCESS;
+}
+
+// Transform benchmark usage: Vulkan-Runtime --bench-transforms [objects]
+// Times building world and world * view * projection matrices for objects random transforms (200000 by default) with each SIMD kernel the CPU supports, on one thread and across the job system
+int BenchmarkTransforms(int argc, char* argv[], int threads)
+{
+    uint32_t ui_objects = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 200000;
+
+    VCore::JobSystem jobSystem;
+    jobSystem.Init(threads >= 0 ? static_cast<uint32_t>(threads) : VCore::JobSystem::GetDefaultWorkerCount());
+    VCore::TransformSystem::RunBenchmark(ui_objects, jobSystem);
+
+    return EXIT_SUCCESS;
+}
+
+// Culling benchmark usage: Vulkan-Runtime --bench-culling [spheres]
+// Times testing spheres random bounding spheres (200000 by default) against a camera frustum, scalar against SSE on one thread and across the job system
+int BenchmarkCulling(int argc, char* argv[], int threads)
+{
+    uint32_t ui_spheres = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 200000;
+
+    VCore::JobSystem jobSystem;
+    jobSystem.Init(threads >= 0 ? static_cast<uint32_t>(threads) : VCore::JobSystem::GetDefaultWorkerCount());
+    VCore::FrustumCuller::RunBenchmark(ui_spheres, jobSystem);
+
+    return EXIT_SUCCESS;
+}
+
+// Occlusion benchmark usage: Vulkan-Runtime --bench-occlusion [spheres] [width]
+// Rasterizes the viking room into a software depth buffer width pixels wide (VM_OCCLUSION_WIDTH by default, 4:3) and tests spheres ghost hand bounds (100000 by default) against it,
+// scalar against SSE on one thread and across the job system
+int BenchmarkOcclusion(int argc, char* argv[], int threads)
+{
+    uint32_t ui_spheres = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 100000;
+    uint32_t ui_width = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : VCore::VM_OCCLUSION_WIDTH;
+
+    VCore::JobSystem jobSystem;
+    jobSystem.Init(threads >= 0 ? static_cast<uint32_t>(threads) : VCore::JobSystem::GetDefaultWorkerCount());
+    VCore::OcclusionRasterizer::RunBenchmark("../Models/viking_room.obj", "../Models/ghostHand.obj", ui_spheres, ui_width, ui_width * 3 / 4, jobSystem);
+
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[])
+{
+    int threads = -1;
+    int copies = -1;
+    int occlusionWidth = -1;
+    try {
+        threads = TakeValue(argc, argv, "--threads");
+        copies = TakeValue(argc, argv, "--copies"); // extra instanced copies of a prop, see VulkanManager::AddPropCopies
+        occlusionWidth = TakeValue(argc, argv, "--occlusion-width"); // software occlusion depth buffer width, see OcclusionRasterizer
+    }
+    catch (const std::exception& e) {
+        std::cerr << "invalid --threads, --copies or --occlusion-width value: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    bool b_bindless = TakeFlag(argc, argv, "--bindless");
+    bool b_gpuCulling = TakeFlag(argc, argv, "--gpu-culling"); // instanced batches culled by a compute shader and drawn indirectly, see GpuCuller
+    bool b_occlusionCulling = TakeFlag(argc, argv, "--occlusion-culling"); // GPU culling plus a depth pyramid test, see DepthPyramid
+    bool b_softwareOcclusion = TakeFlag(argc, argv, "--software-occlusion"); // objects hidden behind the viking room culled on the CPU, see OcclusionRasterizer
+    bool b_compactGeometry = TakeFlag(argc, argv, "--compact-geometry"); // headless only, releases the viking room's mesh and compacts the geometry after the frames, see GeometryArena::Compact
+
+    // How mesh vertices are stored on the GPU, see VertexCodec
+    VCore::VertexFormat vertexFormat = VCore::VertexFormat::FULL;
+    std::string vertexFormatName = TakeString(argc, argv, "--vertex-format");
+    if (!vertexFormatName.empty() && !VCore::VertexCodec::Parse(vertexFormatName, vertexFormat))
+    {
+        std::cerr << "invalid --vertex-format " << vertexFormatName << ", expected full, compact or compact-color" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Pixels a coarser LOD may be off by on screen, 0 for full detail everywhere, see LodSelector
+    float lodError = VCore::VM_LOD_ERROR_PIXELS;
+    std::string lodErrorValue = TakeString(argc, argv, "--lod-error");
+    if (!lodErrorValue.empty())
+    {
+        try {
+            lodError = std::stof(lodErrorValue);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "invalid --lod-error value: " << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--headless") == 0)
+    {
+        try {
+            return RunHeadless(argc, argv, threads, b_bindless, b_gpuCulling, b_occlusionCulling, b_softwareOcclusion, occlusionWidth, copies, vertexFormat, lodError, b_compactGeometry);
+        }
+        catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--convert-mesh") == 0)
+    {
+        try {
+            return ConvertMeshes(argc, argv, threads);
+        }
+        catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--bench-import") == 0)
+    {
+        try {
+            return BenchmarkImport(argc, argv, threads);
+        }
+        catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--bench-mesh-opt") == 0)
+    {
+        try {
+            return BenchmarkMeshOptimizer(argc, argv, threads);
+        }
+        catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--bench-transforms") == 0)
+    {
+        try {
+            return BenchmarkTransforms(argc, argv, threads);
+        }
+        catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--bench-culling") == 0)
+    {
+        try {
+            return BenchmarkCulling(argc, argv, threads);
+        }
+        catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--bench-occlusion") == 0)
+    {
+        try {
+            return BenchmarkOcclusion(argc, argv, threads);
+        }
+        catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--scaling") == 0)
+    {
+        try {
+            return RunScaling(argc, argv);
+        }
+        catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
     bool _quit = false;
     VCore::VulkanManager app = VCore::VulkanManager();
+    if (threads >= 0)
+    {
+        app.SetWorkerThreadCount(static_cast<uint32_t>(threads));
+    }
+    app.SetBindless(b_bindless);
+    app.SetGpuCulling(b_gpuCulling);
+    app.SetOcclusionCulling(b_occlusionCulling);
+    app.SetSoftwareOcclusion(b_softwareOcclusion, occlusionWidth > 0 ? static_cast<uint32_t>(occlusionWidth) : VCore::VM_OCCLUSION_WIDTH);
+    app.SetVertexFormat(vertexFormat);
+    app.SetLodErrorBudget(lodError);
+    try {
+        app.AddPropCopies(copies > 0 ? static_cast<uint32_t>(copies) : 0);
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
 
     while (!_quit)
     {